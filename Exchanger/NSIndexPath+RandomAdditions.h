@@ -26,6 +26,7 @@
 
 
 #import <Foundation/Foundation.h>
+#import "SSCollectionViewExchangeBackingStore.h"
 
 @interface NSIndexPath (RandomAdditions)
 
@@ -36,18 +37,22 @@
 // in the set of excludedIndexPaths. excludedIndexPaths can be nil.
 //
 // The order of the arrays in arrays is important. The first array is section 0,
-// the second array is section 1, and so on. The size of the arrays can vary but
-// an array cannot be empty.
+// the second array is section 1, and so on. The size of the arrays can vary and
+// an array can be empty. Every element is equally likely, whatever the size of
+// its array.
+
++ (NSIndexPath *)randomIndexPathInBackingStore:(id<SSCollectionViewExchangeBackingStore>)backingStore
+                           excludingIndexPaths:(NSSet *)excludedIndexPaths;
+// The same, for the sections of backingStore.
 //
 // Returns nil if:
 //
 //  - arrays is nil
-//  - any of the arrays in arrays is empty
 //  - any of the objects in arrays is not an array
-//  - the number of items in excludedIndexPaths is greater than or equal to the
-//      total number of elements for all the arrays in arrays
+//  - every element of the arrays is in excludedIndexPaths
 //
-// This method will take longer to return as the number of items in excludedIndexPaths
-// grows as a percent of the total number of elements for all the arrays in arrays.
+// Both methods make a RandomIndexPathSampler for one draw, which takes time in
+// proportion to the number of elements plus the number of excluded index paths
+// but no longer as more are excluded. To draw several, make the sampler once.
 
 @end
@@ -26,6 +26,7 @@
 
 
 #import "NSIndexPath+RandomAdditions.h"
+#import "RandomIndexPathSampler.h"
 
 @implementation NSIndexPath (RandomAdditions)
 
@@ -34,32 +35,23 @@
     
     if (arrays == nil) return nil;
     
-    NSUInteger totalElementsInArrays = 0;
     for (NSArray *array in arrays) {
-        if (![array isKindOfClass:[NSArray class]] || array.count == 0) return nil;
-        totalElementsInArrays += array.count;
+        if (![array isKindOfClass:[NSArray class]]) return nil;
     }
     
-    if (excludedIndexPaths.count >= totalElementsInArrays) return nil;
-    // This early return assumes that all the index paths in excludedIndexPaths are
-    // relevant to the index paths represented in arrays. With that assumption if
-    // there are too many excluded index paths, it is not possible to generate
-    // a random index path for arrays.
+    return [self randomIndexPathInBackingStore:[[SSCollectionViewExchangeArrayStore alloc] initWithArrays:arrays]
+                           excludingIndexPaths:excludedIndexPaths];
     
+}
+
++ (NSIndexPath *)randomIndexPathInBackingStore:(id<SSCollectionViewExchangeBackingStore>)backingStore
+                           excludingIndexPaths:(NSSet *)excludedIndexPaths {
     
-    // Otherwise we are good to go...
-    NSIndexPath *randomIndexPath;
-    
-    do {
-        
-        NSInteger randomSection = arc4random_uniform((u_int32_t)arrays.count);
-        NSArray *randomArray = arrays[ randomSection ];
-        NSInteger randomItem = arc4random_uniform((u_int32_t)randomArray.count);
-        randomIndexPath = [NSIndexPath indexPathForItem:randomItem inSection:randomSection];
-        
-    } while ([excludedIndexPaths containsObject:randomIndexPath]);
+    if (backingStore == nil) return nil;
     
-    return randomIndexPath;
+    RandomIndexPathSampler *sampler = [[RandomIndexPathSampler alloc] initWithBackingStore:backingStore
+                                                                       excludingIndexPaths:excludedIndexPaths];
+    return [sampler randomIndexPath];
     
 }
 
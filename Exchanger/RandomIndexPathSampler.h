@@ -0,0 +1,75 @@
+//
+//  RandomIndexPathSampler.h
+//  Exchanger
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#import <Foundation/Foundation.h>
+#import "SSCollectionViewExchangeBackingStore.h"
+
+
+// Draws index paths uniformly at random from the items of some sections, leaving out excluded
+// index paths. Every available item is equally likely, whatever the sizes of the sections.
+//
+// init does the work: it numbers the items section by section, using a running total of the
+// section sizes, and lists the available ones compactly. After that a draw is one random number
+// and an array lookup, and removing an index path swaps it past the end of the list, so both
+// take the same time however many index paths are excluded.
+
+@interface RandomIndexPathSampler : NSObject
+
+- (id)initWithNumbersOfItemsInSections:(const NSUInteger *)numbersOfItemsInSections
+                      numberOfSections:(NSUInteger)numberOfSections
+                   excludingIndexPaths:(NSSet *)excludedIndexPaths;
+// numbersOfItemsInSections[n] is the number of items in section n. Sections can be empty.
+// Index paths in excludedIndexPaths that are not in the sections are ignored. excludedIndexPaths
+// can be nil. Returns nil if there are too many items to number with 32 bits.
+
+- (id)initWithBackingStore:(id<SSCollectionViewExchangeBackingStore>)backingStore
+       excludingIndexPaths:(NSSet *)excludedIndexPaths;
+// The same, for the sections of backingStore when the sampler is made.
+
+@property (nonatomic, readonly) NSUInteger numberOfAvailableIndexPaths;
+
+- (NSIndexPath *)randomIndexPath;
+// Returns an available index path, or nil if there are none. It stays available.
+
+- (NSIndexPath *)removeRandomIndexPath;
+// The same, but the index path is no longer available, so the next draw won't return it.
+
+- (NSArray *)removeRandomIndexPaths:(NSUInteger)count;
+// Draws count distinct index paths and removes them. Returns fewer if fewer are available.
+
+- (NSUInteger)removeRandomIndexPaths:(SSExchangeIndexPath *)indexPaths count:(NSUInteger)count;
+// The same without making NSIndexPaths, for generating large amounts of test input. Returns the
+// number drawn.
+
+- (BOOL)isAvailableIndexPath:(NSIndexPath *)indexPath;
+
+- (void)removeIndexPath:(NSIndexPath *)indexPath;
+// Makes indexPath unavailable. Does nothing if it already is or is not in the sections.
+
+- (void)restoreRemovedIndexPaths;
+// Makes every index path removed since init available again. Those excluded by init stay excluded.
+
+@end
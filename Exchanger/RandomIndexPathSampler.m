@@ -0,0 +1,221 @@
+//
+//  RandomIndexPathSampler.m
+//  Exchanger
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#import "RandomIndexPathSampler.h"
+
+
+@interface RandomIndexPathSampler () {
+
+    NSUInteger              _numberOfSections;
+    uint32_t                *_firstItemOfSections;  // running total of the section sizes, _numberOfSections + 1 of them
+    SSExchangeIndexPath     *_indexPaths;           // every item; the available ones first, then the removed ones, then the excluded ones
+    uint32_t                *_positions;            // for each item, numbered section by section, its position in _indexPaths
+    uint32_t                _numberOfAvailable;
+    uint32_t                _numberNotExcluded;
+}
+
+@end
+
+
+
+@implementation RandomIndexPathSampler
+
+- (id)initWithNumbersOfItemsInSections:(const NSUInteger *)numbersOfItemsInSections
+                      numberOfSections:(NSUInteger)numberOfSections
+                   excludingIndexPaths:(NSSet *)excludedIndexPaths {
+
+    self = [super init];
+    if (self) {
+
+        if (numberOfSections > 0 && numbersOfItemsInSections == NULL) return nil;
+        if (numberOfSections > INT32_MAX) return nil;
+
+        _numberOfSections = numberOfSections;
+        _firstItemOfSections = malloc((numberOfSections + 1) * sizeof(uint32_t));
+        if (_firstItemOfSections == NULL) return nil;
+
+        uint64_t totalNumberOfItems = 0;
+        for (NSUInteger section = 0; section < numberOfSections; section++) {
+            _firstItemOfSections[section] = (uint32_t)totalNumberOfItems;
+            totalNumberOfItems += numbersOfItemsInSections[section];
+            if (totalNumberOfItems > UINT32_MAX) return nil;
+        }
+        _firstItemOfSections[numberOfSections] = (uint32_t)totalNumberOfItems;
+
+        _indexPaths = malloc(MAX(totalNumberOfItems, 1) * sizeof(SSExchangeIndexPath));
+        _positions = malloc(MAX(totalNumberOfItems, 1) * sizeof(uint32_t));
+        if (_indexPaths == NULL || _positions == NULL) return nil;
+
+        for (NSUInteger section = 0; section < numberOfSections; section++) {
+            for (uint32_t item = 0; item < numbersOfItemsInSections[section]; item++) {
+                uint32_t number = _firstItemOfSections[section] + item;
+                _indexPaths[number] = SSExchangeIndexPathMake((int32_t)section, (int32_t)item);
+                _positions[number] = number;
+            }
+        }
+
+        // Excluding works the same as removing, then the removed count is forgotten.
+        _numberOfAvailable = (uint32_t)totalNumberOfItems;
+        for (NSIndexPath *indexPath in excludedIndexPaths) {
+            [self removeIndexPath:indexPath];
+        }
+        _numberNotExcluded = _numberOfAvailable;
+    }
+    return self;
+}
+
+- (id)initWithBackingStore:(id<SSCollectionViewExchangeBackingStore>)backingStore
+       excludingIndexPaths:(NSSet *)excludedIndexPaths {
+
+    NSUInteger numberOfSections = [backingStore numberOfSections];
+    NSUInteger *numbersOfItemsInSections = malloc(MAX(numberOfSections, 1) * sizeof(NSUInteger));
+    if (numbersOfItemsInSections == NULL) return nil;
+
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        numbersOfItemsInSections[section] = [backingStore numberOfItemsInSection:section];
+    }
+
+    self = [self initWithNumbersOfItemsInSections:numbersOfItemsInSections
+                                 numberOfSections:numberOfSections
+                              excludingIndexPaths:excludedIndexPaths];
+    free(numbersOfItemsInSections);
+    return self;
+}
+
+- (void)dealloc {
+
+    free(_firstItemOfSections);
+    free(_indexPaths);
+    free(_positions);
+}
+
+- (NSUInteger)numberOfAvailableIndexPaths {
+
+    return _numberOfAvailable;
+}
+
+
+
+//---------------------------
+#pragma mark - Drawing...
+
+- (NSIndexPath *)randomIndexPath {
+
+    if (_numberOfAvailable == 0) return nil;
+    return NSIndexPathFromSSExchangeIndexPath(_indexPaths[arc4random_uniform(_numberOfAvailable)]);
+}
+
+- (NSIndexPath *)removeRandomIndexPath {
+
+    SSExchangeIndexPath indexPath;
+    if ([self removeRandomIndexPaths:&indexPath count:1] == 0) return nil;
+    return NSIndexPathFromSSExchangeIndexPath(indexPath);
+}
+
+- (NSArray *)removeRandomIndexPaths:(NSUInteger)count {
+
+    count = MIN(count, _numberOfAvailable);
+    NSMutableArray *indexPaths = [NSMutableArray arrayWithCapacity:count];
+
+    for (NSUInteger i = 0; i < count; i++) {
+        [indexPaths addObject:[self removeRandomIndexPath]];
+    }
+    return indexPaths;
+}
+
+- (NSUInteger)removeRandomIndexPaths:(SSExchangeIndexPath *)indexPaths count:(NSUInteger)count {
+
+    if (indexPaths == NULL) return 0;
+
+    // A partial Fisher-Yates shuffle: each draw swaps a random available index path to the end of
+    // the available ones, then shortens them by one.
+    count = MIN(count, _numberOfAvailable);
+    for (NSUInteger i = 0; i < count; i++) {
+        uint32_t position = arc4random_uniform(_numberOfAvailable);
+        indexPaths[i] = _indexPaths[position];
+        [self removeIndexPathAtPosition:position];
+    }
+    return count;
+}
+
+
+
+//------------------------------------------
+#pragma mark - Removing and restoring...
+
+- (BOOL)isAvailableIndexPath:(NSIndexPath *)indexPath {
+
+    uint32_t number;
+    if (![self getNumber:&number ofIndexPath:SSExchangeIndexPathFromNSIndexPath(indexPath)]) return NO;
+    return _positions[number] < _numberOfAvailable;
+}
+
+- (void)removeIndexPath:(NSIndexPath *)indexPath {
+
+    uint32_t number;
+    if (![self getNumber:&number ofIndexPath:SSExchangeIndexPathFromNSIndexPath(indexPath)]) return;
+
+    uint32_t position = _positions[number];
+    if (position < _numberOfAvailable) [self removeIndexPathAtPosition:position];
+}
+
+- (void)restoreRemovedIndexPaths {
+
+    // The removed index paths are still in _indexPaths, just past the available ones.
+    _numberOfAvailable = _numberNotExcluded;
+}
+
+- (void)removeIndexPathAtPosition:(uint32_t)position {
+
+    uint32_t last = _numberOfAvailable - 1;
+
+    SSExchangeIndexPath indexPath = _indexPaths[position];
+    SSExchangeIndexPath lastIndexPath = _indexPaths[last];
+    _indexPaths[position] = lastIndexPath;
+    _indexPaths[last] = indexPath;
+
+    uint32_t number, lastNumber;
+    [self getNumber:&number ofIndexPath:indexPath];
+    [self getNumber:&lastNumber ofIndexPath:lastIndexPath];
+    _positions[number] = last;
+    _positions[lastNumber] = position;
+
+    _numberOfAvailable = last;
+}
+
+- (BOOL)getNumber:(uint32_t *)number ofIndexPath:(SSExchangeIndexPath)indexPath {
+
+    if (SSExchangeIndexPathIsNone(indexPath)) return NO;
+    if ((NSUInteger)indexPath.section >= _numberOfSections) return NO;
+
+    uint32_t firstItem = _firstItemOfSections[indexPath.section];
+    if ((uint32_t)indexPath.item >= _firstItemOfSections[indexPath.section + 1] - firstItem) return NO;
+
+    *number = firstItem + (uint32_t)indexPath.item;
+    return YES;
+}
+
+@end
@@ -38,8 +38,12 @@
 
 #import "ViewController.h"
 #import "SSCollectionViewExchangeController.h"
-#import "NSMutableArray+SSCollectionViewExchangeControllerAdditions.h"
+#import "SSCollectionViewExchangeJournal.h"
+#import "SSCollectionViewExchangeHistory.h"
+#import "SSCollectionViewExchangeInt64Store.h"
+#import "SSCollectionViewExchangeInstrumentation.h"
 #import "NSIndexPath+RandomAdditions.h"
+#import "RandomIndexPathSampler.h"
 #import "NSMutableSet+AddObjectIfNotNil.h"
 #import "MSStringifyMacros_UserDefaults.h"
 #import "MSStringifyMacros_Archiving.h"
@@ -53,21 +57,13 @@ static NSUInteger const kCellLabelTag = 1;
 static NSUInteger const kCatchRectangleTag = 2;
 static NSUInteger const kLockLabelTag = 3;
 
-static NSString * const kUndoText = @"Undo";
-static NSString * const kRedoText = @"Redo";
-
 static NSString * const kCellNibName = @"ItemCell";
 
 static NSString * const kCollectionViewHeader = @"SSCollectionViewHeader";
 
+static NSString * const kJournalDirectoryName = @"Exchanges";
 
-
-// Helps map collection view sections to arrays...
-NS_ENUM(NSInteger, CollectionViewSection) {
-    CollectionViewSectionLeft,
-    CollectionViewSectionMiddle,
-    CollectionViewSectionRight
-};
+static unsigned int const kHistoryCapacity = 4096;
 
 
 
@@ -76,7 +72,8 @@ NS_ENUM(NSInteger, CollectionViewSection) {
 <
     UICollectionViewDataSource,
     UICollectionViewDelegate,
-    SSCollectionViewExchangeControllerDelegate
+    SSCollectionViewExchangeControllerDelegate,
+    SSCollectionViewExchangeJournalSnapshotProvider
 >
 
 @property (weak, nonatomic) IBOutlet UICollectionView *collectionView;
@@ -87,15 +84,16 @@ NS_ENUM(NSInteger, CollectionViewSection) {
 - (IBAction)reset:(id)sender;
 - (IBAction)undo:(id)sender;
 @property (weak, nonatomic) IBOutlet UIButton *undoButton;
+- (IBAction)redo:(id)sender;
+@property (weak, nonatomic) IBOutlet UIButton *redoButton;
 
-@property (strong, nonatomic) NSMutableArray *leftSide;
-@property (strong, nonatomic) NSMutableArray *middle;
-@property (strong, nonatomic) NSMutableArray *rightSide;
+@property (strong, nonatomic) SSCollectionViewExchangeInt64Store *model;
 
-@property (strong, nonatomic) NSIndexPath *indexPath1ForLastExchange;
-@property (strong, nonatomic) NSIndexPath *indexPath2ForLastExchange;
+@property (nonatomic) SSExchangeHistory *history;
 
 @property (strong, nonatomic) SSCollectionViewExchangeController *exchangeController;
+@property (strong, nonatomic) SSCollectionViewExchangeJournal *journal;
+@property (strong, nonatomic) SSCollectionViewExchangeInstrumentation *instrumentation;
 
 - (IBAction)catchRectangleSwitchChanged:(UISwitch *)sender;
 @property (weak, nonatomic) IBOutlet UISwitch *catchRectangleSwitch;
@@ -132,15 +130,24 @@ NS_ENUM(NSInteger, CollectionViewSection) {
     
     [self prepareApp];
     [self prepareCollectionView];
+    [self prepareUndoAndRedo];
+    
+}
+
+- (void)dealloc {
+    
+    SSExchangeHistoryFree(_history);
     
 }
 
 - (void)prepareApp {
     
+    [self prepareJournal];
+    
     if ([self isFirstRun]) {
         
         [self useDefaultModel];
-        [self saveModel];
+        [self.journal writeSnapshot];
         [self useInitialControlStates];
         [self saveControlStates];
         [self saveIndexPaths];
@@ -148,7 +155,13 @@ NS_ENUM(NSInteger, CollectionViewSection) {
         
     } else {
         
-        [self useSavedModel];
+        if (![self useJournaledModel]) {
+            
+            // Saved by an earlier version of this app, before the journal...
+            [self useSavedModel];
+            [self.journal writeSnapshot];
+            
+        }
         [self useSavedControlStates];
         [self useSavedIndexPaths];
 
@@ -190,9 +203,32 @@ NS_ENUM(NSInteger, CollectionViewSection) {
     layout.scrollDirection = UICollectionViewScrollDirectionHorizontal;
 
     self.exchangeController.longPressGestureRecognizer.minimumPressDuration = self.minimumPressDurationSlider.value;
+    
+    // The items scroll horizontally, so let the user drag an item to an edge to reach the rest.
+    self.exchangeController.autoScrollEnabled = YES;
+    
+#ifdef DEBUG
+    // Times the catch, each exchange event, the delegate methods below, layout passes, and the
+    // release. The summary is logged with the model. Leave instrumentation nil in release builds.
+    self.instrumentation = [SSCollectionViewExchangeInstrumentation new];
+    self.exchangeController.instrumentation = self.instrumentation;
+#endif
 
 }
 
+- (void)prepareUndoAndRedo {
+    
+    // The history remembers the final exchange of up to kHistoryCapacity transactions in a fixed
+    // amount of memory. Tap to undo or redo one, press and hold to undo or redo them all...
+    
+    self.history = SSExchangeHistoryCreate(kHistoryCapacity);
+    
+    [self.undoButton addGestureRecognizer:[[UILongPressGestureRecognizer alloc] initWithTarget:self action:@selector(undoAll:)]];
+    [self.redoButton addGestureRecognizer:[[UILongPressGestureRecognizer alloc] initWithTarget:self action:@selector(redoAll:)]];
+    [self updateUndoAndRedoButtons];
+    
+}
+
 
 
 //------------------------------------------------------------------------------------
@@ -232,7 +268,9 @@ NS_ENUM(NSInteger, CollectionViewSection) {
     // of the transaction such as setting up for undo. If the user dragged back to the starting
     // position and released (effectively nothing was exchanged) the index paths will be the same.
     
-    [self saveModel];
+    // Saving the model is just a matter of logging the final exchange. The journal
+    // ignores it if the index paths are the same...
+    [self.journal appendExchangeOfItemAtIndexPath1:indexPath1 withItemAtIndexPath2:indexPath2];
     [self prepareForUndoWithIndexPath1:indexPath1 indexPath2:indexPath2];
     
 }
@@ -329,6 +367,30 @@ NS_ENUM(NSInteger, CollectionViewSection) {
 }
 
 
+- (void) exchangeController:(SSCollectionViewExchangeController *)exchangeController
+   didMoveItemsAtIndexPaths:(NSArray *)fromIndexPaths
+               toIndexPaths:(NSArray *)toIndexPaths {
+    
+    // If implemented, called instead of didExchangeItemAtIndexPath1:withItemAtIndexPath2: with the
+    // net change for the whole exchange event. The item at fromIndexPaths[i] is now at toIndexPaths[i].
+    // Dragging from one item to another is reported as one call moving three items in a cycle rather
+    // than two separate exchanges, which is handy if your model does expensive work on each change.
+    // Exchanges that cancel each other out are never reported.
+    
+    NSUInteger count = fromIndexPaths.count;
+    SSExchangeMove *moves = malloc(count * sizeof(SSExchangeMove));
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        moves[i].fromIndexPath = SSExchangeIndexPathFromNSIndexPath(fromIndexPaths[ i ]);
+        moves[i].toIndexPath = SSExchangeIndexPathFromNSIndexPath(toIndexPaths[ i ]);
+    }
+    
+    [self.model moveItemsWithMoves:moves count:count];
+    free(moves);
+    
+}
+
+
 - (UIView *)             exchangeController:(SSCollectionViewExchangeController *)exchangeController
     viewForCatchRectangleForItemAtIndexPath:(NSIndexPath *)indexPath {
     
@@ -350,13 +412,13 @@ NS_ENUM(NSInteger, CollectionViewSection) {
 
 - (NSInteger)numberOfSectionsInCollectionView:(UICollectionView *)collectionView {
     
-    return 3;
+    return self.model.numberOfSections;
     
 }
 
 - (NSInteger)collectionView:(UICollectionView *)collectionView numberOfItemsInSection:(NSInteger)section {
     
-    return self.leftSide.count;
+    return [self.model numberOfItemsInSection:section];
     
 }
 
@@ -387,7 +449,7 @@ NS_ENUM(NSInteger, CollectionViewSection) {
     
     itemLabel.alpha = (self.allowExchangesSwitch.on)? 1.0:0.2;
     lockLabel.alpha = (self.allowExchangesSwitch.on)? 1.0:0.2;
-    itemLabel.text = [NSString stringWithFormat:@" %@", [self arrayForSection:indexPath.section][ indexPath.item ]];
+    itemLabel.text = [NSString stringWithFormat:@" %lld", [self.model itemAtIndexPath:SSExchangeIndexPathFromNSIndexPath(indexPath)]];
     
     return cell;
 }
@@ -415,27 +477,24 @@ NS_ENUM(NSInteger, CollectionViewSection) {
 
 - (void)exchangeItemAtIndexPath1:(NSIndexPath *)indexPath1 withItemAtIndexPath2:(NSIndexPath *)indexPath2 {
     
-    NSMutableArray *array1 = [self arrayForSection:indexPath1.section];
-    NSMutableArray *array2 = [self arrayForSection:indexPath2.section];
+    // The model is an SSCollectionViewExchangeInt64Store, all twelve items in one C buffer. Exchanging
+    // two items, even in different sections, swaps two int64_t values in place and adjusts the sums
+    // of both sections. If your model is an array for each section use SSCollectionViewExchangeArrayStore,
+    // or the NSMutableArray category directly, instead...
     
-    // as defined in the NSMutableArray category, can exchange items in different arrays...
-    [NSMutableArray exchangeObjectInArray:array1
-                                  atIndex:indexPath1.item
-                   withObjectInOtherArray:array2
-                                  atIndex:indexPath2.item];
+    SSExchangeSwap swap = SSExchangeSwapMake(SSExchangeIndexPathFromNSIndexPath(indexPath1),
+                                             SSExchangeIndexPathFromNSIndexPath(indexPath2));
+    [self.model exchangeItemsWithSwaps:&swap count:1];
     
 }
 
 - (void)prepareForUndoWithIndexPath1:(NSIndexPath *)indexPath1 indexPath2:(NSIndexPath *)indexPath2 {
     
-    if (![indexPath1 isEqual:indexPath2]) {
-        
-        self.indexPath1ForLastExchange = indexPath1;
-        self.indexPath2ForLastExchange = indexPath2;
-        [self saveIndexPaths];
-        [self.undoButton setTitle:kUndoText forState:UIControlStateNormal];
-        
-    }
+    // Exchanges of nothing, when the index paths are the same, are ignored by the history...
+    SSExchangeHistoryRecord(self.history, SSExchangeSwapMake(SSExchangeIndexPathFromNSIndexPath(indexPath1),
+                                                             SSExchangeIndexPathFromNSIndexPath(indexPath2)));
+    [self updateUndoAndRedoButtons];
+    
 }
 
 - (IBAction)undo:(id)sender {
@@ -443,89 +502,113 @@ NS_ENUM(NSInteger, CollectionViewSection) {
     // Demonstrates how undo is enabled by the
     // exchangeControllerDidFinishExchangeTransaction:withIndexPath1:indexPath2:: delegate method.
     
-    if (self.indexPath1ForLastExchange != nil) {
-        
-        [self.collectionView performBatchUpdates:^ {
-            
-            [self.collectionView moveItemAtIndexPath:self.indexPath1ForLastExchange toIndexPath:self.indexPath2ForLastExchange];
-            [self.collectionView moveItemAtIndexPath:self.indexPath2ForLastExchange toIndexPath:self.indexPath1ForLastExchange];
-            
-        }
-                                      completion:^(BOOL finished) {
-                                          
-                                          [self exchangeItemAtIndexPath1:self.indexPath1ForLastExchange
-                                                    withItemAtIndexPath2:self.indexPath2ForLastExchange];
-                                          [self saveModel];
-                                          [self updateSumLabels];
-                                          
-                                          [self logModel];
-                                          
-                                      }];
-        
-        NSString *title = ([[self.undoButton titleForState:UIControlStateNormal] isEqualToString:kUndoText])? kRedoText : kUndoText;
-        [self.undoButton setTitle:title forState:UIControlStateNormal];
-        [self saveControlStates];
-    }
+    [self undoSteps:1];
+    
 }
 
-- (IBAction)reset:(id)sender {
+- (IBAction)redo:(id)sender {
     
-    [self useDefaultModel];
-    [self saveModel];
-    [self logModel];
+    [self redoSteps:1];
     
-    [self.collectionView reloadData];
-    [self updateSumLabels];
+}
+
+- (void)undoAll:(UILongPressGestureRecognizer *)gestureRecognizer {
+    
+    if (gestureRecognizer.state == UIGestureRecognizerStateBegan) [self undoSteps:UINT_MAX];
     
-    [self.undoButton setTitle:kUndoText forState:UIControlStateNormal];
-    self.indexPath1ForLastExchange = nil;
-    self.indexPath2ForLastExchange = nil;
-    [self saveIndexPaths];
 }
 
-- (NSMutableArray *)arrayForSection:(NSUInteger)section {
+- (void)redoAll:(UILongPressGestureRecognizer *)gestureRecognizer {
+    
+    if (gestureRecognizer.state == UIGestureRecognizerStateBegan) [self redoSteps:UINT_MAX];
     
-    // Normally each section of a collection view has its own array. This is a simple example of how
-    // you might map your sections to actual arrays. Using a technique like this simplifies the
-    // implementation of the exchangeItemAtIndexPath1:withItemAtIndexPath2: method.
+}
+
+- (void)undoSteps:(unsigned int)numberOfSteps {
     
-    // If your collection view is represented by a single array you won't need a method like this.
+    unsigned int count = MIN(numberOfSteps, SSExchangeHistoryNumberOfUndos(self.history));
+    if (count == 0) return;
     
-    NSMutableArray *array;
+    SSExchangeSwap *swaps = malloc(count * sizeof(SSExchangeSwap));
+    count = SSExchangeHistoryUndo(self.history, count, swaps);
+    [self performExchangesWithSwaps:swaps count:count];
+    free(swaps);
     
-    switch (section) {
-            
-        case CollectionViewSectionLeft:
-            array = self.leftSide;
-            break;
-            
-        case CollectionViewSectionMiddle:
-            array = self.middle;
-            break;
-            
-        case CollectionViewSectionRight:
-            array = self.rightSide;
-            break;
-    }
-    return array;
 }
 
-- (NSInteger)sumArray:(NSArray *)array {
+- (void)redoSteps:(unsigned int)numberOfSteps {
+    
+    unsigned int count = MIN(numberOfSteps, SSExchangeHistoryNumberOfRedos(self.history));
+    if (count == 0) return;
     
-    NSInteger sum = 0;
-    for (NSNumber *number in array) {
-        sum += [number integerValue];
+    SSExchangeSwap *swaps = malloc(count * sizeof(SSExchangeSwap));
+    count = SSExchangeHistoryRedo(self.history, count, swaps);
+    [self performExchangesWithSwaps:swaps count:count];
+    free(swaps);
+    
+}
+
+- (void)performExchangesWithSwaps:(const SSExchangeSwap *)swaps count:(unsigned int)count {
+    
+    // However many steps are being undone or redone there is only one animation. The swaps are
+    // composed into the net moves, so an item that is exchanged many times moves just once, and
+    // the model and the collection view are updated together in a single batch...
+    
+    SSExchangeMove *moves = malloc(2 * count * sizeof(SSExchangeMove));
+    unsigned int numberOfMoves = SSExchangeHistoryComposeSwaps(self.history, swaps, count, moves);
+    
+    [self.collectionView performBatchUpdates:^ {
+        
+        [self.model exchangeItemsWithSwaps:swaps count:count];
+        
+        for (unsigned int i = 0; i < numberOfMoves; i++) {
+            [self.collectionView moveItemAtIndexPath:NSIndexPathFromSSExchangeIndexPath(moves[i].fromIndexPath)
+                                         toIndexPath:NSIndexPathFromSSExchangeIndexPath(moves[i].toIndexPath)];
+        }
+        
     }
-    return sum;
+                                  completion:^(BOOL finished) {
+                                      
+                                      [self updateSumLabels];
+                                      [self logModel];
+                                      
+                                  }];
+    
+    free(moves);
+    
+    [self.journal appendSwaps:swaps count:count];
+    [self updateUndoAndRedoButtons];
+    
+}
+
+- (void)updateUndoAndRedoButtons {
+    
+    self.undoButton.enabled = (SSExchangeHistoryNumberOfUndos(self.history) > 0);
+    self.redoButton.enabled = (SSExchangeHistoryNumberOfRedos(self.history) > 0);
+    
+}
+
+- (IBAction)reset:(id)sender {
+    
+    [self useDefaultModel];
+    [self.journal writeSnapshot];
+    [self logModel];
+    
+    [self.collectionView reloadData];
+    [self updateSumLabels];
+    
+    SSExchangeHistoryRemoveAll(self.history);
+    [self updateUndoAndRedoButtons];
 }
 
 - (void)updateSumLabels {
     
     // Demonstrates how live updating is enabled by the exchangeControllerDidFinishExchangeEvent: delegate method.
+    // The store keeps each section's sum as items are exchanged so nothing is added up here.
     
-    self.sumLeft.text =     [NSString stringWithFormat:@"%ld", (long)[self sumArray:self.leftSide]];
-    self.sumMiddle.text =   [NSString stringWithFormat:@"%ld", (long)[self sumArray:self.middle]];
-    self.sumRight.text =    [NSString stringWithFormat:@"%ld", (long)[self sumArray:self.rightSide]];
+    self.sumLeft.text =     [NSString stringWithFormat:@"%lld", [self.model sumOfItemsInSection:0]];
+    self.sumMiddle.text =   [NSString stringWithFormat:@"%lld", [self.model sumOfItemsInSection:1]];
+    self.sumRight.text =    [NSString stringWithFormat:@"%lld", [self.model sumOfItemsInSection:2]];
 }
 
 - (void)logModel {
@@ -533,19 +616,24 @@ NS_ENUM(NSInteger, CollectionViewSection) {
     // so you can verify that the model is staying in sync with the changes occurring on the view...
     
     NSLog(@" ");
-    NSLog(@"self.leftSide   |    self.middle    |    self.rightSide");
+    NSLog(@"   section 0    |     section 1     |     section 2");
     
-    for (int i=0; i<[self.leftSide count]; i++) {
-        NSLog(@"          %@     |         %@        |          %@", self.leftSide[i], self.middle[i], self.rightSide[i]);
-    }
+    const int64_t *leftSide =   [self.model itemsInSection:0];
+    const int64_t *middle =     [self.model itemsInSection:1];
+    const int64_t *rightSide =  [self.model itemsInSection:2];
     
-    NSInteger sumLeft =     [self sumArray:self.leftSide];
-    NSInteger sumMiddle =   [self sumArray:self.middle];
-    NSInteger sumRight =    [self sumArray:self.rightSide];
+    for (int i=0; i<[self.model numberOfItemsInSection:0]; i++) {
+        NSLog(@"          %lld     |         %lld        |          %lld", leftSide[i], middle[i], rightSide[i]);
+    }
     
     NSLog(@" ");
-    NSLog(@" sumLeft= %ld        sumMiddle= %ld      sumRight= %ld", (long)sumLeft, (long)sumMiddle, (long)sumRight);
+    NSLog(@" sumLeft= %lld        sumMiddle= %lld      sumRight= %lld",
+          [self.model sumOfItemsInSection:0], [self.model sumOfItemsInSection:1], [self.model sumOfItemsInSection:2]);
     NSLog(@" ");
+    
+    if (self.instrumentation) {
+        NSLog(@"\n%@", [self.instrumentation summary]);
+    }
 }
 
 
@@ -564,16 +652,16 @@ NS_ENUM(NSInteger, CollectionViewSection) {
     
     if (sender.on) {
         
-        NSArray *arrays = @[self.leftSide, self.middle, self.rightSide];
-        
         NSMutableSet *excludingIndexPaths = [[NSMutableSet alloc] init];
         [excludingIndexPaths addObjectIfNotNil:self.indexPathForLockedItem];
-        [excludingIndexPaths addObjectIfNotNil:self.indexPath1ForLastExchange];
-        [excludingIndexPaths addObjectIfNotNil:self.indexPath2ForLastExchange];
         [excludingIndexPaths addObjectIfNotNil:self.indexPath1ForConditionalDisplacement];
         [excludingIndexPaths addObjectIfNotNil:self.indexPath2ForConditionalDisplacement];
         
-        self.indexPathForLockedItem = [NSIndexPath randomIndexPathInArrays:arrays excludingIndexPaths:excludingIndexPaths];
+        self.indexPathForLockedItem = [NSIndexPath randomIndexPathInBackingStore:self.model excludingIndexPaths:excludingIndexPaths];
+        
+        // Undoing could move the locked item so the history is forgotten...
+        SSExchangeHistoryRemoveAll(self.history);
+        [self updateUndoAndRedoButtons];
         
     } else {
         
@@ -591,16 +679,17 @@ NS_ENUM(NSInteger, CollectionViewSection) {
     
     if (sender.on) {
         
-        NSArray *arrays = @[self.leftSide, self.middle, self.rightSide];
-        
         NSMutableSet *excludingIndexPaths = [[NSMutableSet alloc] init];
         [excludingIndexPaths addObjectIfNotNil:self.indexPathForLockedItem];
-        [excludingIndexPaths addObjectIfNotNil:self.indexPath1ForLastExchange];
-        [excludingIndexPaths addObjectIfNotNil:self.indexPath2ForLastExchange];
-        self.indexPath1ForConditionalDisplacement =[NSIndexPath randomIndexPathInArrays:arrays excludingIndexPaths:excludingIndexPaths];
         
-        [excludingIndexPaths addObjectIfNotNil:self.indexPath1ForConditionalDisplacement];
-        self.indexPath2ForConditionalDisplacement = [NSIndexPath randomIndexPathInArrays:arrays excludingIndexPaths:excludingIndexPaths];
+        // Two distinct items from one sampler...
+        RandomIndexPathSampler *sampler = [[RandomIndexPathSampler alloc] initWithBackingStore:self.model excludingIndexPaths:excludingIndexPaths];
+        self.indexPath1ForConditionalDisplacement = [sampler removeRandomIndexPath];
+        self.indexPath2ForConditionalDisplacement = [sampler removeRandomIndexPath];
+        
+        // Undoing could exchange the two items so the history is forgotten...
+        SSExchangeHistoryRemoveAll(self.history);
+        [self updateUndoAndRedoButtons];
         
     } else {
         
@@ -661,7 +750,6 @@ NS_ENUM(NSInteger, CollectionViewSection) {
     self.lockItemSwitch.on = NO;
     self.catchRectangleSwitch.on = NO;
     self.minimumPressDurationSlider.value = 0.15;
-    [self.undoButton setTitle:kUndoText forState:UIControlStateNormal];
     
 }
 
@@ -672,9 +760,6 @@ NS_ENUM(NSInteger, CollectionViewSection) {
     defaultForBool(self.lockItemSwitch.on);
     defaultForBool(self.catchRectangleSwitch.on);
     defaultForFloat(self.minimumPressDurationSlider.value);
-    NSString *undoButtonTitle;
-    defaultForString(undoButtonTitle);
-    [self.undoButton setTitle:undoButtonTitle forState:UIControlStateNormal];
     
 }
 
@@ -685,8 +770,6 @@ NS_ENUM(NSInteger, CollectionViewSection) {
     setDefaultForBool(self.lockItemSwitch.on);
     setDefaultForBool(self.catchRectangleSwitch.on);
     setDefaultForFloat(self.minimumPressDurationSlider.value);
-    NSString *undoButtonTitle = [self.undoButton titleForState:UIControlStateNormal];
-    setDefaultForObject(undoButtonTitle);
     
 }
 
@@ -695,8 +778,6 @@ NS_ENUM(NSInteger, CollectionViewSection) {
     self.indexPathForLockedItem = [self unarchiveObjectWithFileName:NS_STRINGIFY(_indexPathForLockedItem)];
     self.indexPath1ForConditionalDisplacement = [self unarchiveObjectWithFileName:NS_STRINGIFY(_indexPath1ForConditionalDisplacement)];
     self.indexPath2ForConditionalDisplacement = [self unarchiveObjectWithFileName:NS_STRINGIFY(_indexPath2ForConditionalDisplacement)];
-    self.indexPath1ForLastExchange = [self unarchiveObjectWithFileName:NS_STRINGIFY(_indexPath1ForLastExchange)];
-    self.indexPath2ForLastExchange = [self unarchiveObjectWithFileName:NS_STRINGIFY(_indexPath2ForLastExchange)];
     
 }
 
@@ -705,8 +786,6 @@ NS_ENUM(NSInteger, CollectionViewSection) {
     [self archiveObject:self.indexPathForLockedItem toDocumentDirectoryWithFileName:NS_STRINGIFY(_indexPathForLockedItem)];
     [self archiveObject:self.indexPath1ForConditionalDisplacement toDocumentDirectoryWithFileName:NS_STRINGIFY(_indexPath1ForConditionalDisplacement)];
     [self archiveObject:self.indexPath2ForConditionalDisplacement toDocumentDirectoryWithFileName:NS_STRINGIFY(_indexPath2ForConditionalDisplacement)];
-    [self archiveObject:self.indexPath1ForLastExchange toDocumentDirectoryWithFileName:NS_STRINGIFY(_indexPath1ForLastExchange)];
-    [self archiveObject:self.indexPath2ForLastExchange toDocumentDirectoryWithFileName:NS_STRINGIFY(_indexPath2ForLastExchange)];
     
 }
 
@@ -716,25 +795,67 @@ NS_ENUM(NSInteger, CollectionViewSection) {
     NSArray *temp2 =   @[ @5,  @6,  @7,  @8  ];
     NSArray *temp3 =   @[ @9,  @10, @11, @12 ];
     
-    self.leftSide = [NSMutableArray arrayWithArray:temp1];
-    self.middle = [NSMutableArray arrayWithArray:temp2];
-    self.rightSide = [NSMutableArray arrayWithArray:temp3];
+    self.model = [[SSCollectionViewExchangeInt64Store alloc] initWithArrays:@[ temp1, temp2, temp3 ]];
     
 }
 
 - (void)useSavedModel {
     
-    defaultForMutableArray(_leftSide);
-    defaultForMutableArray(_middle);
-    defaultForMutableArray(_rightSide);
+    // Earlier versions of this app kept an array for each section, saved with these names...
+    NSArray *_leftSide, *_middle, *_rightSide;
+    defaultForArray(_leftSide);
+    defaultForArray(_middle);
+    defaultForArray(_rightSide);
+    
+    if (_leftSide && _middle && _rightSide) {
+        self.model = [[SSCollectionViewExchangeInt64Store alloc] initWithArrays:@[ _leftSide, _middle, _rightSide ]];
+    }
+    
+    if (self.model == nil) [self useDefaultModel];
+    
+}
+
+- (void)prepareJournal {
+    
+    // Rather than saving the whole model after every exchange transaction the journal logs just
+    // the exchange. Every so often it asks for a snapshot of the whole model and starts over.
+    
+    NSString *directoryPath = [self filePathInDocumentsForFileName:kJournalDirectoryName];
+    self.journal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:directoryPath];
+    self.journal.snapshotProvider = self;
+    
+}
+
+- (BOOL)useJournaledModel {
+    
+    NSData *snapshotData = [self.journal snapshotData];
+    if (snapshotData == nil) return NO;
+    
+    // The snapshot is the store's own buffer...
+    self.model = [[SSCollectionViewExchangeInt64Store alloc] initWithData:snapshotData];
+    if (self.model == nil) return NO;
+    
+    // Then apply every exchange since the snapshot...
+    SSCollectionViewExchangeInt64Store *model = self.model;
+    __block BOOL replayed = YES;
+    
+    [self.journal replayExchangesWithBlock:^(const SSExchangeSwap *swaps, NSUInteger count) {
+        
+        replayed = [model exchangeItemsWithSwaps:swaps count:count];
+        
+    }];
+    
+    // A log that doesn't fit the snapshot changed nothing. Start over from the snapshot so later
+    // exchanges aren't appended to a log that can never be replayed...
+    if (!replayed) [self.journal writeSnapshot];
+    
+    return YES;
     
 }
 
-- (void)saveModel {
+- (NSData *)snapshotDataForExchangeJournal:(SSCollectionViewExchangeJournal *)exchangeJournal {
     
-    setDefaultForObject(_leftSide);
-    setDefaultForObject(_middle);
-    setDefaultForObject(_rightSide);
+    return [self.model data];
     
 }
 
@@ -0,0 +1,82 @@
+//
+//  SSCollectionViewExchangeAllocationCounter.c
+//  Exchanger
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include "SSCollectionViewExchangeAllocationCounter.h"
+
+#include <stddef.h>
+
+
+#if defined(__GLIBC__)
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+
+static uint64_t SSExchangeAllocationCounterCount;
+
+void *malloc(size_t size) {
+
+    __atomic_fetch_add(&SSExchangeAllocationCounterCount, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+
+    __atomic_fetch_add(&SSExchangeAllocationCounterCount, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) {
+
+    __atomic_fetch_add(&SSExchangeAllocationCounterCount, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(pointer, size);
+}
+
+bool SSExchangeAllocationCounterIsAvailable(void) {
+
+    return true;
+}
+
+uint64_t SSExchangeAllocationCounterNumberOfAllocations(void) {
+
+    return __atomic_load_n(&SSExchangeAllocationCounterCount, __ATOMIC_RELAXED);
+}
+
+#else
+
+bool SSExchangeAllocationCounterIsAvailable(void) {
+
+    return false;
+}
+
+uint64_t SSExchangeAllocationCounterNumberOfAllocations(void) {
+
+    return 0;
+}
+
+#endif
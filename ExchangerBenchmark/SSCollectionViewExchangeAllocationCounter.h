@@ -0,0 +1,59 @@
+//
+//  SSCollectionViewExchangeAllocationCounter.h
+//  Exchanger
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// Counts every allocation in the process, including those made inside Foundation and the
+// Objective-C runtime, so the replay benchmark can report allocations per touch.
+//
+// With glibc, the C library on Linux, malloc(), calloc() and realloc() are defined here and
+// forward to glibc's own. Functions defined in the executable take the place of the shared
+// library's everywhere in the process, so nothing else needs to change. Elsewhere nothing is
+// counted.
+
+#ifndef SSCollectionViewExchangeAllocationCounter_h
+#define SSCollectionViewExchangeAllocationCounter_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+bool SSExchangeAllocationCounterIsAvailable(void);
+
+uint64_t SSExchangeAllocationCounterNumberOfAllocations(void);
+// The number of allocations so far, or 0 if they aren't counted. Matches the numberOfAllocations
+// hook of SSExchangeReplayHooks.
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
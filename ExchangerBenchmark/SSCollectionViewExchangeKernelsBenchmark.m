@@ -0,0 +1,388 @@
+//
+//  SSCollectionViewExchangeKernelsBenchmark.m
+//  Exchanger
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// Compares the value kernels in SSCollectionViewExchangeValueKernels.h with the boxed path they
+// replace, NSMutableArray+SSCollectionViewExchangeControllerAdditions, for every value type. The
+// same batch swaps, moves, whole section permutation and sums are applied to NSMutableArrays of
+// NSNumbers and to plain buffers, then checked against each other. Only Foundation is used, so
+// with GNUstep this builds and runs headlessly on Linux. Refer to GNUmakefile.
+//
+//      exchanger-kernels [--values N] [--swaps N] [--moves N] [--large-values N] [--seed N]
+//
+// N values (default 100000) are put in each of 3 sections. A few moves in one large int64 section
+// of --large-values values (default 10000000) are then timed against the same rearrangement done
+// with swaps, since the cost of a small move should not grow with the section. The exit status is
+// 1 if the kernels ever disagree with the boxed path or with each other.
+
+#import <Foundation/Foundation.h>
+#import "NSMutableArray+SSCollectionViewExchangeControllerAdditions.h"
+#import "SSCollectionViewExchangeValueKernels.h"
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+
+static const size_t numberOfSections = 3;
+
+static const SSExchangeValueType valueTypes[] = {
+    SSExchangeValueTypeInt32,
+    SSExchangeValueTypeInt64,
+    SSExchangeValueTypeFloat,
+    SSExchangeValueTypeDouble
+};
+
+static const char *const valueTypeNames[] = { "int32", "int64", "float", "double" };
+
+
+static uint64_t Time(void) {
+
+#ifdef __APPLE__
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) mach_timebase_info(&timebase);
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static uint32_t Random(uint32_t *seed, uint32_t upperBound) {
+
+    *seed = *seed * 1664525 + 1013904223;
+    return (*seed >> 8) % upperBound;
+}
+
+static double ValueAtIndex(SSExchangeValueType type, const void *values, size_t index) {
+
+    switch (type) {
+        case SSExchangeValueTypeInt32:  return ((const int32_t *)values)[index];
+        case SSExchangeValueTypeInt64:  return (double)((const int64_t *)values)[index];
+        case SSExchangeValueTypeFloat:  return ((const float *)values)[index];
+        case SSExchangeValueTypeDouble: return ((const double *)values)[index];
+    }
+    return 0.0;
+}
+
+static void SetValueAtIndex(SSExchangeValueType type, void *values, size_t index, size_t value) {
+
+    switch (type) {
+        case SSExchangeValueTypeInt32:  ((int32_t *)values)[index] = (int32_t)value; break;
+        case SSExchangeValueTypeInt64:  ((int64_t *)values)[index] = (int64_t)value; break;
+        case SSExchangeValueTypeFloat:  ((float *)values)[index] = (float)value; break;
+        case SSExchangeValueTypeDouble: ((double *)values)[index] = (double)value; break;
+    }
+}
+
+static BOOL ValuesMatchArrays(SSExchangeValueType type, void *const *sections, NSArray *arrays, size_t numberOfValues) {
+
+    for (size_t section = 0; section < numberOfSections; section++) {
+        NSArray *array = arrays[ section ];
+        for (size_t i = 0; i < numberOfValues; i++) {
+            if (ValueAtIndex(type, sections[section], i) != [array[ i ] doubleValue]) return NO;
+        }
+    }
+    return YES;
+}
+
+static void PrintResult(const char *operation, SSExchangeValueType type, uint64_t boxedDuration, uint64_t kernelDuration, BOOL matched) {
+
+    printf("%-12s %-7s boxed %12llu ns   kernel %12llu ns   %7.1fx%s\n",
+           operation,
+           valueTypeNames[type],
+           (unsigned long long)boxedDuration,
+           (unsigned long long)kernelDuration,
+           (kernelDuration > 0)? (double)boxedDuration / kernelDuration : 0.0,
+           (matched)? "" : "   MISMATCH");
+}
+
+
+static BOOL BenchmarkType(SSExchangeValueType type, size_t numberOfValues, size_t numberOfSwaps, size_t numberOfMoves, uint32_t seed) {
+
+    size_t size = SSExchangeValueTypeSize(type);
+    size_t numbersOfValues[numberOfSections];
+    void *sections[numberOfSections];
+    NSMutableArray *arrays = [[NSMutableArray alloc] init];
+
+    for (size_t section = 0; section < numberOfSections; section++) {
+        numbersOfValues[section] = numberOfValues;
+        sections[section] = malloc(MAX(numberOfValues, 1) * size);
+        NSMutableArray *array = [[NSMutableArray alloc] initWithCapacity:numberOfValues];
+        for (size_t i = 0; i < numberOfValues; i++) {
+            size_t value = section * numberOfValues + i;
+            SetValueAtIndex(type, sections[section], i, value);
+            [array addObject:@(value)];
+        }
+        [arrays addObject:array];
+    }
+
+    SSExchangeSwap *swaps = malloc(MAX(numberOfSwaps, 1) * sizeof(SSExchangeSwap));
+    SSExchangeMove *moves = malloc(MAX(numberOfMoves, 1) * sizeof(SSExchangeMove));
+    uint32_t *sourceIndices = malloc(MAX(numberOfValues, 1) * sizeof(uint32_t));
+    uint32_t *destinations = malloc(MAX(numberOfSections * numberOfValues, 1) * sizeof(uint32_t));
+    SSExchangeValueSum sums[numberOfSections];
+    BOOL passed = YES;
+
+    // Swaps...
+    for (size_t i = 0; i < numberOfSwaps; i++) {
+        swaps[i] = SSExchangeSwapMake(SSExchangeIndexPathMake((int32_t)Random(&seed, (uint32_t)numberOfSections), (int32_t)Random(&seed, (uint32_t)numberOfValues)),
+                                      SSExchangeIndexPathMake((int32_t)Random(&seed, (uint32_t)numberOfSections), (int32_t)Random(&seed, (uint32_t)numberOfValues)));
+    }
+    for (size_t section = 0; section < numberOfSections; section++) {
+        sums[section] = SSExchangeValuesSum(type, sections[section], numberOfValues);
+    }
+
+    uint64_t start = Time();
+    BOOL exchanged = [NSMutableArray exchangeObjectsInArrays:arrays withSwaps:swaps count:numberOfSwaps];
+    uint64_t boxedDuration = Time() - start;
+
+    start = Time();
+    exchanged = SSExchangeValuesExchange(type, sections, numbersOfValues, numberOfSections, swaps, numberOfSwaps, sums) && exchanged;
+    uint64_t kernelDuration = Time() - start;
+
+    BOOL matched = exchanged && ValuesMatchArrays(type, sections, arrays, numberOfValues);
+    for (size_t section = 0; section < numberOfSections; section++) {
+        SSExchangeValueSum sum = SSExchangeValuesSum(type, sections[section], numberOfValues);
+        if (memcmp(&sum, &sums[section], sizeof(sum)) != 0) matched = NO;
+    }
+    PrintResult("batch swap", type, boxedDuration, kernelDuration, matched);
+    passed = passed && matched;
+
+    // Moves, a permutation of randomly chosen index paths across sections...
+    size_t numberOfIndexPaths = numberOfSections * numberOfValues;
+    numberOfMoves = MIN(numberOfMoves, numberOfIndexPaths);
+    for (size_t i = 0; i < numberOfIndexPaths; i++) destinations[i] = (uint32_t)i;
+    for (size_t i = 0; i < numberOfMoves; i++) {
+        size_t j = i + Random(&seed, (uint32_t)(numberOfIndexPaths - i));
+        uint32_t destination = destinations[i];
+        destinations[i] = destinations[j];
+        destinations[j] = destination;
+    }
+
+    NSMutableArray *fromIndexPaths = [[NSMutableArray alloc] initWithCapacity:numberOfMoves];
+    NSMutableArray *toIndexPaths = [[NSMutableArray alloc] initWithCapacity:numberOfMoves];
+    for (size_t i = 0; i < numberOfMoves; i++) {
+        uint32_t from = destinations[i];
+        uint32_t to = destinations[(i + 1) % numberOfMoves];
+        moves[i].fromIndexPath = SSExchangeIndexPathMake((int32_t)(from / numberOfValues), (int32_t)(from % numberOfValues));
+        moves[i].toIndexPath = SSExchangeIndexPathMake((int32_t)(to / numberOfValues), (int32_t)(to % numberOfValues));
+        [fromIndexPaths addObject:[NSIndexPath indexPathWithIndexes:(NSUInteger[]){ from / numberOfValues, from % numberOfValues } length:2]];
+        [toIndexPaths addObject:[NSIndexPath indexPathWithIndexes:(NSUInteger[]){ to / numberOfValues, to % numberOfValues } length:2]];
+    }
+
+    start = Time();
+    BOOL moved = [NSMutableArray moveObjectsInArrays:arrays fromIndexPaths:fromIndexPaths toIndexPaths:toIndexPaths];
+    boxedDuration = Time() - start;
+
+    start = Time();
+    moved = SSExchangeValuesMove(type, sections, numbersOfValues, numberOfSections, moves, numberOfMoves, sums) && moved;
+    kernelDuration = Time() - start;
+
+    matched = moved && ValuesMatchArrays(type, sections, arrays, numberOfValues);
+    PrintResult("moves", type, boxedDuration, kernelDuration, matched);
+    passed = passed && matched;
+
+    // A whole section permutation, as from sorting or shuffling section 0...
+    for (size_t i = 0; i < numberOfValues; i++) sourceIndices[i] = (uint32_t)i;
+    for (size_t i = numberOfValues; i > 1; i--) {
+        size_t j = Random(&seed, (uint32_t)i);
+        uint32_t index = sourceIndices[i - 1];
+        sourceIndices[i - 1] = sourceIndices[j];
+        sourceIndices[j] = index;
+    }
+
+    [fromIndexPaths removeAllObjects];
+    [toIndexPaths removeAllObjects];
+    for (size_t i = 0; i < numberOfValues; i++) {
+        [fromIndexPaths addObject:[NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 0, sourceIndices[i] } length:2]];
+        [toIndexPaths addObject:[NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 0, i } length:2]];
+    }
+
+    start = Time();
+    BOOL permuted = [NSMutableArray moveObjectsInArrays:arrays fromIndexPaths:fromIndexPaths toIndexPaths:toIndexPaths];
+    boxedDuration = Time() - start;
+
+    start = Time();
+    permuted = SSExchangeValuesPermute(type, sections[0], numberOfValues, sourceIndices) && permuted;
+    kernelDuration = Time() - start;
+
+    matched = permuted && ValuesMatchArrays(type, sections, arrays, numberOfValues);
+    PrintResult("permutation", type, boxedDuration, kernelDuration, matched);
+    passed = passed && matched;
+
+    // Sums, recalculated from scratch...
+    double boxedSums[numberOfSections];
+    start = Time();
+    for (size_t section = 0; section < numberOfSections; section++) {
+        double sum = 0.0;
+        for (NSNumber *number in arrays[ section ]) sum += [number doubleValue];
+        boxedSums[section] = sum;
+    }
+    boxedDuration = Time() - start;
+
+    start = Time();
+    for (size_t section = 0; section < numberOfSections; section++) {
+        sums[section] = SSExchangeValuesSum(type, sections[section], numberOfValues);
+    }
+    kernelDuration = Time() - start;
+
+    // The values are whole numbers well under 2^53, so every sum is exact.
+    matched = YES;
+    for (size_t section = 0; section < numberOfSections; section++) {
+        BOOL isInteger = (type == SSExchangeValueTypeInt32 || type == SSExchangeValueTypeInt64);
+        double sum = (isInteger)? (double)sums[section].integerSum : sums[section].doubleSum;
+        if (sum != boxedSums[section]) matched = NO;
+    }
+    PrintResult("sums", type, boxedDuration, kernelDuration, matched);
+    passed = passed && matched;
+
+    for (size_t section = 0; section < numberOfSections; section++) free(sections[section]);
+    free(swaps);
+    free(moves);
+    free(sourceIndices);
+    free(destinations);
+    return passed;
+}
+
+static BOOL BenchmarkFewMovesInLargeSection(size_t numberOfValues, uint32_t seed) {
+
+    static const size_t numberOfCalls = 100000;
+
+    int64_t *values = malloc(numberOfValues * sizeof(int64_t));
+    if (values == NULL) {
+        fprintf(stderr, "can't allocate %zu int64 values\n", numberOfValues);
+        return NO;
+    }
+    for (size_t i = 0; i < numberOfValues; i++) values[i] = (int64_t)i;
+    void *sections[1] = { values };
+    size_t numbersOfValues[1] = { numberOfValues };
+
+    // A cycle of 4 distinct values, as a list of moves and as the 3 swaps that do the same...
+    int32_t items[4];
+    for (size_t i = 0; i < 4; i++) {
+        BOOL isRepeat;
+        do {
+            items[i] = (int32_t)Random(&seed, (uint32_t)numberOfValues);
+            isRepeat = NO;
+            for (size_t j = 0; j < i; j++) if (items[j] == items[i]) isRepeat = YES;
+        } while (isRepeat);
+    }
+
+    SSExchangeMove moves[4];
+    for (size_t i = 0; i < 4; i++) {
+        moves[i].fromIndexPath = SSExchangeIndexPathMake(0, items[i]);
+        moves[i].toIndexPath = SSExchangeIndexPathMake(0, items[(i + 1) % 4]);
+    }
+    SSExchangeSwap swaps[3];
+    for (size_t i = 0; i < 3; i++) {
+        swaps[i] = SSExchangeSwapMake(SSExchangeIndexPathMake(0, items[0]), SSExchangeIndexPathMake(0, items[i + 1]));
+    }
+
+    SSExchangeValueSum sums[1] = { SSExchangeValuesSum(SSExchangeValueTypeInt64, values, numberOfValues) };
+    SSExchangeValueSum startSum = sums[0];
+    BOOL passed = YES;
+
+    // Every 4 calls go round the cycle once, so the section ends up as it started.
+    uint64_t start = Time();
+    for (size_t call = 0; call < numberOfCalls; call++) {
+        passed = SSExchangeValuesMove(SSExchangeValueTypeInt64, sections, numbersOfValues, 1, moves, 4, sums) && passed;
+    }
+    uint64_t moveDuration = Time() - start;
+
+    start = Time();
+    for (size_t call = 0; call < numberOfCalls; call++) {
+        passed = SSExchangeValuesExchange(SSExchangeValueTypeInt64, sections, numbersOfValues, 1, swaps, 3, sums) && passed;
+    }
+    uint64_t swapDuration = Time() - start;
+
+    for (size_t i = 0; i < 4; i++) {
+        if (values[items[i]] != items[i]) passed = NO;
+    }
+    if (memcmp(&sums[0], &startSum, sizeof(startSum)) != 0) passed = NO;
+
+    printf("%-12s %-7s moves %10.1f ns/call   swaps %10.1f ns/call   (%zu values)%s\n",
+           "few moves",
+           valueTypeNames[SSExchangeValueTypeInt64],
+           (double)moveDuration / numberOfCalls,
+           (double)swapDuration / numberOfCalls,
+           numberOfValues,
+           (passed)? "" : "   MISMATCH");
+
+    free(values);
+    return passed;
+}
+
+
+int main(int argc, const char *argv[]) {
+
+    @autoreleasepool {
+
+        size_t numberOfValues = 100000;
+        size_t numberOfSwaps = 1000000;
+        size_t numberOfMoves = 100000;
+        size_t numberOfLargeValues = 10000000;
+        uint32_t seed = 1;
+
+        for (int i = 1; i < argc; i++) {
+            BOOL hasValue = (i + 1 < argc);
+            if (hasValue && strcmp(argv[i], "--values") == 0)       numberOfValues = strtoul(argv[++i], NULL, 10);
+            else if (hasValue && strcmp(argv[i], "--swaps") == 0)   numberOfSwaps = strtoul(argv[++i], NULL, 10);
+            else if (hasValue && strcmp(argv[i], "--moves") == 0)   numberOfMoves = strtoul(argv[++i], NULL, 10);
+            else if (hasValue && strcmp(argv[i], "--large-values") == 0) numberOfLargeValues = strtoul(argv[++i], NULL, 10);
+            else if (hasValue && strcmp(argv[i], "--seed") == 0)    seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+            else {
+                fprintf(stderr, "usage: %s [--values N] [--swaps N] [--moves N] [--large-values N] [--seed N]\n", argv[0]);
+                return 2;
+            }
+        }
+
+        // Flat indices across the sections are kept in 32 bits, and every value must be exact in a float.
+        if (numberOfValues == 0 || numberOfValues * numberOfSections > (1 << 24)) {
+            fprintf(stderr, "--values must be from 1 to %d\n", (1 << 24) / (int)numberOfSections);
+            return 2;
+        }
+        if (numberOfLargeValues < 4 || numberOfLargeValues > INT32_MAX) {
+            fprintf(stderr, "--large-values must be from 4 to %d\n", INT32_MAX);
+            return 2;
+        }
+
+        BOOL passed = YES;
+        for (size_t i = 0; i < sizeof(valueTypes) / sizeof(valueTypes[0]); i++) {
+            @autoreleasepool {
+                if (BenchmarkType(valueTypes[i], numberOfValues, numberOfSwaps, numberOfMoves, seed) == NO) passed = NO;
+            }
+        }
+        if (BenchmarkFewMovesInLargeSection(numberOfLargeValues, seed) == NO) passed = NO;
+
+        if (passed == NO) fprintf(stderr, "FAIL: the kernels disagree with the boxed path or each other\n");
+        return (passed)? 0 : 1;
+    }
+}
@@ -0,0 +1,502 @@
+//
+//  SSCollectionViewExchangeReplay.c
+//  Exchanger
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// clock_gettime and CLOCK_MONOTONIC are POSIX, so they need declaring under -std=c99.
+#define _POSIX_C_SOURCE 200809L
+
+#include "SSCollectionViewExchangeReplay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+
+struct SSExchangeReplay {
+    size_t              numberOfSections;
+    size_t              *firstItemOfSections;   // numberOfSections + 1 item numbers, the last is the number of items
+    size_t              *firstRowOfSections;    // the row each section starts on
+    size_t              numberOfColumns;
+    double              itemWidth;
+    double              itemHeight;
+    double              spacing;
+    size_t              lockedItemInterval;
+    SSExchangeGridIndex *gridIndex;
+    int64_t             *model;                 // used when the hooks don't give a model
+    int64_t             *view;                  // the items as the collection view shows them, changed by moves
+    int64_t             *reported;              // the items as the final exchanges reported to the delegate leave them
+};
+
+
+static uint64_t SSExchangeReplayTime(void) {
+
+#ifdef __APPLE__
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) mach_timebase_info(&timebase);
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static uint32_t SSExchangeReplayRandom(uint32_t *seed, uint32_t upperBound) {
+
+    *seed = *seed * 1664525 + 1013904223;
+    return (*seed >> 8) % upperBound;
+}
+
+static size_t SSExchangeReplayItemNumber(const SSExchangeReplay *replay, SSExchangeIndexPath indexPath) {
+
+    // The caller has checked indexPath exists.
+    return replay->firstItemOfSections[indexPath.section] + (size_t)indexPath.item;
+}
+
+static bool SSExchangeReplayHasItem(const SSExchangeReplay *replay, SSExchangeIndexPath indexPath) {
+
+    if (SSExchangeIndexPathIsNone(indexPath) || (size_t)indexPath.section >= replay->numberOfSections) return false;
+    return (size_t)indexPath.item < replay->firstItemOfSections[indexPath.section + 1] - replay->firstItemOfSections[indexPath.section];
+}
+
+
+
+//--------------------------
+// Creating and freeing...
+
+SSExchangeReplay *SSExchangeReplayCreate(const size_t *numberOfItemsInSections,
+                                         size_t numberOfSections,
+                                         size_t numberOfColumns,
+                                         double itemWidth,
+                                         double itemHeight,
+                                         double spacing) {
+
+    if (numberOfItemsInSections == NULL || numberOfSections == 0 || numberOfColumns == 0) return NULL;
+    if (!(itemWidth > 0.0 && itemHeight > 0.0 && spacing >= 0.0)) return NULL;
+
+    SSExchangeReplay *replay = calloc(1, sizeof(SSExchangeReplay));
+    if (replay == NULL) return NULL;
+
+    SSExchangeRect *frames = NULL;
+    SSExchangeIndexPath *indexPaths = NULL;
+
+    replay->numberOfSections = numberOfSections;
+    replay->numberOfColumns = numberOfColumns;
+    replay->itemWidth = itemWidth;
+    replay->itemHeight = itemHeight;
+    replay->spacing = spacing;
+
+    replay->firstItemOfSections = malloc((numberOfSections + 1) * sizeof(size_t));
+    replay->firstRowOfSections = malloc(numberOfSections * sizeof(size_t));
+    if (replay->firstItemOfSections == NULL || replay->firstRowOfSections == NULL) goto fail;
+
+    size_t numberOfItems = 0;
+    size_t numberOfRows = 0;
+    for (size_t section = 0; section < numberOfSections; section++) {
+        if (numberOfItemsInSections[section] > INT32_MAX) goto fail;
+        replay->firstItemOfSections[section] = numberOfItems;
+        replay->firstRowOfSections[section] = numberOfRows;
+        numberOfItems += numberOfItemsInSections[section];
+        numberOfRows += (numberOfItemsInSections[section] + numberOfColumns - 1) / numberOfColumns;
+    }
+    replay->firstItemOfSections[numberOfSections] = numberOfItems;
+    if (numberOfItems == 0) goto fail;
+
+    replay->model = malloc(numberOfItems * sizeof(int64_t));
+    replay->view = malloc(numberOfItems * sizeof(int64_t));
+    replay->reported = malloc(numberOfItems * sizeof(int64_t));
+    frames = malloc(numberOfItems * sizeof(SSExchangeRect));
+    indexPaths = malloc(numberOfItems * sizeof(SSExchangeIndexPath));
+    if (replay->model == NULL || replay->view == NULL || replay->reported == NULL || frames == NULL || indexPaths == NULL) goto fail;
+
+    for (size_t section = 0; section < numberOfSections; section++) {
+        for (size_t item = 0; item < numberOfItemsInSections[section]; item++) {
+            SSExchangeIndexPath indexPath = SSExchangeIndexPathMake((int32_t)section, (int32_t)item);
+            size_t number = SSExchangeReplayItemNumber(replay, indexPath);
+            frames[number] = SSExchangeReplayFrameForItemAtIndexPath(replay, indexPath);
+            indexPaths[number] = indexPath;
+            replay->model[number] = replay->view[number] = replay->reported[number] = (int64_t)number;
+        }
+    }
+
+    replay->gridIndex = SSExchangeGridIndexCreate(frames, indexPaths, numberOfItems);
+    if (replay->gridIndex == NULL) goto fail;
+
+    free(frames);
+    free(indexPaths);
+    return replay;
+
+fail:
+    free(frames);
+    free(indexPaths);
+    SSExchangeReplayFree(replay);
+    return NULL;
+}
+
+void SSExchangeReplayFree(SSExchangeReplay *replay) {
+
+    if (replay == NULL) return;
+
+    SSExchangeGridIndexFree(replay->gridIndex);
+    free(replay->firstItemOfSections);
+    free(replay->firstRowOfSections);
+    free(replay->model);
+    free(replay->view);
+    free(replay->reported);
+    free(replay);
+}
+
+size_t SSExchangeReplayNumberOfItems(const SSExchangeReplay *replay) {
+
+    return replay->firstItemOfSections[replay->numberOfSections];
+}
+
+int64_t SSExchangeReplayNumberOfItemAtIndexPath(const SSExchangeReplay *replay, SSExchangeIndexPath indexPath) {
+
+    return (SSExchangeReplayHasItem(replay, indexPath))? (int64_t)SSExchangeReplayItemNumber(replay, indexPath) : -1;
+}
+
+SSExchangeRect SSExchangeReplayFrameForItemAtIndexPath(const SSExchangeReplay *replay, SSExchangeIndexPath indexPath) {
+
+    SSExchangeRect frame = { 0.0, 0.0, 0.0, 0.0 };
+    if (SSExchangeReplayHasItem(replay, indexPath) == false) return frame;
+
+    size_t row = replay->firstRowOfSections[indexPath.section] + (size_t)indexPath.item / replay->numberOfColumns;
+    size_t column = (size_t)indexPath.item % replay->numberOfColumns;
+
+    frame.x = replay->spacing + column * (replay->itemWidth + replay->spacing);
+    frame.y = replay->spacing + row * (replay->itemHeight + replay->spacing);
+    frame.width = replay->itemWidth;
+    frame.height = replay->itemHeight;
+    return frame;
+}
+
+void SSExchangeReplaySetLockedItemInterval(SSExchangeReplay *replay, size_t interval) {
+
+    replay->lockedItemInterval = interval;
+}
+
+
+
+//------------
+// Traces...
+
+size_t SSExchangeReplayMakeTrace(const SSExchangeReplay *replay,
+                                 uint32_t *seed,
+                                 size_t numberOfChanges,
+                                 SSExchangeTouch *touches) {
+
+    size_t numberOfItems = SSExchangeReplayNumberOfItems(replay);
+    double stepX = replay->itemWidth + replay->spacing;
+    double stepY = replay->itemHeight + replay->spacing;
+
+    // A random point in a random item, found by number so every item is equally likely.
+    #define SSExchangeReplayRandomPoint(touch) do {                                                                   \
+        uint32_t number = SSExchangeReplayRandom(seed, (uint32_t)numberOfItems);                                        \
+        size_t section = 0;                                                                                           \
+        while (replay->firstItemOfSections[section + 1] <= number) section++;                                         \
+        SSExchangeRect frame = SSExchangeReplayFrameForItemAtIndexPath(replay,                                        \
+            SSExchangeIndexPathMake((int32_t)section, (int32_t)(number - replay->firstItemOfSections[section])));     \
+        (touch).x = frame.x + frame.width * SSExchangeReplayRandom(seed, 1000) / 1000.0;                              \
+        (touch).y = frame.y + frame.height * SSExchangeReplayRandom(seed, 1000) / 1000.0;                             \
+    } while (0)
+
+    touches[0].state = SSExchangeTouchBegan;
+    SSExchangeReplayRandomPoint(touches[0]);
+
+    for (size_t i = 1; i <= numberOfChanges; i++) {
+
+        touches[i].state = SSExchangeTouchChanged;
+
+        if (SSExchangeReplayRandom(seed, 16) == 0) {
+            SSExchangeReplayRandomPoint(touches[i]);
+        } else {
+            // Up to half an item in any direction.
+            touches[i].x = touches[i - 1].x + stepX * ((double)SSExchangeReplayRandom(seed, 1001) / 1000.0 - 0.5);
+            touches[i].y = touches[i - 1].y + stepY * ((double)SSExchangeReplayRandom(seed, 1001) / 1000.0 - 0.5);
+        }
+    }
+
+    #undef SSExchangeReplayRandomPoint
+
+    touches[numberOfChanges + 1] = touches[numberOfChanges];
+    touches[numberOfChanges + 1].state = (SSExchangeReplayRandom(seed, 8) == 0)? SSExchangeTouchCancelled : SSExchangeTouchEnded;
+    return numberOfChanges + 2;
+}
+
+size_t SSExchangeReplayParseTrace(const char *text, SSExchangeTouch *touches, size_t capacity) {
+
+    static const struct { const char *name; SSExchangeTouchState state; } states[] = {
+        { "began", SSExchangeTouchBegan },
+        { "changed", SSExchangeTouchChanged },
+        { "ended", SSExchangeTouchEnded },
+        { "cancelled", SSExchangeTouchCancelled }
+    };
+
+    size_t numberOfTouches = 0;
+
+    while (text && *text) {
+
+        const char *endOfLine = strchr(text, '\n');
+        size_t length = (endOfLine)? (size_t)(endOfLine - text) : strlen(text);
+
+        char line[128];
+        char name[16];
+        SSExchangeTouch touch;
+
+        if (length < sizeof(line)) {
+
+            memcpy(line, text, length);
+            line[length] = '\0';
+
+            if (line[0] != '#' && sscanf(line, "%15s %lf %lf", name, &touch.x, &touch.y) == 3) {
+                for (size_t i = 0; i < sizeof(states) / sizeof(states[0]); i++) {
+                    if (strcmp(name, states[i].name) == 0) {
+                        touch.state = states[i].state;
+                        if (touches && numberOfTouches < capacity) touches[numberOfTouches] = touch;
+                        numberOfTouches++;
+                        break;
+                    }
+                }
+            }
+        }
+
+        text = (endOfLine)? endOfLine + 1 : NULL;
+    }
+
+    return numberOfTouches;
+}
+
+
+
+//--------------
+// Replaying...
+
+typedef struct {
+    SSExchangeReplay                *replay;
+    const SSExchangeReplayHooks     *hooks;
+    uint64_t                        numberOfMismatches;
+} SSExchangeReplayRunState;
+
+static bool SSExchangeReplayCanDisplace(SSExchangeIndexPath indexPathOfItemToDisplace,
+                                        SSExchangeIndexPath indexPathOfItemBeingDragged,
+                                        void *context) {
+
+    // The same test the exchange controller makes before asking its delegate.
+    (void)indexPathOfItemBeingDragged;
+    SSExchangeReplay *replay = context;
+    if (SSExchangeReplayHasItem(replay, indexPathOfItemToDisplace) == false) return false;
+    if (replay->lockedItemInterval == 0) return true;
+    return (SSExchangeReplayItemNumber(replay, indexPathOfItemToDisplace) + 1) % replay->lockedItemInterval != 0;
+}
+
+static void SSExchangeReplaySwapItems(int64_t *items, size_t number1, size_t number2) {
+
+    int64_t item = items[number1];
+    items[number1] = items[number2];
+    items[number2] = item;
+}
+
+static int64_t SSExchangeReplayModelItem(SSExchangeReplayRunState *state, SSExchangeIndexPath indexPath) {
+
+    if (state->hooks && state->hooks->itemAtIndexPath) return state->hooks->itemAtIndexPath(indexPath, state->hooks->context);
+    return state->replay->model[SSExchangeReplayItemNumber(state->replay, indexPath)];
+}
+
+static void SSExchangeReplayExchangeModelItems(SSExchangeReplayRunState *state, const SSExchangeSwap *swaps, unsigned int numberOfSwaps) {
+
+    if (state->hooks && state->hooks->exchangeItems) {
+        if (state->hooks->exchangeItems(swaps, numberOfSwaps, state->hooks->context) == false) state->numberOfMismatches++;
+        return;
+    }
+
+    for (unsigned int i = 0; i < numberOfSwaps; i++) {
+        SSExchangeReplaySwapItems(state->replay->model,
+                                  SSExchangeReplayItemNumber(state->replay, swaps[i].indexPath1),
+                                  SSExchangeReplayItemNumber(state->replay, swaps[i].indexPath2));
+    }
+}
+
+static void SSExchangeReplayMoveViewItems(SSExchangeReplayRunState *state, const SSExchangeMove *moves, unsigned int numberOfMoves) {
+
+    // The moves happen all at once, like moveItemAtIndexPath:toIndexPath: in a batch update, so
+    // the items moving are read before any is written. An event has at most three.
+    SSExchangeReplay *replay = state->replay;
+    int64_t items[4];
+
+    for (unsigned int i = 0; i < numberOfMoves && i < 4; i++) items[i] = replay->view[SSExchangeReplayItemNumber(replay, moves[i].fromIndexPath)];
+    for (unsigned int i = 0; i < numberOfMoves && i < 4; i++) replay->view[SSExchangeReplayItemNumber(replay, moves[i].toIndexPath)] = items[i];
+
+    // Only the items that moved can have changed, so only they are checked.
+    for (unsigned int i = 0; i < numberOfMoves; i++) {
+        SSExchangeIndexPath indexPath = moves[i].toIndexPath;
+        if (SSExchangeReplayModelItem(state, indexPath) != replay->view[SSExchangeReplayItemNumber(replay, indexPath)]) state->numberOfMismatches++;
+    }
+}
+
+static void SSExchangeReplayReportFinalExchange(SSExchangeReplayRunState *state, SSExchangeSwap finalSwap) {
+
+    SSExchangeReplay *replay = state->replay;
+    size_t number1 = SSExchangeReplayItemNumber(replay, finalSwap.indexPath1);
+    size_t number2 = SSExchangeReplayItemNumber(replay, finalSwap.indexPath2);
+
+    SSExchangeReplaySwapItems(replay->reported, number1, number2);
+
+    if (SSExchangeReplayModelItem(state, finalSwap.indexPath1) != replay->reported[number1]) state->numberOfMismatches++;
+    if (SSExchangeReplayModelItem(state, finalSwap.indexPath2) != replay->reported[number2]) state->numberOfMismatches++;
+}
+
+static void SSExchangeReplayCancel(SSExchangeReplayRunState *state, SSExchangeCore *core) {
+
+    // The controller undoes the exchange in the model and the view, as one more event.
+    SSExchangeSwap undoSwap;
+    if (SSExchangeCoreCancel(core, &undoSwap) == false) return;
+
+    SSExchangeMove moves[2];
+    unsigned int numberOfMoves = SSExchangeComposeSwaps(&undoSwap, 1, moves);
+    SSExchangeReplayExchangeModelItems(state, &undoSwap, 1);
+    SSExchangeReplayMoveViewItems(state, moves, numberOfMoves);
+}
+
+static void SSExchangeReplayTouch(SSExchangeReplayRunState *state, SSExchangeCore *core, const SSExchangeTouch *touch, SSExchangeReplayResult *result) {
+
+    SSExchangeReplay *replay = state->replay;
+
+    switch (touch->state) {
+
+        case SSExchangeTouchBegan: {
+            // A began while a transaction is in progress means a touch was lost. Cancel, as the
+            // system would.
+            if (core->exchangeTransactionInProgress) SSExchangeReplayCancel(state, core);
+            SSExchangeCoreReset(core);
+
+            SSExchangeIndexPath indexPath = SSExchangeGridIndexIndexPathAtPoint(replay->gridIndex, touch->x, touch->y);
+            if (SSExchangeIndexPathIsNone(indexPath)) break;
+
+            SSExchangeCoreBegin(core, indexPath);
+            result->numberOfTransactions++;
+            break;
+        }
+
+        case SSExchangeTouchChanged: {
+            if (core->exchangeTransactionInProgress == false) break;
+
+            SSExchangeIndexPath indexPath = SSExchangeGridIndexIndexPathAtPoint(replay->gridIndex, touch->x, touch->y);
+            SSExchangeEventType type = SSExchangeCoreEventType(core, indexPath, SSExchangeReplayCanDisplace, replay);
+            if (type == SSExchangeEventTypeNothingToExchange || type == SSExchangeEventTypeCannotDisplaceItem) break;
+
+            SSExchangeEvent event;
+            SSExchangeCorePerformEventType(core, type, &event);
+            SSExchangeReplayExchangeModelItems(state, event.swaps, event.numberOfSwaps);
+            SSExchangeReplayMoveViewItems(state, event.moves, event.numberOfMoves);
+            result->numberOfExchangeEvents++;
+            break;
+        }
+
+        case SSExchangeTouchEnded:
+            if (core->exchangeTransactionInProgress == false) break;
+            SSExchangeReplayReportFinalExchange(state, SSExchangeCoreFinish(core));
+            SSExchangeCoreReset(core);
+            break;
+
+        case SSExchangeTouchCancelled:
+            if (core->exchangeTransactionInProgress == false) break;
+            SSExchangeReplayCancel(state, core);
+            result->numberOfCancelledTransactions++;
+            break;
+    }
+}
+
+static int SSExchangeReplayCompareDurations(const void *duration1, const void *duration2) {
+
+    uint64_t value1 = *(const uint64_t *)duration1;
+    uint64_t value2 = *(const uint64_t *)duration2;
+    return (value1 > value2) - (value1 < value2);
+}
+
+bool SSExchangeReplayRun(SSExchangeReplay *replay,
+                         const SSExchangeTouch *touches,
+                         size_t numberOfTouches,
+                         const SSExchangeReplayHooks *hooks,
+                         SSExchangeReplayResult *result) {
+
+    memset(result, 0, sizeof(SSExchangeReplayResult));
+
+    uint64_t *durations = malloc((numberOfTouches + 1) * sizeof(uint64_t));
+    if (durations == NULL) return false;
+
+    SSExchangeReplayRunState state = { replay, hooks, 0 };
+    SSExchangeCore core;
+    SSExchangeCoreReset(&core);
+
+    bool countsAllocations = (hooks && hooks->numberOfAllocations);
+    uint64_t numberOfAllocationsBefore = (countsAllocations)? hooks->numberOfAllocations() : 0;
+
+    for (size_t i = 0; i < numberOfTouches; i++) {
+        uint64_t startTime = SSExchangeReplayTime();
+        SSExchangeReplayTouch(&state, &core, &touches[i], result);
+        durations[i] = SSExchangeReplayTime() - startTime;
+    }
+
+    result->numberOfAllocations = (countsAllocations)? hooks->numberOfAllocations() - numberOfAllocationsBefore : UINT64_MAX;
+
+    if (core.exchangeTransactionInProgress) {
+        SSExchangeReplayCancel(&state, &core);
+        result->numberOfCancelledTransactions++;
+    }
+
+    // Every item, the model, the view and the reported exchanges must agree.
+    for (int32_t section = 0; (size_t)section < replay->numberOfSections; section++) {
+        int32_t numberOfItems = (int32_t)(replay->firstItemOfSections[section + 1] - replay->firstItemOfSections[section]);
+        for (int32_t item = 0; item < numberOfItems; item++) {
+            SSExchangeIndexPath indexPath = SSExchangeIndexPathMake(section, item);
+            size_t number = SSExchangeReplayItemNumber(replay, indexPath);
+            int64_t modelItem = SSExchangeReplayModelItem(&state, indexPath);
+            if (modelItem != replay->view[number] || modelItem != replay->reported[number]) state.numberOfMismatches++;
+        }
+    }
+
+    result->numberOfTouches = numberOfTouches;
+    result->numberOfMismatches = state.numberOfMismatches;
+
+    if (numberOfTouches > 0) {
+        for (size_t i = 0; i < numberOfTouches; i++) result->totalDuration += durations[i];
+        qsort(durations, numberOfTouches, sizeof(uint64_t), SSExchangeReplayCompareDurations);
+        result->medianDuration = durations[(numberOfTouches - 1) / 2];
+        result->p99Duration = durations[(numberOfTouches * 99 + 99) / 100 - 1];
+        result->maximumDuration = durations[numberOfTouches - 1];
+    }
+
+    free(durations);
+    return true;
+}
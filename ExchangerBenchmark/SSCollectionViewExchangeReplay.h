@@ -0,0 +1,159 @@
+//
+//  SSCollectionViewExchangeReplay.h
+//  Exchanger
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// SSExchangeReplay feeds long press traces through the exchange logic headlessly, checks the
+// result, and measures how long each touch takes.
+//
+// A trace is what the exchange controller's long press gesture recognizer would see: a touch
+// began, changed any number of times, then ended or was cancelled, each at a point in the
+// collection view. The replay does what the controller does with each one. It hit-tests the point
+// with an SSExchangeGridIndex, as SSCollectionViewExchangeLayout does, and drives SSExchangeCore.
+// It applies the swaps of each exchange event to a model and the moves to a copy of the view. At
+// the end of each transaction it applies the final exchange the controller would report to the
+// delegate to a third copy. The three must agree. UIKit isn't involved, so this runs on any
+// platform.
+//
+// The items are laid out like a flow layout: rows of numberOfColumns items, with each section
+// starting a new row. Item n, counting from 0 section by section, starts out with the value n.
+//
+// The replay is plain C. It allocates when it is created and at the start of each run, never
+// while replaying a touch.
+
+#ifndef SSCollectionViewExchangeReplay_h
+#define SSCollectionViewExchangeReplay_h
+
+#include "SSCollectionViewExchangeCore.h"
+#include "SSCollectionViewExchangeGridIndex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef enum {
+    SSExchangeTouchBegan,
+    SSExchangeTouchChanged,
+    SSExchangeTouchEnded,
+    SSExchangeTouchCancelled
+} SSExchangeTouchState;
+
+typedef struct {
+    SSExchangeTouchState    state;
+    double                  x;
+    double                  y;
+} SSExchangeTouch;
+
+
+// How a run reaches the model. Any function can be NULL. Without exchangeItems and itemAtIndexPath
+// the replay uses a model of its own.
+typedef struct {
+    bool        (*exchangeItems)(const SSExchangeSwap *swaps, unsigned int numberOfSwaps, void *context);
+                // applies the swaps in order, like exchangeController:didExchangeItemAtIndexPath1:...
+    int64_t     (*itemAtIndexPath)(SSExchangeIndexPath indexPath, void *context);
+    uint64_t    (*numberOfAllocations)(void);
+                // a count of every allocation so far in the process, read before and after the touches
+    void        *context;
+} SSExchangeReplayHooks;
+
+
+typedef struct {
+    uint64_t    numberOfTouches;
+    uint64_t    numberOfExchangeEvents;         // events that exchanged something
+    uint64_t    numberOfTransactions;           // transactions that began, whether they ended or were cancelled
+    uint64_t    numberOfCancelledTransactions;
+    uint64_t    numberOfMismatches;             // items where the model, view and reported exchanges disagree; should be 0
+    uint64_t    numberOfAllocations;            // while replaying the touches, or UINT64_MAX if not counted
+    uint64_t    totalDuration;                  // nanoseconds handling touches
+    uint64_t    medianDuration;                 // nanoseconds for one touch
+    uint64_t    p99Duration;
+    uint64_t    maximumDuration;
+} SSExchangeReplayResult;
+
+
+typedef struct SSExchangeReplay SSExchangeReplay;
+
+
+SSExchangeReplay *SSExchangeReplayCreate(const size_t *numberOfItemsInSections,
+                                         size_t numberOfSections,
+                                         size_t numberOfColumns,
+                                         double itemWidth,
+                                         double itemHeight,
+                                         double spacing);
+// spacing separates the items horizontally and vertically. A touch there is not over any item.
+// Returns NULL if there are no items or memory can't be allocated. Release the replay with
+// SSExchangeReplayFree().
+
+void SSExchangeReplayFree(SSExchangeReplay *replay);
+// replay can be NULL.
+
+size_t SSExchangeReplayNumberOfItems(const SSExchangeReplay *replay);
+
+int64_t SSExchangeReplayNumberOfItemAtIndexPath(const SSExchangeReplay *replay, SSExchangeIndexPath indexPath);
+// The item's number counting from 0 section by section, which is also its starting value, or -1 if
+// there is no such item. Use it to fill a model passed in the hooks.
+
+SSExchangeRect SSExchangeReplayFrameForItemAtIndexPath(const SSExchangeReplay *replay, SSExchangeIndexPath indexPath);
+// An empty rect if there is no such item.
+
+void SSExchangeReplaySetLockedItemInterval(SSExchangeReplay *replay, size_t interval);
+// Every interval'th item can't be displaced, exercising SSExchangeEventTypeCannotDisplaceItem. 0,
+// the default, locks none.
+
+size_t SSExchangeReplayMakeTrace(const SSExchangeReplay *replay,
+                                 uint32_t *seed,
+                                 size_t numberOfChanges,
+                                 SSExchangeTouch *touches);
+// Writes a synthetic trace to touches, which must have room for numberOfChanges + 2 touches, and
+// returns how many were written. The touch begins over a random item, wanders a fraction of an
+// item at a time with an occasional jump elsewhere, as when auto scrolling, then ends, or one
+// time in eight is cancelled. The same seed gives the same trace. seed is updated so consecutive
+// calls give different traces.
+
+size_t SSExchangeReplayParseTrace(const char *text, SSExchangeTouch *touches, size_t capacity);
+// Parses a recorded trace: one touch per line, the state (began, changed, ended or cancelled)
+// then x and y, separated by spaces. Blank lines and lines starting with # are skipped, as are
+// lines that can't be parsed. Writes up to capacity touches and returns how many there are in
+// total, so pass NULL and 0 first to size touches.
+
+bool SSExchangeReplayRun(SSExchangeReplay *replay,
+                         const SSExchangeTouch *touches,
+                         size_t numberOfTouches,
+                         const SSExchangeReplayHooks *hooks,
+                         SSExchangeReplayResult *result);
+// Replays the touches, which can hold any number of traces one after another. A transaction that
+// is still in progress at the end is cancelled. Then checks every item and fills in result.
+// hooks can be NULL. The model, whether the replay's or one passed in hooks, must hold the
+// starting values before the first run and is left as the touches leave it; runs can follow one
+// another. Returns false if memory can't be allocated.
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,213 @@
+//
+//  main.m
+//  Exchanger
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// Replays long press traces through the exchange logic against grids of 10 to 1,000,000 items and
+// reports touches per second, allocations per touch and the 99th percentile time for a touch.
+// The model is an SSCollectionViewExchangeInt64Store. Only Foundation is used, so with GNUstep
+// this builds and runs headlessly on Linux. Refer to GNUmakefile.
+//
+//      exchanger-replay [--traces N] [--changes N] [--seed N] [--maximum-p99 NANOSECONDS] [trace-file]
+//
+// Without a trace file, N synthetic traces (default 2000) of N changes each (default 100) are
+// made for each grid from the seed. With one, its traces are replayed on every grid. The exit
+// status is 1 if the model ever disagrees with the exchanges reported, or if a p99 is over the
+// maximum given, so a CI job can fail on a correctness or performance regression.
+
+#import <Foundation/Foundation.h>
+#import "SSCollectionViewExchangeInt64Store.h"
+#import "SSCollectionViewExchangeReplay.h"
+#import "SSCollectionViewExchangeAllocationCounter.h"
+
+
+typedef struct {
+    size_t numberOfItems;
+    size_t numberOfSections;
+    size_t numberOfColumns;
+} Grid;
+
+static const Grid grids[] = {
+    {        10,  1,  5 },
+    {      1000,  4, 10 },
+    {    100000, 10, 20 },
+    {   1000000,  4, 50 },
+};
+
+
+static bool ExchangeItemsInStore(const SSExchangeSwap *swaps, unsigned int numberOfSwaps, void *context) {
+
+    SSCollectionViewExchangeInt64Store *store = (__bridge SSCollectionViewExchangeInt64Store *)context;
+    return [store exchangeItemsWithSwaps:swaps count:numberOfSwaps];
+}
+
+static int64_t ItemInStore(SSExchangeIndexPath indexPath, void *context) {
+
+    SSCollectionViewExchangeInt64Store *store = (__bridge SSCollectionViewExchangeInt64Store *)context;
+    return [store itemAtIndexPath:indexPath];
+}
+
+
+static BOOL ReplayGrid(Grid grid, const SSExchangeTouch *recordedTouches, size_t numberOfRecordedTouches,
+                       size_t numberOfTraces, size_t numberOfChanges, uint32_t seed, uint64_t maximumP99Duration) {
+
+    size_t numberOfItemsInSections[grid.numberOfSections];
+    NSUInteger numbersOfItems[grid.numberOfSections];
+    for (size_t section = 0; section < grid.numberOfSections; section++) {
+        numberOfItemsInSections[section] = grid.numberOfItems / grid.numberOfSections + ((section == 0)? grid.numberOfItems % grid.numberOfSections : 0);
+        numbersOfItems[section] = numberOfItemsInSections[section];
+    }
+
+    SSExchangeReplay *replay = SSExchangeReplayCreate(numberOfItemsInSections, grid.numberOfSections, grid.numberOfColumns, 50.0, 50.0, 5.0);
+    SSCollectionViewExchangeInt64Store *store = [[SSCollectionViewExchangeInt64Store alloc] initWithNumbersOfItems:numbersOfItems
+                                                                                                  numberOfSections:grid.numberOfSections];
+    if (replay == NULL || store == nil) {
+        fprintf(stderr, "Couldn't make a grid of %zu items\n", grid.numberOfItems);
+        SSExchangeReplayFree(replay);
+        return NO;
+    }
+
+    // Every seventh item can't be displaced.
+    SSExchangeReplaySetLockedItemInterval(replay, 7);
+
+    for (size_t section = 0; section < grid.numberOfSections; section++) {
+        for (size_t item = 0; item < numberOfItemsInSections[section]; item++) {
+            SSExchangeIndexPath indexPath = SSExchangeIndexPathMake((int32_t)section, (int32_t)item);
+            [store setItem:SSExchangeReplayNumberOfItemAtIndexPath(replay, indexPath) atIndexPath:indexPath];
+        }
+    }
+
+    const SSExchangeTouch *touches = recordedTouches;
+    size_t numberOfTouches = numberOfRecordedTouches;
+    SSExchangeTouch *syntheticTouches = NULL;
+
+    if (touches == NULL) {
+        syntheticTouches = malloc(numberOfTraces * (numberOfChanges + 2) * sizeof(SSExchangeTouch));
+        if (syntheticTouches == NULL) {
+            SSExchangeReplayFree(replay);
+            return NO;
+        }
+        numberOfTouches = 0;
+        for (size_t trace = 0; trace < numberOfTraces; trace++) {
+            numberOfTouches += SSExchangeReplayMakeTrace(replay, &seed, numberOfChanges, &syntheticTouches[numberOfTouches]);
+        }
+        touches = syntheticTouches;
+    }
+
+    SSExchangeReplayHooks hooks = {
+        ExchangeItemsInStore,
+        ItemInStore,
+        (SSExchangeAllocationCounterIsAvailable())? SSExchangeAllocationCounterNumberOfAllocations : NULL,
+        (__bridge void *)store
+    };
+
+    SSExchangeReplayResult result;
+    BOOL ran = SSExchangeReplayRun(replay, touches, numberOfTouches, &hooks, &result);
+
+    free(syntheticTouches);
+    SSExchangeReplayFree(replay);
+    if (ran == NO) return NO;
+
+    double touchesPerSecond = (result.totalDuration > 0)? result.numberOfTouches / (result.totalDuration / 1e9) : 0.0;
+    NSString *allocationsPerTouch = (result.numberOfAllocations == UINT64_MAX)? @"not counted" :
+        [NSString stringWithFormat:@"%.3f", (result.numberOfTouches > 0)? (double)result.numberOfAllocations / result.numberOfTouches : 0.0];
+
+    printf("%8zu items: %llu touches, %llu exchange events, %llu transactions (%llu cancelled), "
+           "%.0f touches/s, allocations/touch %s, p50 %llu ns, p99 %llu ns, max %llu ns, %llu mismatches\n",
+           grid.numberOfItems,
+           (unsigned long long)result.numberOfTouches,
+           (unsigned long long)result.numberOfExchangeEvents,
+           (unsigned long long)result.numberOfTransactions,
+           (unsigned long long)result.numberOfCancelledTransactions,
+           touchesPerSecond,
+           [allocationsPerTouch UTF8String],
+           (unsigned long long)result.medianDuration,
+           (unsigned long long)result.p99Duration,
+           (unsigned long long)result.maximumDuration,
+           (unsigned long long)result.numberOfMismatches);
+
+    BOOL passed = YES;
+    if (result.numberOfMismatches > 0) {
+        fprintf(stderr, "FAIL: the model disagrees with the reported exchanges\n");
+        passed = NO;
+    }
+    if (maximumP99Duration > 0 && result.p99Duration > maximumP99Duration) {
+        fprintf(stderr, "FAIL: p99 %llu ns is over the maximum of %llu ns\n", (unsigned long long)result.p99Duration, (unsigned long long)maximumP99Duration);
+        passed = NO;
+    }
+    return passed;
+}
+
+
+int main(int argc, const char *argv[]) {
+
+    @autoreleasepool {
+
+        size_t numberOfTraces = 2000;
+        size_t numberOfChanges = 100;
+        uint32_t seed = 1;
+        uint64_t maximumP99Duration = 0;
+        NSString *path = nil;
+
+        for (int i = 1; i < argc; i++) {
+            BOOL hasValue = (i + 1 < argc);
+            if (hasValue && strcmp(argv[i], "--traces") == 0)           numberOfTraces = strtoul(argv[++i], NULL, 10);
+            else if (hasValue && strcmp(argv[i], "--changes") == 0)     numberOfChanges = strtoul(argv[++i], NULL, 10);
+            else if (hasValue && strcmp(argv[i], "--seed") == 0)        seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+            else if (hasValue && strcmp(argv[i], "--maximum-p99") == 0) maximumP99Duration = strtoull(argv[++i], NULL, 10);
+            else if (argv[i][0] != '-')                                 path = [NSString stringWithUTF8String:argv[i]];
+            else {
+                fprintf(stderr, "usage: %s [--traces N] [--changes N] [--seed N] [--maximum-p99 NANOSECONDS] [trace-file]\n", argv[0]);
+                return 2;
+            }
+        }
+
+        SSExchangeTouch *recordedTouches = NULL;
+        size_t numberOfRecordedTouches = 0;
+
+        if (path) {
+            NSString *text = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:NULL];
+            if (text == nil) {
+                fprintf(stderr, "Couldn't read %s\n", [path UTF8String]);
+                return 2;
+            }
+            numberOfRecordedTouches = SSExchangeReplayParseTrace([text UTF8String], NULL, 0);
+            recordedTouches = malloc(MAX(numberOfRecordedTouches, 1) * sizeof(SSExchangeTouch));
+            if (recordedTouches == NULL) return 2;
+            SSExchangeReplayParseTrace([text UTF8String], recordedTouches, numberOfRecordedTouches);
+        }
+
+        BOOL passed = YES;
+        for (size_t i = 0; i < sizeof(grids) / sizeof(grids[0]); i++) {
+            @autoreleasepool {
+                if (ReplayGrid(grids[i], recordedTouches, numberOfRecordedTouches, numberOfTraces, numberOfChanges, seed, maximumP99Duration) == NO) passed = NO;
+            }
+        }
+
+        free(recordedTouches);
+        return (passed)? 0 : 1;
+    }
+}
@@ -0,0 +1,241 @@
+//
+//  NSMutableArrayBatchExchangeTests.m
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+// Tests and throughput benchmarks for exchangeObjectsInArrays:withSwaps:count:. Only Foundation
+// and XCTest are used, and random numbers come from a seeded generator rather than arc4random,
+// so this file also builds and runs under GNUstep/XCTest on Linux.
+
+#import <XCTest/XCTest.h>
+#import "NSMutableArray+SSCollectionViewExchangeControllerAdditions.h"
+#import "SSCollectionViewExchangeTestSupport.h"
+
+
+static NSUInteger const kBenchmarkSections = 3;
+static NSUInteger const kBenchmarkItemsPerSection = 10000;
+static NSUInteger const kBenchmarkSwaps = 100000;
+
+
+@interface NSMutableArrayBatchExchangeTests : SSCollectionViewExchangeTestCase
+
+@property (strong, nonatomic) NSArray *originalArrays;
+@property (strong, nonatomic) NSArray *testArrays;
+
+@end
+
+
+@implementation NSMutableArrayBatchExchangeTests
+
+- (void)setUp {
+
+    [super setUp];
+
+    self.originalArrays = @[ @[ @0, @1, @2, @3, @4 ],
+                             @[ @5, @6, @7, @8, @9 ] ];
+}
+
+- (void)resetArrays {
+
+    NSMutableArray *testArrays = [[NSMutableArray alloc] init];
+    for (NSArray *array in self.originalArrays) {
+        [testArrays addObject:[array mutableCopy]];
+    }
+    self.testArrays = testArrays;
+
+}
+
+
+
+//-------------------------
+#pragma mark - Validation...
+
+- (void)testBatchWithNilArraysOrSwaps {
+
+    [self resetArrays];
+    SSExchangeSwap swap = SSExchangeSwapMake(SSExchangeIndexPathMake(0, 0), SSExchangeIndexPathMake(1, 0));
+
+    XCTAssertFalse([NSMutableArray exchangeObjectsInArrays:nil withSwaps:&swap count:1], @"batch succeeded with nil arrays");
+    XCTAssertFalse([NSMutableArray exchangeObjectsInArrays:self.testArrays withSwaps:NULL count:1], @"batch succeeded with NULL swaps");
+    XCTAssertTrue([NSMutableArray exchangeObjectsInArrays:self.testArrays withSwaps:NULL count:0], @"empty batch failed");
+    XCTAssertTrue([self.testArrays isEqual:self.originalArrays], @"arrays modified by an invalid or empty batch");
+}
+
+- (void)testBatchWithInvalidSwapIsAllOrNothing {
+
+    [self resetArrays];
+
+    SSExchangeSwap swaps[] = {
+        SSExchangeSwapMake(SSExchangeIndexPathMake(0, 0), SSExchangeIndexPathMake(1, 4)),   // valid
+        SSExchangeSwapMake(SSExchangeIndexPathMake(0, 1), SSExchangeIndexPathMake(0, 2)),   // valid
+        SSExchangeSwapMake(SSExchangeIndexPathMake(1, 5), SSExchangeIndexPathMake(0, 0)),   // item above upper bounds
+    };
+
+    XCTAssertFalse([NSMutableArray exchangeObjectsInArrays:self.testArrays withSwaps:swaps count:3], @"batch succeeded with an item above upper bounds");
+    XCTAssertTrue([self.testArrays isEqual:self.originalArrays], @"arrays modified when the last swap was invalid");
+
+    swaps[2] = SSExchangeSwapMake(SSExchangeIndexPathMake(2, 0), SSExchangeIndexPathMake(0, 0));
+    XCTAssertFalse([NSMutableArray exchangeObjectsInArrays:self.testArrays withSwaps:swaps count:3], @"batch succeeded with a section above upper bounds");
+    XCTAssertTrue([self.testArrays isEqual:self.originalArrays], @"arrays modified when a section was invalid");
+
+    swaps[2] = SSExchangeSwapMake(SSExchangeIndexPathNone, SSExchangeIndexPathMake(0, 0));
+    XCTAssertFalse([NSMutableArray exchangeObjectsInArrays:self.testArrays withSwaps:swaps count:3], @"batch succeeded with a negative index path");
+    XCTAssertTrue([self.testArrays isEqual:self.originalArrays], @"arrays modified when an index path was negative");
+}
+
+- (void)testBatchWithImmutableArray {
+
+    NSArray *arrays = @[ [self.originalArrays[0] mutableCopy], self.originalArrays[1] ];
+    SSExchangeSwap swap = SSExchangeSwapMake(SSExchangeIndexPathMake(0, 0), SSExchangeIndexPathMake(1, 0));
+
+    XCTAssertFalse([NSMutableArray exchangeObjectsInArrays:arrays withSwaps:&swap count:1], @"batch succeeded with an immutable array");
+    XCTAssertTrue([arrays isEqual:self.originalArrays], @"arrays modified when one was immutable");
+}
+
+- (void)testBatchWithArrayUsedForTwoSections {
+
+    NSMutableArray *array = [self.originalArrays[0] mutableCopy];
+    NSArray *arrays = @[ array, array ];
+    SSExchangeSwap swap = SSExchangeSwapMake(SSExchangeIndexPathMake(0, 0), SSExchangeIndexPathMake(1, 1));
+
+    XCTAssertFalse([NSMutableArray exchangeObjectsInArrays:arrays withSwaps:&swap count:1], @"batch succeeded with one array for two sections");
+    XCTAssertTrue([array isEqual:self.originalArrays[0]], @"array modified when it was used for two sections");
+
+    // Only the later section is checked against the earlier ones, so it alone is enough.
+    swap = SSExchangeSwapMake(SSExchangeIndexPathMake(1, 0), SSExchangeIndexPathMake(1, 1));
+    XCTAssertFalse([NSMutableArray exchangeObjectsInArrays:arrays withSwaps:&swap count:1], @"batch succeeded through the later of two sections sharing an array");
+    XCTAssertTrue([array isEqual:self.originalArrays[0]], @"array modified through the later of two sections sharing it");
+}
+
+
+
+//------------------------------------------------
+#pragma mark - Equivalence with single exchanges...
+
+- (void)testBatchMatchesSingleExchanges {
+
+    for (int i=0; i<1000; i++) {
+
+        [self resetArrays];
+        NSArray *expectedArrays = @[ [self.originalArrays[0] mutableCopy], [self.originalArrays[1] mutableCopy] ];
+
+        NSUInteger count = 1 + [self randomNumberLessThan:8];
+        SSExchangeSwap swaps[8];
+
+        for (NSUInteger j = 0; j < count; j++) {
+            swaps[j] = [self randomSwapForArrays:self.testArrays];
+            [NSMutableArray exchangeObjectInArray:expectedArrays[ swaps[j].indexPath1.section ]
+                                          atIndex:swaps[j].indexPath1.item
+                           withObjectInOtherArray:expectedArrays[ swaps[j].indexPath2.section ]
+                                          atIndex:swaps[j].indexPath2.item];
+        }
+
+        XCTAssertTrue([NSMutableArray exchangeObjectsInArrays:self.testArrays withSwaps:swaps count:count], @"valid batch failed");
+        XCTAssertTrue([self.testArrays isEqual:expectedArrays], @"batch result %@ differs from single exchanges %@", self.testArrays, expectedArrays);
+    }
+}
+
+
+
+//-----------------------
+#pragma mark - Permutations...
+
+- (void)testMoveObjectsAppliesCycleAtOnce {
+
+    [self resetArrays];
+
+    // 0,1 -> 0,2 -> 1,3 -> 0,1
+    NSArray *fromIndexPaths = @[ [NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 0, 1 } length:2],
+                                 [NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 0, 2 } length:2],
+                                 [NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 1, 3 } length:2] ];
+    NSArray *toIndexPaths = @[ fromIndexPaths[1], fromIndexPaths[2], fromIndexPaths[0] ];
+
+    XCTAssertTrue([NSMutableArray moveObjectsInArrays:self.testArrays fromIndexPaths:fromIndexPaths toIndexPaths:toIndexPaths], @"valid moves failed");
+
+    NSArray *expectedArrays = @[ @[ @0, @8, @1, @3, @4 ],
+                                 @[ @5, @6, @7, @2, @9 ] ];
+    XCTAssertTrue([self.testArrays isEqual:expectedArrays], @"moves result %@ differs from %@", self.testArrays, expectedArrays);
+}
+
+- (void)testMoveObjectsIsAllOrNothing {
+
+    [self resetArrays];
+
+    NSArray *fromIndexPaths = @[ [NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 0, 1 } length:2],
+                                 [NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 1, 5 } length:2] ];
+    NSArray *toIndexPaths = @[ fromIndexPaths[1], fromIndexPaths[0] ];
+
+    XCTAssertFalse([NSMutableArray moveObjectsInArrays:self.testArrays fromIndexPaths:fromIndexPaths toIndexPaths:toIndexPaths], @"moves succeeded with an item above upper bounds");
+    XCTAssertFalse([NSMutableArray moveObjectsInArrays:self.testArrays fromIndexPaths:fromIndexPaths toIndexPaths:@[]], @"moves succeeded with mismatched counts");
+    XCTAssertFalse([NSMutableArray moveObjectsInArrays:nil fromIndexPaths:fromIndexPaths toIndexPaths:toIndexPaths], @"moves succeeded with nil arrays");
+    XCTAssertTrue([self.testArrays isEqual:self.originalArrays], @"arrays modified by invalid moves");
+}
+
+- (void)testMoveObjectsMustBeAPermutation {
+
+    [self resetArrays];
+
+    NSIndexPath *indexPath01 = [NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 0, 1 } length:2];
+    NSIndexPath *indexPath02 = [NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 0, 2 } length:2];
+    NSIndexPath *indexPath13 = [NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 1, 3 } length:2];
+
+    // Two objects to one place, which would lose the object at 0,2...
+    XCTAssertFalse([NSMutableArray moveObjectsInArrays:self.testArrays fromIndexPaths:@[ indexPath01, indexPath02 ] toIndexPaths:@[ indexPath02, indexPath02 ]], @"moves succeeded with a duplicate to index path");
+
+    // ...one object to two places...
+    XCTAssertFalse([NSMutableArray moveObjectsInArrays:self.testArrays fromIndexPaths:@[ indexPath01, indexPath01 ] toIndexPaths:@[ indexPath01, indexPath02 ]], @"moves succeeded with a duplicate from index path");
+
+    // ...and a move to a place nothing moves from.
+    XCTAssertFalse([NSMutableArray moveObjectsInArrays:self.testArrays fromIndexPaths:@[ indexPath01, indexPath02 ] toIndexPaths:@[ indexPath02, indexPath13 ]], @"moves succeeded with different from and to index paths");
+
+    XCTAssertTrue([self.testArrays isEqual:self.originalArrays], @"arrays modified by moves that aren't a permutation");
+
+    NSMutableArray *array = [self.originalArrays[0] mutableCopy];
+    NSIndexPath *indexPath11 = [NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 1, 1 } length:2];
+    XCTAssertFalse([NSMutableArray moveObjectsInArrays:@[ array, array ] fromIndexPaths:@[ indexPath01, indexPath11 ] toIndexPaths:@[ indexPath11, indexPath01 ]], @"moves succeeded with one array for two sections");
+    XCTAssertTrue([array isEqual:self.originalArrays[0]], @"array modified when it was used for two sections");
+}
+
+
+
+//--------------------------
+#pragma mark - Benchmarks...
+
+- (void)testPerformanceOfSingleExchanges {
+
+    NSArray *arrays = [self arraysWithSections:kBenchmarkSections itemsPerSection:kBenchmarkItemsPerSection];
+    SSExchangeSwap *swaps = malloc(kBenchmarkSwaps * sizeof(SSExchangeSwap));
+    for (NSUInteger i = 0; i < kBenchmarkSwaps; i++) {
+        swaps[i] = [self randomSwapForArrays:arrays];
+    }
+
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < kBenchmarkSwaps; i++) {
+            [NSMutableArray exchangeObjectInArray:arrays[ swaps[i].indexPath1.section ]
+                                          atIndex:swaps[i].indexPath1.item
+                           withObjectInOtherArray:arrays[ swaps[i].indexPath2.section ]
+                                          atIndex:swaps[i].indexPath2.item];
+        }
+    }];
+
+    free(swaps);
+}
+
+- (void)testPerformanceOfBatchExchange {
+
+    NSArray *arrays = [self arraysWithSections:kBenchmarkSections itemsPerSection:kBenchmarkItemsPerSection];
+    SSExchangeSwap *swaps = malloc(kBenchmarkSwaps * sizeof(SSExchangeSwap));
+    for (NSUInteger i = 0; i < kBenchmarkSwaps; i++) {
+        swaps[i] = [self randomSwapForArrays:arrays];
+    }
+
+    [self measureBlock:^{
+        (void) [NSMutableArray exchangeObjectsInArrays:arrays withSwaps:swaps count:kBenchmarkSwaps];
+    }];
+
+    free(swaps);
+}
+
+@end
@@ -0,0 +1,148 @@
+//
+//  RandomIndexPathSamplerTests.m
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+// Checks the demo's random index path sampler draws only available index paths, draws them
+// uniformly, and takes the same time to draw however many are excluded. Only Foundation and
+// XCTest are used.
+
+#import <XCTest/XCTest.h>
+#import "RandomIndexPathSampler.h"
+#import "NSIndexPath+RandomAdditions.h"
+
+
+@interface RandomIndexPathSamplerTests : XCTestCase
+
+@end
+
+
+@implementation RandomIndexPathSamplerTests
+
+- (NSIndexPath *)indexPathForItem:(NSUInteger)item inSection:(NSUInteger)section {
+
+    NSUInteger indexes[] = { section, item };
+    return [NSIndexPath indexPathWithIndexes:indexes length:2];
+}
+
+- (void)testOnlyAvailableIndexPathsAreDrawn {
+
+    NSUInteger numbersOfItemsInSections[] = { 2, 0, 3 };
+    NSSet *excludedIndexPaths = [NSSet setWithObjects:
+                                 [self indexPathForItem:1 inSection:0],
+                                 [self indexPathForItem:2 inSection:2],
+                                 [self indexPathForItem:0 inSection:1],     // not in the sections, ignored
+                                 [self indexPathForItem:9 inSection:0],     // ditto
+                                 nil];
+
+    RandomIndexPathSampler *sampler = [[RandomIndexPathSampler alloc] initWithNumbersOfItemsInSections:numbersOfItemsInSections
+                                                                                      numberOfSections:3
+                                                                                   excludingIndexPaths:excludedIndexPaths];
+    XCTAssertEqual(sampler.numberOfAvailableIndexPaths, (NSUInteger)3, @"wrong number available");
+
+    for (int i = 0; i < 100; i++) {
+        NSIndexPath *indexPath = [sampler randomIndexPath];
+        XCTAssertTrue([sampler isAvailableIndexPath:indexPath], @"drew %@", indexPath);
+        XCTAssertFalse([excludedIndexPaths containsObject:indexPath], @"drew excluded %@", indexPath);
+    }
+
+    NSArray *indexPaths = [sampler removeRandomIndexPaths:10];
+    NSSet *expectedIndexPaths = [NSSet setWithObjects:
+                                 [self indexPathForItem:0 inSection:0],
+                                 [self indexPathForItem:0 inSection:2],
+                                 [self indexPathForItem:1 inSection:2],
+                                 nil];
+    XCTAssertEqual(indexPaths.count, (NSUInteger)3, @"drew more than were available");
+    XCTAssertEqualObjects([NSSet setWithArray:indexPaths], expectedIndexPaths, @"drew the wrong index paths");
+    XCTAssertNil([sampler randomIndexPath], @"drew from an empty sampler");
+
+    [sampler restoreRemovedIndexPaths];
+    XCTAssertEqual(sampler.numberOfAvailableIndexPaths, (NSUInteger)3, @"removed index paths not restored");
+    XCTAssertFalse([sampler isAvailableIndexPath:[self indexPathForItem:1 inSection:0]], @"excluded index path restored");
+
+    [sampler removeIndexPath:[self indexPathForItem:0 inSection:2]];
+    [sampler removeIndexPath:[self indexPathForItem:0 inSection:2]];
+    XCTAssertEqual(sampler.numberOfAvailableIndexPaths, (NSUInteger)2, @"removing twice counted twice");
+}
+
+- (void)testDrawsAreUniformAcrossUnevenSections {
+
+    // Section 0 has 1 item and section 1 has 99. Picking the section first would draw 0,0 half the time.
+    NSUInteger numbersOfItemsInSections[] = { 1, 99 };
+    RandomIndexPathSampler *sampler = [[RandomIndexPathSampler alloc] initWithNumbersOfItemsInSections:numbersOfItemsInSections
+                                                                                      numberOfSections:2
+                                                                                   excludingIndexPaths:nil];
+    NSIndexPath *smallSectionIndexPath = [self indexPathForItem:0 inSection:0];
+    NSUInteger numberOfDraws = 100000;
+    NSUInteger numberInSmallSection = 0;
+
+    for (NSUInteger i = 0; i < numberOfDraws; i++) {
+        if ([[sampler randomIndexPath] isEqual:smallSectionIndexPath]) numberInSmallSection++;
+    }
+
+    // Expect 1000. Six standard deviations is about 190.
+    XCTAssertTrue(numberInSmallSection > 800 && numberInSmallSection < 1200, @"0,0 drawn %lu times in %lu", (unsigned long)numberInSmallSection, (unsigned long)numberOfDraws);
+}
+
+- (void)testDrawingManyGivesDistinctIndexPaths {
+
+    NSUInteger numbersOfItemsInSections[] = { 500, 1, 700 };
+    RandomIndexPathSampler *sampler = [[RandomIndexPathSampler alloc] initWithNumbersOfItemsInSections:numbersOfItemsInSections
+                                                                                      numberOfSections:3
+                                                                                   excludingIndexPaths:nil];
+    SSExchangeIndexPath indexPaths[1201];
+    NSUInteger numberDrawn = [sampler removeRandomIndexPaths:indexPaths count:1201];
+    XCTAssertEqual(numberDrawn, (NSUInteger)1201, @"didn't draw them all");
+
+    NSMutableSet *packedIndexPaths = [NSMutableSet set];
+    for (NSUInteger i = 0; i < numberDrawn; i++) {
+        XCTAssertTrue((NSUInteger)indexPaths[i].item < numbersOfItemsInSections[indexPaths[i].section], @"drew an item that doesn't exist");
+        [packedIndexPaths addObject:@(SSExchangeIndexPathPack(indexPaths[i]))];
+    }
+    XCTAssertEqual(packedIndexPaths.count, (NSUInteger)1201, @"drew an index path more than once");
+}
+
+- (void)testCategoryUsesEveryNonEmptySection {
+
+    NSArray *arrays = @[[NSMutableArray arrayWithObjects:@1, @2, nil], [NSMutableArray array], [NSMutableArray arrayWithObject:@3]];
+    NSSet *excludedIndexPaths = [NSSet setWithObjects:[self indexPathForItem:0 inSection:0], [self indexPathForItem:1 inSection:0], nil];
+
+    XCTAssertEqualObjects([NSIndexPath randomIndexPathInArrays:arrays excludingIndexPaths:excludedIndexPaths], [self indexPathForItem:0 inSection:2], @"the only available index path wasn't drawn");
+    XCTAssertNil([NSIndexPath randomIndexPathInArrays:@[@1] excludingIndexPaths:nil], @"drew from something that isn't an array");
+    XCTAssertNil([NSIndexPath randomIndexPathInArrays:@[[NSMutableArray array]] excludingIndexPaths:nil], @"drew from empty arrays");
+}
+
+
+
+//------------------------------
+#pragma mark - Performance...
+
+- (void)testPerformanceWithNearlyEverythingExcluded {
+
+    // 10,000 items with all but 10 excluded, the case where rejection sampling expects 1,000 tries
+    // per draw. Making the sampler is most of the time. The draws are 100,000 of them.
+
+    NSUInteger numbersOfItemsInSections[] = { 1000, 3000, 6000 };
+    NSMutableSet *excludedIndexPaths = [NSMutableSet set];
+    for (NSUInteger section = 0; section < 3; section++) {
+        for (NSUInteger item = 0; item < numbersOfItemsInSections[section]; item++) {
+            if (section != 2 || item >= 10) [excludedIndexPaths addObject:[self indexPathForItem:item inSection:section]];
+        }
+    }
+
+    [self measureBlock:^{
+
+        RandomIndexPathSampler *sampler = [[RandomIndexPathSampler alloc] initWithNumbersOfItemsInSections:numbersOfItemsInSections
+                                                                                          numberOfSections:3
+                                                                                       excludingIndexPaths:excludedIndexPaths];
+        SSExchangeIndexPath indexPaths[10];
+        for (int i = 0; i < 10000; i++) {
+            [sampler removeRandomIndexPaths:indexPaths count:10];
+            [sampler restoreRemovedIndexPaths];
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,293 @@
+//
+//  SSCollectionViewExchangeBackingStoreTests.m
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+// Applies the same random exchanges and moves to every kind of backing store and checks they
+// agree with each other, and that the int64 store's sums agree with adding up the items. Only
+// Foundation and XCTest are used so this file also builds and runs under GNUstep/XCTest on Linux.
+
+#import <XCTest/XCTest.h>
+#import "SSCollectionViewExchangeInt64Store.h"
+#import "NSMutableArray+SSCollectionViewExchangeControllerAdditions.h"
+#import "SSCollectionViewExchangeTestSupport.h"
+
+
+static uint32_t const kSections = 3;
+static uint32_t const kItemsPerSection = 50;
+
+static uint32_t const kBenchmarkItemsPerSection = 10000;
+static NSUInteger const kBenchmarkSwaps = 100000;
+
+
+@interface SSCollectionViewExchangeBackingStoreTests : SSCollectionViewExchangeTestCase
+
+@property (strong, nonatomic) NSString *path;
+
+@end
+
+
+@implementation SSCollectionViewExchangeBackingStoreTests
+
+- (void)setUp {
+
+    [super setUp];
+    self.path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"SSCollectionViewExchangeBackingStoreTests.store"];
+    [[NSFileManager defaultManager] removeItemAtPath:self.path error:NULL];
+}
+
+- (void)tearDown {
+
+    [[NSFileManager defaultManager] removeItemAtPath:self.path error:NULL];
+    [super tearDown];
+}
+
+- (void)assertStore:(SSCollectionViewExchangeInt64Store *)store equalToArrays:(NSArray *)arrays {
+
+    XCTAssertEqual([store numberOfSections], arrays.count, @"wrong number of sections");
+
+    for (NSUInteger section = 0; section < arrays.count; section++) {
+
+        NSArray *array = arrays[section];
+        XCTAssertEqual([store numberOfItemsInSection:section], array.count, @"wrong number of items");
+
+        const int64_t *items = [store itemsInSection:section];
+        int64_t sum = 0;
+        for (NSUInteger item = 0; item < array.count; item++) {
+            XCTAssertEqual(items[item], [array[item] longLongValue], @"items differ");
+            sum += items[item];
+        }
+        XCTAssertEqual([store sumOfItemsInSection:section], sum, @"sum not maintained");
+    }
+}
+
+
+
+//---------------------------
+#pragma mark - Exchanging...
+
+- (void)testStoresAgreeAfterRandomExchanges {
+
+    NSArray *arrays = [self arraysWithSections:kSections itemsPerSection:kItemsPerSection];
+    SSCollectionViewExchangeArrayStore *arrayStore = [[SSCollectionViewExchangeArrayStore alloc] initWithArrays:arrays];
+    SSCollectionViewExchangeInt64Store *int64Store = [[SSCollectionViewExchangeInt64Store alloc] initWithArrays:arrays];
+
+    for (int i = 0; i < 1000; i++) {
+
+        // Sometimes one at a time, sometimes in batches...
+        SSExchangeSwap swaps[8];
+        NSUInteger count = 1 + [self randomNumberLessThan:8];
+        for (NSUInteger j = 0; j < count; j++) {
+            swaps[j] = [self randomSwapInSections:kSections itemsPerSection:kItemsPerSection];
+        }
+
+        XCTAssertTrue([arrayStore exchangeItemsWithSwaps:swaps count:count], @"array store refused valid swaps");
+        XCTAssertTrue([int64Store exchangeItemsWithSwaps:swaps count:count], @"int64 store refused valid swaps");
+    }
+
+    [self assertStore:int64Store equalToArrays:arrays];
+}
+
+- (void)testStoresAgreeAfterComposedMoves {
+
+    NSArray *arrays = [self arraysWithSections:kSections itemsPerSection:kItemsPerSection];
+    SSCollectionViewExchangeArrayStore *arrayStore = [[SSCollectionViewExchangeArrayStore alloc] initWithArrays:arrays];
+    SSCollectionViewExchangeInt64Store *int64Store = [[SSCollectionViewExchangeInt64Store alloc] initWithArrays:arrays];
+    SSCollectionViewExchangeInt64Store *swappedStore = [[SSCollectionViewExchangeInt64Store alloc] initWithArrays:arrays];
+
+    SSExchangeSwap swaps[40];
+    SSExchangeMove moves[80];
+    for (int i = 0; i < 40; i++) {
+        swaps[i] = [self randomSwapInSections:kSections itemsPerSection:kItemsPerSection];
+    }
+    unsigned int numberOfMoves = SSExchangeComposeSwaps(swaps, 40, moves);
+
+    XCTAssertTrue([arrayStore moveItemsWithMoves:moves count:numberOfMoves], @"array store refused valid moves");
+    XCTAssertTrue([int64Store moveItemsWithMoves:moves count:numberOfMoves], @"int64 store refused valid moves");
+    XCTAssertTrue([swappedStore exchangeItemsWithSwaps:swaps count:40], @"int64 store refused valid swaps");
+
+    [self assertStore:int64Store equalToArrays:arrays];
+    XCTAssertEqualObjects([int64Store data], [swappedStore data], @"moves and swaps disagree");
+}
+
+- (void)testInvalidSwapsChangeNothing {
+
+    NSArray *arrays = [self arraysWithSections:kSections itemsPerSection:4];
+    SSCollectionViewExchangeInt64Store *store = [[SSCollectionViewExchangeInt64Store alloc] initWithArrays:arrays];
+    NSData *before = [store data];
+
+    SSExchangeSwap swaps[] = { SSExchangeSwapMake(SSExchangeIndexPathMake(0, 0), SSExchangeIndexPathMake(1, 1)),
+                               SSExchangeSwapMake(SSExchangeIndexPathMake(0, 0), SSExchangeIndexPathMake(1, 4)) };
+    SSExchangeSwap noneSwap = SSExchangeSwapMake(SSExchangeIndexPathNone, SSExchangeIndexPathNone);
+
+    XCTAssertFalse([store exchangeItemsWithSwaps:swaps count:2], @"accepted an item that doesn't exist");
+    XCTAssertFalse([store exchangeItemsWithSwaps:NULL count:1], @"accepted NULL swaps");
+    XCTAssertFalse([store exchangeItemsWithSwaps:&noneSwap count:1], @"accepted SSExchangeIndexPathNone");
+    XCTAssertEqualObjects([store data], before, @"store changed");
+
+    XCTAssertTrue([store exchangeItemsWithSwaps:NULL count:0], @"refused nothing to do");
+}
+
+- (void)testMovesThatArentAPermutationChangeNothing {
+
+    NSArray *arrays = [self arraysWithSections:kSections itemsPerSection:4];
+    SSCollectionViewExchangeInt64Store *store = [[SSCollectionViewExchangeInt64Store alloc] initWithArrays:arrays];
+    NSData *before = [store data];
+    int64_t sums[kSections];
+    for (uint32_t section = 0; section < kSections; section++) sums[section] = [store sumOfItemsInSection:section];
+
+    SSExchangeIndexPath a = SSExchangeIndexPathMake(0, 1);
+    SSExchangeIndexPath b = SSExchangeIndexPathMake(1, 2);
+    SSExchangeIndexPath c = SSExchangeIndexPathMake(2, 3);
+    SSExchangeMove repeatedTo[] = { { a, c }, { b, c } };
+    SSExchangeMove repeatedFrom[] = { { a, b }, { a, c } };
+    SSExchangeMove notMovedFrom[] = { { a, b }, { b, c } };
+
+    XCTAssertFalse([store moveItemsWithMoves:repeatedTo count:2], @"accepted a toIndexPath named twice");
+    XCTAssertFalse([store moveItemsWithMoves:repeatedFrom count:2], @"accepted a fromIndexPath named twice");
+    XCTAssertFalse([store moveItemsWithMoves:notMovedFrom count:2], @"accepted a toIndexPath that isn't moved from");
+    XCTAssertEqualObjects([store data], before, @"store changed");
+    for (uint32_t section = 0; section < kSections; section++) {
+        XCTAssertEqual([store sumOfItemsInSection:section], sums[section], @"sum changed");
+    }
+
+    SSExchangeMove cycle[] = { { a, b }, { b, c }, { c, a } };
+    XCTAssertTrue([store moveItemsWithMoves:cycle count:3], @"refused a permutation");
+}
+
+- (void)testSettingItemsMaintainsSums {
+
+    NSUInteger numbersOfItems[] = { 3, 0, 2 };
+    SSCollectionViewExchangeInt64Store *store = [[SSCollectionViewExchangeInt64Store alloc] initWithNumbersOfItems:numbersOfItems numberOfSections:3];
+
+    [store setItem:INT64_MAX atIndexPath:SSExchangeIndexPathMake(0, 0)];
+    [store setItem:-5 atIndexPath:SSExchangeIndexPathMake(0, 2)];
+    [store setItem:7 atIndexPath:SSExchangeIndexPathMake(2, 1)];
+    XCTAssertEqual([store sumOfItemsInSection:0], INT64_MAX - 5, @"wrong sum");
+
+    SSExchangeSwap swap = SSExchangeSwapMake(SSExchangeIndexPathMake(0, 0), SSExchangeIndexPathMake(2, 1));
+    [store exchangeItemsWithSwaps:&swap count:1];
+    XCTAssertEqual([store sumOfItemsInSection:0], (int64_t)2, @"wrong sum after exchange");
+    XCTAssertEqual([store sumOfItemsInSection:1], (int64_t)0, @"wrong sum for an empty section");
+    XCTAssertEqual([store sumOfItemsInSection:2], INT64_MAX, @"wrong sum after exchange");
+}
+
+
+
+//-------------------------------------
+#pragma mark - Data and mapped files...
+
+- (void)testDataRoundTrips {
+
+    NSArray *arrays = [self arraysWithSections:kSections itemsPerSection:kItemsPerSection];
+    SSCollectionViewExchangeInt64Store *store = [[SSCollectionViewExchangeInt64Store alloc] initWithArrays:arrays];
+    SSCollectionViewExchangeInt64Store *copy = [[SSCollectionViewExchangeInt64Store alloc] initWithData:[store data]];
+
+    [self assertStore:copy equalToArrays:arrays];
+}
+
+- (void)testMalformedDataIsRejected {
+
+    NSArray *arrays = [self arraysWithSections:kSections itemsPerSection:4];
+    NSData *data = [[[SSCollectionViewExchangeInt64Store alloc] initWithArrays:arrays] data];
+
+    NSMutableData *wrongMagic = [data mutableCopy];
+    ((uint8_t *)wrongMagic.mutableBytes)[0] ^= 0xFF;
+
+    NSMutableData *wrongCount = [data mutableCopy];
+    ((uint64_t *)((uint8_t *)wrongCount.mutableBytes + 16))[1] = 5;
+
+    XCTAssertNil([[SSCollectionViewExchangeInt64Store alloc] initWithData:[NSData data]], @"accepted no data");
+    XCTAssertNil([[SSCollectionViewExchangeInt64Store alloc] initWithData:[data subdataWithRange:NSMakeRange(0, data.length - 8)]], @"accepted a missing item");
+    XCTAssertNil([[SSCollectionViewExchangeInt64Store alloc] initWithData:wrongMagic], @"accepted the wrong magic number");
+    XCTAssertNil([[SSCollectionViewExchangeInt64Store alloc] initWithData:wrongCount], @"accepted counts that don't match the items");
+}
+
+- (void)testMappedStoreChangesFile {
+
+    NSArray *arrays = [self arraysWithSections:kSections itemsPerSection:kItemsPerSection];
+    SSCollectionViewExchangeInt64Store *store = [[SSCollectionViewExchangeInt64Store alloc] initWithArrays:arrays];
+    XCTAssertTrue([[store data] writeToFile:self.path atomically:YES], @"couldn't write the file");
+
+    SSCollectionViewExchangeMappedInt64Store *mappedStore = [[SSCollectionViewExchangeMappedInt64Store alloc] initWithContentsOfFile:self.path];
+    XCTAssertNotNil(mappedStore, @"couldn't map the file");
+
+    SSExchangeSwap swaps[100];
+    for (int i = 0; i < 100; i++) {
+        swaps[i] = [self randomSwapInSections:kSections itemsPerSection:kItemsPerSection];
+    }
+    [store exchangeItemsWithSwaps:swaps count:100];
+    [mappedStore exchangeItemsWithSwaps:swaps count:100];
+    XCTAssertTrue([mappedStore synchronize], @"couldn't synchronize");
+    mappedStore = nil;
+
+    XCTAssertEqualObjects([NSData dataWithContentsOfFile:self.path], [store data], @"file doesn't hold the exchanges");
+
+    SSCollectionViewExchangeMappedInt64Store *reopenedStore = [[SSCollectionViewExchangeMappedInt64Store alloc] initWithContentsOfFile:self.path];
+    XCTAssertEqual([reopenedStore sumOfItemsInSection:1], [store sumOfItemsInSection:1], @"sums differ after reopening");
+}
+
+
+
+//------------------------------
+#pragma mark - Performance...
+
+// Both tests apply 100,000 random exchanges to 3 sections of 10,000 items, then read every
+// section's sum. Compare the two in the test report.
+
+- (void)fillRandomSwaps:(SSExchangeSwap *)swaps {
+
+    for (NSUInteger i = 0; i < kBenchmarkSwaps; i++) {
+        swaps[i] = [self randomSwapInSections:kSections itemsPerSection:kBenchmarkItemsPerSection];
+    }
+}
+
+- (void)testPerformanceOfBoxedArrays {
+
+    NSArray *arrays = [self arraysWithSections:kSections itemsPerSection:kBenchmarkItemsPerSection];
+    SSExchangeSwap *swaps = malloc(kBenchmarkSwaps * sizeof(SSExchangeSwap));
+    [self fillRandomSwaps:swaps];
+
+    [self measureBlock:^{
+
+        for (NSUInteger i = 0; i < kBenchmarkSwaps; i++) {
+            [NSMutableArray exchangeObjectInArray:arrays[ swaps[i].indexPath1.section ] atIndex:swaps[i].indexPath1.item
+                           withObjectInOtherArray:arrays[ swaps[i].indexPath2.section ] atIndex:swaps[i].indexPath2.item];
+        }
+
+        long long total = 0;
+        for (NSArray *array in arrays) {
+            for (NSNumber *number in array) total += [number longLongValue];
+        }
+        XCTAssertTrue(total > 0, @"no items");
+    }];
+
+    free(swaps);
+}
+
+- (void)testPerformanceOfInt64Store {
+
+    NSArray *arrays = [self arraysWithSections:kSections itemsPerSection:kBenchmarkItemsPerSection];
+    SSCollectionViewExchangeInt64Store *store = [[SSCollectionViewExchangeInt64Store alloc] initWithArrays:arrays];
+    SSExchangeSwap *swaps = malloc(kBenchmarkSwaps * sizeof(SSExchangeSwap));
+    [self fillRandomSwaps:swaps];
+
+    [self measureBlock:^{
+
+        for (NSUInteger i = 0; i < kBenchmarkSwaps; i++) {
+            [store exchangeItemsWithSwaps:&swaps[i] count:1];
+        }
+
+        long long total = 0;
+        for (NSUInteger section = 0; section < kSections; section++) {
+            total += [store sumOfItemsInSection:section];
+        }
+        XCTAssertTrue(total > 0, @"no items");
+    }];
+
+    free(swaps);
+}
+
+@end
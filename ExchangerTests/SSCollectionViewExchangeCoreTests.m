@@ -0,0 +1,312 @@
+//
+//  SSCollectionViewExchangeCoreTests.m
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+// Drives the UIKit-free exchange core with synthetic "finger is over (section, item)" events,
+// applying the swaps it emits to a model and the moves it emits to a mirror of the view, and
+// checks the two stay in sync. Only Foundation and XCTest are used.
+
+#import <XCTest/XCTest.h>
+#import "SSCollectionViewExchangeCore.h"
+#import "SSCollectionViewExchangeTestSupport.h"
+
+
+enum {
+    kSections = 3,
+    kItemsPerSection = 7
+};
+
+
+static bool CannotDisplaceLockedItem(SSExchangeIndexPath indexPathOfItemToDisplace,
+                                     SSExchangeIndexPath indexPathOfItemBeingDragged,
+                                     void *context) {
+
+    SSExchangeIndexPath *lockedIndexPath = context;
+    return !SSExchangeIndexPathEqualToIndexPath(indexPathOfItemToDisplace, *lockedIndexPath);
+}
+
+
+
+@interface SSCollectionViewExchangeCoreTests : SSCollectionViewExchangeTestCase
+
+@end
+
+
+@implementation SSCollectionViewExchangeCoreTests
+
+- (SSExchangeIndexPath)randomIndexPath {
+
+    return [self randomIndexPathInSections:kSections itemsPerSection:kItemsPerSection];
+}
+
+
+
+//----------------------------
+#pragma mark - Event types...
+
+- (void)testEventTypesFollowTheTimeline {
+
+    // The example from the README: catch at 0,3 then drag over 1,3, 1,4 and 1,5.
+
+    SSExchangeCore core;
+    SSExchangeCoreBegin(&core, SSExchangeIndexPathMake(0, 3));
+
+    SSExchangeEvent event = SSExchangeCoreUpdate(&core, SSExchangeIndexPathMake(0, 3), NULL, NULL);
+    XCTAssertEqual(event.type, SSExchangeEventTypeNothingToExchange, @"exchange while still over the starting item");
+
+    event = SSExchangeCoreUpdate(&core, SSExchangeIndexPathMake(1, 3), NULL, NULL);
+    XCTAssertEqual(event.type, SSExchangeEventTypeDraggedFromStartingItem, @"first event type");
+    XCTAssertEqual(event.numberOfSwaps, 1u, @"first event should have one exchange");
+
+    event = SSExchangeCoreUpdate(&core, SSExchangeIndexPathNone, NULL, NULL);
+    XCTAssertEqual(event.type, SSExchangeEventTypeNothingToExchange, @"exchange while between items");
+
+    event = SSExchangeCoreUpdate(&core, SSExchangeIndexPathMake(1, 4), NULL, NULL);
+    XCTAssertEqual(event.type, SSExchangeEventTypeDraggedToOtherItem, @"second event type");
+    XCTAssertEqual(event.numberOfSwaps, 2u, @"second event should undo then exchange");
+
+    event = SSExchangeCoreUpdate(&core, SSExchangeIndexPathMake(1, 5), NULL, NULL);
+    XCTAssertEqual(event.type, SSExchangeEventTypeDraggedToOtherItem, @"third event type");
+
+    SSExchangeSwap finalExchange = SSExchangeCoreFinish(&core);
+    XCTAssertTrue(SSExchangeIndexPathEqualToIndexPath(finalExchange.indexPath1, SSExchangeIndexPathMake(1, 5)), @"final exchange should include 1,5");
+    XCTAssertTrue(SSExchangeIndexPathEqualToIndexPath(finalExchange.indexPath2, SSExchangeIndexPathMake(0, 3)), @"final exchange should include 0,3");
+}
+
+- (void)testDraggingBackToStartingItem {
+
+    SSExchangeCore core;
+    SSExchangeCoreBegin(&core, SSExchangeIndexPathMake(0, 0));
+
+    (void) SSExchangeCoreUpdate(&core, SSExchangeIndexPathMake(2, 2), NULL, NULL);
+    SSExchangeEvent event = SSExchangeCoreUpdate(&core, SSExchangeIndexPathMake(0, 0), NULL, NULL);
+
+    XCTAssertEqual(event.type, SSExchangeEventTypeDraggedToStartingItem, @"back to the starting item");
+
+    SSExchangeSwap finalExchange = SSExchangeCoreFinish(&core);
+    XCTAssertTrue(SSExchangeIndexPathEqualToIndexPath(finalExchange.indexPath1, finalExchange.indexPath2), @"nothing exchanged but index paths differ");
+}
+
+- (void)testCannotDisplaceItem {
+
+    SSExchangeIndexPath lockedIndexPath = SSExchangeIndexPathMake(1, 1);
+    SSExchangeCore core;
+    SSExchangeCoreBegin(&core, SSExchangeIndexPathMake(0, 0));
+
+    SSExchangeEvent event = SSExchangeCoreUpdate(&core, lockedIndexPath, CannotDisplaceLockedItem, &lockedIndexPath);
+    XCTAssertEqual(event.type, SSExchangeEventTypeCannotDisplaceItem, @"locked item displaced");
+    XCTAssertEqual(event.numberOfSwaps, 0u, @"swaps emitted for a locked item");
+}
+
+- (void)testNoEventsOutsideTransaction {
+
+    SSExchangeCore core;
+    SSExchangeCoreReset(&core);
+
+    SSExchangeEvent event = SSExchangeCoreUpdate(&core, SSExchangeIndexPathMake(1, 1), NULL, NULL);
+    XCTAssertEqual(event.type, SSExchangeEventTypeNothingToExchange, @"event outside a transaction");
+
+    SSExchangeSwap undoExchange;
+    XCTAssertFalse(SSExchangeCoreCancel(&core, &undoExchange), @"cancel outside a transaction");
+}
+
+
+
+//--------------------------------------
+#pragma mark - Random drags...
+
+- (void)testRandomDragsKeepModelAndViewInSync {
+
+    for (int trial = 0; trial < 10000; trial++) {
+
+        SSExchangeTestGrid model, view;
+        SSExchangeTestGridReset(&model, kSections, kItemsPerSection);
+        SSExchangeTestGridReset(&view, kSections, kItemsPerSection);
+
+        SSExchangeCore core;
+        SSExchangeCoreBegin(&core, [self randomIndexPath]);
+
+        uint32_t steps = [self randomNumberLessThan:12];
+        for (uint32_t step = 0; step < steps; step++) {
+
+            SSExchangeIndexPath indexPath = ([self randomNumberLessThan:8] == 0)? SSExchangeIndexPathNone : [self randomIndexPath];
+            SSExchangeEvent event = SSExchangeCoreUpdate(&core, indexPath, NULL, NULL);
+
+            SSExchangeTestGridApplySwaps(&model, event.swaps, event.numberOfSwaps);
+            SSExchangeTestGridApplyMoves(&view, event.moves, event.numberOfMoves);
+
+            XCTAssertTrue(SSExchangeTestGridEqualToGrid(&model, &view), @"model and view out of sync on trial %d", trial);
+        }
+
+        if ([self randomNumberLessThan:4] == 0) {
+
+            SSExchangeSwap undoExchange;
+            if (SSExchangeCoreCancel(&core, &undoExchange)) SSExchangeTestGridApplySwaps(&model, &undoExchange, 1);
+            XCTAssertEqual(SSExchangeTestGridNumberOfItemsOutOfPlace(&model), 0u, @"cancel did not restore the model on trial %d", trial);
+
+        } else {
+
+            // The final exchange is reported, not applied. Applying it again must restore the model.
+            SSExchangeSwap finalExchange = SSExchangeCoreFinish(&core);
+            SSExchangeTestGridApplySwaps(&model, &finalExchange, 1);
+            XCTAssertEqual(SSExchangeTestGridNumberOfItemsOutOfPlace(&model), 0u, @"final exchange does not match the model on trial %d", trial);
+        }
+    }
+}
+
+//-----------------------------
+#pragma mark - Composition...
+
+- (void)testComposedSwapsMatchEventMoves {
+
+    // For every event the net permutation of its swaps is the same change as its moves.
+
+    for (int trial = 0; trial < 10000; trial++) {
+
+        SSExchangeCore core;
+        SSExchangeCoreBegin(&core, [self randomIndexPath]);
+
+        for (int step = 0; step < 8; step++) {
+
+            SSExchangeEvent event = SSExchangeCoreUpdate(&core, [self randomIndexPath], NULL, NULL);
+
+            SSExchangeTestGrid fromSwaps, fromComposition;
+            SSExchangeTestGridReset(&fromSwaps, kSections, kItemsPerSection);
+            SSExchangeTestGridReset(&fromComposition, kSections, kItemsPerSection);
+
+            SSExchangeTestGridApplySwaps(&fromSwaps, event.swaps, event.numberOfSwaps);
+
+            SSExchangeMove moves[4];
+            unsigned int numberOfMoves = SSExchangeComposeSwaps(event.swaps, event.numberOfSwaps, moves);
+            SSExchangeTestGridApplyMoves(&fromComposition, moves, numberOfMoves);
+
+            XCTAssertTrue(SSExchangeTestGridEqualToGrid(&fromSwaps, &fromComposition), @"composition differs from swaps on trial %d", trial);
+            XCTAssertEqual(numberOfMoves, event.numberOfMoves, @"composition has a different number of moves on trial %d", trial);
+        }
+    }
+}
+
+- (void)testComposedSwapsThatCancelOutHaveNoMoves {
+
+    SSExchangeIndexPath a = SSExchangeIndexPathMake(0, 1), b = SSExchangeIndexPathMake(1, 2), c = SSExchangeIndexPathMake(2, 3);
+    SSExchangeSwap swaps[] = { SSExchangeSwapMake(a, b), SSExchangeSwapMake(b, c), SSExchangeSwapMake(b, c), SSExchangeSwapMake(b, a), SSExchangeSwapMake(c, c) };
+    SSExchangeMove moves[10];
+
+    XCTAssertEqual(SSExchangeComposeSwaps(swaps, 5, moves), 0u, @"swaps that cancel out produced moves");
+    XCTAssertEqual(SSExchangeComposeSwaps(swaps, 0, moves), 0u, @"no swaps produced moves");
+}
+
+- (void)testComposedSwapsOfRandomSequences {
+
+    for (int trial = 0; trial < 10000; trial++) {
+
+        SSExchangeTestGrid fromSwaps, fromComposition;
+        SSExchangeTestGridReset(&fromSwaps, kSections, kItemsPerSection);
+        SSExchangeTestGridReset(&fromComposition, kSections, kItemsPerSection);
+
+        SSExchangeSwap swaps[16];
+        unsigned int numberOfSwaps = [self randomNumberLessThan:16];
+        for (unsigned int i = 0; i < numberOfSwaps; i++) {
+            swaps[i] = SSExchangeSwapMake([self randomIndexPath], [self randomIndexPath]);
+            SSExchangeTestGridApplySwaps(&fromSwaps, &swaps[i], 1);
+        }
+
+        SSExchangeMove moves[32];
+        unsigned int numberOfMoves = SSExchangeComposeSwaps(swaps, numberOfSwaps, moves);
+        SSExchangeTestGridApplyMoves(&fromComposition, moves, numberOfMoves);
+
+        XCTAssertTrue(SSExchangeTestGridEqualToGrid(&fromSwaps, &fromComposition), @"composition differs from swaps on trial %d", trial);
+        for (unsigned int i = 0; i < numberOfMoves; i++) {
+            XCTAssertFalse(SSExchangeIndexPathEqualToIndexPath(moves[i].fromIndexPath, moves[i].toIndexPath), @"move to the same place on trial %d", trial);
+        }
+    }
+}
+
+
+- (void)testCoalescingUnchangedExchangeHasNoSwaps {
+
+    SSExchangeIndexPath a = SSExchangeIndexPathMake(0, 1), b = SSExchangeIndexPathMake(1, 2);
+    SSExchangeSwap exchange = SSExchangeSwapMake(a, b), nothingExchanged = SSExchangeSwapMake(a, a);
+    SSExchangeSwap swaps[2];
+
+    XCTAssertEqual(SSExchangeCoalesceExchanges(&exchange, &exchange, 1, swaps), 0u, @"an unchanged exchange produced swaps");
+    XCTAssertEqual(SSExchangeCoalesceExchanges(&nothingExchanged, &exchange, 1, swaps), 1u, @"an item exchanged with itself was undone");
+    XCTAssertEqual(SSExchangeCoalesceExchanges(&exchange, &nothingExchanged, 1, swaps), 1u, @"an item exchanged with itself was exchanged");
+}
+
+- (void)testCoalescedExchangeEventsKeepModelAndViewInSync {
+
+    // One model follows every exchange event. Another, and the view, only catch up now and then,
+    // as the exchange controller does while a batch update is animating.
+
+    for (int trial = 0; trial < 10000; trial++) {
+
+        SSExchangeTestGrid everyEvent, model, view;
+        SSExchangeTestGridReset(&everyEvent, kSections, kItemsPerSection);
+        SSExchangeTestGridReset(&model, kSections, kItemsPerSection);
+        SSExchangeTestGridReset(&view, kSections, kItemsPerSection);
+
+        SSExchangeCore core;
+        SSExchangeCoreBegin(&core, [self randomIndexPath]);
+        SSExchangeSwap committedExchange = SSExchangeCoreExchange(&core);
+
+        for (int step = 0; step < 12; step++) {
+
+            SSExchangeIndexPath indexPath = ([self randomNumberLessThan:8] == 0)? SSExchangeIndexPathNone : [self randomIndexPath];
+            SSExchangeEvent event = SSExchangeCoreUpdate(&core, indexPath, NULL, NULL);
+            SSExchangeTestGridApplySwaps(&everyEvent, event.swaps, event.numberOfSwaps);
+
+            if (step < 11 && [self randomNumberLessThan:3] != 0) continue;
+
+            SSExchangeSwap exchange = SSExchangeCoreExchange(&core);
+            SSExchangeSwap swaps[2];
+            unsigned int numberOfSwaps = SSExchangeCoalesceExchanges(&committedExchange, &exchange, 1, swaps);
+            committedExchange = exchange;
+
+            SSExchangeTestGridApplySwaps(&model, swaps, numberOfSwaps);
+            SSExchangeMove moves[4];
+            SSExchangeTestGridApplyMoves(&view, moves, SSExchangeComposeSwaps(swaps, numberOfSwaps, moves));
+
+            XCTAssertTrue(SSExchangeTestGridEqualToGrid(&model, &everyEvent), @"coalesced model differs on trial %d", trial);
+            XCTAssertTrue(SSExchangeTestGridEqualToGrid(&model, &view), @"model and view out of sync on trial %d", trial);
+        }
+
+        SSExchangeSwap finalExchange = SSExchangeCoreFinish(&core);
+        SSExchangeTestGridApplySwaps(&model, &finalExchange, 1);
+        XCTAssertEqual(SSExchangeTestGridNumberOfItemsOutOfPlace(&model), 0u, @"final exchange does not match the model on trial %d", trial);
+    }
+}
+
+
+
+//------------------------------
+#pragma mark - Performance...
+
+- (void)testPerformanceOfReplayingDragEvents {
+
+    SSExchangeIndexPath *trace = malloc(1000000 * sizeof(SSExchangeIndexPath));
+    for (int i = 0; i < 1000000; i++) trace[i] = [self randomIndexPath];
+
+    [self measureBlock:^{
+
+        SSExchangeTestGrid model;
+        SSExchangeTestGridReset(&model, kSections, kItemsPerSection);
+
+        SSExchangeCore core;
+        SSExchangeCoreBegin(&core, trace[0]);
+
+        for (int i = 1; i < 1000000; i++) {
+            SSExchangeEvent event = SSExchangeCoreUpdate(&core, trace[i], NULL, NULL);
+            SSExchangeTestGridApplySwaps(&model, event.swaps, event.numberOfSwaps);
+        }
+
+        (void) SSExchangeCoreFinish(&core);
+    }];
+
+    free(trace);
+}
+
+@end
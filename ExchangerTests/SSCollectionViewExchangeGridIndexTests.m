@@ -0,0 +1,214 @@
+//
+//  SSCollectionViewExchangeGridIndexTests.m
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+// Builds grid indexes from synthetic frames, laid out the way a flow layout would lay them out,
+// and checks every lookup against a linear scan of the frames. Only Foundation and XCTest are used.
+
+#import <XCTest/XCTest.h>
+#import "SSCollectionViewExchangeGridIndex.h"
+#import "SSCollectionViewExchangeTestSupport.h"
+
+
+typedef struct {
+    size_t              count;
+    SSExchangeRect      *frames;
+    SSExchangeIndexPath *indexPaths;
+} Layout;
+
+static void LayoutFree(Layout *layout) {
+
+    free(layout->frames);
+    free(layout->indexPaths);
+}
+
+static SSExchangeIndexPath LinearScan(const Layout *layout, double x, double y) {
+
+    for (size_t i = 0; i < layout->count; i++) {
+        SSExchangeRect frame = layout->frames[i];
+        if (frame.width > 0.0 && frame.height > 0.0 &&
+            x >= frame.x && x < frame.x + frame.width && y >= frame.y && y < frame.y + frame.height) {
+            return layout->indexPaths[i];
+        }
+    }
+    return SSExchangeIndexPathNone;
+}
+
+
+
+@interface SSCollectionViewExchangeGridIndexTests : SSCollectionViewExchangeTestCase
+
+@end
+
+
+@implementation SSCollectionViewExchangeGridIndexTests
+
+- (Layout)flowLayoutWithSections:(int32_t)sections itemsPerSection:(int32_t)itemsPerSection itemSize:(double)itemSize {
+
+    // A vertical flow layout, 320 points wide, with 10 point spacing and a 40 point header per section.
+
+    Layout layout;
+    layout.count = (size_t)sections * itemsPerSection;
+    layout.frames = malloc(layout.count * sizeof(SSExchangeRect));
+    layout.indexPaths = malloc(layout.count * sizeof(SSExchangeIndexPath));
+
+    int32_t columns = (int32_t)((320.0 - 10.0) / (itemSize + 10.0));
+    double y = 0.0;
+    size_t i = 0;
+
+    for (int32_t section = 0; section < sections; section++) {
+
+        y += 40.0;
+        for (int32_t item = 0; item < itemsPerSection; item++, i++) {
+            layout.frames[i] = (SSExchangeRect){ 10.0 + (item % columns) * (itemSize + 10.0),
+                                                 y + (item / columns) * (itemSize + 10.0),
+                                                 itemSize,
+                                                 itemSize };
+            layout.indexPaths[i] = SSExchangeIndexPathMake(section, item);
+        }
+        y += ((itemsPerSection + columns - 1) / columns) * (itemSize + 10.0);
+    }
+
+    return layout;
+}
+
+- (void)assertGridIndex:(SSExchangeGridIndex *)gridIndex matchesLayout:(Layout *)layout lookups:(int)lookups {
+
+    double maxX = 0.0, maxY = 0.0;
+    for (size_t i = 0; i < layout->count; i++) {
+        maxX = fmax(maxX, layout->frames[i].x + layout->frames[i].width);
+        maxY = fmax(maxY, layout->frames[i].y + layout->frames[i].height);
+    }
+
+    for (int lookup = 0; lookup < lookups; lookup++) {
+
+        // Quarter points land on the edges of the frames often enough to exercise them. Some
+        // points are outside the frames altogether.
+        double x = [self randomNumberLessThan:(uint32_t)(maxX + 80.0) * 4] / 4.0 - 40.0;
+        double y = [self randomNumberLessThan:(uint32_t)(maxY + 80.0) * 4] / 4.0 - 40.0;
+
+        SSExchangeIndexPath expected = LinearScan(layout, x, y);
+        SSExchangeIndexPath actual = SSExchangeGridIndexIndexPathAtPoint(gridIndex, x, y);
+        XCTAssertTrue(SSExchangeIndexPathEqualToIndexPath(expected, actual), @"wrong item at %f, %f", x, y);
+    }
+}
+
+
+
+//--------------------------
+#pragma mark - Lookups...
+
+- (void)testFlowLayoutLookupsMatchLinearScan {
+
+    Layout layout = [self flowLayoutWithSections:3 itemsPerSection:7 itemSize:57.0];
+    SSExchangeGridIndex *gridIndex = SSExchangeGridIndexCreate(layout.frames, layout.indexPaths, layout.count);
+
+    XCTAssertEqual(SSExchangeGridIndexCount(gridIndex), layout.count, @"items missing from the index");
+    [self assertGridIndex:gridIndex matchesLayout:&layout lookups:100000];
+
+    SSExchangeGridIndexFree(gridIndex);
+    LayoutFree(&layout);
+}
+
+- (void)testEdgesFollowCGRectContainsPoint {
+
+    SSExchangeRect frames[] = { { 0.0, 0.0, 10.0, 10.0 }, { 10.0, 0.0, 10.0, 10.0 } };
+    SSExchangeIndexPath indexPaths[] = { SSExchangeIndexPathMake(0, 0), SSExchangeIndexPathMake(0, 1) };
+    SSExchangeGridIndex *gridIndex = SSExchangeGridIndexCreate(frames, indexPaths, 2);
+
+    XCTAssertEqual(SSExchangeGridIndexIndexPathAtPoint(gridIndex, 0.0, 0.0).item, 0, @"minimum edge is inside");
+    XCTAssertEqual(SSExchangeGridIndexIndexPathAtPoint(gridIndex, 10.0, 5.0).item, 1, @"shared edge belongs to the item on the right");
+    XCTAssertTrue(SSExchangeIndexPathIsNone(SSExchangeGridIndexIndexPathAtPoint(gridIndex, 20.0, 5.0)), @"maximum edge is outside");
+    XCTAssertTrue(SSExchangeIndexPathIsNone(SSExchangeGridIndexIndexPathAtPoint(gridIndex, 5.0, 10.0)), @"maximum edge is outside");
+    XCTAssertTrue(SSExchangeIndexPathIsNone(SSExchangeGridIndexIndexPathAtPoint(gridIndex, -0.5, 5.0)), @"point before the items");
+    XCTAssertTrue(SSExchangeIndexPathIsNone(SSExchangeGridIndexIndexPathAtPoint(gridIndex, NAN, 5.0)), @"NaN");
+
+    SSExchangeGridIndexFree(gridIndex);
+}
+
+- (void)testRandomFramesMatchLinearScan {
+
+    // Overlapping frames of mixed sizes, some empty, some very wide. The first item wins overlaps.
+
+    for (int trial = 0; trial < 200; trial++) {
+
+        Layout layout;
+        layout.count = 1 + [self randomNumberLessThan:300];
+        layout.frames = malloc(layout.count * sizeof(SSExchangeRect));
+        layout.indexPaths = malloc(layout.count * sizeof(SSExchangeIndexPath));
+
+        for (size_t i = 0; i < layout.count; i++) {
+            double width = ([self randomNumberLessThan:8] == 0)? 0.0 : 1.0 + [self randomNumberLessThan:120];
+            if ([self randomNumberLessThan:50] == 0) width = 400.0;
+            layout.frames[i] = (SSExchangeRect){ [self randomNumberLessThan:300] / 2.0,
+                                                 [self randomNumberLessThan:3000] / 2.0,
+                                                 width,
+                                                 1.0 + [self randomNumberLessThan:90] };
+            layout.indexPaths[i] = SSExchangeIndexPathMake(0, (int32_t)i);
+        }
+
+        SSExchangeGridIndex *gridIndex = SSExchangeGridIndexCreate(layout.frames, layout.indexPaths, layout.count);
+        [self assertGridIndex:gridIndex matchesLayout:&layout lookups:1000];
+
+        SSExchangeGridIndexFree(gridIndex);
+        LayoutFree(&layout);
+    }
+}
+
+- (void)testNothingToIndex {
+
+    SSExchangeRect frames[] = { { 0.0, 0.0, 0.0, 10.0 } };
+    SSExchangeIndexPath indexPaths[] = { SSExchangeIndexPathMake(0, 0) };
+
+    XCTAssertTrue(SSExchangeGridIndexCreate(frames, indexPaths, 0) == NULL, @"index for no items");
+    XCTAssertTrue(SSExchangeGridIndexCreate(frames, indexPaths, 1) == NULL, @"index for only empty frames");
+    XCTAssertTrue(SSExchangeIndexPathIsNone(SSExchangeGridIndexIndexPathAtPoint(NULL, 0.0, 0.0)), @"lookup in a NULL index");
+    XCTAssertEqual(SSExchangeGridIndexCount(NULL), (size_t)0, @"count of a NULL index");
+}
+
+
+
+//------------------------------
+#pragma mark - Performance...
+
+// Both tests look up the same 100,000 points in 10,000 items, which is what indexPathForItemAtPoint:
+// effectively does on every touch sample. Compare the two in the test report.
+
+- (void)testPerformanceOfLinearScanLookups {
+
+    Layout layout = [self flowLayoutWithSections:10 itemsPerSection:1000 itemSize:57.0];
+    double height = layout.frames[layout.count - 1].y;
+
+    [self measureBlock:^{
+        uint32_t found = 0;
+        for (int i = 0; i < 100000; i++) {
+            found += !SSExchangeIndexPathIsNone(LinearScan(&layout, (i * 7) % 320, fmod(i * 97.0, height)));
+        }
+        XCTAssertTrue(found > 0, @"nothing found");
+    }];
+
+    LayoutFree(&layout);
+}
+
+- (void)testPerformanceOfGridIndexLookups {
+
+    Layout layout = [self flowLayoutWithSections:10 itemsPerSection:1000 itemSize:57.0];
+    double height = layout.frames[layout.count - 1].y;
+    SSExchangeGridIndex *gridIndex = SSExchangeGridIndexCreate(layout.frames, layout.indexPaths, layout.count);
+
+    [self measureBlock:^{
+        uint32_t found = 0;
+        for (int i = 0; i < 100000; i++) {
+            found += !SSExchangeIndexPathIsNone(SSExchangeGridIndexIndexPathAtPoint(gridIndex, (i * 7) % 320, fmod(i * 97.0, height)));
+        }
+        XCTAssertTrue(found > 0, @"nothing found");
+    }];
+
+    SSExchangeGridIndexFree(gridIndex);
+    LayoutFree(&layout);
+}
+
+@end
@@ -0,0 +1,276 @@
+//
+//  SSCollectionViewExchangeGroupCoreTests.m
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+// Drives the group exchange core with synthetic "finger is over (section, item)" events for groups
+// of random sizes, applying the swaps it emits to a model and the moves it emits to a mirror of the
+// view, and checks the two stay in sync. Only Foundation and XCTest are used.
+
+#import <XCTest/XCTest.h>
+#import "SSCollectionViewExchangeGroupCore.h"
+#import "SSCollectionViewExchangeTestSupport.h"
+
+
+enum {
+    kSections = 3,
+    kItemsPerSection = 9
+};
+
+
+static bool CanDisplaceItemsInGrid(const SSExchangeIndexPath *indexPathsOfItemsToDisplace,
+                                   const SSExchangeIndexPath *indexPathsOfItemsBeingDragged,
+                                   unsigned int numberOfItems,
+                                   void *context) {
+
+    // Only the items that exist. context, if not NULL, is a locked item.
+    for (unsigned int i = 0; i < numberOfItems; i++) {
+        if (indexPathsOfItemsToDisplace[i].section >= kSections || indexPathsOfItemsToDisplace[i].item >= kItemsPerSection) return false;
+        if (context && SSExchangeIndexPathEqualToIndexPath(indexPathsOfItemsToDisplace[i], *(SSExchangeIndexPath *)context)) return false;
+    }
+    return true;
+}
+
+
+
+@interface SSCollectionViewExchangeGroupCoreTests : SSCollectionViewExchangeTestCase
+
+@end
+
+
+@implementation SSCollectionViewExchangeGroupCoreTests
+
+- (SSExchangeIndexPath)randomIndexPath {
+
+    return [self randomIndexPathInSections:kSections itemsPerSection:kItemsPerSection];
+}
+
+- (unsigned int)getRandomGroup:(SSExchangeIndexPath *)indexPaths maximumNumberOfItems:(unsigned int)maximumNumberOfItems {
+
+    unsigned int numberOfItems = 1 + [self randomNumberLessThan:maximumNumberOfItems];
+    unsigned int count = 0;
+
+    while (count < numberOfItems) {
+
+        SSExchangeIndexPath indexPath = [self randomIndexPath];
+        bool isDuplicate = false;
+        for (unsigned int i = 0; i < count; i++) {
+            if (SSExchangeIndexPathEqualToIndexPath(indexPaths[i], indexPath)) isDuplicate = true;
+        }
+        if (!isDuplicate) indexPaths[count++] = indexPath;
+    }
+    return count;
+}
+
+
+
+//----------------------------
+#pragma mark - Event types...
+
+- (void)testGroupMovesByOneOffset {
+
+    // Catch 0,1 with 0,2 and 1,1 then drag over 1,5: the group lands on 1,5, 1,6 and 2,5.
+
+    SSExchangeIndexPath group[] = { SSExchangeIndexPathMake(0, 1), SSExchangeIndexPathMake(0, 2), SSExchangeIndexPathMake(1, 1) };
+    SSExchangeGroupCore core;
+    XCTAssertTrue(SSExchangeGroupCoreBegin(&core, group, 3), @"group not begun");
+
+    SSExchangeGroupEvent event;
+    SSExchangeGroupCoreUpdate(&core, SSExchangeIndexPathMake(1, 5), NULL, NULL, &event);
+    XCTAssertEqual(event.type, SSExchangeEventTypeDraggedFromStartingItem, @"first event type");
+    XCTAssertEqual(event.numberOfSwaps, 3u, @"one exchange for each item in the group");
+    XCTAssertEqual(event.numberOfMoves, 6u, @"two moves for each exchange");
+
+    SSExchangeIndexPath expectedTargets[] = { SSExchangeIndexPathMake(1, 5), SSExchangeIndexPathMake(1, 6), SSExchangeIndexPathMake(2, 5) };
+    for (int i = 0; i < 3; i++) {
+        XCTAssertTrue(SSExchangeIndexPathEqualToIndexPath(core.displacedIndexPaths[i], expectedTargets[i]), @"wrong target for item %d", i);
+    }
+
+    SSExchangeGroupCoreUpdate(&core, SSExchangeIndexPathMake(1, 5), NULL, NULL, &event);
+    XCTAssertEqual(event.type, SSExchangeEventTypeNothingToExchange, @"exchange while still over the same item");
+
+    SSExchangeGroupCoreUpdate(&core, SSExchangeIndexPathMake(0, 4), NULL, NULL, &event);
+    XCTAssertEqual(event.type, SSExchangeEventTypeDraggedToOtherItem, @"second event type");
+    XCTAssertEqual(event.numberOfSwaps, 6u, @"second event should undo then exchange");
+
+    SSExchangeGroupCoreUpdate(&core, SSExchangeIndexPathMake(0, 1), NULL, NULL, &event);
+    XCTAssertEqual(event.type, SSExchangeEventTypeDraggedToStartingItem, @"back to the starting items");
+
+    SSExchangeSwap finalExchanges[SSExchangeGroupMaximumNumberOfItems];
+    XCTAssertEqual(SSExchangeGroupCoreFinish(&core, finalExchanges), 3u, @"one final exchange for each item");
+    for (int i = 0; i < 3; i++) {
+        XCTAssertTrue(SSExchangeIndexPathEqualToIndexPath(finalExchanges[i].indexPath1, finalExchanges[i].indexPath2), @"nothing exchanged but index paths differ");
+    }
+}
+
+- (void)testNoExchangeWhileTargetsAreMissingOrOverlap {
+
+    SSExchangeIndexPath group[] = { SSExchangeIndexPathMake(1, 1), SSExchangeIndexPathMake(1, 2) };
+    SSExchangeGroupCore core;
+    SSExchangeGroupCoreBegin(&core, group, 2);
+
+    SSExchangeGroupEvent event;
+
+    // 1,0 would need 1,-1.
+    SSExchangeGroupCoreUpdate(&core, SSExchangeIndexPathMake(1, 0), CanDisplaceItemsInGrid, NULL, &event);
+    XCTAssertEqual(event.type, SSExchangeEventTypeNothingToExchange, @"exchange with an item before the start of a section");
+
+    // 1,2 would need 1,3, which overlaps the group.
+    SSExchangeGroupCoreUpdate(&core, SSExchangeIndexPathMake(1, 2), CanDisplaceItemsInGrid, NULL, &event);
+    XCTAssertEqual(event.type, SSExchangeEventTypeNothingToExchange, @"exchange with targets that overlap the group");
+
+    // 1,8 would need 1,9, past the end of the section.
+    SSExchangeGroupCoreUpdate(&core, SSExchangeIndexPathMake(1, 8), CanDisplaceItemsInGrid, NULL, &event);
+    XCTAssertEqual(event.type, SSExchangeEventTypeCannotDisplaceItem, @"exchange with an item past the end of a section");
+    XCTAssertEqual(event.numberOfSwaps, 0u, @"swaps emitted for a missing item");
+
+    // One locked target blocks the whole group.
+    SSExchangeIndexPath lockedIndexPath = SSExchangeIndexPathMake(2, 5);
+    SSExchangeGroupCoreUpdate(&core, SSExchangeIndexPathMake(2, 4), CanDisplaceItemsInGrid, &lockedIndexPath, &event);
+    XCTAssertEqual(event.type, SSExchangeEventTypeCannotDisplaceItem, @"locked item displaced");
+}
+
+- (void)testBeginRejectsBadGroups {
+
+    SSExchangeGroupCore core;
+    SSExchangeIndexPath duplicates[] = { SSExchangeIndexPathMake(0, 1), SSExchangeIndexPathMake(0, 1) };
+    SSExchangeIndexPath none[] = { SSExchangeIndexPathMake(0, 1), SSExchangeIndexPathNone };
+    SSExchangeIndexPath tooMany[SSExchangeGroupMaximumNumberOfItems + 1];
+    for (int32_t i = 0; i < SSExchangeGroupMaximumNumberOfItems + 1; i++) tooMany[i] = SSExchangeIndexPathMake(0, i);
+
+    XCTAssertFalse(SSExchangeGroupCoreBegin(&core, duplicates, 2), @"began with duplicates");
+    XCTAssertFalse(SSExchangeGroupCoreBegin(&core, none, 2), @"began with a missing index path");
+    XCTAssertFalse(SSExchangeGroupCoreBegin(&core, tooMany, 0), @"began with an empty group");
+    XCTAssertFalse(SSExchangeGroupCoreBegin(&core, tooMany, SSExchangeGroupMaximumNumberOfItems + 1), @"began with too many items");
+    XCTAssertTrue(SSExchangeGroupCoreBegin(&core, tooMany, SSExchangeGroupMaximumNumberOfItems), @"didn't begin with the maximum");
+}
+
+
+
+//--------------------------------------
+#pragma mark - Random drags...
+
+- (void)testRandomGroupDragsKeepModelAndViewInSync {
+
+    for (int trial = 0; trial < 10000; trial++) {
+
+        SSExchangeTestGrid model, view;
+        SSExchangeTestGridReset(&model, kSections, kItemsPerSection);
+        SSExchangeTestGridReset(&view, kSections, kItemsPerSection);
+
+        SSExchangeIndexPath group[6];
+        unsigned int numberOfItems = [self getRandomGroup:group maximumNumberOfItems:6];
+
+        SSExchangeGroupCore core;
+        SSExchangeGroupCoreBegin(&core, group, numberOfItems);
+
+        uint32_t steps = [self randomNumberLessThan:12];
+        for (uint32_t step = 0; step < steps; step++) {
+
+            SSExchangeIndexPath indexPath = ([self randomNumberLessThan:8] == 0)? SSExchangeIndexPathNone : [self randomIndexPath];
+            SSExchangeGroupEvent event;
+            SSExchangeGroupCoreUpdate(&core, indexPath, CanDisplaceItemsInGrid, NULL, &event);
+
+            SSExchangeTestGridApplySwaps(&model, event.swaps, event.numberOfSwaps);
+            SSExchangeTestGridApplyMoves(&view, event.moves, event.numberOfMoves);
+
+            XCTAssertTrue(SSExchangeTestGridEqualToGrid(&model, &view), @"model and view out of sync on trial %d", trial);
+            XCTAssertTrue(SSExchangeTestGridNumberOfItemsOutOfPlace(&model) <= 2 * numberOfItems, @"more than the latest exchange out of place on trial %d", trial);
+        }
+
+        SSExchangeSwap exchanges[SSExchangeGroupMaximumNumberOfItems];
+
+        if ([self randomNumberLessThan:4] == 0) {
+
+            SSExchangeTestGridApplySwaps(&model, exchanges, SSExchangeGroupCoreCancel(&core, exchanges));
+            XCTAssertEqual(SSExchangeTestGridNumberOfItemsOutOfPlace(&model), 0u, @"cancel did not restore the model on trial %d", trial);
+
+        } else {
+
+            // The final exchanges are reported, not applied. Applying them again must restore the model.
+            SSExchangeTestGridApplySwaps(&model, exchanges, SSExchangeGroupCoreFinish(&core, exchanges));
+            XCTAssertEqual(SSExchangeTestGridNumberOfItemsOutOfPlace(&model), 0u, @"final exchanges do not match the model on trial %d", trial);
+        }
+    }
+}
+
+
+- (void)testCoalescedGroupExchangeEventsKeepModelAndViewInSync {
+
+    // One model follows every exchange event. Another, and the view, only catch up now and then,
+    // as the exchange controller does while a batch update is animating.
+
+    for (int trial = 0; trial < 10000; trial++) {
+
+        SSExchangeTestGrid everyEvent, model, view;
+        SSExchangeTestGridReset(&everyEvent, kSections, kItemsPerSection);
+        SSExchangeTestGridReset(&model, kSections, kItemsPerSection);
+        SSExchangeTestGridReset(&view, kSections, kItemsPerSection);
+
+        SSExchangeIndexPath group[6];
+        unsigned int numberOfItems = [self getRandomGroup:group maximumNumberOfItems:6];
+
+        SSExchangeGroupCore core;
+        SSExchangeGroupCoreBegin(&core, group, numberOfItems);
+
+        SSExchangeSwap committedExchanges[SSExchangeGroupMaximumNumberOfItems];
+        XCTAssertEqual(SSExchangeGroupCoreGetExchanges(&core, committedExchanges), numberOfItems, @"wrong number of exchanges on trial %d", trial);
+
+        for (int step = 0; step < 12; step++) {
+
+            SSExchangeIndexPath indexPath = ([self randomNumberLessThan:8] == 0)? SSExchangeIndexPathNone : [self randomIndexPath];
+            SSExchangeGroupEvent event;
+            SSExchangeGroupCoreUpdate(&core, indexPath, CanDisplaceItemsInGrid, NULL, &event);
+            SSExchangeTestGridApplySwaps(&everyEvent, event.swaps, event.numberOfSwaps);
+
+            if (step < 11 && [self randomNumberLessThan:3] != 0) continue;
+
+            SSExchangeSwap exchanges[SSExchangeGroupMaximumNumberOfItems];
+            SSExchangeGroupCoreGetExchanges(&core, exchanges);
+
+            SSExchangeSwap swaps[2 * SSExchangeGroupMaximumNumberOfItems];
+            unsigned int numberOfSwaps = SSExchangeCoalesceExchanges(committedExchanges, exchanges, numberOfItems, swaps);
+            memcpy(committedExchanges, exchanges, numberOfItems * sizeof(SSExchangeSwap));
+
+            SSExchangeTestGridApplySwaps(&model, swaps, numberOfSwaps);
+            SSExchangeMove moves[4 * SSExchangeGroupMaximumNumberOfItems];
+            SSExchangeTestGridApplyMoves(&view, moves, SSExchangeComposeSwaps(swaps, numberOfSwaps, moves));
+
+            XCTAssertTrue(SSExchangeTestGridEqualToGrid(&model, &everyEvent), @"coalesced model differs on trial %d", trial);
+            XCTAssertTrue(SSExchangeTestGridEqualToGrid(&model, &view), @"model and view out of sync on trial %d", trial);
+        }
+
+        SSExchangeSwap finalExchanges[SSExchangeGroupMaximumNumberOfItems];
+        SSExchangeTestGridApplySwaps(&model, finalExchanges, SSExchangeGroupCoreFinish(&core, finalExchanges));
+        XCTAssertEqual(SSExchangeTestGridNumberOfItemsOutOfPlace(&model), 0u, @"final exchanges do not match the model on trial %d", trial);
+    }
+}
+
+
+
+//------------------------------
+#pragma mark - Performance...
+
+- (void)testPerformanceOfLargestGroup {
+
+    // A group of the maximum size dragged back and forth between two places in a long section.
+    // Each event is one undo and one exchange of every item.
+
+    SSExchangeIndexPath group[SSExchangeGroupMaximumNumberOfItems];
+    for (int32_t i = 0; i < SSExchangeGroupMaximumNumberOfItems; i++) group[i] = SSExchangeIndexPathMake(0, 2 * i);
+
+    [self measureBlock:^{
+
+        SSExchangeGroupCore core;
+        SSExchangeGroupCoreBegin(&core, group, SSExchangeGroupMaximumNumberOfItems);
+
+        SSExchangeGroupEvent event;
+        for (int32_t i = 0; i < 10000; i++) {
+            SSExchangeGroupCoreUpdate(&core, SSExchangeIndexPathMake(0, 1000 + (i % 2)), NULL, NULL, &event);
+        }
+    }];
+}
+
+@end
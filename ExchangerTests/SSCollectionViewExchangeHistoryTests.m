@@ -0,0 +1,235 @@
+//
+//  SSCollectionViewExchangeHistoryTests.m
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+// Records random exchanges against a model of plain C arrays and checks that undoing and
+// redoing, in steps of any size, and the composed moves, always agree with the model. Only
+// Foundation and XCTest are used.
+
+#import <XCTest/XCTest.h>
+#import "SSCollectionViewExchangeHistory.h"
+#import "SSCollectionViewExchangeTestSupport.h"
+
+
+#define kSections 3
+#define kItemsPerSection 20
+
+
+static int CompareMoves(const void *move1, const void *move2) {
+
+    uint64_t from1 = SSExchangeIndexPathPack(((const SSExchangeMove *)move1)->fromIndexPath);
+    uint64_t from2 = SSExchangeIndexPathPack(((const SSExchangeMove *)move2)->fromIndexPath);
+    return (from1 > from2) - (from1 < from2);
+}
+
+
+
+@interface SSCollectionViewExchangeHistoryTests : SSCollectionViewExchangeTestCase
+
+@end
+
+
+@implementation SSCollectionViewExchangeHistoryTests
+
+- (void)recordRandomExchanges:(unsigned int)count inHistory:(SSExchangeHistory *)history model:(SSExchangeTestGrid *)model {
+
+    for (unsigned int i = 0; i < count; i++) {
+
+        // Every one must be an exchange of something so the counts are predictable.
+        SSExchangeSwap swap;
+        do {
+            swap = [self randomSwapInSections:kSections itemsPerSection:kItemsPerSection];
+        } while (SSExchangeIndexPathEqualToIndexPath(swap.indexPath1, swap.indexPath2));
+
+        SSExchangeTestGridApplySwaps(model, &swap, 1);
+        SSExchangeHistoryRecord(history, swap);
+    }
+}
+
+
+
+//-------------------------------------
+#pragma mark - Undoing and redoing...
+
+- (void)testUndoingEverythingRestoresModel {
+
+    SSExchangeHistory *history = SSExchangeHistoryCreate(100);
+    SSExchangeTestGrid original;
+    SSExchangeTestGridReset(&original, kSections, kItemsPerSection);
+    SSExchangeTestGrid model = original;
+    [self recordRandomExchanges:60 inHistory:history model:&model];
+    SSExchangeTestGrid changed = model;
+
+    SSExchangeSwap swaps[100];
+    unsigned int numberOfUndos = SSExchangeHistoryNumberOfUndos(history);
+
+    // In uneven steps, to cross the boundaries between them.
+    unsigned int steps[] = { 1, 7, 2, 100 };
+    for (int i = 0; i < 4; i++) {
+        unsigned int count = SSExchangeHistoryUndo(history, steps[i], swaps);
+        SSExchangeTestGridApplySwaps(&model, swaps, count);
+    }
+    XCTAssertTrue(SSExchangeTestGridEqualToGrid(&model, &original), @"undo did not restore the model");
+    XCTAssertEqual(SSExchangeHistoryNumberOfUndos(history), 0u, @"undos left");
+    XCTAssertEqual(SSExchangeHistoryNumberOfRedos(history), numberOfUndos, @"wrong number of redos");
+
+    unsigned int count = SSExchangeHistoryRedo(history, 5, swaps);
+    SSExchangeTestGridApplySwaps(&model, swaps, count);
+    count = SSExchangeHistoryRedo(history, 1000, swaps);
+    SSExchangeTestGridApplySwaps(&model, swaps, count);
+    XCTAssertTrue(SSExchangeTestGridEqualToGrid(&model, &changed), @"redo did not restore the changes");
+    XCTAssertEqual(SSExchangeHistoryNumberOfRedos(history), 0u, @"redos left");
+
+    SSExchangeHistoryFree(history);
+}
+
+- (void)testRecordingAfterUndoForgetsRedos {
+
+    SSExchangeHistory *history = SSExchangeHistoryCreate(100);
+    SSExchangeTestGrid model;
+    SSExchangeTestGridReset(&model, kSections, kItemsPerSection);
+    [self recordRandomExchanges:10 inHistory:history model:&model];
+
+    SSExchangeSwap swaps[3];
+    SSExchangeHistoryUndo(history, 3, swaps);
+    [self recordRandomExchanges:1 inHistory:history model:&model];
+
+    XCTAssertEqual(SSExchangeHistoryNumberOfUndos(history), 8u, @"wrong number of undos");
+    XCTAssertEqual(SSExchangeHistoryNumberOfRedos(history), 0u, @"redos not forgotten");
+
+    SSExchangeHistoryFree(history);
+}
+
+- (void)testFullHistoryForgetsOldest {
+
+    SSExchangeHistory *history = SSExchangeHistoryCreate(16);
+    SSExchangeTestGrid model;
+    SSExchangeTestGridReset(&model, kSections, kItemsPerSection);
+    [self recordRandomExchanges:10 inHistory:history model:&model];
+    SSExchangeTestGrid checkpoint = model;
+    [self recordRandomExchanges:16 inHistory:history model:&model];
+
+    XCTAssertEqual(SSExchangeHistoryNumberOfUndos(history), 16u, @"history grew past its capacity");
+
+    SSExchangeSwap swaps[16];
+    unsigned int count = SSExchangeHistoryUndo(history, 16, swaps);
+    SSExchangeTestGridApplySwaps(&model, swaps, count);
+    XCTAssertTrue(SSExchangeTestGridEqualToGrid(&model, &checkpoint), @"undo did not stop at the oldest remembered exchange");
+
+    SSExchangeHistoryFree(history);
+}
+
+- (void)testExchangesOfNothingAreNotRecorded {
+
+    SSExchangeHistory *history = SSExchangeHistoryCreate(4);
+    SSExchangeIndexPath indexPath = SSExchangeIndexPathMake(1, 1);
+
+    SSExchangeHistoryRecord(history, SSExchangeSwapMake(indexPath, indexPath));
+    SSExchangeHistoryRecord(history, SSExchangeSwapMake(indexPath, SSExchangeIndexPathNone));
+    XCTAssertEqual(SSExchangeHistoryNumberOfUndos(history), 0u, @"exchange of nothing recorded");
+    XCTAssertEqual(SSExchangeHistoryNumberOfUndos(NULL), 0u, @"undos in a NULL history");
+
+    SSExchangeHistoryFree(history);
+}
+
+
+
+//-------------------------
+#pragma mark - Composing...
+
+- (void)testComposedSwapsMatchModel {
+
+    SSExchangeHistory *history = SSExchangeHistoryCreate(200);
+
+    for (int trial = 0; trial < 50; trial++) {
+
+        SSExchangeTestGrid model;
+
+        SSExchangeTestGridReset(&model, kSections, kItemsPerSection);
+        SSExchangeHistoryRemoveAll(history);
+        [self recordRandomExchanges:1 + [self randomNumberLessThan:200] inHistory:history model:&model];
+
+        SSExchangeSwap swaps[200];
+        SSExchangeMove moves[400], expectedMoves[400];
+        unsigned int numberOfSwaps = SSExchangeHistoryUndo(history, 1 + [self randomNumberLessThan:200], swaps);
+
+        unsigned int numberOfMoves = SSExchangeHistoryComposeSwaps(history, swaps, numberOfSwaps, moves);
+        unsigned int expectedNumberOfMoves = SSExchangeComposeSwaps(swaps, numberOfSwaps, expectedMoves);
+
+        qsort(moves, numberOfMoves, sizeof(SSExchangeMove), CompareMoves);
+        qsort(expectedMoves, expectedNumberOfMoves, sizeof(SSExchangeMove), CompareMoves);
+        XCTAssertEqual(numberOfMoves, expectedNumberOfMoves, @"wrong number of moves");
+        XCTAssertTrue(memcmp(moves, expectedMoves, numberOfMoves * sizeof(SSExchangeMove)) == 0, @"moves differ from SSExchangeComposeSwaps()");
+
+        SSExchangeTestGrid movedModel = model;
+        SSExchangeTestGridApplyMoves(&movedModel, moves, numberOfMoves);
+        SSExchangeTestGridApplySwaps(&model, swaps, numberOfSwaps);
+        XCTAssertTrue(SSExchangeTestGridEqualToGrid(&movedModel, &model), @"moves and swaps disagree");
+    }
+
+    SSExchangeHistoryFree(history);
+}
+
+- (void)testComposedSwapsThatCancelOutHaveNoMoves {
+
+    SSExchangeHistory *history = SSExchangeHistoryCreate(4);
+    SSExchangeSwap swap = SSExchangeSwapMake(SSExchangeIndexPathMake(0, 0), SSExchangeIndexPathMake(2, 5));
+    SSExchangeSwap swaps[] = { swap, swap };
+    SSExchangeMove moves[4];
+
+    XCTAssertEqual(SSExchangeHistoryComposeSwaps(history, swaps, 2, moves), 0u, @"moves for swaps that cancel out");
+
+    SSExchangeHistoryFree(history);
+}
+
+
+
+//------------------------------
+#pragma mark - Performance...
+
+// Both tests compose the swaps for undoing 4,000 exchanges in a model of 3 sections of 1,000
+// items. Compare the two in the test report.
+
+- (void)fillRandomSwaps:(SSExchangeSwap *)swaps count:(unsigned int)count {
+
+    for (unsigned int i = 0; i < count; i++) {
+        swaps[i] = [self randomSwapInSections:3 itemsPerSection:1000];
+    }
+}
+
+- (void)testPerformanceOfComposingWithCore {
+
+    unsigned int count = 4000;
+    SSExchangeSwap *swaps = malloc(count * sizeof(SSExchangeSwap));
+    SSExchangeMove *moves = malloc(2 * count * sizeof(SSExchangeMove));
+    [self fillRandomSwaps:swaps count:count];
+
+    [self measureBlock:^{
+        XCTAssertTrue(SSExchangeComposeSwaps(swaps, count, moves) > 0, @"no moves");
+    }];
+
+    free(swaps);
+    free(moves);
+}
+
+- (void)testPerformanceOfComposingWithHistory {
+
+    unsigned int count = 4000;
+    SSExchangeHistory *history = SSExchangeHistoryCreate(count);
+    SSExchangeSwap *swaps = malloc(count * sizeof(SSExchangeSwap));
+    SSExchangeMove *moves = malloc(2 * count * sizeof(SSExchangeMove));
+    [self fillRandomSwaps:swaps count:count];
+
+    [self measureBlock:^{
+        XCTAssertTrue(SSExchangeHistoryComposeSwaps(history, swaps, count, moves) > 0, @"no moves");
+    }];
+
+    SSExchangeHistoryFree(history);
+    free(swaps);
+    free(moves);
+}
+
+@end
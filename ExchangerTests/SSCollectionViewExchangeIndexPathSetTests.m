@@ -0,0 +1,116 @@
+//
+//  SSCollectionViewExchangeIndexPathSetTests.m
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+// Checks the bitmap-backed index path set against an NSMutableSet of NSIndexPaths. Only Foundation
+// and XCTest are used.
+
+#import <XCTest/XCTest.h>
+#import "SSCollectionViewExchangeIndexPathSet.h"
+#import "SSCollectionViewExchangeTestSupport.h"
+
+
+@interface SSCollectionViewExchangeIndexPathSetTests : SSCollectionViewExchangeTestCase
+
+@end
+
+
+@implementation SSCollectionViewExchangeIndexPathSetTests
+
+- (void)testMembership {
+
+    // Sections that span word boundaries, and an empty one.
+    size_t numberOfItemsInSections[] = { 3, 0, 130, 64 };
+    SSExchangeIndexPathSet *set = SSExchangeIndexPathSetCreate(numberOfItemsInSections, 4);
+    XCTAssertTrue(set != NULL, @"set not created");
+
+    XCTAssertFalse(SSExchangeIndexPathSetAdd(set, SSExchangeIndexPathMake(0, 3)), @"added past the end of a section");
+    XCTAssertFalse(SSExchangeIndexPathSetAdd(set, SSExchangeIndexPathMake(1, 0)), @"added to an empty section");
+    XCTAssertFalse(SSExchangeIndexPathSetAdd(set, SSExchangeIndexPathMake(4, 0)), @"added past the last section");
+    XCTAssertFalse(SSExchangeIndexPathSetAdd(set, SSExchangeIndexPathNone), @"added none");
+
+    for (int32_t item = 0; item < 130; item += 3) {
+        XCTAssertTrue(SSExchangeIndexPathSetAdd(set, SSExchangeIndexPathMake(2, item)), @"didn't add 2,%d", item);
+    }
+    XCTAssertTrue(SSExchangeIndexPathSetAdd(set, SSExchangeIndexPathMake(3, 63)), @"didn't add the last item");
+    XCTAssertTrue(SSExchangeIndexPathSetAdd(set, SSExchangeIndexPathMake(2, 0)), @"adding a member again failed");
+    XCTAssertEqual(SSExchangeIndexPathSetCount(set), (size_t)45, @"wrong count");
+
+    for (int32_t item = 0; item < 130; item++) {
+        XCTAssertEqual(SSExchangeIndexPathSetContainsIndexPath(set, SSExchangeIndexPathMake(2, item)), (bool)(item % 3 == 0), @"wrong answer for 2,%d", item);
+    }
+    XCTAssertTrue(SSExchangeIndexPathSetContainsIndexPath(set, SSExchangeIndexPathMake(3, 63)), @"last item missing");
+    XCTAssertFalse(SSExchangeIndexPathSetContainsIndexPath(set, SSExchangeIndexPathMake(0, 0)), @"item in the wrong section");
+
+    const SSExchangeIndexPath *members = SSExchangeIndexPathSetMembers(set);
+    XCTAssertTrue(SSExchangeIndexPathEqualToIndexPath(members[0], SSExchangeIndexPathMake(2, 0)), @"members not in the order added");
+    XCTAssertTrue(SSExchangeIndexPathEqualToIndexPath(members[44], SSExchangeIndexPathMake(3, 63)), @"members not in the order added");
+
+    SSExchangeIndexPathSetRemove(set, SSExchangeIndexPathMake(2, 3));
+    SSExchangeIndexPathSetRemove(set, SSExchangeIndexPathMake(2, 4));
+    XCTAssertEqual(SSExchangeIndexPathSetCount(set), (size_t)44, @"wrong count after removing");
+    XCTAssertFalse(SSExchangeIndexPathSetContainsIndexPath(set, SSExchangeIndexPathMake(2, 3)), @"removed item still there");
+    XCTAssertTrue(SSExchangeIndexPathEqualToIndexPath(SSExchangeIndexPathSetMembers(set)[1], SSExchangeIndexPathMake(2, 6)), @"members out of order after removing");
+
+    SSExchangeIndexPathSetRemoveAll(set);
+    XCTAssertEqual(SSExchangeIndexPathSetCount(set), (size_t)0, @"not empty");
+    for (int32_t item = 0; item < 130; item++) {
+        XCTAssertFalse(SSExchangeIndexPathSetContainsIndexPath(set, SSExchangeIndexPathMake(2, item)), @"2,%d left behind", item);
+    }
+
+    SSExchangeIndexPathSetFree(set);
+}
+
+- (void)testNumbersOfItems {
+
+    size_t numberOfItemsInSections[] = { 6, 6 };
+    size_t otherNumberOfItemsInSections[] = { 6, 7 };
+    SSExchangeIndexPathSet *set = SSExchangeIndexPathSetCreate(numberOfItemsInSections, 2);
+
+    XCTAssertTrue(SSExchangeIndexPathSetHasNumbersOfItems(set, numberOfItemsInSections, 2), @"numbers of items don't match");
+    XCTAssertFalse(SSExchangeIndexPathSetHasNumbersOfItems(set, otherNumberOfItemsInSections, 2), @"different numbers of items match");
+    XCTAssertFalse(SSExchangeIndexPathSetHasNumbersOfItems(set, numberOfItemsInSections, 1), @"different numbers of sections match");
+    XCTAssertFalse(SSExchangeIndexPathSetHasNumbersOfItems(NULL, numberOfItemsInSections, 2), @"NULL set matches");
+
+    SSExchangeIndexPathSetFree(set);
+}
+
+- (void)testAgreesWithFoundationSet {
+
+    size_t numberOfItemsInSections[] = { 40, 1, 300, 17 };
+    SSExchangeIndexPathSet *set = SSExchangeIndexPathSetCreate(numberOfItemsInSections, 4);
+    NSMutableSet *foundationSet = [NSMutableSet set];
+
+    for (int round = 0; round < 50; round++) {
+
+        for (int i = 0; i < 40; i++) {
+            int32_t section = [self randomNumberLessThan:4];
+            int32_t item = [self randomNumberLessThan:(uint32_t)numberOfItemsInSections[section]];
+
+            SSExchangeIndexPathSetAdd(set, SSExchangeIndexPathMake(section, item));
+            NSUInteger indexes[] = { section, item };
+            [foundationSet addObject:[NSIndexPath indexPathWithIndexes:indexes length:2]];
+        }
+
+        XCTAssertEqual(SSExchangeIndexPathSetCount(set), (size_t)foundationSet.count, @"counts differ in round %d", round);
+        for (int32_t section = 0; section < 4; section++) {
+            for (int32_t item = 0; item < (int32_t)numberOfItemsInSections[section]; item++) {
+                NSUInteger indexes[] = { section, item };
+                BOOL foundationSetContains = [foundationSet containsObject:[NSIndexPath indexPathWithIndexes:indexes length:2]];
+                XCTAssertEqual(SSExchangeIndexPathSetContainsIndexPath(set, SSExchangeIndexPathMake(section, item)), (bool)foundationSetContains, @"%d,%d differs in round %d", section, item, round);
+            }
+        }
+
+        if (round % 5 == 4) {
+            SSExchangeIndexPathSetRemoveAll(set);
+            [foundationSet removeAllObjects];
+        }
+    }
+
+    SSExchangeIndexPathSetFree(set);
+}
+
+@end
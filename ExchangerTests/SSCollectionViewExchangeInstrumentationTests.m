@@ -0,0 +1,167 @@
+//
+//  SSCollectionViewExchangeInstrumentationTests.m
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+// Records made up samples and checks the ring buffer, the histograms, and the frame budget counts.
+// Only Foundation and XCTest are used so this file also builds and runs under GNUstep/XCTest on Linux.
+
+#import <XCTest/XCTest.h>
+#import "SSCollectionViewExchangeInstrumentation.h"
+
+
+static SSExchangeSample SampleMake(SSExchangePhase phase, uint64_t startTime, uint64_t duration) {
+
+    SSExchangeSample sample = { phase, startTime, duration };
+    return sample;
+}
+
+
+
+@interface SSCollectionViewExchangeInstrumentationTests : XCTestCase
+
+@end
+
+
+@implementation SSCollectionViewExchangeInstrumentationTests
+
+- (void)testRecentSamplesAreOldestFirstAndWrap {
+
+    SSCollectionViewExchangeInstrumentation *instrumentation = [[SSCollectionViewExchangeInstrumentation alloc] initWithCapacity:4];
+
+    for (uint64_t i = 1; i <= 6; i++) {
+        [instrumentation recordSample:SampleMake(SSExchangePhaseLayout, i, 10)];
+    }
+
+    SSExchangeSample samples[8];
+    XCTAssertEqual([instrumentation getRecentSamples:samples count:8], (NSUInteger)4, @"kept more than the capacity");
+    for (int i = 0; i < 4; i++) {
+        XCTAssertEqual(samples[i].startTime, (uint64_t)(3 + i), @"wrong sample or order");
+    }
+
+    XCTAssertEqual([instrumentation getRecentSamples:samples count:2], (NSUInteger)2, @"copied more than asked");
+    XCTAssertEqual(samples[0].startTime, (uint64_t)5, @"not the most recent samples");
+    XCTAssertEqual(samples[1].startTime, (uint64_t)6, @"not the most recent samples");
+
+    // The histograms count everything, not just what the ring holds.
+    XCTAssertEqual([instrumentation numberOfSamplesForPhase:SSExchangePhaseLayout], (uint64_t)6, @"histogram lost samples");
+}
+
+- (void)testHistogramBucketsArePowersOfTwo {
+
+    SSCollectionViewExchangeInstrumentation *instrumentation = [SSCollectionViewExchangeInstrumentation new];
+
+    uint64_t durations[] = { 0, 1, 2, 3, 4, 1000, 1023, 1024 };
+    for (int i = 0; i < 8; i++) {
+        [instrumentation recordSample:SampleMake(SSExchangePhaseDelegate, 0, durations[i])];
+    }
+
+    uint64_t buckets[SSExchangeInstrumentationNumberOfBuckets];
+    [instrumentation getHistogram:buckets forPhase:SSExchangePhaseDelegate];
+
+    XCTAssertEqual(buckets[0], (uint64_t)1, @"0 ns");
+    XCTAssertEqual(buckets[1], (uint64_t)1, @"1 ns");
+    XCTAssertEqual(buckets[2], (uint64_t)2, @"2 and 3 ns");
+    XCTAssertEqual(buckets[3], (uint64_t)1, @"4 ns");
+    XCTAssertEqual(buckets[10], (uint64_t)2, @"1000 and 1023 ns");
+    XCTAssertEqual(buckets[11], (uint64_t)1, @"1024 ns");
+
+    XCTAssertEqual([instrumentation totalDurationForPhase:SSExchangePhaseDelegate], (uint64_t)3057, @"wrong total");
+    XCTAssertEqual([instrumentation maximumDurationForPhase:SSExchangePhaseDelegate], (uint64_t)1024, @"wrong maximum");
+    XCTAssertEqual([instrumentation numberOfSamplesForPhase:SSExchangePhaseCatch], (uint64_t)0, @"samples in the wrong phase");
+}
+
+- (void)testPercentilesAreWithinAFactorOfTwo {
+
+    SSCollectionViewExchangeInstrumentation *instrumentation = [SSCollectionViewExchangeInstrumentation new];
+
+    // 99 fast samples and one slow one.
+    for (int i = 0; i < 99; i++) {
+        [instrumentation recordSample:SampleMake(SSExchangePhaseExchangeEvent, 0, 100000)];
+    }
+    [instrumentation recordSample:SampleMake(SSExchangePhaseExchangeEvent, 0, 40000000)];
+
+    uint64_t p50 = [instrumentation durationAtPercentile:50 forPhase:SSExchangePhaseExchangeEvent];
+    uint64_t p99 = [instrumentation durationAtPercentile:99 forPhase:SSExchangePhaseExchangeEvent];
+    uint64_t p100 = [instrumentation durationAtPercentile:100 forPhase:SSExchangePhaseExchangeEvent];
+
+    XCTAssertTrue(p50 >= 100000 && p50 < 200000, @"p50 is %llu", p50);
+    XCTAssertTrue(p99 >= 100000 && p99 < 200000, @"p99 is %llu", p99);
+    XCTAssertEqual(p100, (uint64_t)40000000, @"p100 isn't the maximum");
+    XCTAssertEqual([instrumentation durationAtPercentile:50 forPhase:SSExchangePhaseRelease], (uint64_t)0, @"percentile of no samples");
+}
+
+- (void)testFrameBudget {
+
+    SSCollectionViewExchangeInstrumentation *instrumentation = [SSCollectionViewExchangeInstrumentation new];
+    XCTAssertEqual(instrumentation.frameBudget, (uint64_t)16666666, @"default isn't 60 frames per second");
+
+    instrumentation.frameBudget = 8000000;
+    [instrumentation recordSample:SampleMake(SSExchangePhaseCatch, 0, 7999999)];
+    [instrumentation recordSample:SampleMake(SSExchangePhaseCatch, 0, 8000000)];
+    [instrumentation recordSample:SampleMake(SSExchangePhaseCatch, 0, 8000001)];
+
+    XCTAssertEqual([instrumentation numberOfSamplesOverFrameBudgetForPhase:SSExchangePhaseCatch], (uint64_t)1, @"wrong count over budget");
+    XCTAssertTrue([[instrumentation summary] rangeOfString:@"Catch: 3 samples"].location != NSNotFound, @"summary is missing the catch");
+
+    [instrumentation removeAllSamples];
+    SSExchangeSample samples[1];
+    XCTAssertEqual([instrumentation getRecentSamples:samples count:1], (NSUInteger)0, @"samples left");
+    XCTAssertEqual([instrumentation numberOfSamplesForPhase:SSExchangePhaseCatch], (uint64_t)0, @"histogram not cleared");
+}
+
+- (void)testPhasesAreTimed {
+
+    SSCollectionViewExchangeInstrumentation *instrumentation = [SSCollectionViewExchangeInstrumentation new];
+
+    uint64_t startTime = SSExchangeInstrumentationBeginPhase(SSExchangePhaseSnapshot);
+    [NSThread sleepForTimeInterval:0.002];
+    SSExchangeInstrumentationEndPhase(instrumentation, SSExchangePhaseSnapshot, startTime);
+
+    SSExchangeSample sample;
+    XCTAssertEqual([instrumentation getRecentSamples:&sample count:1], (NSUInteger)1, @"nothing recorded");
+    XCTAssertEqual(sample.phase, SSExchangePhaseSnapshot, @"wrong phase");
+    XCTAssertEqual(sample.startTime, startTime, @"wrong start time");
+    XCTAssertTrue(sample.duration >= 2000000, @"duration is %llu", sample.duration);
+}
+
+- (void)testPhasesTimedOffTheMainThread {
+
+    // Timed on another queue and recorded afterwards, as the exchange controller does with its commit queue.
+    __block uint64_t startTime;
+    __block SSExchangeSample sample;
+    dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        startTime = SSExchangeInstrumentationBeginPhase(SSExchangePhaseCommit);
+        [NSThread sleepForTimeInterval:0.002];
+        sample = SSExchangeInstrumentationMakeSample(SSExchangePhaseCommit, startTime);
+    });
+
+    SSCollectionViewExchangeInstrumentation *instrumentation = [SSCollectionViewExchangeInstrumentation new];
+    [instrumentation recordSample:sample];
+
+    XCTAssertEqual([instrumentation numberOfSamplesForPhase:SSExchangePhaseCommit], (uint64_t)1, @"nothing recorded");
+    XCTAssertEqual(sample.startTime, startTime, @"wrong start time");
+    XCTAssertTrue(sample.duration >= 2000000, @"duration is %llu", sample.duration);
+    XCTAssertEqualObjects(NSStringFromSSExchangePhase(SSExchangePhaseCommit), @"Commit", @"wrong name");
+}
+
+
+
+//------------------------------
+#pragma mark - Performance...
+
+- (void)testPerformanceOfRecording {
+
+    // A million samples. Divide the time by a million for the cost of each phase.
+    SSCollectionViewExchangeInstrumentation *instrumentation = [SSCollectionViewExchangeInstrumentation new];
+
+    [self measureBlock:^{
+        for (uint64_t i = 0; i < 1000000; i++) {
+            SSExchangeInstrumentationEndPhase(instrumentation, (SSExchangePhase)(i % SSExchangePhaseCount), SSExchangeInstrumentationBeginPhase(SSExchangePhaseLayout));
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,301 @@
+//
+//  SSCollectionViewExchangeJournalTests.m
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+// Tests and benchmarks for SSCollectionViewExchangeJournal. Only Foundation and XCTest are used,
+// and random numbers come from a seeded generator, so this file also builds and runs under
+// GNUstep/XCTest on Linux.
+
+#import <XCTest/XCTest.h>
+#import "SSCollectionViewExchangeJournal.h"
+#import "NSMutableArray+SSCollectionViewExchangeControllerAdditions.h"
+#import "SSCollectionViewExchangeTestSupport.h"
+
+
+static uint32_t const kBenchmarkSections = 3;
+static uint32_t const kBenchmarkItemsPerSection = 10000;
+static NSUInteger const kBenchmarkTransactions = 200;
+
+
+@interface SSCollectionViewExchangeJournalTests : SSCollectionViewExchangeTestCase <SSCollectionViewExchangeJournalSnapshotProvider>
+
+@property (strong, nonatomic) NSString *directoryPath;
+@property (strong, nonatomic) NSData *snapshotData;
+@property (nonatomic) NSUInteger numberOfSnapshotRequests;
+
+@end
+
+
+@implementation SSCollectionViewExchangeJournalTests
+
+- (void)setUp {
+
+    [super setUp];
+
+    NSString *directoryName = [NSString stringWithFormat:@"SSCollectionViewExchangeJournalTests-%@", [[NSProcessInfo processInfo] globallyUniqueString]];
+    self.directoryPath = [NSTemporaryDirectory() stringByAppendingPathComponent:directoryName];
+    self.snapshotData = [@"snapshot" dataUsingEncoding:NSUTF8StringEncoding];
+    self.numberOfSnapshotRequests = 0;
+}
+
+- (void)tearDown {
+
+    [[NSFileManager defaultManager] removeItemAtPath:self.directoryPath error:NULL];
+    [super tearDown];
+}
+
+- (NSData *)snapshotDataForExchangeJournal:(SSCollectionViewExchangeJournal *)exchangeJournal {
+
+    self.numberOfSnapshotRequests++;
+    return self.snapshotData;
+}
+
+- (SSExchangeSwap)randomSwap {
+
+    return [self randomSwapInSections:kBenchmarkSections itemsPerSection:kBenchmarkItemsPerSection];
+}
+
+- (NSArray *)replayedSwapsFromJournal:(SSCollectionViewExchangeJournal *)journal snapshotData:(NSData **)snapshotData {
+
+    NSMutableArray *replayedSwaps = [NSMutableArray array];
+
+    [journal replayExchangesWithBlock:^(const SSExchangeSwap *swaps, NSUInteger count) {
+        for (NSUInteger i = 0; i < count; i++) {
+            [replayedSwaps addObject:[NSValue valueWithBytes:&swaps[i] objCType:@encode(SSExchangeSwap)]];
+        }
+    }];
+
+    if (snapshotData) *snapshotData = [journal snapshotData];
+    return replayedSwaps;
+}
+
+- (BOOL)swapValue:(NSValue *)swapValue isEqualToSwap:(SSExchangeSwap)swap {
+
+    SSExchangeSwap replayedSwap;
+    [swapValue getValue:&replayedSwap];
+    return (SSExchangeIndexPathEqualToIndexPath(replayedSwap.indexPath1, swap.indexPath1) &&
+            SSExchangeIndexPathEqualToIndexPath(replayedSwap.indexPath2, swap.indexPath2));
+}
+
+- (NSString *)logPath {
+
+    return [self.directoryPath stringByAppendingPathComponent:@"exchanges.log"];
+}
+
+
+
+//---------------------------------------
+#pragma mark - Appending and replaying...
+
+- (void)testNewJournalHasNothingToReplay {
+
+    SSCollectionViewExchangeJournal *journal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:self.directoryPath];
+    XCTAssertNotNil(journal, @"journal not created");
+    XCTAssertFalse(journal.hasSnapshot, @"new journal has a snapshot");
+
+    NSData *snapshotData;
+    NSArray *replayedSwaps = [self replayedSwapsFromJournal:journal snapshotData:&snapshotData];
+    XCTAssertNil(snapshotData, @"snapshot data from a new journal");
+    XCTAssertEqual(replayedSwaps.count, (NSUInteger)0, @"exchanges from a new journal");
+}
+
+- (void)testReplayReturnsSnapshotAndExchangesInOrder {
+
+    SSExchangeSwap swaps[] = { SSExchangeSwapMake(SSExchangeIndexPathMake(0, 1), SSExchangeIndexPathMake(2, 3)),
+                               SSExchangeSwapMake(SSExchangeIndexPathMake(1, 70000), SSExchangeIndexPathMake(1, 0)),
+                               SSExchangeSwapMake(SSExchangeIndexPathMake(0, 1), SSExchangeIndexPathMake(2, 3)) };
+
+    SSCollectionViewExchangeJournal *journal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:self.directoryPath];
+    XCTAssertTrue([journal writeSnapshotData:self.snapshotData], @"snapshot not written");
+    for (int i = 0; i < 3; i++) {
+        XCTAssertTrue([journal appendSwap:swaps[i]], @"exchange not appended");
+    }
+    XCTAssertEqual(journal.numberOfExchangesSinceSnapshot, (NSUInteger)3, @"wrong number of exchanges");
+
+    // A new journal for the same directory, as on the next launch.
+    journal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:self.directoryPath];
+    XCTAssertTrue(journal.hasSnapshot, @"snapshot missing");
+
+    NSData *snapshotData;
+    NSArray *replayedSwaps = [self replayedSwapsFromJournal:journal snapshotData:&snapshotData];
+    XCTAssertEqualObjects(snapshotData, self.snapshotData, @"wrong snapshot data");
+    XCTAssertEqual(replayedSwaps.count, (NSUInteger)3, @"wrong number of exchanges");
+    for (int i = 0; i < 3 && i < replayedSwaps.count; i++) {
+        XCTAssertTrue([self swapValue:replayedSwaps[i] isEqualToSwap:swaps[i]], @"wrong exchange %d", i);
+    }
+}
+
+- (void)testExchangesThatDidNotHappenAreNotLogged {
+
+    SSCollectionViewExchangeJournal *journal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:self.directoryPath];
+    NSIndexPath *indexPath = [NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 1, 2 } length:2];
+
+    XCTAssertTrue([journal appendExchangeOfItemAtIndexPath1:indexPath withItemAtIndexPath2:indexPath], @"equal index paths rejected");
+    XCTAssertFalse([journal appendExchangeOfItemAtIndexPath1:indexPath withItemAtIndexPath2:nil], @"nil index path accepted");
+    XCTAssertEqual(journal.numberOfExchangesSinceSnapshot, (NSUInteger)0, @"exchange logged");
+}
+
+- (void)testAppendingManyExchangesAtOnce {
+
+    SSExchangeSwap swaps[] = { [self randomSwap], [self randomSwap], [self randomSwap] };
+    SSExchangeSwap invalidSwaps[] = { [self randomSwap], SSExchangeSwapMake(SSExchangeIndexPathMake(0, 0), SSExchangeIndexPathNone) };
+
+    SSCollectionViewExchangeJournal *journal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:self.directoryPath];
+    XCTAssertTrue([journal appendSwaps:swaps count:3], @"exchanges not appended");
+    XCTAssertFalse([journal appendSwaps:invalidSwaps count:2], @"invalid exchange appended");
+
+    NSArray *replayedSwaps = [self replayedSwapsFromJournal:journal snapshotData:NULL];
+    XCTAssertEqual(replayedSwaps.count, (NSUInteger)3, @"wrong number of exchanges");
+    for (int i = 0; i < 3 && i < replayedSwaps.count; i++) {
+        XCTAssertTrue([self swapValue:replayedSwaps[i] isEqualToSwap:swaps[i]], @"wrong exchange %d", i);
+    }
+}
+
+
+//-------------------------
+#pragma mark - Snapshots...
+
+- (void)testSnapshotEmptiesLog {
+
+    SSCollectionViewExchangeJournal *journal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:self.directoryPath];
+    [journal appendSwap:[self randomSwap]];
+    [journal appendSwap:[self randomSwap]];
+
+    journal.snapshotProvider = self;
+    XCTAssertTrue([journal writeSnapshot], @"snapshot not written");
+    XCTAssertEqual(journal.numberOfExchangesSinceSnapshot, (NSUInteger)0, @"log not emptied");
+
+    SSExchangeSwap swap = [self randomSwap];
+    [journal appendSwap:swap];
+
+    journal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:self.directoryPath];
+    NSArray *replayedSwaps = [self replayedSwapsFromJournal:journal snapshotData:NULL];
+    XCTAssertEqual(replayedSwaps.count, (NSUInteger)1, @"exchanges from before the snapshot replayed");
+    XCTAssertTrue([self swapValue:replayedSwaps.firstObject isEqualToSwap:swap], @"wrong exchange");
+}
+
+- (void)testSnapshotIsTakenAutomatically {
+
+    SSCollectionViewExchangeJournal *journal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:self.directoryPath];
+    journal.snapshotProvider = self;
+    journal.numberOfExchangesBetweenSnapshots = 3;
+
+    for (int i = 0; i < 7; i++) {
+        [journal appendSwap:[self randomSwap]];
+    }
+
+    XCTAssertEqual(self.numberOfSnapshotRequests, (NSUInteger)2, @"wrong number of snapshots");
+    XCTAssertEqual(journal.numberOfExchangesSinceSnapshot, (NSUInteger)1, @"wrong number of exchanges since the snapshot");
+}
+
+
+
+//---------------------------------
+#pragma mark - Crash recovery...
+
+- (void)testPartialRecordIsIgnored {
+
+    SSCollectionViewExchangeJournal *journal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:self.directoryPath];
+    SSExchangeSwap swap1 = [self randomSwap];
+    SSExchangeSwap swap2 = [self randomSwap];
+    [journal appendSwap:swap1];
+    journal = nil;
+
+    // As if the app was killed part way through writing an exchange.
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:[self logPath]];
+    [fileHandle seekToEndOfFile];
+    [fileHandle writeData:[NSData dataWithBytes:"\x01\x02\x03\x04\x05" length:5]];
+    [fileHandle closeFile];
+
+    journal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:self.directoryPath];
+    XCTAssertEqual(journal.numberOfExchangesSinceSnapshot, (NSUInteger)1, @"partial record counted");
+    [journal appendSwap:swap2];
+
+    NSArray *replayedSwaps = [self replayedSwapsFromJournal:journal snapshotData:NULL];
+    XCTAssertEqual(replayedSwaps.count, (NSUInteger)2, @"wrong number of exchanges");
+    XCTAssertTrue([self swapValue:replayedSwaps.firstObject isEqualToSwap:swap1], @"wrong exchange");
+    XCTAssertTrue([self swapValue:replayedSwaps.lastObject isEqualToSwap:swap2], @"exchange after partial record lost");
+}
+
+- (void)testLogFromOlderSnapshotIsIgnored {
+
+    SSCollectionViewExchangeJournal *journal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:self.directoryPath];
+    [journal appendSwap:[self randomSwap]];
+    NSData *oldLog = [NSData dataWithContentsOfFile:[self logPath]];
+
+    [journal writeSnapshotData:self.snapshotData];
+    journal = nil;
+
+    // As if the app was killed after writing the snapshot but before emptying the log.
+    [oldLog writeToFile:[self logPath] atomically:NO];
+
+    journal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:self.directoryPath];
+    NSData *snapshotData;
+    NSArray *replayedSwaps = [self replayedSwapsFromJournal:journal snapshotData:&snapshotData];
+    XCTAssertEqualObjects(snapshotData, self.snapshotData, @"wrong snapshot data");
+    XCTAssertEqual(replayedSwaps.count, (NSUInteger)0, @"exchanges already in the snapshot replayed");
+}
+
+
+
+//------------------------------
+#pragma mark - Performance...
+
+// Both tests save a model of 3 sections of 10,000 numbers after each of 200 transactions. The
+// first archives the whole model each time, the way the demo used to. The second appends each
+// transaction's exchange to a journal. Compare the two in the test report.
+
+- (void)testPerformanceOfArchivingWholeModel {
+
+    NSArray *arrays = [self arraysWithSections:kBenchmarkSections itemsPerSection:kBenchmarkItemsPerSection];
+    NSString *filePath = [self.directoryPath stringByAppendingPathComponent:@"model.archive"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.directoryPath withIntermediateDirectories:YES attributes:nil error:NULL];
+
+    [self measureBlock:^{
+        for (NSUInteger transaction = 0; transaction < kBenchmarkTransactions; transaction++) {
+            SSExchangeSwap swap = [self randomSwap];
+            [NSMutableArray exchangeObjectsInArrays:arrays withSwaps:&swap count:1];
+            [NSKeyedArchiver archiveRootObject:arrays toFile:filePath];
+        }
+    }];
+}
+
+- (void)testPerformanceOfJournalingExchanges {
+
+    NSArray *arrays = [self arraysWithSections:kBenchmarkSections itemsPerSection:kBenchmarkItemsPerSection];
+    SSCollectionViewExchangeJournal *journal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:self.directoryPath];
+    journal.numberOfExchangesBetweenSnapshots = 0;
+
+    [self measureBlock:^{
+        for (NSUInteger transaction = 0; transaction < kBenchmarkTransactions; transaction++) {
+            SSExchangeSwap swap = [self randomSwap];
+            [NSMutableArray exchangeObjectsInArrays:arrays withSwaps:&swap count:1];
+            [journal appendSwap:swap];
+        }
+    }];
+}
+
+- (void)testPerformanceOfReplay {
+
+    // What launch costs with a long log: 10,000 exchanges read and applied to the model.
+
+    SSCollectionViewExchangeJournal *journal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:self.directoryPath];
+    journal.numberOfExchangesBetweenSnapshots = 0;
+    for (NSUInteger i = 0; i < 10000; i++) {
+        [journal appendSwap:[self randomSwap]];
+    }
+
+    NSArray *arrays = [self arraysWithSections:kBenchmarkSections itemsPerSection:kBenchmarkItemsPerSection];
+
+    [self measureBlock:^{
+        SSCollectionViewExchangeJournal *replayingJournal = [[SSCollectionViewExchangeJournal alloc] initWithDirectoryPath:self.directoryPath];
+        [replayingJournal replayExchangesWithBlock:^(const SSExchangeSwap *swaps, NSUInteger count) {
+            XCTAssertTrue([NSMutableArray exchangeObjectsInArrays:arrays withSwaps:swaps count:count], @"replay failed");
+        }];
+    }];
+}
+
+@end
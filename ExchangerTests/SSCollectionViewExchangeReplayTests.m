@@ -0,0 +1,176 @@
+//
+//  SSCollectionViewExchangeReplayTests.m
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+// Replays synthetic and recorded long press traces through the exchange logic and checks the model,
+// the view and the reported exchanges agree. The full benchmark, against up to 1,000,000 items, is
+// the exchanger-replay tool in ExchangerBenchmark. Only Foundation and XCTest are used.
+
+#import <XCTest/XCTest.h>
+#import "SSCollectionViewExchangeReplay.h"
+
+
+// A model that drops one swap, to check the replay notices.
+typedef struct {
+    SSExchangeReplay    *replay;
+    int64_t             items[100];
+    unsigned int        numberOfSwaps;
+    unsigned int        swapToDrop;
+} FaultyModel;
+
+static bool ExchangeItemsInFaultyModel(const SSExchangeSwap *swaps, unsigned int numberOfSwaps, void *context) {
+
+    FaultyModel *model = context;
+    for (unsigned int i = 0; i < numberOfSwaps; i++) {
+        if (++model->numberOfSwaps == model->swapToDrop) continue;
+        int64_t number1 = SSExchangeReplayNumberOfItemAtIndexPath(model->replay, swaps[i].indexPath1);
+        int64_t number2 = SSExchangeReplayNumberOfItemAtIndexPath(model->replay, swaps[i].indexPath2);
+        int64_t item = model->items[number1];
+        model->items[number1] = model->items[number2];
+        model->items[number2] = item;
+    }
+    return true;
+}
+
+static int64_t ItemInFaultyModel(SSExchangeIndexPath indexPath, void *context) {
+
+    FaultyModel *model = context;
+    return model->items[SSExchangeReplayNumberOfItemAtIndexPath(model->replay, indexPath)];
+}
+
+
+
+@interface SSCollectionViewExchangeReplayTests : XCTestCase
+
+@end
+
+
+@implementation SSCollectionViewExchangeReplayTests
+
+- (SSExchangeReplay *)newReplayWithNumberOfItems:(size_t)numberOfItems numberOfSections:(size_t)numberOfSections {
+
+    size_t numberOfItemsInSections[numberOfSections];
+    for (size_t section = 0; section < numberOfSections; section++) numberOfItemsInSections[section] = numberOfItems / numberOfSections;
+    return SSExchangeReplayCreate(numberOfItemsInSections, numberOfSections, 10, 50.0, 50.0, 5.0);
+}
+
+- (void)testSyntheticTracesKeepModelViewAndReportsInSync {
+
+    size_t sizes[] = { 10, 1000, 100000 };
+
+    for (int i = 0; i < 3; i++) {
+
+        SSExchangeReplay *replay = [self newReplayWithNumberOfItems:sizes[i] numberOfSections:(sizes[i] > 10)? 5 : 1];
+        XCTAssertTrue(replay != NULL, @"replay not created");
+        SSExchangeReplaySetLockedItemInterval(replay, 7);
+
+        NSMutableData *touches = [NSMutableData dataWithLength:500 * 52 * sizeof(SSExchangeTouch)];
+        SSExchangeTouch *trace = touches.mutableBytes;
+        size_t numberOfTouches = 0;
+        uint32_t seed = 1;
+        for (int trial = 0; trial < 500; trial++) {
+            numberOfTouches += SSExchangeReplayMakeTrace(replay, &seed, 50, &trace[numberOfTouches]);
+        }
+
+        // Twice, so the second run starts from where the first left the model.
+        for (int run = 0; run < 2; run++) {
+            SSExchangeReplayResult result;
+            XCTAssertTrue(SSExchangeReplayRun(replay, trace, numberOfTouches, NULL, &result), @"replay didn't run");
+            XCTAssertEqual(result.numberOfMismatches, 0ull, @"mismatches with %zu items", sizes[i]);
+            XCTAssertEqual(result.numberOfTransactions, 500ull, @"every trace begins over an item");
+            XCTAssertTrue(result.numberOfExchangeEvents > 0, @"no exchanges with %zu items", sizes[i]);
+            XCTAssertTrue(result.numberOfCancelledTransactions > 0, @"no cancelled transactions with %zu items", sizes[i]);
+        }
+
+        SSExchangeReplayFree(replay);
+    }
+}
+
+- (void)testRecordedTrace {
+
+    // Items are 50 wide with 5 between them, so item n of the first row spans x 5 + 55n to 55 + 55n.
+    const char *text =
+    "# drag 0,0 over 0,1 and 0,2 then back over 0,2 and drop it there\n"
+    "began 10 10\n"
+    "changed 65 10\n"
+    "changed 57 10\n"      // between items
+    "changed 120 10\n"
+    "\n"
+    "changed 121 10\n"
+    "ended 121 10\n"
+    "not a touch\n";
+
+    size_t numberOfTouches = SSExchangeReplayParseTrace(text, NULL, 0);
+    XCTAssertEqual(numberOfTouches, (size_t)6, @"wrong number of touches parsed");
+
+    SSExchangeTouch touches[6];
+    SSExchangeReplayParseTrace(text, touches, 6);
+    XCTAssertEqual(touches[0].state, SSExchangeTouchBegan, @"wrong state");
+    XCTAssertEqual(touches[5].state, SSExchangeTouchEnded, @"wrong state");
+    XCTAssertEqualWithAccuracy(touches[3].x, 120.0, 0.001, @"wrong x");
+
+    SSExchangeReplay *replay = [self newReplayWithNumberOfItems:20 numberOfSections:1];
+    SSExchangeReplayResult result;
+    SSExchangeReplayRun(replay, touches, numberOfTouches, NULL, &result);
+
+    XCTAssertEqual(result.numberOfExchangeEvents, 2ull, @"expected an exchange with 0,1 then with 0,2");
+    XCTAssertEqual(result.numberOfMismatches, 0ull, @"mismatches");
+    XCTAssertEqual(result.numberOfCancelledTransactions, 0ull, @"cancelled");
+
+    SSExchangeReplayFree(replay);
+}
+
+- (void)testReplayNoticesAModelThatDisagrees {
+
+    FaultyModel model;
+    model.replay = [self newReplayWithNumberOfItems:100 numberOfSections:2];
+    model.numberOfSwaps = 0;
+    model.swapToDrop = 40;
+    for (int32_t i = 0; i < 100; i++) model.items[i] = i;
+
+    SSExchangeTouch touches[200 * 32];
+    size_t numberOfTouches = 0;
+    uint32_t seed = 3;
+    for (int trial = 0; trial < 200; trial++) {
+        numberOfTouches += SSExchangeReplayMakeTrace(model.replay, &seed, 30, &touches[numberOfTouches]);
+    }
+
+    SSExchangeReplayHooks hooks = { ExchangeItemsInFaultyModel, ItemInFaultyModel, NULL, &model };
+    SSExchangeReplayResult result;
+    SSExchangeReplayRun(model.replay, touches, numberOfTouches, &hooks, &result);
+
+    XCTAssertTrue(model.numberOfSwaps >= model.swapToDrop, @"not enough swaps to drop one");
+    XCTAssertTrue(result.numberOfMismatches > 0, @"a dropped swap went unnoticed");
+    XCTAssertEqual(result.numberOfAllocations, UINT64_MAX, @"allocations counted without a counter");
+
+    SSExchangeReplayFree(model.replay);
+}
+
+
+
+//------------------------------
+#pragma mark - Performance...
+
+- (void)testPerformanceOfReplayWithAMillionItems {
+
+    SSExchangeReplay *replay = [self newReplayWithNumberOfItems:1000000 numberOfSections:4];
+    NSMutableData *touches = [NSMutableData dataWithLength:1000 * 102 * sizeof(SSExchangeTouch)];
+    SSExchangeTouch *trace = touches.mutableBytes;
+    size_t numberOfTouches = 0;
+    uint32_t seed = 1;
+    for (int trial = 0; trial < 1000; trial++) {
+        numberOfTouches += SSExchangeReplayMakeTrace(replay, &seed, 100, &trace[numberOfTouches]);
+    }
+
+    [self measureBlock:^{
+        SSExchangeReplayResult result;
+        SSExchangeReplayRun(replay, trace, numberOfTouches, NULL, &result);
+    }];
+
+    SSExchangeReplayFree(replay);
+}
+
+@end
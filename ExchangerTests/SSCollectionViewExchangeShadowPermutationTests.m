@@ -0,0 +1,136 @@
+//
+//  SSCollectionViewExchangeShadowPermutationTests.m
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+// Checks the shadow permutation by keeping a model that lags a collection view, as a commit queue
+// does: swaps are applied to the view and pushed straight away, and reach the model, and are
+// popped, some time later. Every index path in the view must map to the same item in the model.
+// Only Foundation and XCTest are used.
+
+#import <XCTest/XCTest.h>
+#import "SSCollectionViewExchangeShadowPermutation.h"
+#import "SSCollectionViewExchangeTestSupport.h"
+
+
+enum {
+    kSections = 2,
+    kItemsPerSection = 6
+};
+
+
+@interface SSCollectionViewExchangeShadowPermutationTests : SSCollectionViewExchangeTestCase
+
+@end
+
+
+@implementation SSCollectionViewExchangeShadowPermutationTests
+
+
+
+//---------------------
+#pragma mark - Basics...
+
+- (void)testNoPendingSwaps {
+
+    SSExchangeShadowPermutation *shadowPermutation = SSExchangeShadowPermutationCreate();
+    XCTAssertTrue(shadowPermutation != NULL, @"shadow permutation not created");
+
+    SSExchangeIndexPath indexPath = SSExchangeIndexPathMake(1, 4);
+    XCTAssertEqual(SSExchangeShadowPermutationNumberOfPendingSwaps(shadowPermutation), 0u, @"pending swaps when created");
+    XCTAssertTrue(SSExchangeIndexPathEqualToIndexPath(SSExchangeShadowPermutationIndexPathInModel(shadowPermutation, indexPath), indexPath), @"index path mapped with no pending swaps");
+    XCTAssertTrue(SSExchangeIndexPathEqualToIndexPath(SSExchangeShadowPermutationIndexPathInModel(NULL, indexPath), indexPath), @"index path mapped by a NULL shadow permutation");
+
+    XCTAssertTrue(SSExchangeShadowPermutationPushSwaps(shadowPermutation, NULL, 0), @"pushing no swaps failed");
+    XCTAssertFalse(SSExchangeShadowPermutationPushSwaps(shadowPermutation, NULL, 1), @"pushed NULL swaps");
+    XCTAssertFalse(SSExchangeShadowPermutationPushSwaps(NULL, NULL, 0), @"pushed to a NULL shadow permutation");
+
+    SSExchangeShadowPermutationFree(shadowPermutation);
+    SSExchangeShadowPermutationFree(NULL);
+}
+
+- (void)testPendingSwapsAreUndoneNewestFirst {
+
+    SSExchangeShadowPermutation *shadowPermutation = SSExchangeShadowPermutationCreate();
+
+    // 0,0 <-> 0,1 then 0,1 <-> 1,2: the item shown at 1,2 came from 0,1, which came from 0,0.
+    SSExchangeSwap swaps[] = {
+        SSExchangeSwapMake(SSExchangeIndexPathMake(0, 0), SSExchangeIndexPathMake(0, 1)),
+        SSExchangeSwapMake(SSExchangeIndexPathMake(0, 1), SSExchangeIndexPathMake(1, 2)),
+    };
+    XCTAssertTrue(SSExchangeShadowPermutationPushSwaps(shadowPermutation, swaps, 2), @"push failed");
+    XCTAssertEqual(SSExchangeShadowPermutationNumberOfPendingSwaps(shadowPermutation), 2u, @"wrong number of pending swaps");
+
+    SSExchangeIndexPath indexPathInModel = SSExchangeShadowPermutationIndexPathInModel(shadowPermutation, SSExchangeIndexPathMake(1, 2));
+    XCTAssertTrue(SSExchangeIndexPathEqualToIndexPath(indexPathInModel, SSExchangeIndexPathMake(0, 0)), @"1,2 should map to 0,0, not %d,%d", indexPathInModel.section, indexPathInModel.item);
+
+    // Once the model has the first swap the item is at 0,1.
+    SSExchangeShadowPermutationPopSwaps(shadowPermutation, 1);
+    indexPathInModel = SSExchangeShadowPermutationIndexPathInModel(shadowPermutation, SSExchangeIndexPathMake(1, 2));
+    XCTAssertTrue(SSExchangeIndexPathEqualToIndexPath(indexPathInModel, SSExchangeIndexPathMake(0, 1)), @"1,2 should map to 0,1, not %d,%d", indexPathInModel.section, indexPathInModel.item);
+
+    SSExchangeShadowPermutationPopSwaps(shadowPermutation, 5);
+    XCTAssertEqual(SSExchangeShadowPermutationNumberOfPendingSwaps(shadowPermutation), 0u, @"popping more than are pending left some");
+
+    SSExchangeShadowPermutationFree(shadowPermutation);
+}
+
+
+
+//-------------------------------------------
+#pragma mark - Agreement with a lagging model...
+
+- (void)testViewAlwaysMapsToTheSameItemInTheModel {
+
+    for (int i=0; i<10000; i++) {
+
+        SSExchangeTestGrid model, view;
+        SSExchangeTestGridReset(&model, kSections, kItemsPerSection);
+        SSExchangeTestGridReset(&view, kSections, kItemsPerSection);
+
+        // Every swap pushed, in order, so the model can catch up with them.
+        SSExchangeSwap queue[120];
+        unsigned int numberOfQueuedSwaps = 0, numberOfAppliedSwaps = 0;
+        SSExchangeShadowPermutation *shadowPermutation = SSExchangeShadowPermutationCreate();
+
+        for (int step = 0; step < 30; step++) {
+
+            if ([self randomNumberLessThan:3] > 0) {
+
+                // An exchange event: the view has its swaps straight away.
+                unsigned int numberOfSwaps = 1 + [self randomNumberLessThan:4];
+                SSExchangeSwap swaps[4];
+                for (unsigned int j = 0; j < numberOfSwaps; j++) {
+                    swaps[j] = [self randomSwapInSections:kSections itemsPerSection:kItemsPerSection];
+                    queue[numberOfQueuedSwaps++] = swaps[j];
+                }
+                SSExchangeTestGridApplySwaps(&view, swaps, numberOfSwaps);
+                XCTAssertTrue(SSExchangeShadowPermutationPushSwaps(shadowPermutation, swaps, numberOfSwaps), @"push failed");
+
+            } else {
+
+                // The model catches up with some of them.
+                unsigned int numberOfSwaps = [self randomNumberLessThan:numberOfQueuedSwaps - numberOfAppliedSwaps + 1];
+                SSExchangeTestGridApplySwaps(&model, queue + numberOfAppliedSwaps, numberOfSwaps);
+                numberOfAppliedSwaps += numberOfSwaps;
+                SSExchangeShadowPermutationPopSwaps(shadowPermutation, numberOfSwaps);
+            }
+
+            XCTAssertEqual(SSExchangeShadowPermutationNumberOfPendingSwaps(shadowPermutation), numberOfQueuedSwaps - numberOfAppliedSwaps, @"wrong number of pending swaps");
+
+            for (int32_t section = 0; section < kSections; section++) {
+                for (int32_t item = 0; item < kItemsPerSection; item++) {
+                    SSExchangeIndexPath indexPath = SSExchangeIndexPathMake(section, item);
+                    SSExchangeIndexPath indexPathInModel = SSExchangeShadowPermutationIndexPathInModel(shadowPermutation, indexPath);
+                    XCTAssertEqual(*SSExchangeTestGridItem(&model, indexPathInModel), *SSExchangeTestGridItem(&view, indexPath), @"%d,%d maps to the wrong item in the model", section, item);
+                }
+            }
+        }
+
+        SSExchangeShadowPermutationFree(shadowPermutation);
+    }
+}
+
+@end
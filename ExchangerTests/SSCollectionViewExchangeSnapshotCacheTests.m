@@ -0,0 +1,157 @@
+//
+//  SSCollectionViewExchangeSnapshotCacheTests.m
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "SSCollectionViewExchangeSnapshotCache.h"
+
+
+@interface SSCollectionViewExchangeSnapshotCacheTests : XCTestCase
+
+@property (strong, nonatomic) SSCollectionViewExchangeSnapshotCache *cache;
+@property (strong, nonatomic) UIImage *image1;
+@property (strong, nonatomic) UIImage *image2;
+
+@end
+
+
+@implementation SSCollectionViewExchangeSnapshotCacheTests
+
+- (void)setUp {
+
+    [super setUp];
+
+    self.cache = [SSCollectionViewExchangeSnapshotCache new];
+    self.image1 = [SSCollectionViewExchangeSnapshotCache imageByRenderingView:[[UIView alloc] initWithFrame:CGRectMake(0.0, 0.0, 50.0, 50.0)]];
+    self.image2 = [SSCollectionViewExchangeSnapshotCache imageByRenderingView:[[UIView alloc] initWithFrame:CGRectMake(0.0, 0.0, 50.0, 50.0)]];
+}
+
+- (UIView *)richCell {
+
+    // Stands in for a cell with a lot going on: shadows, rounded corners, and many labels.
+
+    UIView *cell = [[UIView alloc] initWithFrame:CGRectMake(0.0, 0.0, 300.0, 300.0)];
+    cell.backgroundColor = [UIColor whiteColor];
+    cell.layer.cornerRadius = 12.0;
+
+    for (int i = 0; i < 60; i++) {
+        UILabel *label = [[UILabel alloc] initWithFrame:CGRectMake((i % 6) * 50.0, (i / 6) * 30.0, 48.0, 28.0)];
+        label.text = [NSString stringWithFormat:@"%d", i];
+        label.layer.shadowOpacity = 0.5;
+        label.layer.shadowRadius = 3.0;
+        label.layer.cornerRadius = 4.0;
+        label.backgroundColor = [UIColor colorWithWhite:i / 60.0 alpha:1.0];
+        [cell addSubview:label];
+    }
+
+    return cell;
+}
+
+
+
+//----------------------
+#pragma mark - Images...
+
+- (void)testImageIsReturnedOnlyForMatchingVersionAndSize {
+
+    NSIndexPath *indexPath = [NSIndexPath indexPathForItem:3 inSection:1];
+    [self.cache setImage:self.image1 forItemAtIndexPath:indexPath contentVersion:7];
+
+    XCTAssertEqual([self.cache imageForItemAtIndexPath:indexPath contentVersion:7 size:self.image1.size], self.image1, @"cached image not returned");
+    XCTAssertNil([self.cache imageForItemAtIndexPath:indexPath contentVersion:8 size:self.image1.size], @"image returned for another content version");
+    XCTAssertNil([self.cache imageForItemAtIndexPath:indexPath contentVersion:7 size:CGSizeMake(10.0, 10.0)], @"image returned for another size");
+    XCTAssertNil([self.cache imageForItemAtIndexPath:[NSIndexPath indexPathForItem:4 inSection:1] contentVersion:7 size:self.image1.size], @"image returned for another item");
+
+    [self.cache removeAllImages];
+    XCTAssertNil([self.cache imageForItemAtIndexPath:indexPath contentVersion:7 size:self.image1.size], @"image returned after removeAllImages");
+}
+
+- (void)testExchangeMovesImages {
+
+    NSIndexPath *indexPath1 = [NSIndexPath indexPathForItem:0 inSection:0];
+    NSIndexPath *indexPath2 = [NSIndexPath indexPathForItem:2 inSection:2];
+    NSIndexPath *indexPath3 = [NSIndexPath indexPathForItem:5 inSection:1];
+
+    [self.cache setImage:self.image1 forItemAtIndexPath:indexPath1 contentVersion:1];
+    [self.cache setImage:self.image2 forItemAtIndexPath:indexPath2 contentVersion:2];
+
+    [self.cache exchangeImageForItemAtIndexPath:indexPath1 withImageForItemAtIndexPath:indexPath2];
+    XCTAssertEqual([self.cache imageForItemAtIndexPath:indexPath1 contentVersion:2 size:self.image2.size], self.image2, @"image did not follow its item");
+    XCTAssertEqual([self.cache imageForItemAtIndexPath:indexPath2 contentVersion:1 size:self.image1.size], self.image1, @"image did not follow its item");
+
+    // Exchanging with an item that has no image leaves nothing behind.
+    [self.cache exchangeImageForItemAtIndexPath:indexPath1 withImageForItemAtIndexPath:indexPath3];
+    XCTAssertNil([self.cache imageForItemAtIndexPath:indexPath1 contentVersion:2 size:self.image2.size], @"stale image left behind");
+    XCTAssertEqual([self.cache imageForItemAtIndexPath:indexPath3 contentVersion:2 size:self.image2.size], self.image2, @"image did not follow its item");
+}
+
+
+
+//---------------------------
+#pragma mark - Image views...
+
+- (void)testPooledImageViewsAreReusedAndReset {
+
+    UIView *superview = [UIView new];
+    UIImageView *imageView = [self.cache dequeueImageViewWithImage:self.image1];
+    [superview addSubview:imageView];
+    imageView.alpha = 0.0;
+    imageView.transform = CGAffineTransformMakeScale(1.2, 1.2);
+    imageView.center = CGPointMake(200.0, 200.0);
+
+    [self.cache enqueueImageView:imageView];
+    XCTAssertNil(imageView.superview, @"pooled image view still in its superview");
+
+    UIImageView *reusedImageView = [self.cache dequeueImageViewWithImage:self.image2];
+    XCTAssertEqual(reusedImageView, imageView, @"image view not reused");
+    XCTAssertEqual(reusedImageView.image, self.image2, @"wrong image");
+    XCTAssertEqual(reusedImageView.alpha, (CGFloat)1.0, @"alpha not reset");
+    XCTAssertTrue(CGAffineTransformIsIdentity(reusedImageView.transform), @"transform not reset");
+    XCTAssertTrue(CGRectEqualToRect(reusedImageView.frame, (CGRect){ CGPointZero, self.image2.size }), @"frame not reset");
+}
+
+
+
+//------------------------------
+#pragma mark - Performance...
+
+// These measure the part of the catch that the cache affects: getting an image of the cell
+// and a view to show it in. Compare the two in the test report.
+
+- (void)testPerformanceOfCatchWithColdCache {
+
+    UIView *cell = [self richCell];
+    NSIndexPath *indexPath = [NSIndexPath indexPathForItem:0 inSection:0];
+
+    [self measureBlock:^{
+        for (NSUInteger contentVersion = 0; contentVersion < 20; contentVersion++) {
+            UIImage *image = [self.cache imageForItemAtIndexPath:indexPath contentVersion:contentVersion size:cell.bounds.size];
+            if (image == nil) {
+                image = [SSCollectionViewExchangeSnapshotCache imageByRenderingView:cell];
+                [self.cache setImage:image forItemAtIndexPath:indexPath contentVersion:contentVersion];
+            }
+            [self.cache enqueueImageView:[self.cache dequeueImageViewWithImage:image]];
+        }
+        [self.cache removeAllImages];
+    }];
+}
+
+- (void)testPerformanceOfCatchWithWarmCache {
+
+    UIView *cell = [self richCell];
+    NSIndexPath *indexPath = [NSIndexPath indexPathForItem:0 inSection:0];
+    [self.cache setImage:[SSCollectionViewExchangeSnapshotCache imageByRenderingView:cell] forItemAtIndexPath:indexPath contentVersion:0];
+
+    [self measureBlock:^{
+        for (int i = 0; i < 20; i++) {
+            UIImage *image = [self.cache imageForItemAtIndexPath:indexPath contentVersion:0 size:cell.bounds.size];
+            XCTAssertNotNil(image, @"cache miss");
+            [self.cache enqueueImageView:[self.cache dequeueImageViewWithImage:image]];
+        }
+    }];
+}
+
+@end
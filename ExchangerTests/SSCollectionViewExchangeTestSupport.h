@@ -0,0 +1,68 @@
+//
+//  SSCollectionViewExchangeTestSupport.h
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+// Fixtures shared by the tests: a grid of numbered items to apply swaps and moves to, and a test
+// case base class with a seeded random number generator, so failures and timings are reproducible,
+// and the random swaps and arrays of numbers built from it. Only Foundation and XCTest are used.
+
+#import <XCTest/XCTest.h>
+#import "SSCollectionViewExchangeCore.h"
+
+
+
+//----------------
+// Grid...
+
+enum {
+    SSExchangeTestGridCapacity = 256
+};
+
+typedef struct {
+    int32_t numberOfSections;
+    int32_t itemsPerSection;
+    int32_t items[SSExchangeTestGridCapacity];
+} SSExchangeTestGrid;
+// A model, or a mirror of the view, small enough to copy and compare with memcmp. The item at
+// section, item starts as section * itemsPerSection + item.
+
+void SSExchangeTestGridReset(SSExchangeTestGrid *grid, int32_t numberOfSections, int32_t itemsPerSection);
+// Numbers every item in place. numberOfSections * itemsPerSection must be at most
+// SSExchangeTestGridCapacity. The unused capacity is zeroed so grids compare with memcmp.
+
+int32_t *SSExchangeTestGridItem(SSExchangeTestGrid *grid, SSExchangeIndexPath indexPath);
+
+void SSExchangeTestGridApplySwaps(SSExchangeTestGrid *grid, const SSExchangeSwap *swaps, unsigned int numberOfSwaps);
+// Applies the swaps in order, as the delegate applies them to the model.
+
+void SSExchangeTestGridApplyMoves(SSExchangeTestGrid *grid, const SSExchangeMove *moves, unsigned int numberOfMoves);
+// Applies the moves all at once, like moveItemAtIndexPath:toIndexPath: in a batch update.
+
+unsigned int SSExchangeTestGridNumberOfItemsOutOfPlace(const SSExchangeTestGrid *grid);
+
+bool SSExchangeTestGridEqualToGrid(const SSExchangeTestGrid *grid1, const SSExchangeTestGrid *grid2);
+
+
+
+//----------------
+// Test case...
+
+@interface SSCollectionViewExchangeTestCase : XCTestCase
+
+@property (nonatomic) uint32_t seed;    // 1 at the start of every test
+
+- (uint32_t)randomNumberLessThan:(uint32_t)upperBound;
+// A deterministic linear congruential generator.
+
+- (SSExchangeIndexPath)randomIndexPathInSections:(uint32_t)sections itemsPerSection:(uint32_t)itemsPerSection;
+- (SSExchangeSwap)randomSwapInSections:(uint32_t)sections itemsPerSection:(uint32_t)itemsPerSection;
+- (SSExchangeSwap)randomSwapForArrays:(NSArray *)arrays;
+// Either index path may be in any section and the two may be the same.
+
+- (NSArray *)arraysWithSections:(NSUInteger)sections itemsPerSection:(NSUInteger)itemsPerSection;
+// NSMutableArrays of NSNumbers numbered like a grid.
+
+@end
@@ -0,0 +1,117 @@
+//
+//  SSCollectionViewExchangeTestSupport.m
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+#import "SSCollectionViewExchangeTestSupport.h"
+
+
+
+//----------------
+// Grid...
+
+void SSExchangeTestGridReset(SSExchangeTestGrid *grid, int32_t numberOfSections, int32_t itemsPerSection) {
+
+    memset(grid, 0, sizeof(SSExchangeTestGrid));
+    grid->numberOfSections = numberOfSections;
+    grid->itemsPerSection = itemsPerSection;
+    for (int32_t i = 0; i < numberOfSections * itemsPerSection; i++) grid->items[i] = i;
+}
+
+int32_t *SSExchangeTestGridItem(SSExchangeTestGrid *grid, SSExchangeIndexPath indexPath) {
+
+    return &grid->items[indexPath.section * grid->itemsPerSection + indexPath.item];
+}
+
+void SSExchangeTestGridApplySwaps(SSExchangeTestGrid *grid, const SSExchangeSwap *swaps, unsigned int numberOfSwaps) {
+
+    for (unsigned int i = 0; i < numberOfSwaps; i++) {
+        int32_t item = *SSExchangeTestGridItem(grid, swaps[i].indexPath1);
+        *SSExchangeTestGridItem(grid, swaps[i].indexPath1) = *SSExchangeTestGridItem(grid, swaps[i].indexPath2);
+        *SSExchangeTestGridItem(grid, swaps[i].indexPath2) = item;
+    }
+}
+
+void SSExchangeTestGridApplyMoves(SSExchangeTestGrid *grid, const SSExchangeMove *moves, unsigned int numberOfMoves) {
+
+    SSExchangeTestGrid before = *grid;
+    for (unsigned int i = 0; i < numberOfMoves; i++) {
+        *SSExchangeTestGridItem(grid, moves[i].toIndexPath) = *SSExchangeTestGridItem(&before, moves[i].fromIndexPath);
+    }
+}
+
+unsigned int SSExchangeTestGridNumberOfItemsOutOfPlace(const SSExchangeTestGrid *grid) {
+
+    unsigned int numberOfItems = 0;
+    for (int32_t i = 0; i < grid->numberOfSections * grid->itemsPerSection; i++) {
+        if (grid->items[i] != i) numberOfItems++;
+    }
+    return numberOfItems;
+}
+
+bool SSExchangeTestGridEqualToGrid(const SSExchangeTestGrid *grid1, const SSExchangeTestGrid *grid2) {
+
+    return memcmp(grid1, grid2, sizeof(SSExchangeTestGrid)) == 0;
+}
+
+
+
+//----------------
+// Test case...
+
+@implementation SSCollectionViewExchangeTestCase
+
+- (void)setUp {
+
+    [super setUp];
+    self.seed = 1;
+}
+
+- (uint32_t)randomNumberLessThan:(uint32_t)upperBound {
+
+    self.seed = self.seed * 1664525 + 1013904223;
+    return (self.seed >> 8) % upperBound;
+}
+
+- (SSExchangeIndexPath)randomIndexPathInSections:(uint32_t)sections itemsPerSection:(uint32_t)itemsPerSection {
+
+    int32_t section = [self randomNumberLessThan:sections];
+    int32_t item = [self randomNumberLessThan:itemsPerSection];
+
+    return SSExchangeIndexPathMake(section, item);
+}
+
+- (SSExchangeSwap)randomSwapInSections:(uint32_t)sections itemsPerSection:(uint32_t)itemsPerSection {
+
+    SSExchangeIndexPath indexPath1 = [self randomIndexPathInSections:sections itemsPerSection:itemsPerSection];
+    SSExchangeIndexPath indexPath2 = [self randomIndexPathInSections:sections itemsPerSection:itemsPerSection];
+
+    return SSExchangeSwapMake(indexPath1, indexPath2);
+}
+
+- (SSExchangeSwap)randomSwapForArrays:(NSArray *)arrays {
+
+    int32_t section1 = [self randomNumberLessThan:(uint32_t)arrays.count];
+    int32_t section2 = [self randomNumberLessThan:(uint32_t)arrays.count];
+    int32_t item1 = [self randomNumberLessThan:(uint32_t)[arrays[ section1 ] count]];
+    int32_t item2 = [self randomNumberLessThan:(uint32_t)[arrays[ section2 ] count]];
+
+    return SSExchangeSwapMake(SSExchangeIndexPathMake(section1, item1), SSExchangeIndexPathMake(section2, item2));
+}
+
+- (NSArray *)arraysWithSections:(NSUInteger)sections itemsPerSection:(NSUInteger)itemsPerSection {
+
+    NSMutableArray *arrays = [[NSMutableArray alloc] initWithCapacity:sections];
+    for (NSUInteger section = 0; section < sections; section++) {
+        NSMutableArray *array = [[NSMutableArray alloc] initWithCapacity:itemsPerSection];
+        for (NSUInteger item = 0; item < itemsPerSection; item++) {
+            [array addObject:@(section * itemsPerSection + item)];
+        }
+        [arrays addObject:array];
+    }
+    return arrays;
+}
+
+@end
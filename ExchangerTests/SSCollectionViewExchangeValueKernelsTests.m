@@ -0,0 +1,329 @@
+//
+//  SSCollectionViewExchangeValueKernelsTests.m
+//  Exchanger
+//
+//  Copyright (c) 2014 Murray Sagal. All rights reserved.
+//
+
+// Checks the value kernels, through NSMutableData+SSCollectionViewExchangeControllerAdditions, against
+// the NSMutableArray category they stand in for: the same swaps and moves applied to boxed arrays and
+// to datas of every value type must leave the same values, and the running sums must always equal
+// sums recalculated from scratch. The values are small integers so they are exact in every type.
+
+#import <XCTest/XCTest.h>
+#import "NSMutableArray+SSCollectionViewExchangeControllerAdditions.h"
+#import "NSMutableData+SSCollectionViewExchangeControllerAdditions.h"
+#import "SSCollectionViewExchangeTestSupport.h"
+
+
+static uint32_t const kSections = 3;
+static uint32_t const kValuesPerSection = 20;
+
+static uint32_t const kBenchmarkValuesPerSection = 10000;
+static NSUInteger const kBenchmarkSwaps = 100000;
+
+static SSExchangeValueType const kValueTypes[] = {
+    SSExchangeValueTypeInt32,
+    SSExchangeValueTypeInt64,
+    SSExchangeValueTypeFloat,
+    SSExchangeValueTypeDouble
+};
+
+
+@interface SSCollectionViewExchangeValueKernelsTests : SSCollectionViewExchangeTestCase
+
+@end
+
+
+@implementation SSCollectionViewExchangeValueKernelsTests
+
+- (NSArray *)datasOfType:(SSExchangeValueType)type withArrays:(NSArray *)arrays {
+
+    NSMutableArray *datas = [[NSMutableArray alloc] init];
+    for (NSArray *array in arrays) {
+        NSMutableData *data = [NSMutableData dataWithLength:array.count * SSExchangeValueTypeSize(type)];
+        for (NSUInteger i = 0; i < array.count; i++) {
+            switch (type) {
+                case SSExchangeValueTypeInt32:  ((int32_t *)data.mutableBytes)[i] = [array[ i ] intValue]; break;
+                case SSExchangeValueTypeInt64:  ((int64_t *)data.mutableBytes)[i] = [array[ i ] longLongValue]; break;
+                case SSExchangeValueTypeFloat:  ((float *)data.mutableBytes)[i] = [array[ i ] floatValue]; break;
+                case SSExchangeValueTypeDouble: ((double *)data.mutableBytes)[i] = [array[ i ] doubleValue]; break;
+            }
+        }
+        [datas addObject:data];
+    }
+    return datas;
+}
+
+- (double)valueAtIndex:(NSUInteger)index inData:(NSData *)data ofType:(SSExchangeValueType)type {
+
+    switch (type) {
+        case SSExchangeValueTypeInt32:  return ((const int32_t *)data.bytes)[index];
+        case SSExchangeValueTypeInt64:  return ((const int64_t *)data.bytes)[index];
+        case SSExchangeValueTypeFloat:  return ((const float *)data.bytes)[index];
+        case SSExchangeValueTypeDouble: return ((const double *)data.bytes)[index];
+    }
+    return NAN;
+}
+
+- (BOOL)datas:(NSArray *)datas ofType:(SSExchangeValueType)type matchArrays:(NSArray *)arrays {
+
+    for (NSUInteger section = 0; section < arrays.count; section++) {
+        NSArray *array = arrays[ section ];
+        if ([datas[ section ] length] != array.count * SSExchangeValueTypeSize(type)) return NO;
+        for (NSUInteger i = 0; i < array.count; i++) {
+            if ([self valueAtIndex:i inData:datas[ section ] ofType:type] != [array[ i ] doubleValue]) return NO;
+        }
+    }
+    return YES;
+}
+
+- (void)getSums:(SSExchangeValueSum *)sums ofDatas:(NSArray *)datas ofType:(SSExchangeValueType)type {
+
+    for (NSUInteger section = 0; section < datas.count; section++) {
+        sums[section] = [datas[ section ] sumOfValuesOfType:type];
+    }
+}
+
+- (BOOL)sums:(const SSExchangeValueSum *)sums matchDatas:(NSArray *)datas ofType:(SSExchangeValueType)type {
+
+    BOOL isInteger = (type == SSExchangeValueTypeInt32 || type == SSExchangeValueTypeInt64);
+    for (NSUInteger section = 0; section < datas.count; section++) {
+        SSExchangeValueSum sum = [datas[ section ] sumOfValuesOfType:type];
+        if (isInteger && sum.integerSum != sums[section].integerSum) return NO;
+        if (!isInteger && sum.doubleSum != sums[section].doubleSum) return NO;
+    }
+    return YES;
+}
+
+
+
+//------------------------------------
+#pragma mark - Equivalence with boxes...
+
+- (void)testExchangeMatchesBoxedExchangeForEveryType {
+
+    for (int i=0; i<1000; i++) {
+
+        NSArray *arrays = [self arraysWithSections:kSections itemsPerSection:kValuesPerSection];
+        NSUInteger count = 1 + [self randomNumberLessThan:16];
+        SSExchangeSwap swaps[16];
+        for (NSUInteger j = 0; j < count; j++) {
+            swaps[j] = [self randomSwapInSections:kSections itemsPerSection:kValuesPerSection];
+        }
+
+        NSArray *originalArrays = [self arraysWithSections:kSections itemsPerSection:kValuesPerSection];
+        XCTAssertTrue([NSMutableArray exchangeObjectsInArrays:arrays withSwaps:swaps count:count], @"valid boxed batch failed");
+
+        for (size_t t = 0; t < sizeof(kValueTypes) / sizeof(kValueTypes[0]); t++) {
+
+            SSExchangeValueType type = kValueTypes[t];
+            NSArray *datas = [self datasOfType:type withArrays:originalArrays];
+            SSExchangeValueSum sums[kSections];
+            [self getSums:sums ofDatas:datas ofType:type];
+
+            XCTAssertTrue([NSMutableData exchangeValuesOfType:type inDatas:datas withSwaps:swaps count:count sums:sums], @"valid batch failed for type %d", type);
+            XCTAssertTrue([self datas:datas ofType:type matchArrays:arrays], @"type %d differs from the boxed batch %@", type, arrays);
+            XCTAssertTrue([self sums:sums matchDatas:datas ofType:type], @"running sums for type %d differ from recalculated sums", type);
+        }
+    }
+}
+
+- (void)testMoveMatchesBoxedMovesForEveryType {
+
+    for (int i=0; i<1000; i++) {
+
+        // Some distinct index paths, each moving to another of them...
+        NSMutableArray *fromIndexPaths = [[NSMutableArray alloc] init];
+        NSUInteger count = 1 + [self randomNumberLessThan:16];
+        while (fromIndexPaths.count < count) {
+            NSUInteger indexes[] = { [self randomNumberLessThan:kSections], [self randomNumberLessThan:kValuesPerSection] };
+            NSIndexPath *indexPath = [NSIndexPath indexPathWithIndexes:indexes length:2];
+            if ([fromIndexPaths containsObject:indexPath] == NO) [fromIndexPaths addObject:indexPath];
+        }
+        NSMutableArray *toIndexPaths = [fromIndexPaths mutableCopy];
+        for (NSUInteger j = count - 1; j > 0; j--) {
+            [toIndexPaths exchangeObjectAtIndex:j withObjectAtIndex:[self randomNumberLessThan:(uint32_t)j + 1]];
+        }
+
+        NSArray *arrays = [self arraysWithSections:kSections itemsPerSection:kValuesPerSection];
+        NSArray *originalArrays = [self arraysWithSections:kSections itemsPerSection:kValuesPerSection];
+        XCTAssertTrue([NSMutableArray moveObjectsInArrays:arrays fromIndexPaths:fromIndexPaths toIndexPaths:toIndexPaths], @"valid boxed moves failed");
+
+        for (size_t t = 0; t < sizeof(kValueTypes) / sizeof(kValueTypes[0]); t++) {
+
+            SSExchangeValueType type = kValueTypes[t];
+            NSArray *datas = [self datasOfType:type withArrays:originalArrays];
+            SSExchangeValueSum sums[kSections];
+            [self getSums:sums ofDatas:datas ofType:type];
+
+            XCTAssertTrue([NSMutableData moveValuesOfType:type inDatas:datas fromIndexPaths:fromIndexPaths toIndexPaths:toIndexPaths sums:sums], @"valid moves failed for type %d", type);
+            XCTAssertTrue([self datas:datas ofType:type matchArrays:arrays], @"type %d differs from the boxed moves %@", type, arrays);
+            XCTAssertTrue([self sums:sums matchDatas:datas ofType:type], @"running sums for type %d differ from recalculated sums", type);
+        }
+    }
+}
+
+- (void)testPermuteMatchesBoxedMovesForEveryType {
+
+    for (int i=0; i<100; i++) {
+
+        uint32_t sourceIndices[kValuesPerSection];
+        for (uint32_t j = 0; j < kValuesPerSection; j++) sourceIndices[j] = j;
+        for (uint32_t j = kValuesPerSection - 1; j > 0; j--) {
+            uint32_t k = [self randomNumberLessThan:j + 1];
+            uint32_t index = sourceIndices[j];
+            sourceIndices[j] = sourceIndices[k];
+            sourceIndices[k] = index;
+        }
+
+        // values[j] = old values[sourceIndices[j]] is the move sourceIndices[j] -> j.
+        NSMutableArray *fromIndexPaths = [[NSMutableArray alloc] init];
+        NSMutableArray *toIndexPaths = [[NSMutableArray alloc] init];
+        for (NSUInteger j = 0; j < kValuesPerSection; j++) {
+            [fromIndexPaths addObject:[NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 0, sourceIndices[j] } length:2]];
+            [toIndexPaths addObject:[NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 0, j } length:2]];
+        }
+
+        NSArray *arrays = [self arraysWithSections:kSections itemsPerSection:kValuesPerSection];
+        NSArray *originalArrays = [self arraysWithSections:kSections itemsPerSection:kValuesPerSection];
+        XCTAssertTrue([NSMutableArray moveObjectsInArrays:arrays fromIndexPaths:fromIndexPaths toIndexPaths:toIndexPaths], @"valid boxed moves failed");
+
+        for (size_t t = 0; t < sizeof(kValueTypes) / sizeof(kValueTypes[0]); t++) {
+
+            SSExchangeValueType type = kValueTypes[t];
+            NSArray *datas = [self datasOfType:type withArrays:originalArrays];
+
+            XCTAssertTrue([datas[0] permuteValuesOfType:type withSourceIndices:sourceIndices], @"valid permutation failed for type %d", type);
+            XCTAssertTrue([self datas:datas ofType:type matchArrays:arrays], @"type %d differs from the boxed moves %@", type, arrays);
+        }
+    }
+}
+
+
+
+//-------------------------
+#pragma mark - Validation...
+
+- (void)testInvalidInputIsAllOrNothing {
+
+    NSArray *originalArrays = [self arraysWithSections:kSections itemsPerSection:5];
+
+    for (size_t t = 0; t < sizeof(kValueTypes) / sizeof(kValueTypes[0]); t++) {
+
+        SSExchangeValueType type = kValueTypes[t];
+        NSArray *datas = [self datasOfType:type withArrays:originalArrays];
+
+        SSExchangeSwap swaps[] = {
+            SSExchangeSwapMake(SSExchangeIndexPathMake(0, 0), SSExchangeIndexPathMake(1, 4)),   // valid
+            SSExchangeSwapMake(SSExchangeIndexPathMake(1, 5), SSExchangeIndexPathMake(0, 0)),   // item above upper bounds
+        };
+        XCTAssertFalse([NSMutableData exchangeValuesOfType:type inDatas:datas withSwaps:swaps count:2 sums:NULL], @"batch succeeded with an item above upper bounds");
+
+        swaps[1] = SSExchangeSwapMake(SSExchangeIndexPathMake(3, 0), SSExchangeIndexPathMake(0, 0));
+        XCTAssertFalse([NSMutableData exchangeValuesOfType:type inDatas:datas withSwaps:swaps count:2 sums:NULL], @"batch succeeded with a section above upper bounds");
+
+        swaps[1] = SSExchangeSwapMake(SSExchangeIndexPathNone, SSExchangeIndexPathMake(0, 0));
+        XCTAssertFalse([NSMutableData exchangeValuesOfType:type inDatas:datas withSwaps:swaps count:2 sums:NULL], @"batch succeeded with a negative index path");
+
+        XCTAssertFalse([NSMutableData exchangeValuesOfType:type inDatas:datas withSwaps:NULL count:1 sums:NULL], @"batch succeeded with NULL swaps");
+        XCTAssertFalse([NSMutableData exchangeValuesOfType:type inDatas:nil withSwaps:swaps count:1 sums:NULL], @"batch succeeded with nil datas");
+
+        NSArray *fromIndexPaths = @[ [NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 0, 1 } length:2],
+                                     [NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 1, 5 } length:2] ];
+        NSArray *toIndexPaths = @[ fromIndexPaths[1], fromIndexPaths[0] ];
+        XCTAssertFalse([NSMutableData moveValuesOfType:type inDatas:datas fromIndexPaths:fromIndexPaths toIndexPaths:toIndexPaths sums:NULL], @"moves succeeded with an item above upper bounds");
+        XCTAssertFalse([NSMutableData moveValuesOfType:type inDatas:datas fromIndexPaths:fromIndexPaths toIndexPaths:@[] sums:NULL], @"moves succeeded with mismatched counts");
+
+        // Valid index paths that aren't a rearrangement of each other...
+        NSIndexPath *indexPath00 = [NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 0, 0 } length:2];
+        NSIndexPath *indexPath01 = [NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 0, 1 } length:2];
+        NSIndexPath *indexPath10 = [NSIndexPath indexPathWithIndexes:(NSUInteger[]){ 1, 0 } length:2];
+        XCTAssertFalse([NSMutableData moveValuesOfType:type inDatas:datas fromIndexPaths:@[ indexPath00, indexPath10 ] toIndexPaths:@[ indexPath10, indexPath10 ] sums:NULL], @"moves succeeded with a repeated toIndexPath");
+        XCTAssertFalse([NSMutableData moveValuesOfType:type inDatas:datas fromIndexPaths:@[ indexPath00, indexPath00 ] toIndexPaths:@[ indexPath00, indexPath01 ] sums:NULL], @"moves succeeded with a repeated fromIndexPath");
+        XCTAssertFalse([NSMutableData moveValuesOfType:type inDatas:datas fromIndexPaths:@[ indexPath00, indexPath01 ] toIndexPaths:@[ indexPath01, indexPath10 ] sums:NULL], @"moves succeeded to an index path nothing moved from");
+
+        XCTAssertTrue([self datas:datas ofType:type matchArrays:originalArrays], @"datas of type %d modified by invalid input", type);
+    }
+}
+
+- (void)testDatasMustHoldWholeValuesAndBeMutable {
+
+    NSArray *originalArrays = [self arraysWithSections:kSections itemsPerSection:5];
+    NSArray *datas = [self datasOfType:SSExchangeValueTypeInt64 withArrays:originalArrays];
+    SSExchangeSwap swap = SSExchangeSwapMake(SSExchangeIndexPathMake(0, 0), SSExchangeIndexPathMake(1, 0));
+
+    NSMutableData *ragged = [datas[1] mutableCopy];
+    [ragged setLength:ragged.length - 1];
+    XCTAssertFalse([NSMutableData exchangeValuesOfType:SSExchangeValueTypeInt64 inDatas:@[ datas[0], ragged ] withSwaps:&swap count:1 sums:NULL], @"batch succeeded with a partial value");
+
+    NSData *immutable = [datas[1] copy];
+    XCTAssertFalse([NSMutableData exchangeValuesOfType:SSExchangeValueTypeInt64 inDatas:@[ datas[0], immutable ] withSwaps:&swap count:1 sums:NULL], @"batch succeeded with an immutable data");
+
+    XCTAssertTrue([self datas:datas ofType:SSExchangeValueTypeInt64 matchArrays:originalArrays], @"datas modified by invalid input");
+}
+
+- (void)testPermuteRejectsNonPermutations {
+
+    NSArray *originalArrays = [self arraysWithSections:kSections itemsPerSection:4];
+    NSArray *datas = [self datasOfType:SSExchangeValueTypeInt32 withArrays:originalArrays];
+
+    uint32_t repeated[] = { 0, 1, 1, 3 };
+    uint32_t outOfBounds[] = { 0, 1, 2, 4 };
+
+    XCTAssertFalse([datas[0] permuteValuesOfType:SSExchangeValueTypeInt32 withSourceIndices:repeated], @"permutation succeeded with a repeated index");
+    XCTAssertFalse([datas[0] permuteValuesOfType:SSExchangeValueTypeInt32 withSourceIndices:outOfBounds], @"permutation succeeded with an index above upper bounds");
+    XCTAssertFalse([datas[0] permuteValuesOfType:SSExchangeValueTypeInt32 withSourceIndices:NULL], @"permutation succeeded with NULL indices");
+    XCTAssertTrue([self datas:datas ofType:SSExchangeValueTypeInt32 matchArrays:originalArrays], @"data modified by an invalid permutation");
+}
+
+
+
+//-------------------
+#pragma mark - Sums...
+
+- (void)testSumOfValues {
+
+    // 7 values so the sum has a tail after the groups of four.
+    int32_t int32s[] = { 1, -2, 3, INT32_MAX, 5, INT32_MAX, 7 };
+    NSMutableData *data = [NSMutableData dataWithBytes:int32s length:sizeof(int32s)];
+    XCTAssertEqual([data sumOfValuesOfType:SSExchangeValueTypeInt32].integerSum, (int64_t)14 + 2 * (int64_t)INT32_MAX, @"int32 values are summed in 64 bits");
+
+    int64_t int64s[] = { INT64_MAX, 1 };
+    data = [NSMutableData dataWithBytes:int64s length:sizeof(int64s)];
+    XCTAssertEqual([data sumOfValuesOfType:SSExchangeValueTypeInt64].integerSum, INT64_MIN, @"int64 sums wrap on overflow");
+
+    float floats[] = { 0.5f, 1.5f, 2.5f, 3.5f, 4.5f };
+    data = [NSMutableData dataWithBytes:floats length:sizeof(floats)];
+    XCTAssertEqual([data sumOfValuesOfType:SSExchangeValueTypeFloat].doubleSum, 12.5, @"wrong float sum");
+
+    XCTAssertEqual([[NSMutableData data] sumOfValuesOfType:SSExchangeValueTypeDouble].doubleSum, 0.0, @"the sum of no values is 0");
+}
+
+
+
+//--------------------------
+#pragma mark - Benchmarks...
+
+- (void)testPerformanceOfInt64KernelExchange {
+
+    // The same values and swaps as testPerformanceOfBatchExchange in NSMutableArrayBatchExchangeTests,
+    // the boxed baseline.
+    NSArray *arrays = [self arraysWithSections:kSections itemsPerSection:kBenchmarkValuesPerSection];
+    NSArray *datas = [self datasOfType:SSExchangeValueTypeInt64 withArrays:arrays];
+    SSExchangeSwap *swaps = malloc(kBenchmarkSwaps * sizeof(SSExchangeSwap));
+    for (NSUInteger i = 0; i < kBenchmarkSwaps; i++) {
+        swaps[i] = [self randomSwapForArrays:arrays];
+    }
+    SSExchangeValueSum *sums = malloc(kSections * sizeof(SSExchangeValueSum));
+    [self getSums:sums ofDatas:datas ofType:SSExchangeValueTypeInt64];
+
+    [self measureBlock:^{
+        (void) [NSMutableData exchangeValuesOfType:SSExchangeValueTypeInt64 inDatas:datas withSwaps:swaps count:kBenchmarkSwaps sums:sums];
+    }];
+
+    free(sums);
+    free(swaps);
+}
+
+@end
@@ -27,6 +27,7 @@
 
 
 #import <Foundation/Foundation.h>
+#import "SSCollectionViewExchangeTypes.h"
 
 @interface NSMutableArray (SSCollectionViewExchangeControllerAdditions)
 
@@ -34,4 +35,33 @@
        withObjectInOtherArray:(NSMutableArray *)otherArray  atIndex:(NSUInteger)indexInOtherArray;
 // exchanges two objects that *can* be in two different arrays.
 
++ (BOOL)exchangeObjectsInArrays:(NSArray *)arrays
+                      withSwaps:(const SSExchangeSwap *)swaps
+                          count:(NSUInteger)count;
+// Applies count exchanges, in order, as if exchangeObjectInArray:atIndex:withObjectInOtherArray:atIndex:
+// had been called once for each. arrays maps sections to arrays: the array for section n is arrays[n]
+// and it must be an NSMutableArray that is not used for any other section. Exchanges can be within
+// one array or between two arrays.
+//
+// Every swap is validated before any is applied. Returns NO, leaving all the arrays untouched, if
+// arrays is nil, swaps is NULL (and count is not 0), any index path names a section or item that
+// does not exist, or a section the swaps touch shares its array with an earlier section. Returns YES
+// otherwise.
+//
+// Intended for large batches. Each array involved is read once and written once, over the range of
+// indices the batch touches, and the exchanges themselves are applied to a plain C buffer.
+
++ (BOOL)moveObjectsInArrays:(NSArray *)arrays
+             fromIndexPaths:(NSArray *)fromIndexPaths
+               toIndexPaths:(NSArray *)toIndexPaths;
+// Applies a permutation, like the one passed to exchangeController:didMoveItemsAtIndexPaths:toIndexPaths:.
+// The object at fromIndexPaths[i] moves to toIndexPaths[i]. All the moves happen at once so a cycle
+// like 0,1 -> 0,2 -> 0,3 -> 0,1 needs no temporary. arrays maps sections to arrays, as above.
+//
+// Returns NO, leaving all the arrays untouched, if any argument is nil, the two index path arrays
+// differ in length, any index path names a section or item that does not exist, or the moves aren't
+// a permutation: toIndexPaths must hold the same index paths as fromIndexPaths, each only once.
+// Also returns NO if a section moved from or to shares its array with an earlier section. Returns
+// YES otherwise.
+
 @end
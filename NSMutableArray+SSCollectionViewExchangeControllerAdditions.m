@@ -53,4 +53,186 @@
     }
 }
 
++ (BOOL)exchangeObjectsInArrays:(NSArray *)arrays
+                      withSwaps:(const SSExchangeSwap *)swaps
+                          count:(NSUInteger)count {
+
+    if (arrays == nil) return NO;
+    if (count == 0) return YES;
+    if (swaps == NULL) return NO;
+
+    NSUInteger numberOfSections = arrays.count;
+
+    // For each section: the number of objects in its array (NSNotFound until the section is first
+    // seen) and the range of indices touched by the batch. Each array is asked for its class and
+    // count once, no matter how many swaps refer to it, and is checked once for being used by an
+    // earlier section too. Two touched sections sharing an array would each write back a stale
+    // copy of its range, losing objects.
+    NSUInteger *counts = malloc(numberOfSections * sizeof(NSUInteger));
+    NSRange *touchedRanges = calloc(numberOfSections, sizeof(NSRange));
+    NSUInteger *offsets = malloc(numberOfSections * sizeof(NSUInteger));
+
+    if (numberOfSections > 0 && (counts == NULL || touchedRanges == NULL || offsets == NULL)) {
+        free(counts); free(touchedRanges); free(offsets);
+        return NO;
+    }
+
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        counts[section] = NSNotFound;
+    }
+
+
+    // Validate everything first...
+    BOOL valid = YES;
+
+    for (NSUInteger i = 0; i < count * 2; i++) {
+
+        SSExchangeIndexPath indexPath = (i % 2 == 0)? swaps[i / 2].indexPath1 : swaps[i / 2].indexPath2;
+
+        if (SSExchangeIndexPathIsNone(indexPath) || (NSUInteger)indexPath.section >= numberOfSections) {
+            valid = NO;
+            break;
+        }
+
+        NSUInteger section = indexPath.section;
+        NSUInteger item = indexPath.item;
+
+        if (counts[section] == NSNotFound) {
+            NSMutableArray *array = arrays[ section ];
+            if ([arrays indexOfObjectIdenticalTo:array] != section) {
+                valid = NO;
+                break;
+            }
+            counts[section] = ([array isKindOfClass:[NSMutableArray class]])? array.count : 0;
+        }
+
+        if (item >= counts[section]) {
+            valid = NO;
+            break;
+        }
+
+        NSRange range = touchedRanges[section];
+        if (range.length == 0) {
+            touchedRanges[section] = NSMakeRange(item, 1);
+        } else if (item < range.location) {
+            touchedRanges[section] = NSMakeRange(item, NSMaxRange(range) - item);
+        } else if (item >= NSMaxRange(range)) {
+            touchedRanges[section] = NSMakeRange(range.location, item - range.location + 1);
+        }
+    }
+
+    if (valid == NO) {
+        free(counts); free(touchedRanges); free(offsets);
+        return NO;
+    }
+
+
+    // Then copy the touched range of each array into one buffer...
+    NSUInteger bufferLength = 0;
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        offsets[section] = bufferLength;
+        bufferLength += touchedRanges[section].length;
+    }
+
+    __unsafe_unretained id *buffer = (__unsafe_unretained id *)calloc(bufferLength, sizeof(id));
+    if (buffer == NULL) {
+        free(counts); free(touchedRanges); free(offsets);
+        return NO;
+    }
+
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        if (touchedRanges[section].length > 0) {
+            [arrays[ section ] getObjects:buffer + offsets[section] range:touchedRanges[section]];
+        }
+    }
+
+
+    // Exchange the objects in the buffer. No messages are sent here...
+    for (NSUInteger i = 0; i < count; i++) {
+
+        SSExchangeIndexPath indexPath1 = swaps[i].indexPath1;
+        SSExchangeIndexPath indexPath2 = swaps[i].indexPath2;
+
+        NSUInteger position1 = offsets[indexPath1.section] + indexPath1.item - touchedRanges[indexPath1.section].location;
+        NSUInteger position2 = offsets[indexPath2.section] + indexPath2.item - touchedRanges[indexPath2.section].location;
+
+        __unsafe_unretained id object = buffer[position1];
+        buffer[position1] = buffer[position2];
+        buffer[position2] = object;
+    }
+
+
+    // And write each touched range back. The replacements are all created before any array is
+    // modified so that objects moving between arrays are retained throughout.
+    NSMutableArray *replacements = [[NSMutableArray alloc] init];
+
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        if (touchedRanges[section].length > 0) {
+            [replacements addObject:[NSArray arrayWithObjects:buffer + offsets[section] count:touchedRanges[section].length]];
+        }
+    }
+
+    NSUInteger replacementIndex = 0;
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        if (touchedRanges[section].length > 0) {
+            [arrays[ section ] replaceObjectsInRange:touchedRanges[section]
+                                withObjectsFromArray:replacements[ replacementIndex++ ]];
+        }
+    }
+
+    free(buffer);
+    free(counts);
+    free(touchedRanges);
+    free(offsets);
+
+    return YES;
+}
+
++ (BOOL)moveObjectsInArrays:(NSArray *)arrays
+             fromIndexPaths:(NSArray *)fromIndexPaths
+               toIndexPaths:(NSArray *)toIndexPaths {
+    
+    if (arrays == nil || fromIndexPaths == nil || toIndexPaths == nil) return NO;
+    if (fromIndexPaths.count != toIndexPaths.count) return NO;
+    
+    NSUInteger count = fromIndexPaths.count;
+    
+    // Validate everything first. The moves must be a permutation: the index paths moved to are the
+    // ones moved from, with none named twice, or objects would be duplicated and others lost...
+    NSMutableSet *movedFrom = [NSMutableSet setWithCapacity:count];
+    NSMutableSet *movedTo = [NSMutableSet setWithCapacity:count];
+    
+    for (NSUInteger i = 0; i < count * 2; i++) {
+        
+        SSExchangeIndexPath indexPath = SSExchangeIndexPathFromNSIndexPath((i < count)? fromIndexPaths[ i ] : toIndexPaths[ i - count ]);
+        
+        if (SSExchangeIndexPathIsNone(indexPath) || (NSUInteger)indexPath.section >= arrays.count) return NO;
+        
+        NSMutableArray *array = arrays[ indexPath.section ];
+        if ([array isKindOfClass:[NSMutableArray class]] == NO || (NSUInteger)indexPath.item >= array.count) return NO;
+        if ([arrays indexOfObjectIdenticalTo:array] != (NSUInteger)indexPath.section) return NO;
+        
+        NSMutableSet *indexPaths = (i < count)? movedFrom : movedTo;
+        NSNumber *packedIndexPath = @(SSExchangeIndexPathPack(indexPath));
+        if ([indexPaths containsObject:packedIndexPath]) return NO;
+        [indexPaths addObject:packedIndexPath];
+    }
+    
+    if ([movedFrom isEqualToSet:movedTo] == NO) return NO;
+    
+    // Then pick up every object that moves before putting any of them down...
+    NSMutableArray *objects = [NSMutableArray arrayWithCapacity:count];
+    for (NSIndexPath *fromIndexPath in fromIndexPaths) {
+        SSExchangeIndexPath indexPath = SSExchangeIndexPathFromNSIndexPath(fromIndexPath);
+        [objects addObject:arrays[ indexPath.section ][ indexPath.item ]];
+    }
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        SSExchangeIndexPath indexPath = SSExchangeIndexPathFromNSIndexPath(toIndexPaths[ i ]);
+        [arrays[ indexPath.section ] replaceObjectAtIndex:indexPath.item withObject:objects[ i ]];
+    }
+    
+    return YES;
+}
+
 @end
@@ -0,0 +1,62 @@
+//
+//  NSMutableData+SSCollectionViewExchangeControllerAdditions.h
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#import <Foundation/Foundation.h>
+#import "SSCollectionViewExchangeTypes.h"
+#import "SSCollectionViewExchangeValueKernels.h"
+
+@interface NSMutableData (SSCollectionViewExchangeControllerAdditions)
+
+// The counterparts of the NSMutableArray category's batch methods for models of plain numbers.
+// Each section is an NSMutableData holding packed values of one SSExchangeValueType, so its number
+// of values is its length divided by SSExchangeValueTypeSize(). The work is done by the kernels in
+// SSCollectionViewExchangeValueKernels.h. No objects are created and nothing is retained or released.
+
++ (BOOL)exchangeValuesOfType:(SSExchangeValueType)type
+                     inDatas:(NSArray *)datas
+                   withSwaps:(const SSExchangeSwap *)swaps
+                       count:(NSUInteger)count
+                        sums:(SSExchangeValueSum *)sums;
+// Like exchangeObjectsInArrays:withSwaps:count:. datas maps sections to datas: the data for
+// section n is datas[n] and it must be an NSMutableData that is not used for any other section.
+// sums, which can be NULL, has the sum of each section and is kept up to date. Returns NO, leaving
+// all the datas untouched, if datas is nil, a data's length isn't a whole number of values, or any
+// index path names a section or value that does not exist. Returns YES otherwise.
+
++ (BOOL)moveValuesOfType:(SSExchangeValueType)type
+                 inDatas:(NSArray *)datas
+          fromIndexPaths:(NSArray *)fromIndexPaths
+            toIndexPaths:(NSArray *)toIndexPaths
+                    sums:(SSExchangeValueSum *)sums;
+// Like moveObjectsInArrays:fromIndexPaths:toIndexPaths:. Otherwise as above.
+
+- (BOOL)permuteValuesOfType:(SSExchangeValueType)type withSourceIndices:(const uint32_t *)sourceIndices;
+// Refer to SSExchangeValuesPermute(). There must be a source index for every value.
+
+- (SSExchangeValueSum)sumOfValuesOfType:(SSExchangeValueType)type;
+
+@end
@@ -0,0 +1,113 @@
+//
+//  NSMutableData+SSCollectionViewExchangeControllerAdditions.m
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#import "NSMutableData+SSCollectionViewExchangeControllerAdditions.h"
+
+
+@implementation NSMutableData (SSCollectionViewExchangeControllerAdditions)
+
++ (BOOL)getSections:(void **)sections
+    numbersOfValues:(size_t *)numbersOfValues
+          fromDatas:(NSArray *)datas
+             ofType:(SSExchangeValueType)type {
+
+    size_t size = SSExchangeValueTypeSize(type);
+    if (size == 0) return NO;
+
+    for (NSUInteger section = 0; section < datas.count; section++) {
+
+        NSMutableData *data = datas[ section ];
+        if ([data isKindOfClass:[NSMutableData class]] == NO || data.length % size != 0) return NO;
+
+        sections[section] = data.mutableBytes;
+        numbersOfValues[section] = data.length / size;
+    }
+    return YES;
+}
+
++ (BOOL)exchangeValuesOfType:(SSExchangeValueType)type
+                     inDatas:(NSArray *)datas
+                   withSwaps:(const SSExchangeSwap *)swaps
+                       count:(NSUInteger)count
+                        sums:(SSExchangeValueSum *)sums {
+
+    if (datas == nil) return NO;
+    if (count == 0) return YES;
+
+    NSUInteger numberOfSections = datas.count;
+    void *sections[MAX(numberOfSections, 1)];
+    size_t numbersOfValues[MAX(numberOfSections, 1)];
+
+    if ([self getSections:sections numbersOfValues:numbersOfValues fromDatas:datas ofType:type] == NO) return NO;
+
+    return SSExchangeValuesExchange(type, sections, numbersOfValues, numberOfSections, swaps, count, sums);
+}
+
++ (BOOL)moveValuesOfType:(SSExchangeValueType)type
+                 inDatas:(NSArray *)datas
+          fromIndexPaths:(NSArray *)fromIndexPaths
+            toIndexPaths:(NSArray *)toIndexPaths
+                    sums:(SSExchangeValueSum *)sums {
+
+    if (datas == nil || fromIndexPaths == nil || toIndexPaths == nil) return NO;
+    if (fromIndexPaths.count != toIndexPaths.count) return NO;
+
+    NSUInteger numberOfSections = datas.count;
+    void *sections[MAX(numberOfSections, 1)];
+    size_t numbersOfValues[MAX(numberOfSections, 1)];
+
+    if ([self getSections:sections numbersOfValues:numbersOfValues fromDatas:datas ofType:type] == NO) return NO;
+
+    NSUInteger count = fromIndexPaths.count;
+    SSExchangeMove *moves = malloc(MAX(count, 1) * sizeof(SSExchangeMove));
+    if (moves == NULL) return NO;
+
+    for (NSUInteger i = 0; i < count; i++) {
+        moves[i].fromIndexPath = SSExchangeIndexPathFromNSIndexPath(fromIndexPaths[ i ]);
+        moves[i].toIndexPath = SSExchangeIndexPathFromNSIndexPath(toIndexPaths[ i ]);
+    }
+
+    BOOL moved = SSExchangeValuesMove(type, sections, numbersOfValues, numberOfSections, moves, count, sums);
+    free(moves);
+    return moved;
+}
+
+- (BOOL)permuteValuesOfType:(SSExchangeValueType)type withSourceIndices:(const uint32_t *)sourceIndices {
+
+    size_t size = SSExchangeValueTypeSize(type);
+    if (size == 0 || self.length % size != 0) return NO;
+
+    return SSExchangeValuesPermute(type, self.mutableBytes, self.length / size, sourceIndices);
+}
+
+- (SSExchangeValueSum)sumOfValuesOfType:(SSExchangeValueType)type {
+
+    size_t size = SSExchangeValueTypeSize(type);
+    return SSExchangeValuesSum(type, self.bytes, (size > 0)? self.length / size : 0);
+}
+
+@end
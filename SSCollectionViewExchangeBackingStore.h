@@ -0,0 +1,77 @@
+//
+//  SSCollectionViewExchangeBackingStore.h
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#import <Foundation/Foundation.h>
+#import "SSCollectionViewExchangeCore.h"
+
+
+// SSCollectionViewExchangeBackingStore is what a model needs to provide so exchanges, and the
+// moves passed to exchangeController:didMoveItemsAtIndexPaths:toIndexPaths:, can be applied to
+// it without knowing how it is stored. Sections map to whatever storage the model has: arrays,
+// one contiguous C buffer, or a memory-mapped file.
+//
+// Three implementations are provided:
+//
+//  SSCollectionViewExchangeArrayStore          adapts an array of NSMutableArrays, one per section
+//  SSCollectionViewExchangeInt64Store          holds unboxed int64_t values, or object IDs, in one
+//                                              buffer and keeps a running sum for each section
+//  SSCollectionViewExchangeMappedInt64Store    the same but in a memory-mapped file
+//
+// Only Foundation is used.
+
+
+@protocol SSCollectionViewExchangeBackingStore <NSObject>
+
+- (NSUInteger)numberOfSections;
+- (NSUInteger)numberOfItemsInSection:(NSUInteger)section;
+
+- (BOOL)exchangeItemsWithSwaps:(const SSExchangeSwap *)swaps count:(NSUInteger)count;
+// Applies count exchanges, in order. Every swap is validated before any is applied. Returns NO,
+// leaving the store untouched, if swaps is NULL (and count is not 0) or any index path names a
+// section or item that does not exist. Returns YES otherwise.
+
+- (BOOL)moveItemsWithMoves:(const SSExchangeMove *)moves count:(NSUInteger)count;
+// Applies a permutation: the item at moves[i].fromIndexPath moves to moves[i].toIndexPath. All
+// the moves happen at once, like those produced by SSExchangeComposeSwaps(). Validated the same
+// way as above, and also returns NO, leaving the store untouched, if the moves aren't a
+// permutation: an index path named twice as a fromIndexPath or as a toIndexPath, or a
+// toIndexPath that isn't also a fromIndexPath.
+
+@end
+
+
+
+@interface SSCollectionViewExchangeArrayStore : NSObject <SSCollectionViewExchangeBackingStore>
+
+- (id)initWithArrays:(NSArray *)arrays;
+// arrays maps sections to arrays: the array for section n is arrays[n] and it must be an
+// NSMutableArray that is not used for any other section. The arrays are changed in place using
+// the NSMutableArray category.
+
+@property (strong, nonatomic, readonly) NSArray *arrays;
+
+@end
@@ -0,0 +1,88 @@
+//
+//  SSCollectionViewExchangeBackingStore.m
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#import "SSCollectionViewExchangeBackingStore.h"
+#import "NSMutableArray+SSCollectionViewExchangeControllerAdditions.h"
+
+
+@interface SSCollectionViewExchangeArrayStore ()
+
+@property (strong, nonatomic, readwrite) NSArray *arrays;
+
+@end
+
+
+
+@implementation SSCollectionViewExchangeArrayStore
+
+- (id)initWithArrays:(NSArray *)arrays {
+
+    self = [super init];
+    if (self) {
+
+        _arrays = [arrays copy];
+    }
+    return self;
+}
+
+- (NSUInteger)numberOfSections {
+
+    return self.arrays.count;
+}
+
+- (NSUInteger)numberOfItemsInSection:(NSUInteger)section {
+
+    return (section < self.arrays.count)? [self.arrays[section] count] : 0;
+}
+
+- (BOOL)exchangeItemsWithSwaps:(const SSExchangeSwap *)swaps count:(NSUInteger)count {
+
+    return [NSMutableArray exchangeObjectsInArrays:self.arrays withSwaps:swaps count:count];
+}
+
+- (BOOL)moveItemsWithMoves:(const SSExchangeMove *)moves count:(NSUInteger)count {
+
+    if (count == 0) return YES;
+    if (moves == NULL) return NO;
+
+    NSMutableArray *fromIndexPaths = [NSMutableArray arrayWithCapacity:count];
+    NSMutableArray *toIndexPaths = [NSMutableArray arrayWithCapacity:count];
+
+    for (NSUInteger i = 0; i < count; i++) {
+
+        NSIndexPath *fromIndexPath = NSIndexPathFromSSExchangeIndexPath(moves[i].fromIndexPath);
+        NSIndexPath *toIndexPath = NSIndexPathFromSSExchangeIndexPath(moves[i].toIndexPath);
+        if (fromIndexPath == nil || toIndexPath == nil) return NO;
+
+        [fromIndexPaths addObject:fromIndexPath];
+        [toIndexPaths addObject:toIndexPath];
+    }
+
+    return [NSMutableArray moveObjectsInArrays:self.arrays fromIndexPaths:fromIndexPaths toIndexPaths:toIndexPaths];
+}
+
+@end
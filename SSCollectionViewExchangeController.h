@@ -31,6 +31,7 @@
 typedef void (^PostReleaseCompletionBlock) (NSTimeInterval animationDuration);
 
 @class SSCollectionViewExchangeController;
+@protocol SSCollectionViewExchangeInstrumentationSink;
 
 @protocol SSCollectionViewExchangeControllerDelegate <NSObject>
 
@@ -58,11 +59,25 @@ typedef void (^PostReleaseCompletionBlock) (NSTimeInterval animationDuration);
                                   withItemAtIndexPath:(NSIndexPath *)indexPath;
 
 
+- (NSArray *)          exchangeController:(SSCollectionViewExchangeController *)exchangeController
+    indexPathsForGroupWithItemAtIndexPath:(NSIndexPath *)indexPath;
+
+
+- (void)exchangeControllerDidFinishGroupExchangeTransaction:(SSCollectionViewExchangeController *)exchangeController
+                                            withIndexPaths1:(NSArray *)indexPaths1
+                                                indexPaths2:(NSArray *)indexPaths2;
+
+
 - (BOOL)          exchangeController:(SSCollectionViewExchangeController *)exchangeController
           canDisplaceItemAtIndexPath:(NSIndexPath *)indexPathOfItemToDisplace
    withItemBeingDraggedFromIndexPath:(NSIndexPath *)indexPathOfItemBeingDragged;
 
 
+- (NSIndexSet *)                    exchangeController:(SSCollectionViewExchangeController *)exchangeController
+   indexesOfItemsThatCanBeDisplacedAtIndexPaths:(NSArray *)indexPathsOfItemsToDisplace
+              withItemBeingDraggedFromIndexPath:(NSIndexPath *)indexPathOfItemBeingDragged;
+
+
 - (UIView *)           exchangeController:(SSCollectionViewExchangeController *)exchangeController
   viewForCatchRectangleForItemAtIndexPath:(NSIndexPath *)indexPath;
 
@@ -71,6 +86,15 @@ typedef void (^PostReleaseCompletionBlock) (NSTimeInterval animationDuration);
                snapshotForCell:(UICollectionViewCell *)cell;
 
 
+- (NSUInteger)      exchangeController:(SSCollectionViewExchangeController *)exchangeController
+      contentVersionForItemAtIndexPath:(NSIndexPath *)indexPath;
+
+
+- (void) exchangeController:(SSCollectionViewExchangeController *)exchangeController
+   didMoveItemsAtIndexPaths:(NSArray *)fromIndexPaths
+               toIndexPaths:(NSArray *)toIndexPaths;
+
+
 
 - (void)animateCatchForExchangeController:(SSCollectionViewExchangeController *)exchangeController
                              withSnapshot:(UIView *)snapshot;
@@ -91,6 +115,13 @@ typedef void (^PostReleaseCompletionBlock) (NSTimeInterval animationDuration);
 
 - (UICollectionViewFlowLayout *)layout;
 
+- (void)prerenderSnapshotsForVisibleItems;
+
+- (void)invalidateDisplacementPermissions;
+- (void)invalidateDisplacementPermissionForItemAtIndexPath:(NSIndexPath *)indexPath;
+
+- (NSIndexPath *)indexPathInModelForItemAtIndexPath:(NSIndexPath *)indexPath;
+
 
 @property (weak, nonatomic, readonly)   UILongPressGestureRecognizer    *longPressGestureRecognizer;
 
@@ -106,4 +137,17 @@ typedef void (^PostReleaseCompletionBlock) (NSTimeInterval animationDuration);
 
 @property (nonatomic)                   double                          animationBacklogDelay;
 
+@property (nonatomic)                   BOOL                            autoScrollEnabled;
+@property (nonatomic)                   CGFloat                         autoScrollEdgeInset;
+@property (nonatomic)                   CGFloat                         autoScrollMaximumSpeed;
+
+@property (strong, nonatomic)           id<SSCollectionViewExchangeInstrumentationSink> instrumentation;
+
+@property (strong, nonatomic)           dispatch_queue_t                commitQueue;
+// Default nil. Must be a serial queue: on a concurrent queue the swaps could reach the model out
+// of order, or at the same time, and a global queue ignores the barriers that end transactions.
+// Never the main queue. Once it is set, didExchangeItemAtIndexPath1:withItemAtIndexPath2:,
+// didMoveItemsAtIndexPaths:toIndexPaths: and exchangeControllerDidFinishExchangeEvent: are called
+// on it, off the main thread. Refer to the README.
+
 @end
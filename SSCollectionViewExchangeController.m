@@ -26,21 +26,67 @@
 
 
 #import "SSCollectionViewExchangeController.h"
+#import <QuartzCore/QuartzCore.h>
 #import "SSCollectionViewExchangeLayout.h"
+#import "SSCollectionViewExchangeCoordinator.h"
+#import "SSCollectionViewExchangeCore.h"
+#import "SSCollectionViewExchangeGroupCore.h"
+#import "SSCollectionViewExchangeIndexPathSet.h"
+#import "SSCollectionViewExchangeShadowPermutation.h"
+#import "SSCollectionViewExchangeSnapshotCache.h"
+#import "SSCollectionViewExchangeInstrumentation.h"
 #import "UIView+SSCollectionViewExchangeControllerAdditions.h"
 
 
-typedef NS_ENUM(NSInteger, ExchangeEventType) {
-    ExchangeEventTypeDraggedFromStartingItem,
-    ExchangeEventTypeDraggedToOtherItem,
-    ExchangeEventTypeDraggedToStartingItem,
-    ExchangeEventTypeNothingToExchange,
-    ExchangeEventTypeCannotDisplaceItem
-};
 
+// The parts of the coordinator the exchange controller works with. They are implemented in
+// SSCollectionViewExchangeCoordinator.m.
+@interface SSCollectionViewExchangeCoordinator (SSCollectionViewExchangeController)
 
+- (BOOL)exchangeControllerDidDrag:(SSCollectionViewExchangeController *)exchangeController;
+- (BOOL)finishExchangeTransactionForExchangeController:(SSCollectionViewExchangeController *)exchangeController;
+- (BOOL)cancelExchangeTransactionForExchangeController:(SSCollectionViewExchangeController *)exchangeController;
+- (void)exchangeControllerDidFinishRelease:(SSCollectionViewExchangeController *)exchangeController;
+- (BOOL)getItemsToHide:(SSExchangeIndexPathSet *)itemsToHide
+            itemsToDim:(SSExchangeIndexPathSet *)itemsToDim
+ forExchangeController:(SSCollectionViewExchangeController *)exchangeController;
 
-@interface SSCollectionViewExchangeController () <SSCollectionViewExchangeLayoutDelegate>
+@end
+
+
+
+@interface SSCollectionViewExchangeController () <SSCollectionViewExchangeLayoutDelegate> {
+
+    // The exchange transaction state machine: the original index paths for the dragged and displaced
+    // items, the current index path, and whether a prior exchange must be undone. This class adapts it
+    // to UIKit. Refer to SSCollectionViewExchangeCore.h.
+    SSExchangeCore _exchangeCore;
+    
+    // Used instead of _exchangeCore when the delegate gives a group of items to drag together.
+    // Its numberOfItems is 0 except during a group exchange transaction and its release. Refer to
+    // SSCollectionViewExchangeGroupCore.h.
+    SSExchangeGroupCore _groupExchangeCore;
+    
+    // The delegate's answers to canDisplaceItemAtIndexPath: during this exchange transaction, so it
+    // is asked only once for each item however often the user drags over it. An index path is in
+    // _displacementPermissionsChecked once the answer is known, and also in
+    // _displacementPermissionsAllowed if the answer was YES. For a group the answer for the whole
+    // group is kept by the first of the items it would displace. Refer to the Displacement
+    // permissions section.
+    SSExchangeIndexPathSet *_displacementPermissionsChecked;
+    SSExchangeIndexPathSet *_displacementPermissionsAllowed;
+    
+    // The exchanges the delegate's model and the collection view reflect, which can lag behind the
+    // exchange core's while a batch update is animating. The layout hides and dims according to
+    // these. Refer to the Coalescing exchange events section.
+    SSExchangeSwap _committedExchanges[SSExchangeGroupMaximumNumberOfItems];
+    unsigned int _numberOfCommittedExchanges;
+    
+    // The swaps the collection view shows but the delegate's model doesn't have yet because they
+    // are still waiting on the commit queue. Only used under @synchronized (self). Refer to the
+    // Committing on the commit queue section.
+    SSExchangeShadowPermutation *_shadowPermutation;
+}
 
 @property (weak, nonatomic)             id<SSCollectionViewExchangeControllerDelegate> delegate;            // the delegate, which must conform to the SSCollectionViewExchangeControllerDelegate protocol
 
@@ -50,20 +96,31 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
 @property (nonatomic)                   CGPoint                         locationInCollectionView;           // the last known location of the long press
 
 @property (strong, nonatomic)           UIView                          *snapshot;                          // this is the view that follows the user's finger during the long press
+@property (nonatomic)                   BOOL                            snapshotIsFromPool;                 // YES if snapshot came from snapshotCache and should go back to its pool when done
+@property (strong, nonatomic)           NSArray                         *snapshotParts;                     // for a group, the snapshot of each item in the group within snapshot, or NSNull for items that weren't on screen
+@property (strong, nonatomic)           NSMutableArray                  *snapshotPartsFromPool;             // the snapshot parts that should go back to the pool when done
+@property (strong, nonatomic)           SSCollectionViewExchangeSnapshotCache *snapshotCache;               // rendered images of items and reusable snapshot views, refer to SSCollectionViewExchangeSnapshotCache.h
+@property (strong, nonatomic)           NSMutableArray                  *indexPathsToPrerender;             // refer to prerenderSnapshotsForVisibleItems
+@property (nonatomic)                   BOOL                            prerenderingIsScheduled;            // ditto
 @property (nonatomic)                   CGPoint                         offsetToCenterOfSnapshot;           // for the snapshot, this is the offset from the location of the long press to its center
 
-@property (strong, nonatomic)           NSIndexPath                     *originalIndexPathForDraggedItem;   // the index path where the exchange transaction began
-@property (strong, nonatomic)           NSIndexPath                     *originalIndexPathForDisplacedItem; // the original index path for the item most recently displaced item
-@property (strong, nonatomic)           NSIndexPath                     *currentIndexPath;                  // the index path for the item under locationInCollectionView
+@property (strong, nonatomic)           NSIndexPath                     *indexPathForDimmedItem;            // the original index path for the dragged item as an NSIndexPath, for the release animation and the delegate
 
-@property (nonatomic, assign)           BOOL                            mustUndoPriorExchange;              // for each exchange, tells the exchange controller if a prior exchange must be undone first
 @property (nonatomic, assign)           BOOL                            longPressWasManuallyCancelled;      // in some cases the exchange controller needs to cancel the gesture recognizer, this flag distinguishes those cases from cases where the system cancels the recognizer
 @property (nonatomic, assign, readwrite) BOOL                           exchangeTransactionInProgress;      // exposed as readonly in the header to allow the delegate to determine if an exchange transaction is in progress
 
 @property (nonatomic, copy)             PostReleaseCompletionBlock      postReleaseCompletionBlock;         // refer to the comments in the header file
 
-@property (strong, nonatomic)           NSIndexPath                     *indexPathForItemLastChecked;       // refer to the comments in delegateAllowsDisplacingItemAtIndexPath:withItemFromIndexPath:
-@property (nonatomic, assign)           BOOL                            resultForItemLastChecked;           // ditto
+@property (strong, nonatomic)           CADisplayLink                   *autoScrollDisplayLink;             // runs only while the finger is in an edge zone and the collection view can scroll that way
+@property (nonatomic)                   CFTimeInterval                  timestampOfLastAutoScroll;          // 0 until the display link's first tick
+
+@property (nonatomic)                   uint64_t                        startTimeOfReleaseAnimation;        // for instrumentation, 0 when the release animation isn't being timed
+
+@property (weak, nonatomic)             SSCollectionViewExchangeCoordinator *coordinator;                   // set by the coordinator this exchange controller was added to, if any
+
+@property (nonatomic)                   BOOL                            batchUpdateIsInFlight;              // YES from the start of a batch update until its animations complete, refer to the Coalescing exchange events section
+
+@property (strong, nonatomic)           dispatch_queue_t                retiringCommitQueue;                // after commitQueue is set to nil, the old queue, used until it has caught up, refer to setCommitQueue:
 
 
 // At the end of the exchange transation the snapshot is animated to the center of the cell
@@ -72,9 +129,40 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
 // the end of each exchange event just before the layout hides the item.
 @property (nonatomic)                   CGPoint                         centerOfHiddenCell;
 
+- (BOOL)delegateAllowsDisplacingItemAtIndexPath:(SSExchangeIndexPath)indexPathForItemToDisplace
+                          withItemFromIndexPath:(SSExchangeIndexPath)indexPathOfItemBeingDragged;
+
+- (BOOL)delegateAllowsDisplacingItemsAtIndexPaths:(const SSExchangeIndexPath *)indexPathsForItemsToDisplace
+                         withItemsFromIndexPaths:(const SSExchangeIndexPath *)indexPathsOfItemsBeingDragged
+                                           count:(unsigned int)numberOfItems;
+
 @end
 
 
+// Called by the exchange core, through SSExchangeCoreEventType(), to ask if an item can be displaced.
+static bool SSExchangeControllerCanDisplace(SSExchangeIndexPath indexPathOfItemToDisplace,
+                                            SSExchangeIndexPath indexPathOfItemBeingDragged,
+                                            void *context) {
+
+    SSCollectionViewExchangeController *exchangeController = (__bridge SSCollectionViewExchangeController *)context;
+    return [exchangeController delegateAllowsDisplacingItemAtIndexPath:indexPathOfItemToDisplace
+                                                 withItemFromIndexPath:indexPathOfItemBeingDragged];
+}
+
+// Ditto, through SSExchangeGroupCoreEventType(), for a group.
+static bool SSExchangeControllerCanDisplaceGroup(const SSExchangeIndexPath *indexPathsOfItemsToDisplace,
+                                                 const SSExchangeIndexPath *indexPathsOfItemsBeingDragged,
+                                                 unsigned int numberOfItems,
+                                                 void *context) {
+    
+    SSCollectionViewExchangeController *exchangeController = (__bridge SSCollectionViewExchangeController *)context;
+    return [exchangeController delegateAllowsDisplacingItemsAtIndexPaths:indexPathsOfItemsToDisplace
+                                                  withItemsFromIndexPaths:indexPathsOfItemsBeingDragged
+                                                                    count:numberOfItems];
+}
+
+
+
 @implementation SSCollectionViewExchangeController
 
 - (id)initWithDelegate:(id<SSCollectionViewExchangeControllerDelegate>)delegate
@@ -92,6 +180,14 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
         _snapshotAlpha =                0.80;
         _snapshotBackgroundColor =      [UIColor darkGrayColor];
         _longPressWasManuallyCancelled = NO;
+        _snapshotCache =                [SSCollectionViewExchangeSnapshotCache new];
+        _snapshotPartsFromPool =        [NSMutableArray array];
+        _autoScrollEnabled =            NO;
+        _autoScrollEdgeInset =          60.0;
+        _autoScrollMaximumSpeed =       1200.0;
+        SSExchangeCoreReset(&_exchangeCore);
+        SSExchangeGroupCoreReset(&_groupExchangeCore);
+        _shadowPermutation =            SSExchangeShadowPermutationCreate();
         
         
         UILongPressGestureRecognizer *longPress = [[UILongPressGestureRecognizer alloc] initWithTarget:self action:@selector(longPress)];
@@ -108,6 +204,13 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
     return self;
 }
 
+- (void)dealloc {
+    
+    SSExchangeIndexPathSetFree(_displacementPermissionsChecked);
+    SSExchangeIndexPathSetFree(_displacementPermissionsAllowed);
+    SSExchangeShadowPermutationFree(_shadowPermutation);
+}
+
 
 
 //-------------------------
@@ -118,6 +221,81 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
     return (UICollectionViewFlowLayout *)self.collectionView.collectionViewLayout;
 }
 
+- (void)setSnapshotAlpha:(CGFloat)snapshotAlpha {
+    
+    // Cached snapshots were rendered with the old value.
+    _snapshotAlpha = snapshotAlpha;
+    [self.snapshotCache removeAllImages];
+}
+
+- (void)setSnapshotBackgroundColor:(UIColor *)snapshotBackgroundColor {
+    
+    // Ditto.
+    _snapshotBackgroundColor = snapshotBackgroundColor;
+    [self.snapshotCache removeAllImages];
+}
+
+- (void)setInstrumentation:(id<SSCollectionViewExchangeInstrumentationSink>)instrumentation {
+    
+    // Layout passes are timed by the layout itself.
+    _instrumentation = instrumentation;
+    
+    SSCollectionViewExchangeLayout *layout = (SSCollectionViewExchangeLayout *)self.collectionView.collectionViewLayout;
+    if ([layout isKindOfClass:[SSCollectionViewExchangeLayout class]]) {
+        layout.instrumentation = instrumentation;
+    }
+}
+
+- (void)setCommitQueue:(dispatch_queue_t)commitQueue {
+    
+    // The main queue would only put the delegate's work back on the main thread, after the batch
+    // update instead of in it, so it's the same as no commit queue.
+    NSAssert(commitQueue != dispatch_get_main_queue(), @"commitQueue must not be the main queue");
+    if (commitQueue == dispatch_get_main_queue()) commitQueue = nil;
+    
+    dispatch_queue_t oldQueue = [self queueForCommits];
+    _commitQueue = commitQueue;
+    if (oldQueue == nil || oldQueue == commitQueue) {
+        self.retiringCommitQueue = nil;
+        return;
+    }
+    
+    // Swaps already on the old queue must reach the model before any after them. Waiting for the
+    // old queue could deadlock if it is waiting on the main thread, so instead a new queue is held
+    // until the old one gets to here, and without one the old queue is used until it catches up.
+    if (commitQueue) {
+        self.retiringCommitQueue = nil;
+        dispatch_suspend(commitQueue);
+        dispatch_barrier_async(oldQueue, ^{
+            dispatch_resume(commitQueue);
+        });
+    } else {
+        self.retiringCommitQueue = oldQueue;
+        [self retireCommitQueueOnceCaughtUp:oldQueue];
+    }
+}
+
+- (void)retireCommitQueueOnceCaughtUp:(dispatch_queue_t)queue {
+    
+    dispatch_barrier_async(queue, ^{
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (self.retiringCommitQueue != queue) return;
+            
+            // More swaps may have been queued behind the barrier. Once none are pending the model
+            // is changed on the main thread again.
+            unsigned int numberOfPendingSwaps;
+            @synchronized (self) {
+                numberOfPendingSwaps = SSExchangeShadowPermutationNumberOfPendingSwaps(self->_shadowPermutation);
+            }
+            if (numberOfPendingSwaps == 0) {
+                self.retiringCommitQueue = nil;
+            } else {
+                [self retireCommitQueueOnceCaughtUp:queue];
+            }
+        });
+    });
+}
+
 
 
 //-------------------------------------------------------------------------------
@@ -133,7 +311,9 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
             
         case UIGestureRecognizerStateChanged:
             [self updateSnapshotLocation];
+            if ([self.coordinator exchangeControllerDidDrag:self]) break;   // the coordinator has taken the exchange transaction over
             [self performExchangeEventType];
+            [self updateAutoScroll];
             break;
             
         case UIGestureRecognizerStateEnded:
@@ -156,36 +336,55 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
 
 - (void)beginExchangeTransaction {
     
+    uint64_t startTime = [self beginPhase:SSExchangePhaseCatch];
+    
     CGPoint locationInCollectionView = [self.longPressGestureRecognizer locationInView:self.collectionView];
-    NSIndexPath *startingIndexPath = [self.collectionView indexPathForItemAtPoint:locationInCollectionView];
+    NSIndexPath *startingIndexPath = NSIndexPathFromSSExchangeIndexPath([self indexPathForItemAtPoint:locationInCollectionView]);
     
     if ([self cannotBeginExchangeTransactionWithItemAtIndexPath:startingIndexPath]) {
         [self cancelLongPressRecognizer];
+        [self endPhase:SSExchangePhaseCatch startTime:startTime];
         return;
     }
     
     self.exchangeTransactionInProgress = YES;
-    self.indexPathForItemLastChecked = nil;
+    [self prepareDisplacementPermissions];
+    
+    // A group exchange transaction if the delegate gives a group, otherwise an ordinary one.
+    BOOL isGroupExchangeTransaction = [self beginGroupExchangeTransactionWithItemAtIndexPath:startingIndexPath];
     
     UICollectionViewCell *cell = [self.collectionView cellForItemAtIndexPath:startingIndexPath];
-    UIView *snapshot = [self snapshotForCell:cell];
+    uint64_t startTimeOfSnapshot = [self beginPhase:SSExchangePhaseSnapshot];
+    UIView *snapshot = (isGroupExchangeTransaction)? [self snapshotForGroup] : [self snapshotForCell:cell atIndexPath:startingIndexPath];
+    [self endPhase:SSExchangePhaseSnapshot startTime:startTimeOfSnapshot];
     [self.collectionView addSubview:snapshot];
     
     [self animateCatch:snapshot];
     
-    CGPoint locationInCell = [self.longPressGestureRecognizer locationInView:cell];
-    self.offsetToCenterOfSnapshot = [cell offsetToCenterFromPoint:locationInCell];
+    if (isGroupExchangeTransaction) {
+        self.offsetToCenterOfSnapshot = CGPointMake(locationInCollectionView.x - snapshot.center.x, locationInCollectionView.y - snapshot.center.y);
+    } else {
+        CGPoint locationInCell = [self.longPressGestureRecognizer locationInView:cell];
+        self.offsetToCenterOfSnapshot = [cell offsetToCenterFromPoint:locationInCell];
+    }
     self.snapshot = snapshot;
     self.centerOfHiddenCell = cell.center;
-    self.originalIndexPathForDraggedItem = startingIndexPath;
-    self.originalIndexPathForDisplacedItem = startingIndexPath;
-    self.mustUndoPriorExchange = NO;
     
-    // InvalidateLayout kicks off the process of redrawing the layout.
+    if (isGroupExchangeTransaction == NO) {
+        SSExchangeCoreBegin(&_exchangeCore, SSExchangeIndexPathFromNSIndexPath(startingIndexPath));
+        [self prefetchDisplacementPermissionsForItemBeingDraggedFromIndexPath:startingIndexPath];
+    }
+    _numberOfCommittedExchanges = [self getExchanges:_committedExchanges];
+    [self updateIndexPathsForHidingAndDimming];
+    
+    // Invalidating the layout kicks off the process of redrawing the layout.
     // SSCollectionViewExchangeLayout intervenes in that process by overriding
     // layoutAttributesForElementsInRect: and layoutAttributesForItemAtIndexPath:
-    // to hide and dim collection view items as required.
-    [self.collectionView.collectionViewLayout invalidateLayout];
+    // to hide and dim collection view items as required. Only the starting items
+    // change so only they are invalidated.
+    [self invalidateLayoutForHidingAndDimming];
+    
+    [self endPhase:SSExchangePhaseCatch startTime:startTime];
     
 }
 
@@ -193,135 +392,163 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
     
     self.locationInCollectionView = [self.longPressGestureRecognizer locationInView:self.collectionView];
     CGPoint offsetLocationInCollectionView = CGPointMake(self.locationInCollectionView.x - self.offsetToCenterOfSnapshot.x, self.locationInCollectionView.y - self.offsetToCenterOfSnapshot.y);
-    self.snapshot.center = offsetLocationInCollectionView;
+    
+    // The coordinator, if there is one, may have moved the snapshot into another collection view.
+    UIView *superview = self.snapshot.superview ?: self.collectionView;
+    self.snapshot.center = [self.collectionView convertPoint:offsetLocationInCollectionView toView:superview];
     
 }
 
-- (ExchangeEventType)exchangeEventType {
+- (SSExchangeEventType)exchangeEventType {
     
     // The user is still dragging in the long press. Determine the exchange event type.
+    // The exchange core records the index path under the user's finger as its current index path.
     
-    self.currentIndexPath = [self.collectionView indexPathForItemAtPoint:self.locationInCollectionView];
-    
-    if  ([self isOverSameItemAtIndexPath:self.currentIndexPath] || self.currentIndexPath == nil) {
-        return ExchangeEventTypeNothingToExchange;
+    if ([self isGroupExchangeTransaction]) {
+        return SSExchangeGroupCoreEventType(&_groupExchangeCore,
+                                            [self indexPathForItemAtPoint:self.locationInCollectionView],
+                                            SSExchangeControllerCanDisplaceGroup,
+                                            (__bridge void *)self);
     }
     
-    if ([self delegateAllowsDisplacingItemAtIndexPath:self.currentIndexPath
-                                withItemFromIndexPath:self.originalIndexPathForDraggedItem] == NO) {
-        return ExchangeEventTypeCannotDisplaceItem;
-    }
+    return SSExchangeCoreEventType(&_exchangeCore,
+                                   [self indexPathForItemAtPoint:self.locationInCollectionView],
+                                   SSExchangeControllerCanDisplace,
+                                   (__bridge void *)self);
+}
+
+- (SSExchangeIndexPath)indexPathForItemAtPoint:(CGPoint)point {
     
+    // This runs for every touch sample during the transaction, so ask the layout's grid index
+    // first. UIKit's indexPathForItemAtPoint: is the fallback if the index is unavailable, for
+    // example when the delegate has replaced the layout.
     
-    // Otherwise there is an exchange event to perform. What kind?
+    SSExchangeIndexPath indexPath;
+    SSCollectionViewExchangeLayout *layout = (SSCollectionViewExchangeLayout *)self.collectionView.collectionViewLayout;
     
-    if (self.mustUndoPriorExchange) {
-        
-        return ([self isBackToStartingItemAtIndexPath:self.currentIndexPath])? ExchangeEventTypeDraggedToStartingItem : ExchangeEventTypeDraggedToOtherItem;
-        
-    } else {
-        
-        return ExchangeEventTypeDraggedFromStartingItem;
+    if ([layout isKindOfClass:[SSCollectionViewExchangeLayout class]] && [layout getIndexPath:&indexPath forItemAtPoint:point]) {
+        return indexPath;
     }
+    
+    return SSExchangeIndexPathFromNSIndexPath([self.collectionView indexPathForItemAtPoint:point]);
 }
 
 - (void)performExchangeEventType {
     
-    switch ([self exchangeEventType]) {
-            
-        case ExchangeEventTypeNothingToExchange:
-            break;
-            
-        case ExchangeEventTypeCannotDisplaceItem:
-            break;
+    SSExchangeEventType exchangeEventType = [self exchangeEventType];
+    
+    switch (exchangeEventType) {
             
-        case ExchangeEventTypeDraggedFromStartingItem:
-            [self performExchangeEventTypeDraggedFromStartingItem];
+        case SSExchangeEventTypeNothingToExchange:
             break;
             
-        case ExchangeEventTypeDraggedToOtherItem:
-            [self performExchangeEventTypeDraggedToOtherItem];
+        case SSExchangeEventTypeCannotDisplaceItem:
             break;
             
-        case ExchangeEventTypeDraggedToStartingItem:
-            [self performExchangeEventTypeDraggedToStartingItem];
+        case SSExchangeEventTypeDraggedFromStartingItem:
+        case SSExchangeEventTypeDraggedToOtherItem:
+        case SSExchangeEventTypeDraggedToStartingItem:
+            [self performExchangeEventOfType:exchangeEventType];
             break;
     }
 }
 
-- (void)performExchangeEventTypeDraggedFromStartingItem {
+- (void)performExchangeEventOfType:(SSExchangeEventType)exchangeEventType {
     
-    [self.collectionView performBatchUpdates:^{
-        
-        // Model...
-        [self.delegate exchangeController:self
-              didExchangeItemAtIndexPath1:self.currentIndexPath
-                     withItemAtIndexPath2:self.originalIndexPathForDraggedItem];
-        [self.delegate exchangeControllerDidFinishExchangeEvent:self];
-        
-        // View...
-        [self ensureItemsToMoveAreFrontMost];
-        [self.collectionView moveItemAtIndexPath:self.originalIndexPathForDraggedItem toIndexPath:self.currentIndexPath];
-        [self.collectionView moveItemAtIndexPath:self.currentIndexPath toIndexPath:self.originalIndexPathForDraggedItem];
-        
-        [self setPostExchangeEventStateWithIndexPathForDisplacedItem:self.currentIndexPath undoFlag:YES];
-        
-    } completion:nil];
-}
-
-
-- (void)performExchangeEventTypeDraggedToOtherItem {
+    // The exchange core moves on to its post exchange event state. Its event isn't used here:
+    // the model and the view are brought up to date with the net change since the last commit,
+    // which is the event itself unless a batch update was still animating. Refer to the
+    // Coalescing exchange events section.
     
-    [self.collectionView performBatchUpdates:^{
-        
-        // Model...
-        [self.delegate exchangeController:self
-              didExchangeItemAtIndexPath1:self.originalIndexPathForDraggedItem
-                     withItemAtIndexPath2:self.originalIndexPathForDisplacedItem];
-        [self.delegate exchangeController:self
-              didExchangeItemAtIndexPath1:self.currentIndexPath
-                     withItemAtIndexPath2:self.originalIndexPathForDraggedItem];
-        [self.delegate exchangeControllerDidFinishExchangeEvent:self];
-        
-        // View...
-        [self ensureItemsToMoveAreFrontMost];
-        [self.collectionView moveItemAtIndexPath:self.originalIndexPathForDraggedItem toIndexPath:self.originalIndexPathForDisplacedItem];
-        [self.collectionView moveItemAtIndexPath:self.originalIndexPathForDisplacedItem toIndexPath:self.currentIndexPath];
-        [self.collectionView moveItemAtIndexPath:self.currentIndexPath toIndexPath:self.originalIndexPathForDraggedItem];
-        
-        [self setPostExchangeEventStateWithIndexPathForDisplacedItem:self.currentIndexPath undoFlag:YES];
-        
-    } completion:nil];
+    uint64_t startTime = [self beginPhase:SSExchangePhaseExchangeEvent];
+    
+    if ([self isGroupExchangeTransaction]) {
+        SSExchangeGroupEvent event;
+        SSExchangeGroupCorePerformEventType(&_groupExchangeCore, exchangeEventType, &event);
+    } else {
+        SSExchangeEvent event;
+        SSExchangeCorePerformEventType(&_exchangeCore, exchangeEventType, &event);
+    }
+    
+    if (self.batchUpdateIsInFlight == NO) {
+        [self commitExchanges];
+    }
+    
+    [self endPhase:SSExchangePhaseExchangeEvent startTime:startTime];
 }
 
-- (void)performExchangeEventTypeDraggedToStartingItem {
+- (void)performBatchUpdatesWithSwaps:(const SSExchangeSwap *)swaps
+                               count:(unsigned int)numberOfSwaps
+                               moves:(const SSExchangeMove *)moves
+                               count:(unsigned int)numberOfMoves
+               indexPathForHiddenItem:(SSExchangeIndexPath)indexPathForHiddenItem {
+    
+    // The update block runs before performBatchUpdates:completion: returns, so it can use the
+    // caller's swaps and moves where they are.
+    
+    self.batchUpdateIsInFlight = YES;
     
     [self.collectionView performBatchUpdates:^{
         
         // Model...
-        [self.delegate exchangeController:self
-              didExchangeItemAtIndexPath1:self.originalIndexPathForDraggedItem
-                     withItemAtIndexPath2:self.originalIndexPathForDisplacedItem];
-        [self.delegate exchangeControllerDidFinishExchangeEvent:self];
+        uint64_t startTimeOfDelegate = [self beginPhase:SSExchangePhaseDelegate];
+        if ([self commitsOnCommitQueue]) {
+            [self commitSwapsOnCommitQueue:swaps count:numberOfSwaps finishingExchangeEvent:YES];
+        } else {
+            [self didExchangeItemsWithSwaps:swaps count:numberOfSwaps];
+            [self.delegate exchangeControllerDidFinishExchangeEvent:self];
+        }
+        [self endPhase:SSExchangePhaseDelegate startTime:startTimeOfDelegate];
         
         // View...
-        [self ensureItemsToMoveAreFrontMost];
-        [self.collectionView moveItemAtIndexPath:self.originalIndexPathForDraggedItem toIndexPath:self.originalIndexPathForDisplacedItem];
-        [self.collectionView moveItemAtIndexPath:self.originalIndexPathForDisplacedItem toIndexPath:self.originalIndexPathForDraggedItem];
+        [self ensureItemsToMoveAreFrontMost:moves count:numberOfMoves];
+        for (unsigned int i = 0; i < numberOfMoves; i++) {
+            [self.collectionView moveItemAtIndexPath:NSIndexPathFromSSExchangeIndexPath(moves[i].fromIndexPath)
+                                         toIndexPath:NSIndexPathFromSSExchangeIndexPath(moves[i].toIndexPath)];
+        }
         
-        [self setPostExchangeEventStateWithIndexPathForDisplacedItem:self.self.originalIndexPathForDraggedItem undoFlag:NO];
+        [self setPostExchangeEventStateWithIndexPathForCurrentItem:NSIndexPathFromSSExchangeIndexPath(indexPathForHiddenItem)];
         
-    } completion:nil];
+    } completion:^(BOOL finished) {
+        [self batchUpdateDidComplete];
+    }];
 }
 
 - (void)finishExchangeTransaction {
     
-    [self.delegate exchangeControllerDidFinishExchangeTransaction:self
-                                                   withIndexPath1:self.originalIndexPathForDisplacedItem
-                                                       indexPath2:self.originalIndexPathForDraggedItem];
+    uint64_t startTime = [self beginPhase:SSExchangePhaseRelease];
+    [self stopAutoScroll];
+    
+    // The delegate's model must reflect the final exchange before it is told about it, even if
+    // that means queuing a batch update behind one that is still animating.
+    [self commitExchanges];
+    
+    uint64_t startTimeOfDelegate = [self beginPhase:SSExchangePhaseDelegate];
+    if ([self.coordinator finishExchangeTransactionForExchangeController:self]) {
+        // The coordinator took the exchange transaction over so it reports the final exchange.
+    } else if ([self isGroupExchangeTransaction]) {
+        SSExchangeSwap finalExchanges[SSExchangeGroupMaximumNumberOfItems];
+        unsigned int numberOfFinalExchanges = SSExchangeGroupCoreFinish(&_groupExchangeCore, finalExchanges);
+        NSData *finalExchangesData = [NSData dataWithBytes:finalExchanges length:numberOfFinalExchanges * sizeof(SSExchangeSwap)];
+        [self performBlockOnceCommitted:^{
+            [self didFinishGroupExchangeTransactionWithExchanges:finalExchangesData.bytes count:numberOfFinalExchanges];
+        }];
+    } else {
+        SSExchangeSwap finalExchange = SSExchangeCoreFinish(&_exchangeCore);
+        [self performBlockOnceCommitted:^{
+            [self.delegate exchangeControllerDidFinishExchangeTransaction:self
+                                                           withIndexPath1:NSIndexPathFromSSExchangeIndexPath(finalExchange.indexPath1)
+                                                               indexPath2:NSIndexPathFromSSExchangeIndexPath(finalExchange.indexPath2)];
+        }];
+    }
+    [self endPhase:SSExchangePhaseDelegate startTime:startTimeOfDelegate];
+    
+    self.startTimeOfReleaseAnimation = [self beginPhase:SSExchangePhaseReleaseAnimation];
     [self animateRelease];
     
     self.exchangeTransactionInProgress = NO;
+    
+    [self endPhase:SSExchangePhaseRelease startTime:startTime];
 }
 
 - (void)cancelExchangeTransaction {
@@ -330,31 +557,220 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
     // This needs to be distinguished from system events, like an incoming phone call, that can
     // also cancel the gesture recognizer.
     
+    [self stopAutoScroll];
+    
     if (self.longPressWasManuallyCancelled) {
 
         self.longPressWasManuallyCancelled = NO;
         
+    } else if ([self.coordinator cancelExchangeTransactionForExchangeController:self]) {
+        
+        // The coordinator took the exchange transaction over and has already restored the model
+        // and the collection views. The exchange core is out of date.
+        [self resetExchangeCore];
+        self.exchangeTransactionInProgress = NO;
+        [self removeSnapshot];
+        
     } else {
         
         // Control reaches here, for example, if the user gets a phone call in the middle of the long press.
         
         // So the delegate can undo the last exchange in its model and thus
-        // return it to its pre-exchange transaction state...
-        [self.delegate exchangeController:self
-              didExchangeItemAtIndexPath1:self.originalIndexPathForDisplacedItem
-                     withItemAtIndexPath2:self.originalIndexPathForDraggedItem];
+        // return it to its pre-exchange transaction state. That is the committed exchanges, not
+        // the exchange core's, which may include exchange events the model hasn't seen yet...
+        SSExchangeSwap undoExchanges[SSExchangeGroupMaximumNumberOfItems];
+        unsigned int numberOfUndoExchanges = _numberOfCommittedExchanges;
+        memcpy(undoExchanges, _committedExchanges, numberOfUndoExchanges * sizeof(SSExchangeSwap));
+        
+        SSExchangeSwap coreUndoExchanges[SSExchangeGroupMaximumNumberOfItems];
+        SSExchangeGroupCoreCancel(&_groupExchangeCore, coreUndoExchanges);
+        SSExchangeCoreCancel(&_exchangeCore, &coreUndoExchanges[0]);
+        _numberOfCommittedExchanges = 0;
+        
+        // With a commit queue the undo exchanges go on it behind any exchange events still waiting
+        // there, so the model is restored whatever it had got to...
+        uint64_t startTimeOfDelegate = [self beginPhase:SSExchangePhaseDelegate];
+        if (numberOfUndoExchanges > 0 && [self commitsOnCommitQueue]) {
+            [self commitSwapsOnCommitQueue:undoExchanges count:numberOfUndoExchanges finishingExchangeEvent:NO];
+        } else if (numberOfUndoExchanges > 0) {
+            [self didExchangeItemsWithSwaps:undoExchanges count:numberOfUndoExchanges];
+        }
         
         // So the delegate has an opportunity to update its view...
-        [self.delegate exchangeControllerDidCancelExchangeTransaction:self];
+        [self performBlockOnceCommitted:^{
+            [self.delegate exchangeControllerDidCancelExchangeTransaction:self];
+        }];
+        [self endPhase:SSExchangePhaseDelegate startTime:startTimeOfDelegate];
         
-        self.originalIndexPathForDisplacedItem = nil;
-        self.originalIndexPathForDraggedItem = nil;
-        [self.snapshot removeFromSuperview];
+        [self updateIndexPathsForHidingAndDimming];
         self.exchangeTransactionInProgress = NO;
+        [self removeSnapshot];
+        
+        // Only the items in the undo exchanges differ from the model, and they were also the hidden
+        // and dimmed items, so reloading them restores the collection view. With a commit queue the
+        // data source finds them with indexPathInModelForItemAtIndexPath:. Batch updates are
+        // queued behind any move animations still in progress so, unlike reloadData, there is no
+        // need to wait for the backlog of animations to finish.
+        NSArray *indexPathsToReload = [self indexPathsForExchanges:undoExchanges count:numberOfUndoExchanges];
+        if (indexPathsToReload.count > 0) {
+            [self.collectionView performBatchUpdates:^{
+                [self.collectionView reloadItemsAtIndexPaths:indexPathsToReload];
+            } completion:nil];
+        }
+    }
+}
+
+
+
+//------------------------------------------------
+#pragma mark - Coalescing exchange events...
+
+// When the user's finger sweeps quickly across many items each exchange event used to start its
+// own batch update, and the move animations queued up behind one another. Now the exchange core
+// keeps up with the finger but the delegate's model and the collection view are only brought up to
+// date, or committed, when no batch update is animating. Exchange events that arrive in the
+// meantime are collapsed into the net change, committed in one batch update as soon as the one in
+// flight completes. So at most one batch update is pending at a time. The delegate sees the swaps
+// of that net change, which leave its model exactly as the individual exchange events would have,
+// followed by a single exchangeControllerDidFinishExchangeEvent:.
+
+- (unsigned int)getExchanges:(SSExchangeSwap *)exchanges {
+    
+    // The exchanges the exchange core has arrived at, an item exchanged with itself if nothing is exchanged.
+    
+    if ([self isGroupExchangeTransaction]) {
+        return SSExchangeGroupCoreGetExchanges(&_groupExchangeCore, exchanges);
+    }
+    
+    exchanges[0] = SSExchangeCoreExchange(&_exchangeCore);
+    return 1;
+}
+
+- (void)commitExchanges {
+    
+    SSExchangeSwap exchanges[SSExchangeGroupMaximumNumberOfItems];
+    unsigned int numberOfExchanges = [self getExchanges:exchanges];
+    if (numberOfExchanges != _numberOfCommittedExchanges) return;     // outside an exchange transaction
+    
+    SSExchangeSwap swaps[2 * SSExchangeGroupMaximumNumberOfItems];
+    unsigned int numberOfSwaps = SSExchangeCoalesceExchanges(_committedExchanges, exchanges, numberOfExchanges, swaps);
+    if (numberOfSwaps == 0) return;
+    
+    // Committed before the batch update because the layout reads them during it.
+    memcpy(_committedExchanges, exchanges, numberOfExchanges * sizeof(SSExchangeSwap));
+    
+    SSExchangeMove moves[4 * SSExchangeGroupMaximumNumberOfItems];
+    unsigned int numberOfMoves = SSExchangeComposeSwaps(swaps, numberOfSwaps, moves);
+    
+    // However many items are in the group, and however many exchange events are collapsed, it is
+    // still one batch update. The caught item's hidden item is where the snapshot will be released.
+    [self performBatchUpdatesWithSwaps:swaps count:numberOfSwaps moves:moves count:numberOfMoves indexPathForHiddenItem:exchanges[0].indexPath1];
+}
+
+- (void)batchUpdateDidComplete {
+    
+    self.batchUpdateIsInFlight = NO;
+    
+    if (self.exchangeTransactionInProgress) {
+        [self commitExchanges];
+    }
+}
+
+
+
+//----------------------------------------------
+#pragma mark - Committing on the commit queue...
+
+// Without a commit queue the delegate's model is changed in each batch update, on the main thread,
+// so the delegate's time is taken from the move animations. With one, each exchange event's swaps
+// are put on the commit queue instead and the delegate changes its model there. The collection
+// view moves the items straight away, so until the queue catches up the collection view is ahead
+// of the model. The shadow permutation records the swaps in between so index paths in the
+// collection view can be mapped to the model, and hit testing, hiding and dimming, which use only
+// the exchange controller's own state, are unaffected.
+//
+// The queue must be serial, or the swaps could reach the model out of order. The main queue is
+// treated as no queue. The delegate's didExchangeItemAtIndexPath1:withItemAtIndexPath2: or
+// didMoveItemsAtIndexPaths:toIndexPaths: is called on the queue under @synchronized (self), with
+// the popping of those swaps from the shadow permutation, so a data source that maps an index path
+// and reads the model under the same lock never sees the model changed but the swaps still
+// pending, or the reverse. Those calls, which change the model, are all that is done under the
+// lock: their index paths are made beforehand and exchangeControllerDidFinishExchangeEvent:
+// follows outside it, for the slow work: validation, persistence or sync. The end of the exchange
+// transaction, finished or cancelled, is reported on the main thread once everything before it on
+// the queue has been done. Exchange transactions coordinated with other collection views don't
+// use the queue.
+
+- (dispatch_queue_t)queueForCommits {
+    
+    return (self.commitQueue)? self.commitQueue : self.retiringCommitQueue;
+}
+
+- (BOOL)commitsOnCommitQueue {
+    
+    return [self queueForCommits] != nil && self.coordinator == nil;
+}
+
+- (void)commitSwapsOnCommitQueue:(const SSExchangeSwap *)swaps count:(unsigned int)numberOfSwaps finishingExchangeEvent:(BOOL)finishingExchangeEvent {
+    
+    // Cached snapshots follow the items in the collection view, which has these swaps now.
+    [self exchangeCachedImagesWithSwaps:swaps count:numberOfSwaps];
+    
+    NSData *swapsData = [NSData dataWithBytes:swaps length:numberOfSwaps * sizeof(SSExchangeSwap)];
+    BOOL pushed;
+    @synchronized (self) {
+        pushed = SSExchangeShadowPermutationPushSwaps(_shadowPermutation, swaps, numberOfSwaps);
+    }
+    
+    // The sink is read here, on the main thread, and only given samples there.
+    id<SSCollectionViewExchangeInstrumentationSink> instrumentation = self.instrumentation;
+    
+    void (^commit)(void) = ^{
         
-        // Why delay? Refer to the comments for the animationBacklogDelay property in the .h file.
-        [self performBlock:^{ [self.collectionView reloadData]; }
-                afterDelay:self.animationBacklogDelay];
+        uint64_t startTime = (instrumentation)? SSExchangeInstrumentationBeginPhase(SSExchangePhaseCommit) : 0;
+        
+        // The lock is held only while the delegate changes its model and the swaps are popped, which
+        // the data source must see together. Everything else is done outside it.
+        dispatch_block_t changeModel = [self delegateCallsForSwaps:swapsData.bytes count:numberOfSwaps];
+        @synchronized (self) {
+            changeModel();
+            if (pushed) SSExchangeShadowPermutationPopSwaps(self->_shadowPermutation, numberOfSwaps);
+        }
+        if (finishingExchangeEvent) {
+            [self.delegate exchangeControllerDidFinishExchangeEvent:self];
+        }
+        
+        [self endPhaseOffMainThread:SSExchangePhaseCommit startTime:startTime instrumentation:instrumentation];
+    };
+    
+    // The swaps are queued even if they couldn't be recorded, which only happens when memory runs
+    // out, so the model gets them in order. Until the queue catches up indexPathInModelForItemAtIndexPath:
+    // won't account for them. Waiting for the queue instead could deadlock if the delegate waits on
+    // the main thread there.
+    dispatch_async([self queueForCommits], commit);
+}
+
+- (void)performBlockOnceCommitted:(dispatch_block_t)block {
+    
+    // On the main thread after everything already on the commit queue, or straight away without one.
+    
+    if ([self commitsOnCommitQueue] == NO) {
+        block();
+        return;
+    }
+    
+    dispatch_barrier_async([self queueForCommits], ^{
+        dispatch_async(dispatch_get_main_queue(), block);
+    });
+}
+
+- (NSIndexPath *)indexPathInModelForItemAtIndexPath:(NSIndexPath *)indexPath {
+    
+    if (indexPath == nil) return nil;
+    
+    @synchronized (self) {
+        SSExchangeIndexPath indexPathInModel = SSExchangeShadowPermutationIndexPathInModel(_shadowPermutation, SSExchangeIndexPathFromNSIndexPath(indexPath));
+        return NSIndexPathFromSSExchangeIndexPath(indexPathInModel);
     }
 }
 
@@ -363,6 +779,75 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
 //---------------------------------------
 #pragma mark - Exchange helper methods...
 
+- (void)didExchangeItemsWithSwaps:(const SSExchangeSwap *)swaps count:(unsigned int)numberOfSwaps {
+    
+    // Every change to the model goes through here, or through commitSwapsOnCommitQueue:, so cached
+    // snapshots follow their items.
+    
+    [self exchangeCachedImagesWithSwaps:swaps count:numberOfSwaps];
+    [self delegateDidExchangeItemsWithSwaps:swaps count:numberOfSwaps];
+}
+
+- (void)exchangeCachedImagesWithSwaps:(const SSExchangeSwap *)swaps count:(unsigned int)numberOfSwaps {
+    
+    for (unsigned int i = 0; i < numberOfSwaps; i++) {
+        [self.snapshotCache exchangeImageForItemAtIndexPath:NSIndexPathFromSSExchangeIndexPath(swaps[i].indexPath1)
+                                withImageForItemAtIndexPath:NSIndexPathFromSSExchangeIndexPath(swaps[i].indexPath2)];
+    }
+}
+
+- (void)delegateDidExchangeItemsWithSwaps:(const SSExchangeSwap *)swaps count:(unsigned int)numberOfSwaps {
+    
+    [self delegateCallsForSwaps:swaps count:numberOfSwaps]();
+}
+
+- (dispatch_block_t)delegateCallsForSwaps:(const SSExchangeSwap *)swaps count:(unsigned int)numberOfSwaps {
+    
+    // The index paths are made before the delegate is called so that on the commit queue the lock
+    // is held only for the calls themselves. Refer to commitSwapsOnCommitQueue:.
+    
+    NSMutableArray *indexPaths1 = [NSMutableArray arrayWithCapacity:numberOfSwaps];
+    NSMutableArray *indexPaths2 = [NSMutableArray arrayWithCapacity:numberOfSwaps];
+    
+    if ([self.delegate respondsToSelector:@selector(exchangeController:didMoveItemsAtIndexPaths:toIndexPaths:)]) {
+        [self getNetMovesFromIndexPaths:indexPaths1 toIndexPaths:indexPaths2 withSwaps:swaps count:numberOfSwaps];
+        return ^{
+            if (indexPaths1.count == 0) return;
+            [self.delegate exchangeController:self didMoveItemsAtIndexPaths:indexPaths1 toIndexPaths:indexPaths2];
+        };
+    }
+    
+    for (unsigned int i = 0; i < numberOfSwaps; i++) {
+        [indexPaths1 addObject:NSIndexPathFromSSExchangeIndexPath(swaps[i].indexPath1)];
+        [indexPaths2 addObject:NSIndexPathFromSSExchangeIndexPath(swaps[i].indexPath2)];
+    }
+    return ^{
+        for (NSUInteger i = 0; i < indexPaths1.count; i++) {
+            [self.delegate exchangeController:self didExchangeItemAtIndexPath1:indexPaths1[i] withItemAtIndexPath2:indexPaths2[i]];
+        }
+    };
+}
+
+- (void)getNetMovesFromIndexPaths:(NSMutableArray *)fromIndexPaths
+                     toIndexPaths:(NSMutableArray *)toIndexPaths
+                        withSwaps:(const SSExchangeSwap *)swaps
+                            count:(unsigned int)numberOfSwaps {
+    
+    // The delegate wants the net change, not the individual exchanges. For example, dragging
+    // from one item to another undoes the prior exchange then exchanges again, two exchanges
+    // that amount to three items moving in a cycle. Exchanges that cancel out are not reported.
+    
+    if (numberOfSwaps == 0) return;
+    
+    SSExchangeMove moves[2 * numberOfSwaps];
+    unsigned int numberOfMoves = SSExchangeComposeSwaps(swaps, numberOfSwaps, moves);
+    
+    for (unsigned int i = 0; i < numberOfMoves; i++) {
+        [fromIndexPaths addObject:NSIndexPathFromSSExchangeIndexPath(moves[i].fromIndexPath)];
+        [toIndexPaths addObject:NSIndexPathFromSSExchangeIndexPath(moves[i].toIndexPath)];
+    }
+}
+
 - (void)cancelLongPressRecognizer {
     
     self.longPressWasManuallyCancelled = YES;
@@ -397,38 +882,37 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
     BOOL delegateAllowsExchangeToBeginWithItemAtIndexPath = YES;
     
     if ([self.delegate respondsToSelector:@selector(exchangeControllerCanBeginExchangeTransaction:withItemAtIndexPath:)]) {
+        uint64_t startTimeOfDelegate = [self beginPhase:SSExchangePhaseDelegate];
         delegateAllowsExchangeToBeginWithItemAtIndexPath = [self.delegate exchangeControllerCanBeginExchangeTransaction:self
                                                                                                     withItemAtIndexPath:indexPath];
+        [self endPhase:SSExchangePhaseDelegate startTime:startTimeOfDelegate];
     }
     
     return delegateAllowsExchangeToBeginWithItemAtIndexPath;
 }
 
-- (BOOL)delegateAllowsDisplacingItemAtIndexPath:(NSIndexPath *)indexPathForItemToDisplace
-                          withItemFromIndexPath:(NSIndexPath *)indexPathOfItemBeingDragged {
+- (BOOL)delegateAllowsDisplacingItemAtIndexPath:(SSExchangeIndexPath)indexPathForItemToDisplace
+                          withItemFromIndexPath:(SSExchangeIndexPath)indexPathOfItemBeingDragged {
     
-    // This if() is here to prevent repeated calls to the delegate. With this if() the delegate
-    // is asked only once until indexPathForItemToDisplace changes.
+    // The delegate is asked only once for each item during the exchange transaction. After
+    // that the answer comes from the displacement permissions.
     
-    if ([indexPathForItemToDisplace isEqual:self.indexPathForItemLastChecked]) {
-        
-        return self.resultForItemLastChecked;
-        
-    } else {
-        
-        self.indexPathForItemLastChecked = indexPathForItemToDisplace;
-        
-        BOOL delegateAllowsDisplacingItemAtIndexPath = YES;
-        
-        if ([self.delegate respondsToSelector:@selector(exchangeController:canDisplaceItemAtIndexPath:withItemBeingDraggedFromIndexPath:)]) {
-            delegateAllowsDisplacingItemAtIndexPath = [self.delegate exchangeController:self
-                                                             canDisplaceItemAtIndexPath:indexPathForItemToDisplace
-                                                      withItemBeingDraggedFromIndexPath:indexPathOfItemBeingDragged];
-        }
-        
-        self.resultForItemLastChecked = delegateAllowsDisplacingItemAtIndexPath;
+    BOOL delegateAllowsDisplacingItemAtIndexPath = YES;
+    
+    if ([self getDisplacementPermission:&delegateAllowsDisplacingItemAtIndexPath forIndexPath:indexPathForItemToDisplace]) {
         return delegateAllowsDisplacingItemAtIndexPath;
     }
+    
+    if ([self.delegate respondsToSelector:@selector(exchangeController:canDisplaceItemAtIndexPath:withItemBeingDraggedFromIndexPath:)]) {
+        uint64_t startTimeOfDelegate = [self beginPhase:SSExchangePhaseDelegate];
+        delegateAllowsDisplacingItemAtIndexPath = [self.delegate exchangeController:self
+                                                         canDisplaceItemAtIndexPath:NSIndexPathFromSSExchangeIndexPath(indexPathForItemToDisplace)
+                                                  withItemBeingDraggedFromIndexPath:NSIndexPathFromSSExchangeIndexPath(indexPathOfItemBeingDragged)];
+        [self endPhase:SSExchangePhaseDelegate startTime:startTimeOfDelegate];
+    }
+    
+    [self rememberDisplacementPermission:delegateAllowsDisplacingItemAtIndexPath forIndexPath:indexPathForItemToDisplace];
+    return delegateAllowsDisplacingItemAtIndexPath;
 }
 
 - (BOOL)locationIsInCatchRectangleForItemAtIndexPath:(NSIndexPath *)indexPath {
@@ -458,93 +942,713 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
     
 }
 
-- (void)ensureItemsToMoveAreFrontMost {
+- (void)ensureItemsToMoveAreFrontMost:(const SSExchangeMove *)moves count:(unsigned int)numberOfMoves {
     
     // It can happen that the cells being exchanged are not the frontmost in the view. In that case
     // the move animations are obscured behind other collection view items.
     
-    UICollectionViewCell *cell;
+    for (unsigned int i = 0; i < numberOfMoves; i++) {
+        UICollectionViewCell *cell = [self.collectionView cellForItemAtIndexPath:NSIndexPathFromSSExchangeIndexPath(moves[i].fromIndexPath)];
+        if (cell) [self.collectionView bringSubviewToFront:cell];
+    }
     
-    cell = [self.collectionView cellForItemAtIndexPath:self.originalIndexPathForDraggedItem];
-    [self.collectionView bringSubviewToFront:cell];
+    [self.collectionView bringSubviewToFront:self.snapshot];
     
-    cell = [self.collectionView cellForItemAtIndexPath:self.currentIndexPath];
-    [self.collectionView bringSubviewToFront:cell];
+}
+
+- (void)setPostExchangeEventStateWithIndexPathForCurrentItem:(NSIndexPath *)indexPathForCurrentItem {
     
-    [self.collectionView bringSubviewToFront:self.snapshot];
+    // The exchange core has already moved on to its post exchange event state.
+    [self updateIndexPathsForHidingAndDimming];
+    self.centerOfHiddenCell = [self.collectionView cellForItemAtIndexPath:indexPathForCurrentItem].center;
+}
+
+- (void)invalidateLayoutForHidingAndDimming {
     
+    SSCollectionViewExchangeLayout *layout = (SSCollectionViewExchangeLayout *)self.collectionView.collectionViewLayout;
+    
+    if ([layout isKindOfClass:[SSCollectionViewExchangeLayout class]]) {
+        [layout invalidateLayoutForHidingAndDimming];
+    } else {
+        [layout invalidateLayout];
+    }
 }
 
-- (void)setPostExchangeEventStateWithIndexPathForDisplacedItem:(NSIndexPath *)indexPathForDisplacedItem
-                                                      undoFlag:(BOOL)undoFlag {
-    self.originalIndexPathForDisplacedItem = indexPathForDisplacedItem;
-    self.mustUndoPriorExchange = undoFlag;
-    self.centerOfHiddenCell = [self.collectionView cellForItemAtIndexPath:self.currentIndexPath].center;
+- (NSArray *)indexPathsForExchanges:(const SSExchangeSwap *)exchanges count:(unsigned int)numberOfExchanges {
+    
+    // The exchanges in a group never share an item, so only an item exchanged with itself could
+    // appear twice.
+    
+    NSMutableArray *indexPaths = [NSMutableArray arrayWithCapacity:2 * numberOfExchanges];
+    
+    for (unsigned int i = 0; i < numberOfExchanges; i++) {
+        
+        SSExchangeSwap exchange = exchanges[i];
+        
+        if (!SSExchangeIndexPathIsNone(exchange.indexPath1)) {
+            [indexPaths addObject:NSIndexPathFromSSExchangeIndexPath(exchange.indexPath1)];
+        }
+        
+        if (!SSExchangeIndexPathIsNone(exchange.indexPath2) && !SSExchangeIndexPathEqualToIndexPath(exchange.indexPath1, exchange.indexPath2)) {
+            [indexPaths addObject:NSIndexPathFromSSExchangeIndexPath(exchange.indexPath2)];
+        }
+    }
+    
+    return indexPaths;
 }
 
-- (UIView *)snapshotForCell:(UICollectionViewCell *)cell {
+- (void)updateIndexPathsForHidingAndDimming {
+    
+    // The layout reads the committed exchanges directly. The dimmed item is converted to NSIndexPath
+    // once, when the exchange core's state changes, for the release animation and the delegate.
     
-    UIView *snapshot;
+    SSExchangeIndexPath indexPathForDimmedItem = ([self isGroupExchangeTransaction])? _groupExchangeCore.originalIndexPaths[0] : _exchangeCore.originalIndexPathForDraggedItem;
+    
+    if (!SSExchangeIndexPathEqualToIndexPath(indexPathForDimmedItem, SSExchangeIndexPathFromNSIndexPath(self.indexPathForDimmedItem))) {
+        self.indexPathForDimmedItem = NSIndexPathFromSSExchangeIndexPath(indexPathForDimmedItem);
+    }
+}
+
+- (UIView *)snapshotForCell:(UICollectionViewCell *)cell atIndexPath:(NSIndexPath *)indexPath {
     
     if ([self.delegate respondsToSelector:@selector(exchangeController:snapshotForCell:)]) {
         
+        self.snapshotIsFromPool = NO;
         return [self.delegate exchangeController:self snapshotForCell:cell];
         
     } else {
         
-        BOOL shouldApplyBackgroundColor = self.snapshotBackgroundColor != nil;
-        UIColor *originalBackgroundColor;
+        // Rendering a rich cell is the slowest part of the catch. If the delegate provides content
+        // versions the image can come from the cache, rendered earlier, perhaps by
+        // prerenderSnapshotsForVisibleItems. The view to show it in comes from a pool.
         
-        if (shouldApplyBackgroundColor) {
-            originalBackgroundColor = cell.backgroundColor;
-            cell.backgroundColor = self.snapshotBackgroundColor;
-        }
-        
-        float originalAlpha = cell.alpha;
-        cell.alpha = self.snapshotAlpha;
-        
-        // Normally, it would be appropriate to use UIView's snapshotViewAfterScreenUpdates:.
-        // Like this...
-        //
-        //      snapshot = [cell snapshotViewAfterScreenUpdates:YES];
-        //
-        // But when that runs on an iPad (device or simulator) there is an annoying screen
-        // flash. The flash doesn't happen if NO is passed to snapshotViewAfterScreenUpdates:
-        // but then the default background colour and alpha aren't applied. So for now
-        // I've gone back to the UIGraphics method for generating the snapshot.
-        
-        //////////////////////////////////////////////////////
-        UIGraphicsBeginImageContextWithOptions(cell.bounds.size, cell.opaque, 0.0f);
-        [cell.layer renderInContext:UIGraphicsGetCurrentContext()];
-        UIImage *cellImage = UIGraphicsGetImageFromCurrentImageContext();
-        UIGraphicsEndImageContext();
-        snapshot = [[UIImageView alloc] initWithImage:cellImage];
-        //////////////////////////////////////////////////////
-
-//        snapshot = [cell snapshotViewAfterScreenUpdates:YES];
-        // This can replace the UIGraphics code above if it starts to work on the iPad.
-        
-        snapshot.frame = cell.frame;
+        UIImage *cellImage = [self cachedImageForCell:cell atIndexPath:indexPath];
         
-        if (shouldApplyBackgroundColor) {
-            cell.backgroundColor = originalBackgroundColor;
+        if (cellImage == nil) {
+            cellImage = [self renderedImageForCell:cell];
+            [self cacheImage:cellImage forItemAtIndexPath:indexPath];
         }
         
-        cell.alpha = originalAlpha;
+        UIView *snapshot = [self.snapshotCache dequeueImageViewWithImage:cellImage];
+        snapshot.frame = cell.frame;
+        self.snapshotIsFromPool = YES;
         
         return snapshot;
         
     }
 }
 
-- (void)animateCatch:(UIView *)snapshot {
+- (UIImage *)renderedImageForCell:(UICollectionViewCell *)cell {
     
-    if ([self.delegate respondsToSelector:@selector(animateCatchForExchangeController:withSnapshot:)]) {
-        
-        [self.delegate animateCatchForExchangeController:self withSnapshot:snapshot];
-        
-    } else {
-        
+    BOOL shouldApplyBackgroundColor = self.snapshotBackgroundColor != nil;
+    UIColor *originalBackgroundColor;
+    
+    if (shouldApplyBackgroundColor) {
+        originalBackgroundColor = cell.backgroundColor;
+        cell.backgroundColor = self.snapshotBackgroundColor;
+    }
+    
+    float originalAlpha = cell.alpha;
+    cell.alpha = self.snapshotAlpha;
+    
+    // Normally, it would be appropriate to use UIView's snapshotViewAfterScreenUpdates:.
+    // Like this...
+    //
+    //      snapshot = [cell snapshotViewAfterScreenUpdates:YES];
+    //
+    // But when that runs on an iPad (device or simulator) there is an annoying screen
+    // flash. The flash doesn't happen if NO is passed to snapshotViewAfterScreenUpdates:
+    // but then the default background colour and alpha aren't applied. So for now
+    // I've gone back to rendering the layer into an image.
+    
+    UIImage *cellImage = [SSCollectionViewExchangeSnapshotCache imageByRenderingView:cell];
+    
+    if (shouldApplyBackgroundColor) {
+        cell.backgroundColor = originalBackgroundColor;
+    }
+    
+    cell.alpha = originalAlpha;
+    
+    return cellImage;
+}
+
+- (BOOL)delegateProvidesContentVersions {
+    
+    return [self.delegate respondsToSelector:@selector(exchangeController:contentVersionForItemAtIndexPath:)];
+}
+
+- (UIImage *)cachedImageForCell:(UICollectionViewCell *)cell atIndexPath:(NSIndexPath *)indexPath {
+    
+    if ([self delegateProvidesContentVersions] == NO) return nil;
+    
+    return [self.snapshotCache imageForItemAtIndexPath:indexPath
+                                        contentVersion:[self.delegate exchangeController:self contentVersionForItemAtIndexPath:indexPath]
+                                                  size:cell.bounds.size];
+}
+
+- (void)cacheImage:(UIImage *)image forItemAtIndexPath:(NSIndexPath *)indexPath {
+    
+    if ([self delegateProvidesContentVersions] == NO) return;
+    
+    [self.snapshotCache setImage:image
+              forItemAtIndexPath:indexPath
+                  contentVersion:[self.delegate exchangeController:self contentVersionForItemAtIndexPath:indexPath]];
+}
+
+- (void)removeSnapshot {
+    
+    for (UIImageView *snapshotPart in self.snapshotPartsFromPool) {
+        [self.snapshotCache enqueueImageView:snapshotPart];
+    }
+    [self.snapshotPartsFromPool removeAllObjects];
+    self.snapshotParts = nil;
+    
+    if (self.snapshotIsFromPool) {
+        [self.snapshotCache enqueueImageView:(UIImageView *)self.snapshot];
+    } else {
+        [self.snapshot removeFromSuperview];
+    }
+    
+    self.snapshot = nil;
+    self.snapshotIsFromPool = NO;
+    
+    [self endPhase:SSExchangePhaseReleaseAnimation startTime:self.startTimeOfReleaseAnimation];
+    self.startTimeOfReleaseAnimation = 0;
+    
+    // The transaction is over. Carry on with any prerendering it interrupted.
+    [self schedulePrerendering];
+}
+
+
+
+//------------------------------
+#pragma mark - Auto scrolling...
+
+// When the user drags to within autoScrollEdgeInset of an edge the collection view scrolls that way,
+// faster the closer the finger gets, up to autoScrollMaximumSpeed. A display link drives it so it
+// keeps going while the finger is still, which produces no touch samples. Each tick moves the
+// content offset by the speed times the time since the last tick, so the speed is the same at any
+// frame rate, moves the snapshot and the long press location along with the content so they stay
+// under the finger, and then hit tests again, through the layout's grid index, in case the content
+// brought a new item under the finger. Changing the content offset doesn't invalidate the flow
+// layout, so a tick is a few arithmetic operations and one hit test unless an exchange happens.
+//
+// The display link runs only while there is somewhere to scroll. It stops when the finger leaves
+// the edge zones, when the content reaches its end, and when the transaction ends.
+
+- (void)updateAutoScroll {
+    
+    CGPoint velocity = [self autoScrollVelocity];
+    
+    if (velocity.x == 0 && velocity.y == 0) {
+        [self stopAutoScroll];
+    } else if (self.autoScrollDisplayLink == nil) {
+        self.timestampOfLastAutoScroll = 0;
+        self.autoScrollDisplayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(autoScrollDisplayLinkDidFire:)];
+        [self.autoScrollDisplayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+    }
+}
+
+- (void)stopAutoScroll {
+    
+    // The display link retains its target until it is invalidated.
+    [self.autoScrollDisplayLink invalidate];
+    self.autoScrollDisplayLink = nil;
+}
+
+- (CGPoint)autoScrollVelocity {
+    
+    // In points per second. Each axis ramps from 0 at the inner edge of its edge zone to the maximum
+    // speed at the edge of the collection view, and is 0 if the content can't scroll that way.
+    
+    if (self.autoScrollEnabled == NO || self.exchangeTransactionInProgress == NO || self.autoScrollEdgeInset <= 0) return CGPointZero;
+    
+    UICollectionView *collectionView = self.collectionView;
+    CGRect bounds = collectionView.bounds;
+    CGPoint minimumContentOffset = [self minimumContentOffset];
+    CGPoint maximumContentOffset = [self maximumContentOffset];
+    CGPoint location = self.locationInCollectionView;
+    
+    CGFloat x = [self autoScrollSpeedForDistanceToLowerEdge:location.x - CGRectGetMinX(bounds)
+                                        distanceToUpperEdge:CGRectGetMaxX(bounds) - location.x];
+    CGFloat y = [self autoScrollSpeedForDistanceToLowerEdge:location.y - CGRectGetMinY(bounds)
+                                        distanceToUpperEdge:CGRectGetMaxY(bounds) - location.y];
+    
+    if ((x < 0 && bounds.origin.x <= minimumContentOffset.x) || (x > 0 && bounds.origin.x >= maximumContentOffset.x)) x = 0;
+    if ((y < 0 && bounds.origin.y <= minimumContentOffset.y) || (y > 0 && bounds.origin.y >= maximumContentOffset.y)) y = 0;
+    
+    return CGPointMake(x, y);
+}
+
+- (CGFloat)autoScrollSpeedForDistanceToLowerEdge:(CGFloat)distanceToLowerEdge distanceToUpperEdge:(CGFloat)distanceToUpperEdge {
+    
+    // Negative toward the lower edge, positive toward the upper. The ramp is quadratic so the first
+    // part of the edge zone gives fine control.
+    
+    CGFloat edgeInset = self.autoScrollEdgeInset;
+    CGFloat distance = MIN(distanceToLowerEdge, distanceToUpperEdge);
+    if (distance >= edgeInset) return 0;
+    
+    CGFloat ramp = MIN(1.0, (edgeInset - distance) / edgeInset);
+    CGFloat speed = self.autoScrollMaximumSpeed * ramp * ramp;
+    
+    return (distanceToLowerEdge < distanceToUpperEdge)? -speed : speed;
+}
+
+- (CGPoint)minimumContentOffset {
+    
+    UIEdgeInsets contentInset = self.collectionView.contentInset;
+    return CGPointMake(-contentInset.left, -contentInset.top);
+}
+
+- (CGPoint)maximumContentOffset {
+    
+    UICollectionView *collectionView = self.collectionView;
+    UIEdgeInsets contentInset = collectionView.contentInset;
+    CGSize contentSize = collectionView.contentSize;
+    CGSize boundsSize = collectionView.bounds.size;
+    
+    return CGPointMake(MAX(-contentInset.left, contentSize.width + contentInset.right - boundsSize.width),
+                       MAX(-contentInset.top, contentSize.height + contentInset.bottom - boundsSize.height));
+}
+
+- (void)autoScrollDisplayLinkDidFire:(CADisplayLink *)displayLink {
+    
+    CGPoint velocity = [self autoScrollVelocity];
+    if (velocity.x == 0 && velocity.y == 0) {
+        [self stopAutoScroll];
+        return;
+    }
+    
+    uint64_t startTime = [self beginPhase:SSExchangePhaseAutoScroll];
+    [self autoScrollWithVelocity:velocity displayLink:displayLink];
+    [self endPhase:SSExchangePhaseAutoScroll startTime:startTime];
+}
+
+- (void)autoScrollWithVelocity:(CGPoint)velocity displayLink:(CADisplayLink *)displayLink {
+    
+    // The first tick has no previous one so it assumes a frame. Long gaps, like after the app was
+    // briefly blocked, are capped so the content doesn't jump.
+    CFTimeInterval elapsed = (self.timestampOfLastAutoScroll > 0)? displayLink.timestamp - self.timestampOfLastAutoScroll : displayLink.duration;
+    elapsed = MIN(MAX(elapsed, 0), 0.05);
+    self.timestampOfLastAutoScroll = displayLink.timestamp;
+    
+    UICollectionView *collectionView = self.collectionView;
+    CGPoint contentOffset = collectionView.contentOffset;
+    CGPoint minimumContentOffset = [self minimumContentOffset];
+    CGPoint maximumContentOffset = [self maximumContentOffset];
+    
+    CGPoint newContentOffset = CGPointMake(MIN(MAX(contentOffset.x + velocity.x * elapsed, minimumContentOffset.x), maximumContentOffset.x),
+                                           MIN(MAX(contentOffset.y + velocity.y * elapsed, minimumContentOffset.y), maximumContentOffset.y));
+    CGFloat dx = newContentOffset.x - contentOffset.x;
+    CGFloat dy = newContentOffset.y - contentOffset.y;
+    if (dx == 0 && dy == 0) return;
+    
+    collectionView.contentOffset = newContentOffset;
+    
+    // The finger hasn't moved on the screen so in the collection view's coordinates it has moved
+    // with the content, and so has the snapshot...
+    self.locationInCollectionView = CGPointMake(self.locationInCollectionView.x + dx, self.locationInCollectionView.y + dy);
+    self.snapshot.center = CGPointMake(self.snapshot.center.x + dx, self.snapshot.center.y + dy);
+    
+    [self performExchangeEventType];
+}
+
+
+
+//---------------------------------------------
+#pragma mark - Group exchange transactions...
+
+// If the delegate gives a group for the item the user catches, the whole group is dragged together
+// in one exchange transaction. Each exchange event exchanges every item in the group with its
+// target in a single batch update, and the group shares one snapshot: a view holding a snapshot of
+// each item in the group that is on screen, arranged as the items are. The catch and the release
+// are animated once for the whole group. Refer to SSCollectionViewExchangeGroupCore.h for how the
+// targets are chosen.
+
+- (BOOL)isGroupExchangeTransaction {
+    
+    // Still YES during the release, until the exchange core is reset.
+    return _groupExchangeCore.numberOfItems > 0;
+}
+
+- (BOOL)beginGroupExchangeTransactionWithItemAtIndexPath:(NSIndexPath *)indexPath {
+    
+    if ([self.delegate respondsToSelector:@selector(exchangeController:indexPathsForGroupWithItemAtIndexPath:)] == NO) return NO;
+    
+    uint64_t startTimeOfDelegate = [self beginPhase:SSExchangePhaseDelegate];
+    NSArray *indexPathsForGroup = [self.delegate exchangeController:self indexPathsForGroupWithItemAtIndexPath:indexPath];
+    [self endPhase:SSExchangePhaseDelegate startTime:startTimeOfDelegate];
+    
+    // The item the user caught comes first. Duplicates, index paths that aren't in the collection
+    // view, and anything past the maximum are left out.
+    
+    SSExchangeIndexPath indexPaths[SSExchangeGroupMaximumNumberOfItems];
+    unsigned int numberOfItems = 0;
+    indexPaths[numberOfItems++] = SSExchangeIndexPathFromNSIndexPath(indexPath);
+    
+    for (NSIndexPath *indexPathInGroup in indexPathsForGroup) {
+        
+        if (numberOfItems == SSExchangeGroupMaximumNumberOfItems) break;
+        
+        SSExchangeIndexPath indexPathToAdd = SSExchangeIndexPathFromNSIndexPath(indexPathInGroup);
+        BOOL shouldLeaveOut = ([self collectionViewHasItemAtIndexPath:indexPathToAdd] == NO);
+        
+        for (unsigned int i = 0; i < numberOfItems && shouldLeaveOut == NO; i++) {
+            shouldLeaveOut = SSExchangeIndexPathEqualToIndexPath(indexPaths[i], indexPathToAdd);
+        }
+        
+        if (shouldLeaveOut == NO) indexPaths[numberOfItems++] = indexPathToAdd;
+    }
+    
+    // A group of one is an ordinary exchange transaction.
+    return numberOfItems > 1 && SSExchangeGroupCoreBegin(&_groupExchangeCore, indexPaths, numberOfItems);
+}
+
+- (BOOL)collectionViewHasItemAtIndexPath:(SSExchangeIndexPath)indexPath {
+    
+    return (SSExchangeIndexPathIsNone(indexPath) == NO &&
+            indexPath.section < [self.collectionView numberOfSections] &&
+            indexPath.item < [self.collectionView numberOfItemsInSection:indexPath.section]);
+}
+
+- (BOOL)delegateAllowsDisplacingItemsAtIndexPaths:(const SSExchangeIndexPath *)indexPathsForItemsToDisplace
+                         withItemsFromIndexPaths:(const SSExchangeIndexPath *)indexPathsOfItemsBeingDragged
+                                           count:(unsigned int)numberOfItems {
+    
+    // The targets are the group moved by one offset, so the first of them identifies them all and
+    // the answer is remembered by it in the displacement permissions. A group can't displace items
+    // that aren't there, like those past the end of a section.
+    
+    BOOL delegateAllowsDisplacingItems = YES;
+    
+    if ([self getDisplacementPermission:&delegateAllowsDisplacingItems forIndexPath:indexPathsForItemsToDisplace[0]]) {
+        return delegateAllowsDisplacingItems;
+    }
+    
+    for (unsigned int i = 0; i < numberOfItems && delegateAllowsDisplacingItems; i++) {
+        delegateAllowsDisplacingItems = [self collectionViewHasItemAtIndexPath:indexPathsForItemsToDisplace[i]];
+    }
+    
+    if (delegateAllowsDisplacingItems && [self.delegate respondsToSelector:@selector(exchangeController:canDisplaceItemAtIndexPath:withItemBeingDraggedFromIndexPath:)]) {
+        
+        uint64_t startTimeOfDelegate = [self beginPhase:SSExchangePhaseDelegate];
+        for (unsigned int i = 0; i < numberOfItems && delegateAllowsDisplacingItems; i++) {
+            delegateAllowsDisplacingItems = [self.delegate exchangeController:self
+                                                   canDisplaceItemAtIndexPath:NSIndexPathFromSSExchangeIndexPath(indexPathsForItemsToDisplace[i])
+                                            withItemBeingDraggedFromIndexPath:NSIndexPathFromSSExchangeIndexPath(indexPathsOfItemsBeingDragged[i])];
+        }
+        [self endPhase:SSExchangePhaseDelegate startTime:startTimeOfDelegate];
+    }
+    
+    [self rememberDisplacementPermission:delegateAllowsDisplacingItems forIndexPath:indexPathsForItemsToDisplace[0]];
+    return delegateAllowsDisplacingItems;
+}
+
+- (void)didFinishGroupExchangeTransactionWithExchanges:(const SSExchangeSwap *)exchanges count:(unsigned int)numberOfExchanges {
+    
+    // Delegates that don't know about groups are told about each item's final exchange in turn.
+    
+    if ([self.delegate respondsToSelector:@selector(exchangeControllerDidFinishGroupExchangeTransaction:withIndexPaths1:indexPaths2:)]) {
+        
+        NSMutableArray *indexPaths1 = [NSMutableArray arrayWithCapacity:numberOfExchanges];
+        NSMutableArray *indexPaths2 = [NSMutableArray arrayWithCapacity:numberOfExchanges];
+        
+        for (unsigned int i = 0; i < numberOfExchanges; i++) {
+            [indexPaths1 addObject:NSIndexPathFromSSExchangeIndexPath(exchanges[i].indexPath1)];
+            [indexPaths2 addObject:NSIndexPathFromSSExchangeIndexPath(exchanges[i].indexPath2)];
+        }
+        
+        [self.delegate exchangeControllerDidFinishGroupExchangeTransaction:self withIndexPaths1:indexPaths1 indexPaths2:indexPaths2];
+        
+    } else {
+        
+        for (unsigned int i = 0; i < numberOfExchanges; i++) {
+            [self.delegate exchangeControllerDidFinishExchangeTransaction:self
+                                                           withIndexPath1:NSIndexPathFromSSExchangeIndexPath(exchanges[i].indexPath1)
+                                                               indexPath2:NSIndexPathFromSSExchangeIndexPath(exchanges[i].indexPath2)];
+        }
+    }
+}
+
+- (UIView *)snapshotForGroup {
+    
+    // Each part is a snapshot of one item, made the same way as the snapshot of a single item, and
+    // is placed where its cell is. Items that aren't on screen have no cell and no part. The item
+    // the user caught is always on screen.
+    
+    NSMutableArray *snapshotParts = [NSMutableArray arrayWithCapacity:_groupExchangeCore.numberOfItems];
+    CGRect frame = CGRectNull;
+    
+    for (unsigned int i = 0; i < _groupExchangeCore.numberOfItems; i++) {
+        
+        NSIndexPath *indexPath = NSIndexPathFromSSExchangeIndexPath(_groupExchangeCore.originalIndexPaths[i]);
+        UICollectionViewCell *cell = [self.collectionView cellForItemAtIndexPath:indexPath];
+        
+        if (cell == nil) {
+            [snapshotParts addObject:[NSNull null]];
+            continue;
+        }
+        
+        UIView *snapshotPart = [self snapshotForCell:cell atIndexPath:indexPath];
+        if (self.snapshotIsFromPool) [self.snapshotPartsFromPool addObject:snapshotPart];
+        
+        snapshotPart.center = cell.center;
+        frame = CGRectUnion(frame, snapshotPart.frame);
+        [snapshotParts addObject:snapshotPart];
+    }
+    
+    UIView *snapshot = [[UIView alloc] initWithFrame:frame];
+    
+    for (UIView *snapshotPart in snapshotParts) {
+        if ((id)snapshotPart == [NSNull null]) continue;
+        snapshotPart.center = CGPointMake(snapshotPart.center.x - frame.origin.x, snapshotPart.center.y - frame.origin.y);
+        [snapshot addSubview:snapshotPart];
+    }
+    
+    self.snapshotParts = snapshotParts;
+    self.snapshotIsFromPool = NO;
+    
+    return snapshot;
+}
+
+- (CGPoint)centerOfGroupSnapshotForRelease {
+    
+    UIView *partForCaughtItem = self.snapshotParts.firstObject;
+    if (partForCaughtItem == nil || (id)partForCaughtItem == [NSNull null]) return self.centerOfHiddenCell;
+    
+    CGRect bounds = self.snapshot.bounds;
+    
+    return CGPointMake(self.centerOfHiddenCell.x - (partForCaughtItem.center.x - CGRectGetMidX(bounds)),
+                       self.centerOfHiddenCell.y - (partForCaughtItem.center.y - CGRectGetMidY(bounds)));
+}
+
+- (void)moveSnapshotPartsToHiddenItems {
+    
+    // Called in the release animation, after the snapshot has been moved. The items in the group
+    // aren't always arranged the same way as their targets, for example when the targets wrap onto
+    // another line, so each part goes to its own hidden item. Hidden items have no cell so their
+    // centers come from the layout.
+    
+    UIView *snapshot = self.snapshot;
+    
+    for (unsigned int i = 0; i < self.snapshotParts.count; i++) {
+        
+        UIView *snapshotPart = self.snapshotParts[i];
+        if ((id)snapshotPart == [NSNull null]) continue;
+        
+        NSIndexPath *indexPath = NSIndexPathFromSSExchangeIndexPath(_groupExchangeCore.displacedIndexPaths[i]);
+        CGPoint center = [self.collectionView layoutAttributesForItemAtIndexPath:indexPath].center;
+        
+        snapshotPart.center = CGPointMake(center.x - snapshot.center.x + CGRectGetMidX(snapshot.bounds),
+                                          center.y - snapshot.center.y + CGRectGetMidY(snapshot.bounds));
+    }
+}
+
+- (NSArray *)cellsForOriginalLocations {
+    
+    // The dimmed cells, restored in the release animation.
+    
+    NSMutableArray *cells = [NSMutableArray array];
+    
+    if ([self isGroupExchangeTransaction]) {
+        for (unsigned int i = 0; i < _groupExchangeCore.numberOfItems; i++) {
+            UICollectionViewCell *cell = [self.collectionView cellForItemAtIndexPath:NSIndexPathFromSSExchangeIndexPath(_groupExchangeCore.originalIndexPaths[i])];
+            if (cell) [cells addObject:cell];
+        }
+    } else {
+        UICollectionViewCell *cell = [self.collectionView cellForItemAtIndexPath:self.indexPathForDimmedItem];
+        if (cell) [cells addObject:cell];
+    }
+    
+    return cells;
+}
+
+
+
+//--------------------------------------------
+#pragma mark - Displacement permissions...
+
+// The delegate's canDisplaceItemAtIndexPath: can be expensive and is asked about an item every
+// time the user drags over it. Its answers are remembered in two bitmaps, so each is one shift and
+// mask to look up, for the rest of the exchange transaction. The delegate can also answer for all
+// the visible items at once at the beginning, and tell the exchange controller to forget answers
+// when its model changes.
+
+- (void)prepareDisplacementPermissions {
+    
+    // The bitmaps are sized for the numbers of items in each section so they are created again
+    // when those change. Otherwise emptying them takes time in proportion to the answers they hold.
+    
+    UICollectionView *collectionView = self.collectionView;
+    NSInteger numberOfSections = [collectionView numberOfSections];
+    
+    size_t *numberOfItemsInSections = malloc(MAX(numberOfSections, 1) * sizeof(size_t));
+    if (numberOfItemsInSections == NULL) return;
+    
+    for (NSInteger section = 0; section < numberOfSections; section++) {
+        numberOfItemsInSections[section] = [collectionView numberOfItemsInSection:section];
+    }
+    
+    if (SSExchangeIndexPathSetHasNumbersOfItems(_displacementPermissionsChecked, numberOfItemsInSections, numberOfSections)) {
+        
+        SSExchangeIndexPathSetRemoveAll(_displacementPermissionsChecked);
+        SSExchangeIndexPathSetRemoveAll(_displacementPermissionsAllowed);
+        
+    } else {
+        
+        SSExchangeIndexPathSetFree(_displacementPermissionsChecked);
+        SSExchangeIndexPathSetFree(_displacementPermissionsAllowed);
+        _displacementPermissionsChecked = SSExchangeIndexPathSetCreate(numberOfItemsInSections, numberOfSections);
+        _displacementPermissionsAllowed = SSExchangeIndexPathSetCreate(numberOfItemsInSections, numberOfSections);
+    }
+    
+    free(numberOfItemsInSections);
+}
+
+- (void)prefetchDisplacementPermissionsForItemBeingDraggedFromIndexPath:(NSIndexPath *)indexPath {
+    
+    // Only for an ordinary exchange transaction. In a group each item displaced is matched with a
+    // different item being dragged.
+    
+    if ([self.delegate respondsToSelector:@selector(exchangeController:indexesOfItemsThatCanBeDisplacedAtIndexPaths:withItemBeingDraggedFromIndexPath:)] == NO) return;
+    
+    NSArray *indexPathsForVisibleItems = [self.collectionView indexPathsForVisibleItems];
+    
+    uint64_t startTimeOfDelegate = [self beginPhase:SSExchangePhaseDelegate];
+    NSIndexSet *indexes = [self.delegate exchangeController:self
+               indexesOfItemsThatCanBeDisplacedAtIndexPaths:indexPathsForVisibleItems
+                          withItemBeingDraggedFromIndexPath:indexPath];
+    [self endPhase:SSExchangePhaseDelegate startTime:startTimeOfDelegate];
+    
+    if (indexes == nil) return;
+    
+    [indexPathsForVisibleItems enumerateObjectsUsingBlock:^(NSIndexPath *indexPathForVisibleItem, NSUInteger index, BOOL *stop) {
+        [self rememberDisplacementPermission:[indexes containsIndex:index] forIndexPath:SSExchangeIndexPathFromNSIndexPath(indexPathForVisibleItem)];
+    }];
+}
+
+- (BOOL)getDisplacementPermission:(BOOL *)permission forIndexPath:(SSExchangeIndexPath)indexPath {
+    
+    if (SSExchangeIndexPathSetContainsIndexPath(_displacementPermissionsChecked, indexPath) == NO) return NO;
+    
+    *permission = SSExchangeIndexPathSetContainsIndexPath(_displacementPermissionsAllowed, indexPath);
+    return YES;
+}
+
+- (void)rememberDisplacementPermission:(BOOL)permission forIndexPath:(SSExchangeIndexPath)indexPath {
+    
+    // An index path the bitmaps can't hold, past the end of a section for example, isn't
+    // remembered and is asked about each time. The allowed bitmap is set first so a failure
+    // there can't leave a YES looking like a NO.
+    
+    if (permission && SSExchangeIndexPathSetAdd(_displacementPermissionsAllowed, indexPath) == NO) return;
+    SSExchangeIndexPathSetAdd(_displacementPermissionsChecked, indexPath);
+}
+
+- (void)invalidateDisplacementPermissions {
+    
+    [self prepareDisplacementPermissions];
+}
+
+- (void)invalidateDisplacementPermissionForItemAtIndexPath:(NSIndexPath *)indexPath {
+    
+    // For a group the answers are kept by the first item displaced but are about the whole group,
+    // so any of them could depend on the item at indexPath.
+    
+    if ([self isGroupExchangeTransaction]) {
+        [self invalidateDisplacementPermissions];
+        return;
+    }
+    
+    SSExchangeIndexPath exchangeIndexPath = SSExchangeIndexPathFromNSIndexPath(indexPath);
+    SSExchangeIndexPathSetRemove(_displacementPermissionsChecked, exchangeIndexPath);
+    SSExchangeIndexPathSetRemove(_displacementPermissionsAllowed, exchangeIndexPath);
+}
+
+
+
+//-----------------------------
+#pragma mark - Instrumentation...
+
+// Each phase is timed only when there is somewhere to record it. Without instrumentation the cost
+// is one property read per phase. Refer to SSCollectionViewExchangeInstrumentation.h.
+
+- (uint64_t)beginPhase:(SSExchangePhase)phase {
+    
+    return (self.instrumentation)? SSExchangeInstrumentationBeginPhase(phase) : 0;
+}
+
+- (void)endPhase:(SSExchangePhase)phase startTime:(uint64_t)startTime {
+    
+    if (startTime == 0) return;
+    SSExchangeInstrumentationEndPhase(self.instrumentation, phase, startTime);
+}
+
+- (void)endPhaseOffMainThread:(SSExchangePhase)phase startTime:(uint64_t)startTime instrumentation:(id<SSCollectionViewExchangeInstrumentationSink>)instrumentation {
+    
+    // Sinks are only used on the main thread, so the sample is timed here and recorded there.
+    if (startTime == 0) return;
+    SSExchangeSample sample = SSExchangeInstrumentationMakeSample(phase, startTime);
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [instrumentation recordSample:sample];
+    });
+}
+
+
+
+//---------------------------------------
+#pragma mark - Prerendering snapshots...
+
+- (void)prerenderSnapshotsForVisibleItems {
+    
+    if ([self delegateProvidesContentVersions] == NO) return;
+    if ([self.delegate respondsToSelector:@selector(exchangeController:snapshotForCell:)]) return;
+    
+    self.indexPathsToPrerender = [[self.collectionView indexPathsForVisibleItems] mutableCopy];
+    [self schedulePrerendering];
+}
+
+- (void)schedulePrerendering {
+    
+    // Rendering reads the cell's layer tree so it has to happen on the main thread. To keep
+    // scrolling and touches responsive one cell is rendered per pass of the main queue. Nothing
+    // is rendered during an exchange transaction, when cells are moving and the main thread is
+    // busy. Prerendering picks up again when the transaction is over.
+    
+    if (self.prerenderingIsScheduled || self.indexPathsToPrerender.count == 0 || self.exchangeTransactionInProgress) return;
+    
+    self.prerenderingIsScheduled = YES;
+    
+    __weak SSCollectionViewExchangeController *weakSelf = self;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        weakSelf.prerenderingIsScheduled = NO;
+        [weakSelf prerenderNextSnapshot];
+        [weakSelf schedulePrerendering];
+    });
+}
+
+- (void)prerenderNextSnapshot {
+    
+    if (self.indexPathsToPrerender.count == 0 || self.exchangeTransactionInProgress) return;
+    
+    NSIndexPath *indexPath = [self.indexPathsToPrerender lastObject];
+    [self.indexPathsToPrerender removeLastObject];
+    
+    UICollectionViewCell *cell = [self.collectionView cellForItemAtIndexPath:indexPath];
+    if (cell && [self cachedImageForCell:cell atIndexPath:indexPath] == nil) {
+        [self cacheImage:[self renderedImageForCell:cell] forItemAtIndexPath:indexPath];
+    }
+}
+
+- (void)animateCatch:(UIView *)snapshot {
+    
+    if ([self.delegate respondsToSelector:@selector(animateCatchForExchangeController:withSnapshot:)]) {
+        
+        [self.delegate animateCatchForExchangeController:self withSnapshot:snapshot];
+        
+    } else {
+        
         NSTimeInterval duration = self.animationDuration;
         CGFloat blinkToScale = self.blinkToScaleForCatch;
         CGFloat finalScale = 1.0;
@@ -563,14 +1667,16 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
     
     self.longPressGestureRecognizer.enabled = NO;
 
-    UICollectionViewCell *cellForOriginalLocation = [self.collectionView cellForItemAtIndexPath:self.originalIndexPathForDraggedItem];
+    // For a group, the snapshot goes wherever lines the caught item's part up with the hidden cell.
+    CGPoint toPoint = ([self isGroupExchangeTransaction])? [self centerOfGroupSnapshotForRelease] : self.centerOfHiddenCell;
+    NSArray *cellsForOriginalLocations = [self cellsForOriginalLocations];
     
     if ([self.delegate respondsToSelector:@selector(animateReleaseForExchangeController:withSnapshot:toPoint:originalIndexPathForDraggedItem:completionBlock:)]) {
         
         [self.delegate animateReleaseForExchangeController:self
                                               withSnapshot:self.snapshot
-                                                   toPoint:self.centerOfHiddenCell
-                           originalIndexPathForDraggedItem:self.originalIndexPathForDraggedItem
+                                                   toPoint:toPoint
+                           originalIndexPathForDraggedItem:self.indexPathForDimmedItem
                                            completionBlock:self.postReleaseCompletionBlock];
         
     } else {
@@ -580,8 +1686,11 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
         CGFloat finalScale = 1.0;
         
         [UIView animateWithDuration:duration animations:^ {
-            self.snapshot.center = self.centerOfHiddenCell;
-            cellForOriginalLocation.alpha = 1.0;
+            self.snapshot.center = toPoint;
+            [self moveSnapshotPartsToHiddenItems];
+            for (UICollectionViewCell *cell in cellsForOriginalLocations) {
+                cell.alpha = 1.0;
+            }
         } completion:^(BOOL finished) {
             
             [UIView animateWithDuration:duration animations:^ {
@@ -598,16 +1707,6 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
     }
 }
 
-- (BOOL)isOverSameItemAtIndexPath:(NSIndexPath *)indexPath {
-    
-    return [indexPath isEqual:self.originalIndexPathForDisplacedItem];
-}
-
-- (BOOL)isBackToStartingItemAtIndexPath:(NSIndexPath *)indexPath {
-    
-    return [indexPath isEqual:self.originalIndexPathForDraggedItem];
-}
-
 - (UIView *)snapshotForView:(UIView *)view
        withBackgroundColor:(UIColor *)backgroundColor
                       alpha:(float)alpha {
@@ -623,13 +1722,12 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
     
 }
 
-- (void)performBlock:(void (^) ())block afterDelay:(double)delay {
+- (void)resetExchangeCore {
     
-    double delayInSeconds = delay;
-    dispatch_time_t popTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delayInSeconds * NSEC_PER_SEC));
-    dispatch_after(popTime, dispatch_get_main_queue(), ^(void){
-        block();
-    });
+    SSExchangeCoreReset(&_exchangeCore);
+    SSExchangeGroupCoreReset(&_groupExchangeCore);
+    _numberOfCommittedExchanges = 0;
+    [self updateIndexPathsForHidingAndDimming];
 }
 
 - (PostReleaseCompletionBlock)postReleaseCompletionBlock {
@@ -638,15 +1736,14 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
     
     return ^ void (NSTimeInterval duration) {
         
-        weakSelf.originalIndexPathForDisplacedItem = nil;
-        weakSelf.originalIndexPathForDraggedItem = nil;
-        [weakSelf.collectionView.collectionViewLayout invalidateLayout];
+        [weakSelf resetExchangeCore];
+        [weakSelf.coordinator exchangeControllerDidFinishRelease:weakSelf];
+        [weakSelf invalidateLayoutForHidingAndDimming];
         
         [UIView animateWithDuration:duration animations:^ {
             weakSelf.snapshot.alpha = 0.0;
         } completion:^(BOOL finished) {
-            [weakSelf.snapshot removeFromSuperview];
-            weakSelf.snapshot = nil;
+            [weakSelf removeSnapshot];
             self.longPressGestureRecognizer.enabled = YES;
         }];
     };
@@ -654,25 +1751,37 @@ typedef NS_ENUM(NSInteger, ExchangeEventType) {
 
 
 
-//--------------------------------------------------------------
-#pragma mark - SSCollectionViewExchangeLayoutDelegate methods...
+//-------------------------------------------------------------
+#pragma mark - Coordinating with other exchange controllers...
 
-- (NSIndexPath *)indexPathForItemToHide {
-    
-    return self.originalIndexPathForDisplacedItem;
-    
-    // Return nil if you don't want to hide.
-    // This can be useful during testing to ensure that the item
-    // you're dragging around is properly following.
+// Called by SSCollectionViewExchangeCoordinator when it takes an exchange transaction over. The
+// other methods it uses are declared there.
 
+- (void)getExchangeCore:(SSExchangeCore *)exchangeCore {
+    
+    *exchangeCore = _exchangeCore;
 }
 
-- (NSIndexPath *)indexPathForItemToDim {
-    
-    return self.originalIndexPathForDraggedItem;
 
-    // As above return nil if you don't want to dim.
 
+//--------------------------------------------------------------
+#pragma mark - SSCollectionViewExchangeLayoutDelegate methods...
+
+- (void)getItemsToHide:(SSExchangeIndexPathSet *)itemsToHide itemsToDim:(SSExchangeIndexPathSet *)itemsToDim {
+    
+    // Comment out the adds to itemsToHide if you don't want to hide.
+    // This can be useful during testing to ensure that the items
+    // you're dragging around are properly following. As for dimming.
+    
+    // The committed exchanges, which is what the collection view shows, rather than the exchange
+    // core's, which may be ahead of it. Unless a coordinator has taken the exchange transaction over.
+    
+    if ([self.coordinator getItemsToHide:itemsToHide itemsToDim:itemsToDim forExchangeController:self]) return;
+    
+    for (unsigned int i = 0; i < _numberOfCommittedExchanges; i++) {
+        SSExchangeIndexPathSetAdd(itemsToHide, _committedExchanges[i].indexPath1);
+        SSExchangeIndexPathSetAdd(itemsToDim, _committedExchanges[i].indexPath2);
+    }
 }
 
 - (CGFloat)alphaForItemToDim {
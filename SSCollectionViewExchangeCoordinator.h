@@ -0,0 +1,104 @@
+//
+//  SSCollectionViewExchangeCoordinator.h
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#import <UIKit/UIKit.h>
+
+@class SSCollectionViewExchangeCoordinator;
+@class SSCollectionViewExchangeController;
+
+
+// SSCollectionViewExchangeCoordinator lets an exchange transaction that began in one exchange
+// controller's collection view carry on into another's, for views that show several collection
+// views side by side.
+//
+// Each exchange controller handles its own exchange transactions as usual. When the user's finger
+// drags an item over another collection view whose exchange controller has been added to the same
+// coordinator, the coordinator takes over the rest of the transaction: the snapshot moves into
+// whichever collection view is under the finger, the dragged item can be exchanged with items in
+// any of them, and the exchange controller's release or cancel is completed by the coordinator.
+// Items that change collection view are deleted from one and inserted into the other in batch
+// updates, so neither collection view is reloaded.
+//
+// The coordinator updates the model itself, with
+// exchangeObjectsInArrays:withSwaps:count: from NSMutableArray+SSCollectionViewExchangeControllerAdditions.h,
+// using the arrays its delegate gives it for each section of each collection view. These must be
+// the same arrays the exchange controllers' delegates update. Group exchange transactions stay
+// within their own collection view.
+
+
+@protocol SSCollectionViewExchangeCoordinatorDelegate <NSObject>
+
+@required
+
+- (NSMutableArray *)exchangeCoordinator:(SSCollectionViewExchangeCoordinator *)exchangeCoordinator
+                        arrayForSection:(NSInteger)section
+                   ofExchangeController:(SSCollectionViewExchangeController *)exchangeController;
+
+
+@optional
+
+- (void)            exchangeCoordinator:(SSCollectionViewExchangeCoordinator *)exchangeCoordinator
+             didExchangeItemAtIndexPath:(NSIndexPath *)indexPath1
+                   inExchangeController:(SSCollectionViewExchangeController *)exchangeController1
+                    withItemAtIndexPath:(NSIndexPath *)indexPath2
+                   inExchangeController:(SSCollectionViewExchangeController *)exchangeController2;
+
+
+- (void)exchangeCoordinatorDidFinishExchangeEvent:(SSCollectionViewExchangeCoordinator *)exchangeCoordinator;
+
+
+- (void)exchangeCoordinatorDidFinishExchangeTransaction:(SSCollectionViewExchangeCoordinator *)exchangeCoordinator
+                                         withIndexPath1:(NSIndexPath *)indexPath1
+                                   inExchangeController:(SSCollectionViewExchangeController *)exchangeController1
+                                             indexPath2:(NSIndexPath *)indexPath2
+                                   inExchangeController:(SSCollectionViewExchangeController *)exchangeController2;
+
+
+- (void)exchangeCoordinatorDidCancelExchangeTransaction:(SSCollectionViewExchangeCoordinator *)exchangeCoordinator;
+
+
+- (BOOL)            exchangeCoordinator:(SSCollectionViewExchangeCoordinator *)exchangeCoordinator
+             canDisplaceItemAtIndexPath:(NSIndexPath *)indexPathOfItemToDisplace
+                   inExchangeController:(SSCollectionViewExchangeController *)exchangeControllerOfItemToDisplace
+      withItemBeingDraggedFromIndexPath:(NSIndexPath *)indexPathOfItemBeingDragged
+                   inExchangeController:(SSCollectionViewExchangeController *)exchangeControllerOfItemBeingDragged;
+
+@end
+
+
+@interface SSCollectionViewExchangeCoordinator : NSObject
+
+- (instancetype)initWithDelegate:(id<SSCollectionViewExchangeCoordinatorDelegate>)delegate;
+
+- (void)addExchangeController:(SSCollectionViewExchangeController *)exchangeController;
+- (void)removeExchangeController:(SSCollectionViewExchangeController *)exchangeController;
+
+@property (strong, nonatomic, readonly) NSArray                         *exchangeControllers;
+
+@property (nonatomic, assign, readonly) BOOL                            exchangeTransactionInProgress;
+
+@end
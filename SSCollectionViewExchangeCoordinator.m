@@ -0,0 +1,550 @@
+//
+//  SSCollectionViewExchangeCoordinator.m
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#import "SSCollectionViewExchangeCoordinator.h"
+#import "SSCollectionViewExchangeController.h"
+#import "SSCollectionViewExchangeCore.h"
+#import "SSCollectionViewExchangeIndexPathSet.h"
+#import "SSCollectionViewExchangeSnapshotCache.h"
+#import "NSMutableArray+SSCollectionViewExchangeControllerAdditions.h"
+
+
+
+// The parts of the exchange controller the coordinator works with. They are implemented in
+// SSCollectionViewExchangeController.m, in the Coordinating with other exchange controllers section.
+@interface SSCollectionViewExchangeController (SSCollectionViewExchangeCoordinator)
+
+@property (weak, nonatomic)     SSCollectionViewExchangeCoordinator     *coordinator;
+@property (weak, nonatomic)     UICollectionView                        *collectionView;
+@property (strong, nonatomic)   UIView                                  *snapshot;
+@property (nonatomic)           CGPoint                                 locationInCollectionView;
+@property (nonatomic)           CGPoint                                 centerOfHiddenCell;
+@property (strong, nonatomic)   SSCollectionViewExchangeSnapshotCache   *snapshotCache;
+
+- (BOOL)isGroupExchangeTransaction;
+- (void)getExchangeCore:(SSExchangeCore *)exchangeCore;
+- (void)commitExchanges;
+- (void)stopAutoScroll;
+- (void)invalidateLayoutForHidingAndDimming;
+
+@end
+
+
+
+@interface SSCollectionViewExchangeCoordinator () {
+
+    // Once the coordinator takes an exchange transaction over it has its own exchange core, which
+    // carries on from the exchange controller's. Its index paths are global: the sections of each
+    // collection view follow those of the collection views before it. Refer to the Global index
+    // paths section.
+    SSExchangeCore _exchangeCore;
+}
+
+@property (weak, nonatomic)             id<SSCollectionViewExchangeCoordinatorDelegate> delegate;
+
+@property (strong, nonatomic)           NSHashTable                     *exchangeControllerTable;           // the exchange controllers that were added, held weakly
+
+@property (strong, nonatomic)           SSCollectionViewExchangeController *sourceExchangeController;       // the exchange controller whose long press is being coordinated, from the take over until the end of its release
+@property (strong, nonatomic)           NSArray                         *transactionExchangeControllers;    // the exchange controllers taking part, the source first, in the order of their global sections
+@property (strong, nonatomic)           NSArray                         *firstGlobalSections;               // NSNumbers, the first global section of each of transactionExchangeControllers, plus the total number of sections
+@property (strong, nonatomic)           NSArray                         *arrays;                            // the delegate's array for each global section
+
+@property (nonatomic, assign, readwrite) BOOL                           exchangeTransactionInProgress;      // exposed as readonly in the header
+
+- (BOOL)delegateAllowsDisplacingItemAtIndexPath:(SSExchangeIndexPath)indexPathForItemToDisplace
+              withItemBeingDraggedFromIndexPath:(SSExchangeIndexPath)indexPathForItemBeingDragged;
+
+@end
+
+
+
+static bool SSExchangeCoordinatorCanDisplace(SSExchangeIndexPath indexPathOfItemToDisplace,
+                                             SSExchangeIndexPath indexPathOfItemBeingDragged,
+                                             void *context) {
+
+    SSCollectionViewExchangeCoordinator *exchangeCoordinator = (__bridge SSCollectionViewExchangeCoordinator *)context;
+    return [exchangeCoordinator delegateAllowsDisplacingItemAtIndexPath:indexPathOfItemToDisplace
+                                      withItemBeingDraggedFromIndexPath:indexPathOfItemBeingDragged];
+}
+
+
+
+@implementation SSCollectionViewExchangeCoordinator
+
+- (instancetype)initWithDelegate:(id<SSCollectionViewExchangeCoordinatorDelegate>)delegate {
+
+    self = [super init];
+    if (self) {
+        _delegate = delegate;
+        _exchangeControllerTable = [NSHashTable weakObjectsHashTable];
+        SSExchangeCoreReset(&_exchangeCore);
+    }
+    return self;
+}
+
+- (void)addExchangeController:(SSCollectionViewExchangeController *)exchangeController {
+
+    exchangeController.coordinator = self;
+    [self.exchangeControllerTable addObject:exchangeController];
+}
+
+- (void)removeExchangeController:(SSCollectionViewExchangeController *)exchangeController {
+
+    if (exchangeController.coordinator == self) {
+        exchangeController.coordinator = nil;
+    }
+    [self.exchangeControllerTable removeObject:exchangeController];
+}
+
+- (NSArray *)exchangeControllers {
+
+    return self.exchangeControllerTable.allObjects;
+}
+
+
+
+//-----------------------------------------------------------------
+#pragma mark - Called by the exchange controllers during a long press...
+
+- (BOOL)exchangeControllerDidDrag:(SSCollectionViewExchangeController *)exchangeController {
+
+    // Returns YES if the coordinator has taken the exchange transaction over, in which case the
+    // exchange controller leaves the exchange event to the coordinator. It takes over the first
+    // time the user's finger is over another collection view, and keeps it until the release.
+
+    if (self.exchangeTransactionInProgress) {
+        if (exchangeController != self.sourceExchangeController) return NO;
+        [self performExchangeEvent];
+        return YES;
+    }
+
+    if (self.sourceExchangeController != nil || [exchangeController isGroupExchangeTransaction]) return NO;
+
+    SSCollectionViewExchangeController *exchangeControllerUnderFinger = [self exchangeControllerUnderFingerOfExchangeController:exchangeController
+                                                                                                          exchangeControllers:self.exchangeControllers];
+    if (exchangeControllerUnderFinger == nil || exchangeControllerUnderFinger == exchangeController) return NO;
+
+    if ([self takeOverExchangeTransactionFromExchangeController:exchangeController] == NO) return NO;
+
+    [self performExchangeEvent];
+    return YES;
+}
+
+- (BOOL)finishExchangeTransactionForExchangeController:(SSCollectionViewExchangeController *)exchangeController {
+
+    // Returns YES if the coordinator has the exchange transaction, in which case it reports the final
+    // exchange and gets the snapshot ready for the exchange controller's release animation.
+
+    if (self.exchangeTransactionInProgress == NO || exchangeController != self.sourceExchangeController) return NO;
+
+    SSExchangeSwap finalExchange = SSExchangeCoreFinish(&_exchangeCore);
+
+    if ([self.delegate respondsToSelector:@selector(exchangeCoordinatorDidFinishExchangeTransaction:withIndexPath1:inExchangeController:indexPath2:inExchangeController:)]) {
+
+        SSCollectionViewExchangeController *exchangeController1, *exchangeController2;
+        NSIndexPath *indexPath1 = [self indexPathForGlobalIndexPath:finalExchange.indexPath1 exchangeController:&exchangeController1];
+        NSIndexPath *indexPath2 = [self indexPathForGlobalIndexPath:finalExchange.indexPath2 exchangeController:&exchangeController2];
+
+        [self.delegate exchangeCoordinatorDidFinishExchangeTransaction:self
+                                                        withIndexPath1:indexPath1
+                                                  inExchangeController:exchangeController1
+                                                            indexPath2:indexPath2
+                                                  inExchangeController:exchangeController2];
+    }
+
+    // The release animation takes the snapshot to the hidden item, so it has to be in the hidden
+    // item's collection view. Hidden items have no cell so the center comes from the layout.
+    SSCollectionViewExchangeController *exchangeControllerForHiddenItem;
+    NSIndexPath *indexPathForHiddenItem = [self indexPathForGlobalIndexPath:finalExchange.indexPath1 exchangeController:&exchangeControllerForHiddenItem];
+    [self moveSnapshotToExchangeController:exchangeControllerForHiddenItem];
+    exchangeController.centerOfHiddenCell = [exchangeControllerForHiddenItem.collectionView layoutAttributesForItemAtIndexPath:indexPathForHiddenItem].center;
+
+    [self removeAllCachedImages];
+    self.exchangeTransactionInProgress = NO;
+    return YES;
+}
+
+- (BOOL)cancelExchangeTransactionForExchangeController:(SSCollectionViewExchangeController *)exchangeController {
+
+    // Returns YES if the coordinator has the exchange transaction, in which case it returns the model
+    // and the collection views to their state before the transaction.
+
+    if (self.exchangeTransactionInProgress == NO || exchangeController != self.sourceExchangeController) return NO;
+
+    SSExchangeSwap undoExchange;
+    BOOL mustUndo = SSExchangeCoreCancel(&_exchangeCore, &undoExchange);
+
+    if (mustUndo) {
+        [self didExchangeItemsWithSwaps:&undoExchange count:1];
+    }
+
+    if ([self.delegate respondsToSelector:@selector(exchangeCoordinatorDidCancelExchangeTransaction:)]) {
+        [self.delegate exchangeCoordinatorDidCancelExchangeTransaction:self];
+    }
+
+    // Only the two items in the undo exchange differ from the model, and they were also the hidden
+    // and dimmed items, so reloading them restores the collection views.
+    if (mustUndo) {
+
+        SSCollectionViewExchangeController *exchangeController1, *exchangeController2;
+        NSIndexPath *indexPath1 = [self indexPathForGlobalIndexPath:undoExchange.indexPath1 exchangeController:&exchangeController1];
+        NSIndexPath *indexPath2 = [self indexPathForGlobalIndexPath:undoExchange.indexPath2 exchangeController:&exchangeController2];
+
+        if (exchangeController1 == exchangeController2) {
+            [exchangeController1.collectionView performBatchUpdates:^{
+                [exchangeController1.collectionView reloadItemsAtIndexPaths:@[indexPath1, indexPath2]];
+            } completion:nil];
+        } else {
+            [exchangeController1.collectionView performBatchUpdates:^{
+                [exchangeController1.collectionView reloadItemsAtIndexPaths:@[indexPath1]];
+            } completion:nil];
+            [exchangeController2.collectionView performBatchUpdates:^{
+                [exchangeController2.collectionView reloadItemsAtIndexPaths:@[indexPath2]];
+            } completion:nil];
+        }
+    }
+
+    [self removeAllCachedImages];
+    [self endExchangeTransaction];
+    return YES;
+}
+
+- (void)exchangeControllerDidFinishRelease:(SSCollectionViewExchangeController *)exchangeController {
+
+    if (exchangeController != self.sourceExchangeController) return;
+    [self endExchangeTransaction];
+}
+
+- (BOOL)getItemsToHide:(SSExchangeIndexPathSet *)itemsToHide
+            itemsToDim:(SSExchangeIndexPathSet *)itemsToDim
+ forExchangeController:(SSCollectionViewExchangeController *)exchangeController {
+
+    // Returns YES if the coordinator has the exchange transaction, including its release, and
+    // exchangeController is taking part. The exchange controller's own exchange core is out of
+    // date from the take over on.
+
+    if (self.sourceExchangeController == nil) return NO;
+
+    NSUInteger index = [self.transactionExchangeControllers indexOfObjectIdenticalTo:exchangeController];
+    if (index == NSNotFound) return NO;
+
+    int32_t firstSection = [self.firstGlobalSections[index] intValue];
+    int32_t endSection = [self.firstGlobalSections[index + 1] intValue];
+
+    SSExchangeIndexPath indexPathForHiddenItem = _exchangeCore.originalIndexPathForDisplacedItem;
+    SSExchangeIndexPath indexPathForDimmedItem = _exchangeCore.originalIndexPathForDraggedItem;
+
+    if (indexPathForHiddenItem.section >= firstSection && indexPathForHiddenItem.section < endSection) {
+        SSExchangeIndexPathSetAdd(itemsToHide, SSExchangeIndexPathMake(indexPathForHiddenItem.section - firstSection, indexPathForHiddenItem.item));
+    }
+
+    if (indexPathForDimmedItem.section >= firstSection && indexPathForDimmedItem.section < endSection) {
+        SSExchangeIndexPathSetAdd(itemsToDim, SSExchangeIndexPathMake(indexPathForDimmedItem.section - firstSection, indexPathForDimmedItem.item));
+    }
+
+    return YES;
+}
+
+
+
+//-----------------------------------------
+#pragma mark - Coordinated transactions...
+
+- (BOOL)takeOverExchangeTransactionFromExchangeController:(SSCollectionViewExchangeController *)exchangeController {
+
+    // The source comes first so its global index paths are its own and its exchange core can be
+    // carried on as it is. Only collection views in the same window can be dragged to.
+
+    NSMutableArray *transactionExchangeControllers = [NSMutableArray arrayWithObject:exchangeController];
+    UIWindow *window = exchangeController.collectionView.window;
+
+    for (SSCollectionViewExchangeController *otherExchangeController in self.exchangeControllers) {
+        if (otherExchangeController != exchangeController && otherExchangeController.collectionView.window == window) {
+            [transactionExchangeControllers addObject:otherExchangeController];
+        }
+    }
+
+    NSMutableArray *firstGlobalSections = [NSMutableArray arrayWithCapacity:transactionExchangeControllers.count + 1];
+    NSMutableArray *arrays = [NSMutableArray array];
+
+    for (SSCollectionViewExchangeController *transactionExchangeController in transactionExchangeControllers) {
+
+        [firstGlobalSections addObject:@(arrays.count)];
+
+        NSInteger numberOfSections = [transactionExchangeController.collectionView numberOfSections];
+        for (NSInteger section = 0; section < numberOfSections; section++) {
+            NSMutableArray *array = [self.delegate exchangeCoordinator:self arrayForSection:section ofExchangeController:transactionExchangeController];
+            if (array == nil) return NO;
+            [arrays addObject:array];
+        }
+    }
+    [firstGlobalSections addObject:@(arrays.count)];
+
+    // The model and the collection view must reflect the exchange core the coordinator carries on from.
+    [exchangeController commitExchanges];
+    [exchangeController stopAutoScroll];
+    [exchangeController getExchangeCore:&_exchangeCore];
+
+    self.sourceExchangeController = exchangeController;
+    self.transactionExchangeControllers = transactionExchangeControllers;
+    self.firstGlobalSections = firstGlobalSections;
+    self.arrays = arrays;
+    self.exchangeTransactionInProgress = YES;
+
+    // Cached images follow their items through exchanges within a collection view, not between them.
+    [self removeAllCachedImages];
+
+    return YES;
+}
+
+- (void)endExchangeTransaction {
+
+    SSExchangeCoreReset(&_exchangeCore);
+
+    NSArray *transactionExchangeControllers = self.transactionExchangeControllers;
+
+    self.sourceExchangeController = nil;
+    self.transactionExchangeControllers = nil;
+    self.firstGlobalSections = nil;
+    self.arrays = nil;
+    self.exchangeTransactionInProgress = NO;
+
+    for (SSCollectionViewExchangeController *exchangeController in transactionExchangeControllers) {
+        [exchangeController invalidateLayoutForHidingAndDimming];
+    }
+}
+
+- (void)performExchangeEvent {
+
+    SSCollectionViewExchangeController *sourceExchangeController = self.sourceExchangeController;
+    SSCollectionViewExchangeController *exchangeControllerUnderFinger = [self exchangeControllerUnderFingerOfExchangeController:sourceExchangeController
+                                                                                                          exchangeControllers:self.transactionExchangeControllers];
+    SSExchangeIndexPath indexPath = SSExchangeIndexPathNone;
+
+    if (exchangeControllerUnderFinger) {
+
+        [self moveSnapshotToExchangeController:exchangeControllerUnderFinger];
+
+        UICollectionView *collectionView = exchangeControllerUnderFinger.collectionView;
+        CGPoint location = [sourceExchangeController.collectionView convertPoint:sourceExchangeController.locationInCollectionView toView:collectionView];
+        indexPath = [self globalIndexPathForIndexPath:[collectionView indexPathForItemAtPoint:location] exchangeController:exchangeControllerUnderFinger];
+    }
+
+    SSExchangeEventType exchangeEventType = SSExchangeCoreEventType(&_exchangeCore, indexPath, SSExchangeCoordinatorCanDisplace, (__bridge void *)self);
+
+    switch (exchangeEventType) {
+
+        case SSExchangeEventTypeNothingToExchange:
+        case SSExchangeEventTypeCannotDisplaceItem:
+            break;
+
+        case SSExchangeEventTypeDraggedFromStartingItem:
+        case SSExchangeEventTypeDraggedToOtherItem:
+        case SSExchangeEventTypeDraggedToStartingItem: {
+
+            SSExchangeEvent event;
+            SSExchangeCorePerformEventType(&_exchangeCore, exchangeEventType, &event);
+
+            // Model...
+            [self didExchangeItemsWithSwaps:event.swaps count:event.numberOfSwaps];
+            if ([self.delegate respondsToSelector:@selector(exchangeCoordinatorDidFinishExchangeEvent:)]) {
+                [self.delegate exchangeCoordinatorDidFinishExchangeEvent:self];
+            }
+
+            // View...
+            [self performBatchUpdatesWithMoves:event.moves count:event.numberOfMoves];
+            break;
+        }
+    }
+}
+
+- (void)didExchangeItemsWithSwaps:(const SSExchangeSwap *)swaps count:(unsigned int)numberOfSwaps {
+
+    // The arrays are indexed by global section so the swaps apply as they are, within one array or
+    // between two.
+
+    [NSMutableArray exchangeObjectsInArrays:self.arrays withSwaps:swaps count:numberOfSwaps];
+
+    if ([self.delegate respondsToSelector:@selector(exchangeCoordinator:didExchangeItemAtIndexPath:inExchangeController:withItemAtIndexPath:inExchangeController:)] == NO) return;
+
+    for (unsigned int i = 0; i < numberOfSwaps; i++) {
+
+        SSCollectionViewExchangeController *exchangeController1, *exchangeController2;
+        NSIndexPath *indexPath1 = [self indexPathForGlobalIndexPath:swaps[i].indexPath1 exchangeController:&exchangeController1];
+        NSIndexPath *indexPath2 = [self indexPathForGlobalIndexPath:swaps[i].indexPath2 exchangeController:&exchangeController2];
+
+        [self.delegate exchangeCoordinator:self
+                didExchangeItemAtIndexPath:indexPath1
+                      inExchangeController:exchangeController1
+                       withItemAtIndexPath:indexPath2
+                      inExchangeController:exchangeController2];
+    }
+}
+
+- (void)performBatchUpdatesWithMoves:(const SSExchangeMove *)moves count:(unsigned int)numberOfMoves {
+
+    // A collection view can only move items within itself. An item that moves to another
+    // collection view is deleted from its own and inserted into the other. Every position keeps
+    // its number of items so the collection views don't need reloading. Each collection view the
+    // moves touch gets one batch update.
+
+    for (SSCollectionViewExchangeController *exchangeController in self.transactionExchangeControllers) {
+
+        NSMutableArray *fromIndexPaths = [NSMutableArray array];
+        NSMutableArray *toIndexPaths = [NSMutableArray array];
+        NSMutableArray *indexPathsToDelete = [NSMutableArray array];
+        NSMutableArray *indexPathsToInsert = [NSMutableArray array];
+
+        for (unsigned int i = 0; i < numberOfMoves; i++) {
+
+            SSCollectionViewExchangeController *fromExchangeController, *toExchangeController;
+            NSIndexPath *fromIndexPath = [self indexPathForGlobalIndexPath:moves[i].fromIndexPath exchangeController:&fromExchangeController];
+            NSIndexPath *toIndexPath = [self indexPathForGlobalIndexPath:moves[i].toIndexPath exchangeController:&toExchangeController];
+
+            if (fromExchangeController == exchangeController && toExchangeController == exchangeController) {
+                [fromIndexPaths addObject:fromIndexPath];
+                [toIndexPaths addObject:toIndexPath];
+            } else if (fromExchangeController == exchangeController) {
+                [indexPathsToDelete addObject:fromIndexPath];
+            } else if (toExchangeController == exchangeController) {
+                [indexPathsToInsert addObject:toIndexPath];
+            }
+        }
+
+        if (fromIndexPaths.count == 0 && indexPathsToDelete.count == 0 && indexPathsToInsert.count == 0) continue;
+
+        UICollectionView *collectionView = exchangeController.collectionView;
+
+        [collectionView performBatchUpdates:^{
+            [collectionView deleteItemsAtIndexPaths:indexPathsToDelete];
+            [collectionView insertItemsAtIndexPaths:indexPathsToInsert];
+            for (NSUInteger i = 0; i < fromIndexPaths.count; i++) {
+                [collectionView moveItemAtIndexPath:fromIndexPaths[i] toIndexPath:toIndexPaths[i]];
+            }
+        } completion:nil];
+    }
+
+    [self.sourceExchangeController.snapshot.superview bringSubviewToFront:self.sourceExchangeController.snapshot];
+}
+
+- (BOOL)delegateAllowsDisplacingItemAtIndexPath:(SSExchangeIndexPath)indexPathForItemToDisplace
+              withItemBeingDraggedFromIndexPath:(SSExchangeIndexPath)indexPathForItemBeingDragged {
+
+    if ([self.delegate respondsToSelector:@selector(exchangeCoordinator:canDisplaceItemAtIndexPath:inExchangeController:withItemBeingDraggedFromIndexPath:inExchangeController:)] == NO) return YES;
+
+    SSCollectionViewExchangeController *exchangeControllerOfItemToDisplace, *exchangeControllerOfItemBeingDragged;
+    NSIndexPath *indexPathOfItemToDisplace = [self indexPathForGlobalIndexPath:indexPathForItemToDisplace exchangeController:&exchangeControllerOfItemToDisplace];
+    NSIndexPath *indexPathOfItemBeingDragged = [self indexPathForGlobalIndexPath:indexPathForItemBeingDragged exchangeController:&exchangeControllerOfItemBeingDragged];
+
+    return [self.delegate exchangeCoordinator:self
+                   canDisplaceItemAtIndexPath:indexPathOfItemToDisplace
+                         inExchangeController:exchangeControllerOfItemToDisplace
+            withItemBeingDraggedFromIndexPath:indexPathOfItemBeingDragged
+                         inExchangeController:exchangeControllerOfItemBeingDragged];
+}
+
+
+
+//-----------------------------
+#pragma mark - Global index paths...
+
+// During a coordinated transaction every item in every collection view taking part has a global
+// index path. The sections of transactionExchangeControllers[i] are numbered from
+// firstGlobalSections[i]. The items keep their own numbers. That lets one exchange core, and one
+// list of arrays for exchangeObjectsInArrays:withSwaps:count:, cover all the collection views.
+
+- (SSExchangeIndexPath)globalIndexPathForIndexPath:(NSIndexPath *)indexPath exchangeController:(SSCollectionViewExchangeController *)exchangeController {
+
+    NSUInteger index = [self.transactionExchangeControllers indexOfObjectIdenticalTo:exchangeController];
+    if (indexPath == nil || index == NSNotFound) return SSExchangeIndexPathNone;
+
+    return SSExchangeIndexPathMake([self.firstGlobalSections[index] intValue] + (int32_t)indexPath.section, (int32_t)indexPath.item);
+}
+
+- (NSIndexPath *)indexPathForGlobalIndexPath:(SSExchangeIndexPath)globalIndexPath exchangeController:(SSCollectionViewExchangeController **)exchangeController {
+
+    for (NSUInteger i = 0; i < self.transactionExchangeControllers.count && SSExchangeIndexPathIsNone(globalIndexPath) == false; i++) {
+
+        int32_t endSection = [self.firstGlobalSections[i + 1] intValue];
+        if (globalIndexPath.section >= endSection) continue;
+
+        *exchangeController = self.transactionExchangeControllers[i];
+        return [NSIndexPath indexPathForItem:globalIndexPath.item inSection:globalIndexPath.section - [self.firstGlobalSections[i] intValue]];
+    }
+
+    *exchangeController = nil;
+    return nil;
+}
+
+
+
+//-----------------------------
+#pragma mark - Helper methods...
+
+- (SSCollectionViewExchangeController *)exchangeControllerUnderFingerOfExchangeController:(SSCollectionViewExchangeController *)exchangeController
+                                                                      exchangeControllers:(NSArray *)exchangeControllers {
+
+    // The exchange controller's own collection view wins where collection views overlap.
+
+    UICollectionView *collectionView = exchangeController.collectionView;
+    CGPoint location = exchangeController.locationInCollectionView;
+
+    if (CGRectContainsPoint(collectionView.bounds, location)) return exchangeController;
+
+    for (SSCollectionViewExchangeController *otherExchangeController in exchangeControllers) {
+
+        UICollectionView *otherCollectionView = otherExchangeController.collectionView;
+        if (otherCollectionView == nil || otherCollectionView.window != collectionView.window) continue;
+
+        if (CGRectContainsPoint(otherCollectionView.bounds, [collectionView convertPoint:location toView:otherCollectionView])) {
+            return otherExchangeController;
+        }
+    }
+
+    return nil;
+}
+
+- (void)moveSnapshotToExchangeController:(SSCollectionViewExchangeController *)exchangeController {
+
+    // Collection views clip to their bounds so the snapshot has to be in the one under the finger.
+
+    UIView *snapshot = self.sourceExchangeController.snapshot;
+    UICollectionView *collectionView = exchangeController.collectionView;
+    if (snapshot == nil || collectionView == nil || snapshot.superview == collectionView) return;
+
+    snapshot.center = [snapshot.superview convertPoint:snapshot.center toView:collectionView];
+    [collectionView addSubview:snapshot];
+}
+
+- (void)removeAllCachedImages {
+
+    for (SSCollectionViewExchangeController *exchangeController in self.transactionExchangeControllers) {
+        [exchangeController.snapshotCache removeAllImages];
+    }
+}
+
+@end
@@ -0,0 +1,260 @@
+//
+//  SSCollectionViewExchangeCore.c
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include "SSCollectionViewExchangeCore.h"
+
+
+static SSExchangeMove SSExchangeMoveMake(SSExchangeIndexPath fromIndexPath, SSExchangeIndexPath toIndexPath) {
+
+    SSExchangeMove move = { fromIndexPath, toIndexPath };
+    return move;
+}
+
+static void SSExchangeCoreSetPostExchangeEventState(SSExchangeCore *core,
+                                                    SSExchangeIndexPath indexPathForDisplacedItem,
+                                                    bool undoFlag) {
+
+    core->originalIndexPathForDisplacedItem = indexPathForDisplacedItem;
+    core->mustUndoPriorExchange = undoFlag;
+}
+
+
+
+//-------------------------------------
+// Beginning and ending transactions...
+
+void SSExchangeCoreReset(SSExchangeCore *core) {
+
+    core->originalIndexPathForDraggedItem = SSExchangeIndexPathNone;
+    core->originalIndexPathForDisplacedItem = SSExchangeIndexPathNone;
+    core->currentIndexPath = SSExchangeIndexPathNone;
+    core->mustUndoPriorExchange = false;
+    core->exchangeTransactionInProgress = false;
+}
+
+void SSExchangeCoreBegin(SSExchangeCore *core, SSExchangeIndexPath startingIndexPath) {
+
+    SSExchangeCoreReset(core);
+    core->originalIndexPathForDraggedItem = startingIndexPath;
+    core->originalIndexPathForDisplacedItem = startingIndexPath;
+    core->exchangeTransactionInProgress = true;
+}
+
+SSExchangeSwap SSExchangeCoreExchange(const SSExchangeCore *core) {
+
+    return SSExchangeSwapMake(core->originalIndexPathForDisplacedItem, core->originalIndexPathForDraggedItem);
+}
+
+SSExchangeSwap SSExchangeCoreFinish(SSExchangeCore *core) {
+
+    core->exchangeTransactionInProgress = false;
+    return SSExchangeCoreExchange(core);
+}
+
+bool SSExchangeCoreCancel(SSExchangeCore *core, SSExchangeSwap *undoSwap) {
+
+    bool wasInProgress = core->exchangeTransactionInProgress;
+
+    if (wasInProgress && undoSwap != NULL) {
+        *undoSwap = SSExchangeSwapMake(core->originalIndexPathForDisplacedItem, core->originalIndexPathForDraggedItem);
+    }
+
+    SSExchangeCoreReset(core);
+    return wasInProgress;
+}
+
+
+
+//--------------------
+// Exchange events...
+
+SSExchangeEventType SSExchangeCoreEventType(SSExchangeCore *core,
+                                            SSExchangeIndexPath indexPath,
+                                            SSExchangeCanDisplaceFunction canDisplace,
+                                            void *context) {
+
+    // The user is still dragging. Determine the exchange event type.
+
+    core->currentIndexPath = indexPath;
+
+    if (core->exchangeTransactionInProgress == false ||
+        SSExchangeIndexPathIsNone(indexPath) ||
+        SSExchangeIndexPathEqualToIndexPath(indexPath, core->originalIndexPathForDisplacedItem)) {
+        return SSExchangeEventTypeNothingToExchange;
+    }
+
+    if (canDisplace != NULL && canDisplace(indexPath, core->originalIndexPathForDraggedItem, context) == false) {
+        return SSExchangeEventTypeCannotDisplaceItem;
+    }
+
+
+    // Otherwise there is an exchange event to perform. What kind?
+
+    if (core->mustUndoPriorExchange) {
+
+        return (SSExchangeIndexPathEqualToIndexPath(indexPath, core->originalIndexPathForDraggedItem))? SSExchangeEventTypeDraggedToStartingItem : SSExchangeEventTypeDraggedToOtherItem;
+
+    } else {
+
+        return SSExchangeEventTypeDraggedFromStartingItem;
+    }
+}
+
+void SSExchangeCorePerformEventType(SSExchangeCore *core, SSExchangeEventType type, SSExchangeEvent *event) {
+
+    SSExchangeIndexPath dragged = core->originalIndexPathForDraggedItem;
+    SSExchangeIndexPath displaced = core->originalIndexPathForDisplacedItem;
+    SSExchangeIndexPath current = core->currentIndexPath;
+
+    event->type = type;
+    event->numberOfSwaps = 0;
+    event->numberOfMoves = 0;
+
+    switch (type) {
+
+        case SSExchangeEventTypeNothingToExchange:
+        case SSExchangeEventTypeCannotDisplaceItem:
+            break;
+
+        case SSExchangeEventTypeDraggedFromStartingItem:
+            event->swaps[event->numberOfSwaps++] = SSExchangeSwapMake(current, dragged);
+
+            event->moves[event->numberOfMoves++] = SSExchangeMoveMake(dragged, current);
+            event->moves[event->numberOfMoves++] = SSExchangeMoveMake(current, dragged);
+
+            SSExchangeCoreSetPostExchangeEventState(core, current, true);
+            break;
+
+        case SSExchangeEventTypeDraggedToOtherItem:
+            event->swaps[event->numberOfSwaps++] = SSExchangeSwapMake(dragged, displaced);
+            event->swaps[event->numberOfSwaps++] = SSExchangeSwapMake(current, dragged);
+
+            event->moves[event->numberOfMoves++] = SSExchangeMoveMake(dragged, displaced);
+            event->moves[event->numberOfMoves++] = SSExchangeMoveMake(displaced, current);
+            event->moves[event->numberOfMoves++] = SSExchangeMoveMake(current, dragged);
+
+            SSExchangeCoreSetPostExchangeEventState(core, current, true);
+            break;
+
+        case SSExchangeEventTypeDraggedToStartingItem:
+            event->swaps[event->numberOfSwaps++] = SSExchangeSwapMake(dragged, displaced);
+
+            event->moves[event->numberOfMoves++] = SSExchangeMoveMake(dragged, displaced);
+            event->moves[event->numberOfMoves++] = SSExchangeMoveMake(displaced, dragged);
+
+            SSExchangeCoreSetPostExchangeEventState(core, dragged, false);
+            break;
+    }
+}
+
+SSExchangeEvent SSExchangeCoreUpdate(SSExchangeCore *core,
+                                     SSExchangeIndexPath indexPath,
+                                     SSExchangeCanDisplaceFunction canDisplace,
+                                     void *context) {
+
+    SSExchangeEvent event;
+    SSExchangeCorePerformEventType(core, SSExchangeCoreEventType(core, indexPath, canDisplace, context), &event);
+    return event;
+}
+
+
+
+//--------------
+// Composition...
+
+static unsigned int SSExchangeComposeIndexOfPosition(SSExchangeMove *positions, unsigned int *numberOfPositions, SSExchangeIndexPath indexPath) {
+
+    // positions[i].toIndexPath is a position touched by the swaps so far and fromIndexPath is the
+    // original position of the item now there. An untouched position holds its own item.
+
+    for (unsigned int i = 0; i < *numberOfPositions; i++) {
+        if (SSExchangeIndexPathEqualToIndexPath(positions[i].toIndexPath, indexPath)) return i;
+    }
+
+    positions[*numberOfPositions] = SSExchangeMoveMake(indexPath, indexPath);
+    return (*numberOfPositions)++;
+}
+
+unsigned int SSExchangeComposeSwaps(const SSExchangeSwap *swaps, unsigned int numberOfSwaps, SSExchangeMove *moves) {
+
+    // moves doubles as the table of touched positions, then is compacted in place.
+
+    unsigned int numberOfPositions = 0;
+
+    for (unsigned int i = 0; i < numberOfSwaps; i++) {
+
+        unsigned int position1 = SSExchangeComposeIndexOfPosition(moves, &numberOfPositions, swaps[i].indexPath1);
+        unsigned int position2 = SSExchangeComposeIndexOfPosition(moves, &numberOfPositions, swaps[i].indexPath2);
+
+        SSExchangeIndexPath item = moves[position1].fromIndexPath;
+        moves[position1].fromIndexPath = moves[position2].fromIndexPath;
+        moves[position2].fromIndexPath = item;
+    }
+
+    unsigned int numberOfMoves = 0;
+
+    for (unsigned int i = 0; i < numberOfPositions; i++) {
+        if (!SSExchangeIndexPathEqualToIndexPath(moves[i].fromIndexPath, moves[i].toIndexPath)) {
+            moves[numberOfMoves++] = moves[i];
+        }
+    }
+
+    return numberOfMoves;
+}
+
+unsigned int SSExchangeCoalesceExchanges(const SSExchangeSwap *priorExchanges,
+                                         const SSExchangeSwap *exchanges,
+                                         unsigned int numberOfExchanges,
+                                         SSExchangeSwap *swaps) {
+
+    bool exchangesChanged = false;
+    for (unsigned int i = 0; i < numberOfExchanges; i++) {
+        if (!SSExchangeIndexPathEqualToIndexPath(priorExchanges[i].indexPath1, exchanges[i].indexPath1) ||
+            !SSExchangeIndexPathEqualToIndexPath(priorExchanges[i].indexPath2, exchanges[i].indexPath2)) {
+            exchangesChanged = true;
+            break;
+        }
+    }
+    if (!exchangesChanged) return 0;
+
+    // The exchanges in a group never share an item so the order within each half doesn't matter.
+    unsigned int numberOfSwaps = 0;
+
+    for (unsigned int i = 0; i < numberOfExchanges; i++) {
+        if (!SSExchangeIndexPathEqualToIndexPath(priorExchanges[i].indexPath1, priorExchanges[i].indexPath2)) {
+            swaps[numberOfSwaps++] = SSExchangeSwapMake(priorExchanges[i].indexPath2, priorExchanges[i].indexPath1);
+        }
+    }
+
+    for (unsigned int i = 0; i < numberOfExchanges; i++) {
+        if (!SSExchangeIndexPathEqualToIndexPath(exchanges[i].indexPath1, exchanges[i].indexPath2)) {
+            swaps[numberOfSwaps++] = exchanges[i];
+        }
+    }
+
+    return numberOfSwaps;
+}
@@ -0,0 +1,170 @@
+//
+//  SSCollectionViewExchangeCore.h
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// SSCollectionViewExchangeCore is the exchange transaction state machine, independent of UIKit.
+//
+// SSCollectionViewExchangeController is a UIKit adapter on top of it: it turns long press states
+// into calls to these functions, hit-tests to find the index path under the user's finger, and
+// applies the swaps and moves each event returns to its delegate and collection view. Because the
+// core is plain C, works entirely with SSExchangeIndexPath values, and never allocates, it can be
+// driven headlessly by tests, benchmarks, and replay tools on any platform.
+//
+// The terminology (transaction, event, dragged item, displaced item) is the same as in the README.
+//
+// Typical use:
+//
+//      SSExchangeCore core;
+//      SSExchangeCoreBegin(&core, startingIndexPath);
+//
+//      // for each new location of the user's finger...
+//      SSExchangeEvent event = SSExchangeCoreUpdate(&core, indexPathUnderFinger, canDisplace, context);
+//      // apply event.swaps to the model and event.moves to the view
+//
+//      SSExchangeSwap finalSwap = SSExchangeCoreFinish(&core);    // or SSExchangeCoreCancel()
+//      // ...after any release animation...
+//      SSExchangeCoreReset(&core);
+
+#ifndef SSCollectionViewExchangeCore_h
+#define SSCollectionViewExchangeCore_h
+
+#include "SSCollectionViewExchangeTypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef enum {
+    SSExchangeEventTypeDraggedFromStartingItem,     // the first exchange in the transaction, one swap
+    SSExchangeEventTypeDraggedToOtherItem,          // undo the prior exchange then exchange again, two swaps
+    SSExchangeEventTypeDraggedToStartingItem,       // undo the prior exchange, one swap
+    SSExchangeEventTypeNothingToExchange,           // still over the same item, or not over any item
+    SSExchangeEventTypeCannotDisplaceItem           // over an item the delegate does not allow to be displaced
+} SSExchangeEventType;
+
+
+// The item at fromIndexPath moves to toIndexPath. This is what the collection view is told.
+typedef struct {
+    SSExchangeIndexPath fromIndexPath;
+    SSExchangeIndexPath toIndexPath;
+} SSExchangeMove;
+
+
+// Everything an exchange event produces. The swaps are for the model and must be applied in order.
+// The moves are for the view and together describe the same net change as the swaps.
+typedef struct {
+    SSExchangeEventType type;
+    unsigned int        numberOfSwaps;
+    SSExchangeSwap      swaps[2];
+    unsigned int        numberOfMoves;
+    SSExchangeMove      moves[3];
+} SSExchangeEvent;
+
+
+typedef struct {
+    SSExchangeIndexPath originalIndexPathForDraggedItem;    // the index path where the exchange transaction began
+    SSExchangeIndexPath originalIndexPathForDisplacedItem;  // the original index path for the item most recently displaced
+    SSExchangeIndexPath currentIndexPath;                   // the index path for the item under the user's finger
+    bool                mustUndoPriorExchange;              // for each exchange, tells the core if a prior exchange must be undone first
+    bool                exchangeTransactionInProgress;
+} SSExchangeCore;
+
+
+// Asked whether the item at indexPathOfItemToDisplace may be displaced by the item being dragged.
+// context is passed through unchanged from SSExchangeCoreUpdate() or SSExchangeCoreEventType().
+typedef bool (*SSExchangeCanDisplaceFunction)(SSExchangeIndexPath indexPathOfItemToDisplace,
+                                              SSExchangeIndexPath indexPathOfItemBeingDragged,
+                                              void *context);
+
+
+void SSExchangeCoreBegin(SSExchangeCore *core, SSExchangeIndexPath startingIndexPath);
+// Begins an exchange transaction with the item at startingIndexPath.
+
+SSExchangeEventType SSExchangeCoreEventType(SSExchangeCore *core,
+                                            SSExchangeIndexPath indexPath,
+                                            SSExchangeCanDisplaceFunction canDisplace,
+                                            void *context);
+// Determines the type of exchange event for the user's finger being over indexPath, which is
+// SSExchangeIndexPathNone when the finger is not over an item. Records indexPath as the current
+// index path but does not otherwise change the state. canDisplace can be NULL, meaning any item
+// can be displaced. It is only called when there would otherwise be an exchange.
+
+void SSExchangeCorePerformEventType(SSExchangeCore *core, SSExchangeEventType type, SSExchangeEvent *event);
+// Performs an event of the type returned by the most recent SSExchangeCoreEventType(), filling
+// in event and moving the state on.
+
+SSExchangeEvent SSExchangeCoreUpdate(SSExchangeCore *core,
+                                     SSExchangeIndexPath indexPath,
+                                     SSExchangeCanDisplaceFunction canDisplace,
+                                     void *context);
+// SSExchangeCoreEventType() followed by SSExchangeCorePerformEventType().
+
+SSExchangeSwap SSExchangeCoreExchange(const SSExchangeCore *core);
+// The exchange the transaction has arrived at so far: the displaced item's original index path and
+// the dragged item's original index path, equal if nothing is exchanged. It is what
+// SSExchangeCoreFinish() would return now.
+
+SSExchangeSwap SSExchangeCoreFinish(SSExchangeCore *core);
+// Finishes the exchange transaction and returns the two items in the final exchange: the
+// displaced item's original index path and the dragged item's original index path. They are
+// equal if nothing was exchanged. The original index paths are kept, for hiding and dimming
+// during the release, until SSExchangeCoreReset().
+
+bool SSExchangeCoreCancel(SSExchangeCore *core, SSExchangeSwap *undoSwap);
+// Cancels the exchange transaction and resets the core. If the transaction was in progress
+// returns true and sets undoSwap to the swap that returns the model to its state before the
+// transaction. Otherwise returns false.
+
+void SSExchangeCoreReset(SSExchangeCore *core);
+// Clears all state. Use at the end of the release, and to initialize a core.
+
+
+unsigned int SSExchangeComposeSwaps(const SSExchangeSwap *swaps, unsigned int numberOfSwaps, SSExchangeMove *moves);
+// Composes swaps, applied in order, into the net permutation they describe and returns it as moves:
+// the item that was at fromIndexPath ends up at toIndexPath. Items that end up where they started
+// are left out so swaps that cancel out produce no moves at all. moves must have room for
+// 2 * numberOfSwaps moves. Returns the number of moves. Intended for the handful of swaps in an
+// event or a short history, it takes time proportional to numberOfSwaps squared.
+
+unsigned int SSExchangeCoalesceExchanges(const SSExchangeSwap *priorExchanges,
+                                         const SSExchangeSwap *exchanges,
+                                         unsigned int numberOfExchanges,
+                                         SSExchangeSwap *swaps);
+// Sets swaps to the swaps that take the model from reflecting priorExchanges to reflecting
+// exchanges instead, and returns how many there are. Both are exchanges from the same transaction,
+// as returned by SSExchangeCoreExchange() or SSExchangeGroupCoreGetExchanges(), so any number of
+// exchange events in between collapse into at most two swaps per item: the prior exchanges are
+// undone, the way an exchange event undoes a prior exchange, then the new ones are made. An item
+// exchanged with itself needs no swap, and if nothing changed there are no swaps at all. swaps
+// must have room for 2 * numberOfExchanges swaps.
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
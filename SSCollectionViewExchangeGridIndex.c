@@ -0,0 +1,247 @@
+//
+//  SSCollectionViewExchangeGridIndex.c
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include "SSCollectionViewExchangeGridIndex.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+
+struct SSExchangeGridIndex {
+    size_t              count;              // the number of items with non-empty frames
+    SSExchangeRect      *frames;            // count frames, in the order they were given
+    SSExchangeIndexPath *indexPaths;        // count index paths, in the same order
+    double              originX;            // the top left of the area covered by the items
+    double              originY;
+    double              bucketWidth;
+    double              bucketHeight;
+    size_t              columns;
+    size_t              rows;
+    uint32_t            *bucketStarts;      // columns * rows + 1 offsets into entries, one bucket after another
+    uint32_t            *entries;           // for each bucket, the items (offsets into frames) overlapping it, in order
+};
+
+
+// Keeps the number of buckets proportional to the number of items even when the frames vary
+// widely in size or are spread out with large gaps between them.
+static const size_t SSExchangeGridIndexMaximumBucketsPerItem = 4;
+
+
+static size_t SSExchangeGridIndexClamp(double value, size_t limit) {
+
+    // Both the item frames and the lookups go through here so they always agree on the bucket.
+    if (!(value > 0.0)) return 0;
+    if (value >= (double)(limit - 1)) return limit - 1;
+    return (size_t)value;
+}
+
+static size_t SSExchangeGridIndexColumn(const SSExchangeGridIndex *gridIndex, double x) {
+
+    return SSExchangeGridIndexClamp(floor((x - gridIndex->originX) / gridIndex->bucketWidth), gridIndex->columns);
+}
+
+static size_t SSExchangeGridIndexRow(const SSExchangeGridIndex *gridIndex, double y) {
+
+    return SSExchangeGridIndexClamp(floor((y - gridIndex->originY) / gridIndex->bucketHeight), gridIndex->rows);
+}
+
+static bool SSExchangeRectIsEmpty(SSExchangeRect rect) {
+
+    return !(rect.width > 0.0 && rect.height > 0.0);
+}
+
+static bool SSExchangeRectContainsPoint(SSExchangeRect rect, double x, double y) {
+
+    return x >= rect.x && x < rect.x + rect.width && y >= rect.y && y < rect.y + rect.height;
+}
+
+
+
+//--------------------------
+// Creating and freeing...
+
+SSExchangeGridIndex *SSExchangeGridIndexCreate(const SSExchangeRect *frames,
+                                               const SSExchangeIndexPath *indexPaths,
+                                               size_t count) {
+
+    if (frames == NULL || indexPaths == NULL || count == 0 || count > UINT32_MAX) return NULL;
+
+    SSExchangeGridIndex *gridIndex = calloc(1, sizeof(SSExchangeGridIndex));
+    if (gridIndex == NULL) return NULL;
+
+    gridIndex->frames = malloc(count * sizeof(SSExchangeRect));
+    gridIndex->indexPaths = malloc(count * sizeof(SSExchangeIndexPath));
+    if (gridIndex->frames == NULL || gridIndex->indexPaths == NULL) goto fail;
+
+
+    // Keep the non-empty frames and find the area they cover and their average size, which
+    // becomes the bucket size.
+
+    double minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    double totalWidth = 0.0, totalHeight = 0.0;
+
+    for (size_t i = 0; i < count; i++) {
+
+        if (SSExchangeRectIsEmpty(frames[i])) continue;
+
+        SSExchangeRect frame = frames[i];
+        gridIndex->frames[gridIndex->count] = frame;
+        gridIndex->indexPaths[gridIndex->count] = indexPaths[i];
+        gridIndex->count++;
+
+        minX = fmin(minX, frame.x);
+        minY = fmin(minY, frame.y);
+        maxX = fmax(maxX, frame.x + frame.width);
+        maxY = fmax(maxY, frame.y + frame.height);
+        totalWidth += frame.width;
+        totalHeight += frame.height;
+    }
+
+    if (gridIndex->count == 0) goto fail;
+
+    double bucketWidth = totalWidth / gridIndex->count;
+    double bucketHeight = totalHeight / gridIndex->count;
+    double columns = ceil((maxX - minX) / bucketWidth);
+    double rows = ceil((maxY - minY) / bucketHeight);
+
+    double maximumBuckets = (double)gridIndex->count * SSExchangeGridIndexMaximumBucketsPerItem;
+    if (columns * rows > maximumBuckets) {
+        double scale = sqrt(columns * rows / maximumBuckets);
+        bucketWidth *= scale;
+        bucketHeight *= scale;
+        columns = ceil((maxX - minX) / bucketWidth);
+        rows = ceil((maxY - minY) / bucketHeight);
+    }
+
+    gridIndex->originX = minX;
+    gridIndex->originY = minY;
+    gridIndex->bucketWidth = bucketWidth;
+    gridIndex->bucketHeight = bucketHeight;
+    gridIndex->columns = (columns < 1.0)? 1 : (size_t)columns;
+    gridIndex->rows = (rows < 1.0)? 1 : (size_t)rows;
+
+    size_t numberOfBuckets = gridIndex->columns * gridIndex->rows;
+    gridIndex->bucketStarts = calloc(numberOfBuckets + 1, sizeof(uint32_t));
+    if (gridIndex->bucketStarts == NULL) goto fail;
+
+
+    // First pass counts the items overlapping each bucket, second pass records them. In between
+    // the counts become offsets.
+
+    size_t numberOfEntries = 0;
+    for (size_t i = 0; i < gridIndex->count; i++) {
+
+        SSExchangeRect frame = gridIndex->frames[i];
+        size_t firstColumn = SSExchangeGridIndexColumn(gridIndex, frame.x);
+        size_t lastColumn = SSExchangeGridIndexColumn(gridIndex, frame.x + frame.width);
+        size_t firstRow = SSExchangeGridIndexRow(gridIndex, frame.y);
+        size_t lastRow = SSExchangeGridIndexRow(gridIndex, frame.y + frame.height);
+
+        for (size_t row = firstRow; row <= lastRow; row++) {
+            for (size_t column = firstColumn; column <= lastColumn; column++) {
+                gridIndex->bucketStarts[row * gridIndex->columns + column + 1]++;
+            }
+        }
+        numberOfEntries += (lastRow - firstRow + 1) * (lastColumn - firstColumn + 1);
+    }
+
+    if (numberOfEntries > UINT32_MAX) goto fail;
+
+    for (size_t bucket = 0; bucket < numberOfBuckets; bucket++) {
+        gridIndex->bucketStarts[bucket + 1] += gridIndex->bucketStarts[bucket];
+    }
+
+    gridIndex->entries = malloc(numberOfEntries * sizeof(uint32_t));
+    uint32_t *nextEntry = malloc(numberOfBuckets * sizeof(uint32_t));
+    if (gridIndex->entries == NULL || nextEntry == NULL) {
+        free(nextEntry);
+        goto fail;
+    }
+
+    for (size_t bucket = 0; bucket < numberOfBuckets; bucket++) nextEntry[bucket] = gridIndex->bucketStarts[bucket];
+
+    for (size_t i = 0; i < gridIndex->count; i++) {
+
+        SSExchangeRect frame = gridIndex->frames[i];
+        size_t firstColumn = SSExchangeGridIndexColumn(gridIndex, frame.x);
+        size_t lastColumn = SSExchangeGridIndexColumn(gridIndex, frame.x + frame.width);
+        size_t firstRow = SSExchangeGridIndexRow(gridIndex, frame.y);
+        size_t lastRow = SSExchangeGridIndexRow(gridIndex, frame.y + frame.height);
+
+        for (size_t row = firstRow; row <= lastRow; row++) {
+            for (size_t column = firstColumn; column <= lastColumn; column++) {
+                gridIndex->entries[nextEntry[row * gridIndex->columns + column]++] = (uint32_t)i;
+            }
+        }
+    }
+
+    free(nextEntry);
+    return gridIndex;
+
+fail:
+    SSExchangeGridIndexFree(gridIndex);
+    return NULL;
+}
+
+void SSExchangeGridIndexFree(SSExchangeGridIndex *gridIndex) {
+
+    if (gridIndex == NULL) return;
+
+    free(gridIndex->frames);
+    free(gridIndex->indexPaths);
+    free(gridIndex->bucketStarts);
+    free(gridIndex->entries);
+    free(gridIndex);
+}
+
+
+
+//------------
+// Queries...
+
+SSExchangeIndexPath SSExchangeGridIndexIndexPathAtPoint(const SSExchangeGridIndex *gridIndex, double x, double y) {
+
+    if (gridIndex == NULL) return SSExchangeIndexPathNone;
+
+    // Points outside the covered area can't be in any item. This also rejects NaN.
+    if (!(x >= gridIndex->originX && y >= gridIndex->originY)) return SSExchangeIndexPathNone;
+
+    size_t bucket = SSExchangeGridIndexRow(gridIndex, y) * gridIndex->columns + SSExchangeGridIndexColumn(gridIndex, x);
+
+    for (uint32_t entry = gridIndex->bucketStarts[bucket]; entry < gridIndex->bucketStarts[bucket + 1]; entry++) {
+
+        uint32_t i = gridIndex->entries[entry];
+        if (SSExchangeRectContainsPoint(gridIndex->frames[i], x, y)) return gridIndex->indexPaths[i];
+    }
+
+    return SSExchangeIndexPathNone;
+}
+
+size_t SSExchangeGridIndexCount(const SSExchangeGridIndex *gridIndex) {
+
+    return (gridIndex == NULL)? 0 : gridIndex->count;
+}
@@ -0,0 +1,85 @@
+//
+//  SSCollectionViewExchangeGridIndex.h
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// SSExchangeGridIndex answers "which item is at this point?" in constant time.
+//
+// During an exchange transaction the exchange controller hit-tests the location of the user's
+// finger on every touch sample. UICollectionView's indexPathForItemAtPoint: searches the layout
+// attributes to do that, which becomes expensive with thousands of items. This index divides the
+// area covered by the items into a uniform grid of buckets, about one item in size, and records
+// which items overlap each bucket. A lookup computes the bucket for the point and checks only the
+// few items recorded there.
+//
+// SSCollectionViewExchangeLayout builds an index from its item frames when the layout is prepared
+// and keeps it until the layout is invalidated. The index itself is plain C and has no dependency
+// on UIKit or CoreGraphics so it can be built from synthetic frames in tests.
+
+#ifndef SSCollectionViewExchangeGridIndex_h
+#define SSCollectionViewExchangeGridIndex_h
+
+#include "SSCollectionViewExchangeTypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef struct {
+    double x;
+    double y;
+    double width;
+    double height;
+} SSExchangeRect;
+
+
+typedef struct SSExchangeGridIndex SSExchangeGridIndex;
+
+
+SSExchangeGridIndex *SSExchangeGridIndexCreate(const SSExchangeRect *frames,
+                                               const SSExchangeIndexPath *indexPaths,
+                                               size_t count);
+// Creates an index for count items. The frame for the item at indexPaths[i] is frames[i]. Items
+// with empty frames are ignored. Returns NULL if count is 0, there are no non-empty frames, or
+// memory can't be allocated. Release the index with SSExchangeGridIndexFree().
+
+void SSExchangeGridIndexFree(SSExchangeGridIndex *gridIndex);
+// Frees the index. gridIndex can be NULL.
+
+SSExchangeIndexPath SSExchangeGridIndexIndexPathAtPoint(const SSExchangeGridIndex *gridIndex, double x, double y);
+// Returns the index path for the item whose frame contains the point, with the same edge rules as
+// CGRectContainsPoint(), or SSExchangeIndexPathNone if there isn't one. If frames overlap, the
+// item that came first when the index was created wins. gridIndex can be NULL.
+
+size_t SSExchangeGridIndexCount(const SSExchangeGridIndex *gridIndex);
+// The number of items in the index. gridIndex can be NULL.
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,228 @@
+//
+//  SSCollectionViewExchangeGroupCore.c
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include "SSCollectionViewExchangeGroupCore.h"
+
+
+static bool SSExchangeGroupCoreIndexPathsAreEqual(const SSExchangeIndexPath *indexPaths1, const SSExchangeIndexPath *indexPaths2, unsigned int count) {
+
+    for (unsigned int i = 0; i < count; i++) {
+        if (!SSExchangeIndexPathEqualToIndexPath(indexPaths1[i], indexPaths2[i])) return false;
+    }
+    return true;
+}
+
+static bool SSExchangeGroupCoreIndexPathsContain(const SSExchangeIndexPath *indexPaths, unsigned int count, SSExchangeIndexPath indexPath) {
+
+    for (unsigned int i = 0; i < count; i++) {
+        if (SSExchangeIndexPathEqualToIndexPath(indexPaths[i], indexPath)) return true;
+    }
+    return false;
+}
+
+static bool SSExchangeGroupCoreSetTargets(SSExchangeGroupCore *core, SSExchangeIndexPath indexPath) {
+
+    // Each item keeps its offset from the dragged item, which is originalIndexPaths[0].
+
+    if (SSExchangeIndexPathIsNone(indexPath)) return false;
+
+    SSExchangeIndexPath dragged = core->originalIndexPaths[0];
+
+    for (unsigned int i = 0; i < core->numberOfItems; i++) {
+
+        SSExchangeIndexPath target = SSExchangeIndexPathMake(indexPath.section + core->originalIndexPaths[i].section - dragged.section,
+                                                             indexPath.item + core->originalIndexPaths[i].item - dragged.item);
+        if (SSExchangeIndexPathIsNone(target)) return false;
+
+        core->targetIndexPaths[i] = target;
+    }
+    return true;
+}
+
+static void SSExchangeGroupCoreAddSwaps(SSExchangeGroupEvent *event, const SSExchangeIndexPath *indexPaths1, const SSExchangeIndexPath *indexPaths2, unsigned int count) {
+
+    for (unsigned int i = 0; i < count; i++) {
+        event->swaps[event->numberOfSwaps++] = SSExchangeSwapMake(indexPaths1[i], indexPaths2[i]);
+    }
+}
+
+
+
+//-------------------------------------
+// Beginning and ending transactions...
+
+void SSExchangeGroupCoreReset(SSExchangeGroupCore *core) {
+
+    core->numberOfItems = 0;
+    core->currentIndexPath = SSExchangeIndexPathNone;
+    core->targetsAreValid = false;
+    core->mustUndoPriorExchange = false;
+    core->exchangeTransactionInProgress = false;
+}
+
+bool SSExchangeGroupCoreBegin(SSExchangeGroupCore *core, const SSExchangeIndexPath *indexPaths, unsigned int numberOfItems) {
+
+    if (indexPaths == NULL || numberOfItems == 0 || numberOfItems > SSExchangeGroupMaximumNumberOfItems) return false;
+
+    for (unsigned int i = 0; i < numberOfItems; i++) {
+        if (SSExchangeIndexPathIsNone(indexPaths[i]) || SSExchangeGroupCoreIndexPathsContain(indexPaths, i, indexPaths[i])) return false;
+    }
+
+    SSExchangeGroupCoreReset(core);
+
+    for (unsigned int i = 0; i < numberOfItems; i++) {
+        core->originalIndexPaths[i] = indexPaths[i];
+        core->displacedIndexPaths[i] = indexPaths[i];
+    }
+    core->numberOfItems = numberOfItems;
+    core->exchangeTransactionInProgress = true;
+    return true;
+}
+
+unsigned int SSExchangeGroupCoreGetExchanges(const SSExchangeGroupCore *core, SSExchangeSwap *exchanges) {
+
+    for (unsigned int i = 0; i < core->numberOfItems; i++) {
+        exchanges[i] = SSExchangeSwapMake(core->displacedIndexPaths[i], core->originalIndexPaths[i]);
+    }
+    return core->numberOfItems;
+}
+
+unsigned int SSExchangeGroupCoreFinish(SSExchangeGroupCore *core, SSExchangeSwap *finalSwaps) {
+
+    core->exchangeTransactionInProgress = false;
+    return SSExchangeGroupCoreGetExchanges(core, finalSwaps);
+}
+
+unsigned int SSExchangeGroupCoreCancel(SSExchangeGroupCore *core, SSExchangeSwap *undoSwaps) {
+
+    unsigned int numberOfUndoSwaps = 0;
+
+    if (core->exchangeTransactionInProgress && undoSwaps != NULL) {
+        numberOfUndoSwaps = SSExchangeGroupCoreFinish(core, undoSwaps);
+    }
+
+    SSExchangeGroupCoreReset(core);
+    return numberOfUndoSwaps;
+}
+
+
+
+//--------------------
+// Exchange events...
+
+SSExchangeEventType SSExchangeGroupCoreEventType(SSExchangeGroupCore *core,
+                                                 SSExchangeIndexPath indexPath,
+                                                 SSExchangeGroupCanDisplaceFunction canDisplace,
+                                                 void *context) {
+
+    // The user is still dragging. Determine the exchange event type.
+
+    if (core->exchangeTransactionInProgress == false ||
+        SSExchangeIndexPathEqualToIndexPath(indexPath, core->currentIndexPath)) {
+        return SSExchangeEventTypeNothingToExchange;
+    }
+
+    core->currentIndexPath = indexPath;
+    core->targetsAreValid = SSExchangeGroupCoreSetTargets(core, indexPath);
+
+    unsigned int numberOfItems = core->numberOfItems;
+
+    if (core->targetsAreValid == false ||
+        SSExchangeGroupCoreIndexPathsAreEqual(core->targetIndexPaths, core->displacedIndexPaths, numberOfItems)) {
+        return SSExchangeEventTypeNothingToExchange;
+    }
+
+    if (SSExchangeGroupCoreIndexPathsAreEqual(core->targetIndexPaths, core->originalIndexPaths, numberOfItems)) {
+        return SSExchangeEventTypeDraggedToStartingItem;
+    }
+
+    // The targets are the group moved by one offset, so if they overlap the group at all the
+    // overlap isn't the whole group and there is nothing sensible to exchange.
+    for (unsigned int i = 0; i < numberOfItems; i++) {
+        if (SSExchangeGroupCoreIndexPathsContain(core->originalIndexPaths, numberOfItems, core->targetIndexPaths[i])) {
+            return SSExchangeEventTypeNothingToExchange;
+        }
+    }
+
+    if (canDisplace != NULL && canDisplace(core->targetIndexPaths, core->originalIndexPaths, numberOfItems, context) == false) {
+        return SSExchangeEventTypeCannotDisplaceItem;
+    }
+
+
+    // Otherwise there is an exchange event to perform. What kind?
+
+    return (core->mustUndoPriorExchange)? SSExchangeEventTypeDraggedToOtherItem : SSExchangeEventTypeDraggedFromStartingItem;
+}
+
+void SSExchangeGroupCorePerformEventType(SSExchangeGroupCore *core, SSExchangeEventType type, SSExchangeGroupEvent *event) {
+
+    // The items in the group, the items they displaced, and the targets are all distinct, so the
+    // swaps within each step are independent of one another.
+
+    unsigned int numberOfItems = core->numberOfItems;
+
+    event->type = type;
+    event->numberOfSwaps = 0;
+    event->numberOfMoves = 0;
+
+    switch (type) {
+
+        case SSExchangeEventTypeNothingToExchange:
+        case SSExchangeEventTypeCannotDisplaceItem:
+            return;
+
+        case SSExchangeEventTypeDraggedFromStartingItem:
+            SSExchangeGroupCoreAddSwaps(event, core->targetIndexPaths, core->originalIndexPaths, numberOfItems);
+            break;
+
+        case SSExchangeEventTypeDraggedToOtherItem:
+            SSExchangeGroupCoreAddSwaps(event, core->originalIndexPaths, core->displacedIndexPaths, numberOfItems);
+            SSExchangeGroupCoreAddSwaps(event, core->targetIndexPaths, core->originalIndexPaths, numberOfItems);
+            break;
+
+        case SSExchangeEventTypeDraggedToStartingItem:
+            SSExchangeGroupCoreAddSwaps(event, core->originalIndexPaths, core->displacedIndexPaths, numberOfItems);
+            break;
+    }
+
+    // The post exchange event state. After dragging back to the starting items the targets are the originals.
+    for (unsigned int i = 0; i < numberOfItems; i++) {
+        core->displacedIndexPaths[i] = core->targetIndexPaths[i];
+    }
+    core->mustUndoPriorExchange = (type != SSExchangeEventTypeDraggedToStartingItem);
+
+    event->numberOfMoves = SSExchangeComposeSwaps(event->swaps, event->numberOfSwaps, event->moves);
+}
+
+void SSExchangeGroupCoreUpdate(SSExchangeGroupCore *core,
+                               SSExchangeIndexPath indexPath,
+                               SSExchangeGroupCanDisplaceFunction canDisplace,
+                               void *context,
+                               SSExchangeGroupEvent *event) {
+
+    SSExchangeGroupCorePerformEventType(core, SSExchangeGroupCoreEventType(core, indexPath, canDisplace, context), event);
+}
@@ -0,0 +1,159 @@
+//
+//  SSCollectionViewExchangeGroupCore.h
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// SSExchangeGroupCore is the exchange transaction state machine for a group of items dragged
+// together. It is the counterpart of SSExchangeCore, which handles a single item, and has the same
+// shape: plain C, SSExchangeIndexPath values only, and no allocation.
+//
+// The group is caught by one of its items, the dragged item, and the others follow it. When the
+// user's finger is over an item, each item in the group is matched with a target item at the same
+// offset from that item as it has from the dragged item, section for section and item for item.
+// The group then exchanges with the targets all at once: one event, whatever the size of the group.
+// As with a single item, each event first undoes the prior exchange, so only the items in the most
+// recent exchange are ever out of place.
+//
+// There is no exchange while any target is missing or is itself in the group. Targets before the
+// start of a section are missing and are detected here. Targets past the end of a section are
+// detected by canDisplace, which must return false for them. Either way, the user carries on
+// dragging until the whole group is over items it can exchange with.
+//
+// Typical use:
+//
+//      SSExchangeGroupCore core;
+//      SSExchangeGroupCoreBegin(&core, indexPaths, count);        // indexPaths[0] is the dragged item
+//
+//      // for each new location of the user's finger...
+//      SSExchangeGroupEvent event;
+//      SSExchangeGroupCoreUpdate(&core, indexPathUnderFinger, canDisplace, context, &event);
+//      // apply event.swaps to the model and event.moves to the view
+//
+//      SSExchangeSwap finalSwaps[SSExchangeGroupMaximumNumberOfItems];
+//      unsigned int numberOfFinalSwaps = SSExchangeGroupCoreFinish(&core, finalSwaps);
+//      // ...after any release animation...
+//      SSExchangeGroupCoreReset(&core);
+
+#ifndef SSCollectionViewExchangeGroupCore_h
+#define SSCollectionViewExchangeGroupCore_h
+
+#include "SSCollectionViewExchangeCore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#define SSExchangeGroupMaximumNumberOfItems 32
+
+
+// Everything a group exchange event produces. The swaps are for the model and must be applied in
+// order. The moves are for the view and together describe the same net change as the swaps.
+typedef struct {
+    SSExchangeEventType type;
+    unsigned int        numberOfSwaps;
+    SSExchangeSwap      swaps[2 * SSExchangeGroupMaximumNumberOfItems];
+    unsigned int        numberOfMoves;
+    SSExchangeMove      moves[4 * SSExchangeGroupMaximumNumberOfItems];
+} SSExchangeGroupEvent;
+
+
+typedef struct {
+    unsigned int        numberOfItems;                                                      // 0 when there is no group
+    SSExchangeIndexPath originalIndexPaths[SSExchangeGroupMaximumNumberOfItems];            // where each item in the group began, the dragged item first
+    SSExchangeIndexPath displacedIndexPaths[SSExchangeGroupMaximumNumberOfItems];           // the original index paths for the items most recently displaced, matching originalIndexPaths
+    SSExchangeIndexPath targetIndexPaths[SSExchangeGroupMaximumNumberOfItems];              // the targets for currentIndexPath, matching originalIndexPaths
+    SSExchangeIndexPath currentIndexPath;                                                   // the index path for the item under the user's finger
+    bool                targetsAreValid;                                                    // false if currentIndexPath has no targets
+    bool                mustUndoPriorExchange;
+    bool                exchangeTransactionInProgress;
+} SSExchangeGroupCore;
+
+
+// Asked whether the items at indexPathsOfItemsToDisplace may be displaced by the items being
+// dragged, which are from indexPathsOfItemsBeingDragged, item for item. Return false if any of
+// them may not, or if any of indexPathsOfItemsToDisplace is past the end of its section.
+// context is passed through unchanged from SSExchangeGroupCoreUpdate() or SSExchangeGroupCoreEventType().
+typedef bool (*SSExchangeGroupCanDisplaceFunction)(const SSExchangeIndexPath *indexPathsOfItemsToDisplace,
+                                                   const SSExchangeIndexPath *indexPathsOfItemsBeingDragged,
+                                                   unsigned int numberOfItems,
+                                                   void *context);
+
+
+bool SSExchangeGroupCoreBegin(SSExchangeGroupCore *core, const SSExchangeIndexPath *indexPaths, unsigned int numberOfItems);
+// Begins an exchange transaction with the group of items at indexPaths. indexPaths[0] is the dragged
+// item. Returns false, without beginning, if numberOfItems is 0 or more than
+// SSExchangeGroupMaximumNumberOfItems, or if any index path is none or appears more than once.
+
+SSExchangeEventType SSExchangeGroupCoreEventType(SSExchangeGroupCore *core,
+                                                 SSExchangeIndexPath indexPath,
+                                                 SSExchangeGroupCanDisplaceFunction canDisplace,
+                                                 void *context);
+// Determines the type of exchange event for the user's finger being over indexPath, which is
+// SSExchangeIndexPathNone when the finger is not over an item. Records indexPath and its targets
+// but does not otherwise change the state. The answer can only change when indexPath does, so if
+// indexPath is the same as the last time this returns SSExchangeEventTypeNothingToExchange
+// straight away. canDisplace can be NULL, meaning every target exists and can be displaced. It is
+// only called when there would otherwise be an exchange.
+
+void SSExchangeGroupCorePerformEventType(SSExchangeGroupCore *core, SSExchangeEventType type, SSExchangeGroupEvent *event);
+// Performs an event of the type returned by the most recent SSExchangeGroupCoreEventType(),
+// filling in event and moving the state on.
+
+void SSExchangeGroupCoreUpdate(SSExchangeGroupCore *core,
+                               SSExchangeIndexPath indexPath,
+                               SSExchangeGroupCanDisplaceFunction canDisplace,
+                               void *context,
+                               SSExchangeGroupEvent *event);
+// SSExchangeGroupCoreEventType() followed by SSExchangeGroupCorePerformEventType(). The event is
+// returned through a pointer because it is a few kilobytes.
+
+unsigned int SSExchangeGroupCoreGetExchanges(const SSExchangeGroupCore *core, SSExchangeSwap *exchanges);
+// Sets exchanges, which must have room for the number of items in the group, to the exchanges the
+// transaction has arrived at so far, the same as SSExchangeGroupCoreFinish() would set now.
+// Returns the number of items in the group.
+
+unsigned int SSExchangeGroupCoreFinish(SSExchangeGroupCore *core, SSExchangeSwap *finalSwaps);
+// Finishes the exchange transaction and sets finalSwaps, which must have room for the number of
+// items in the group, to the exchanges that make up the final exchange: for each item in the group,
+// the original index path of the item it displaced and its own original index path. The two are
+// equal if nothing was exchanged. Returns the number of items in the group. The original index
+// paths are kept, for hiding and dimming during the release, until SSExchangeGroupCoreReset().
+
+unsigned int SSExchangeGroupCoreCancel(SSExchangeGroupCore *core, SSExchangeSwap *undoSwaps);
+// Cancels the exchange transaction and resets the core. If the transaction was in progress sets
+// undoSwaps, which must have room for the number of items in the group, to the swaps that return
+// the model to its state before the transaction and returns how many there are. Otherwise
+// returns 0.
+
+void SSExchangeGroupCoreReset(SSExchangeGroupCore *core);
+// Clears all state. Use at the end of the release, and to initialize a core.
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
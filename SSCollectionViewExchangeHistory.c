@@ -0,0 +1,226 @@
+//
+//  SSCollectionViewExchangeHistory.c
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include "SSCollectionViewExchangeHistory.h"
+
+#include <stdlib.h>
+
+
+struct SSExchangeHistory {
+    unsigned int    capacity;
+    unsigned int    start;              // the offset of the oldest record in records
+    unsigned int    count;              // the number of records, undoable and redoable
+    unsigned int    numberOfUndos;      // the records before this are undoable, the rest redoable
+    SSExchangeSwap  *records;           // capacity records, a ring starting at start
+    uint64_t        *positions;         // 2 * capacity packed index paths, working memory for composing
+    uint32_t        *contents;          // 2 * capacity offsets into positions, working memory for composing
+};
+
+
+static bool SSExchangeSwapExchangesNothing(SSExchangeSwap swap) {
+
+    return (SSExchangeIndexPathIsNone(swap.indexPath1) ||
+            SSExchangeIndexPathIsNone(swap.indexPath2) ||
+            SSExchangeIndexPathEqualToIndexPath(swap.indexPath1, swap.indexPath2));
+}
+
+static SSExchangeSwap SSExchangeHistoryRecordAt(const SSExchangeHistory *history, unsigned int offset) {
+
+    return history->records[(history->start + offset) % history->capacity];
+}
+
+static int SSExchangeHistoryComparePositions(const void *position1, const void *position2) {
+
+    uint64_t value1 = *(const uint64_t *)position1;
+    uint64_t value2 = *(const uint64_t *)position2;
+    return (value1 > value2) - (value1 < value2);
+}
+
+static uint32_t SSExchangeHistoryIndexOfPosition(const uint64_t *positions, uint32_t count, uint64_t position) {
+
+    // positions is sorted and position is always in it.
+    uint32_t low = 0;
+    uint32_t high = count - 1;
+
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (positions[middle] < position) low = middle + 1;
+        else high = middle;
+    }
+    return low;
+}
+
+
+
+SSExchangeHistory *SSExchangeHistoryCreate(unsigned int capacity) {
+
+    if (capacity == 0 || capacity > UINT32_MAX / 2) return NULL;
+
+    SSExchangeHistory *history = calloc(1, sizeof(SSExchangeHistory));
+    if (history == NULL) return NULL;
+
+    history->capacity = capacity;
+    history->records = malloc(capacity * sizeof(SSExchangeSwap));
+    history->positions = malloc(2 * (size_t)capacity * sizeof(uint64_t));
+    history->contents = malloc(2 * (size_t)capacity * sizeof(uint32_t));
+
+    if (history->records == NULL || history->positions == NULL || history->contents == NULL) {
+        SSExchangeHistoryFree(history);
+        return NULL;
+    }
+
+    return history;
+}
+
+void SSExchangeHistoryFree(SSExchangeHistory *history) {
+
+    if (history == NULL) return;
+
+    free(history->records);
+    free(history->positions);
+    free(history->contents);
+    free(history);
+}
+
+void SSExchangeHistoryRecord(SSExchangeHistory *history, SSExchangeSwap swap) {
+
+    if (history == NULL || SSExchangeSwapExchangesNothing(swap)) return;
+
+    // Anything that could have been redone no longer can be.
+    history->count = history->numberOfUndos;
+
+    if (history->count == history->capacity) {
+        history->start = (history->start + 1) % history->capacity;
+        history->count--;
+        history->numberOfUndos--;
+    }
+
+    history->records[(history->start + history->count) % history->capacity] = swap;
+    history->count++;
+    history->numberOfUndos++;
+}
+
+void SSExchangeHistoryRemoveAll(SSExchangeHistory *history) {
+
+    if (history == NULL) return;
+
+    history->start = 0;
+    history->count = 0;
+    history->numberOfUndos = 0;
+}
+
+unsigned int SSExchangeHistoryNumberOfUndos(const SSExchangeHistory *history) {
+
+    return (history)? history->numberOfUndos : 0;
+}
+
+unsigned int SSExchangeHistoryNumberOfRedos(const SSExchangeHistory *history) {
+
+    return (history)? history->count - history->numberOfUndos : 0;
+}
+
+unsigned int SSExchangeHistoryUndo(SSExchangeHistory *history, unsigned int numberOfSteps, SSExchangeSwap *swaps) {
+
+    unsigned int numberOfSwaps = SSExchangeHistoryNumberOfUndos(history);
+    if (numberOfSteps < numberOfSwaps) numberOfSwaps = numberOfSteps;
+
+    // Newest first.
+    for (unsigned int i = 0; i < numberOfSwaps; i++) {
+        swaps[i] = SSExchangeHistoryRecordAt(history, history->numberOfUndos - 1 - i);
+    }
+
+    if (numberOfSwaps > 0) history->numberOfUndos -= numberOfSwaps;
+    return numberOfSwaps;
+}
+
+unsigned int SSExchangeHistoryRedo(SSExchangeHistory *history, unsigned int numberOfSteps, SSExchangeSwap *swaps) {
+
+    unsigned int numberOfSwaps = SSExchangeHistoryNumberOfRedos(history);
+    if (numberOfSteps < numberOfSwaps) numberOfSwaps = numberOfSteps;
+
+    // Oldest first, the order they were originally made in.
+    for (unsigned int i = 0; i < numberOfSwaps; i++) {
+        swaps[i] = SSExchangeHistoryRecordAt(history, history->numberOfUndos + i);
+    }
+
+    if (numberOfSwaps > 0) history->numberOfUndos += numberOfSwaps;
+    return numberOfSwaps;
+}
+
+unsigned int SSExchangeHistoryComposeSwaps(SSExchangeHistory *history,
+                                           const SSExchangeSwap *swaps,
+                                           unsigned int numberOfSwaps,
+                                           SSExchangeMove *moves) {
+
+    if (history == NULL || swaps == NULL || numberOfSwaps == 0 || numberOfSwaps > history->capacity) return 0;
+
+    // Every index path the swaps touch, sorted and without duplicates. contents[p] is the position
+    // the item now at positions[p] started at. Each swap exchanges two contents, found by binary
+    // search. At the end every position whose contents changed is a move.
+
+    uint64_t *positions = history->positions;
+    uint32_t *contents = history->contents;
+    uint32_t numberOfPositions = 0;
+
+    for (unsigned int i = 0; i < numberOfSwaps; i++) {
+        positions[numberOfPositions++] = SSExchangeIndexPathPack(swaps[i].indexPath1);
+        positions[numberOfPositions++] = SSExchangeIndexPathPack(swaps[i].indexPath2);
+    }
+
+    qsort(positions, numberOfPositions, sizeof(uint64_t), SSExchangeHistoryComparePositions);
+
+    uint32_t numberOfUniquePositions = 1;
+    for (uint32_t p = 1; p < numberOfPositions; p++) {
+        if (positions[p] != positions[numberOfUniquePositions - 1]) {
+            positions[numberOfUniquePositions++] = positions[p];
+        }
+    }
+
+    for (uint32_t p = 0; p < numberOfUniquePositions; p++) {
+        contents[p] = p;
+    }
+
+    for (unsigned int i = 0; i < numberOfSwaps; i++) {
+        uint32_t p1 = SSExchangeHistoryIndexOfPosition(positions, numberOfUniquePositions, SSExchangeIndexPathPack(swaps[i].indexPath1));
+        uint32_t p2 = SSExchangeHistoryIndexOfPosition(positions, numberOfUniquePositions, SSExchangeIndexPathPack(swaps[i].indexPath2));
+        uint32_t content = contents[p1];
+        contents[p1] = contents[p2];
+        contents[p2] = content;
+    }
+
+    unsigned int numberOfMoves = 0;
+
+    for (uint32_t p = 0; p < numberOfUniquePositions; p++) {
+        if (contents[p] != p) {
+            moves[numberOfMoves].fromIndexPath = SSExchangeIndexPathUnpack(positions[contents[p]]);
+            moves[numberOfMoves].toIndexPath = SSExchangeIndexPathUnpack(positions[p]);
+            numberOfMoves++;
+        }
+    }
+
+    return numberOfMoves;
+}
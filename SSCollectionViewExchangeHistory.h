@@ -0,0 +1,97 @@
+//
+//  SSCollectionViewExchangeHistory.h
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// SSExchangeHistory keeps the exchanges made by finished exchange transactions so they can be
+// undone and redone, any number of steps at a time.
+//
+// The history is a ring buffer of SSExchangeSwap records with a fixed capacity, allocated once
+// when the history is created. When it is full, recording another exchange forgets the oldest.
+// Recording an exchange after undoing forgets everything that could have been redone.
+//
+// An exchange is its own inverse so undoing is just applying the recorded swaps again, newest
+// first. To animate many steps at once, compose the swaps into their net moves with
+// SSExchangeHistoryComposeSwaps() and give those to the collection view in a single
+// performBatchUpdates:completion:.
+//
+// The history is plain C and has no dependency on UIKit or Foundation.
+
+#ifndef SSCollectionViewExchangeHistory_h
+#define SSCollectionViewExchangeHistory_h
+
+#include "SSCollectionViewExchangeCore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef struct SSExchangeHistory SSExchangeHistory;
+
+
+SSExchangeHistory *SSExchangeHistoryCreate(unsigned int capacity);
+// Creates a history that remembers up to capacity exchanges. Each one costs 16 bytes, plus 24 bytes
+// of working memory for SSExchangeHistoryComposeSwaps(). Returns NULL if capacity is 0 or memory
+// can't be allocated. Release the history with SSExchangeHistoryFree().
+
+void SSExchangeHistoryFree(SSExchangeHistory *history);
+// Frees the history. history can be NULL.
+
+void SSExchangeHistoryRecord(SSExchangeHistory *history, SSExchangeSwap swap);
+// Records an exchange, like the final exchange of a transaction. Swaps with equal index paths, or
+// SSExchangeIndexPathNone, exchange nothing and are ignored.
+
+void SSExchangeHistoryRemoveAll(SSExchangeHistory *history);
+// Forgets everything, like after the model is replaced.
+
+unsigned int SSExchangeHistoryNumberOfUndos(const SSExchangeHistory *history);
+unsigned int SSExchangeHistoryNumberOfRedos(const SSExchangeHistory *history);
+// history can be NULL.
+
+unsigned int SSExchangeHistoryUndo(SSExchangeHistory *history, unsigned int numberOfSteps, SSExchangeSwap *swaps);
+// Undoes up to numberOfSteps exchanges. Fills swaps with the swaps to apply to the model, in order,
+// and returns how many there are. swaps must have room for the smaller of numberOfSteps and
+// SSExchangeHistoryNumberOfUndos().
+
+unsigned int SSExchangeHistoryRedo(SSExchangeHistory *history, unsigned int numberOfSteps, SSExchangeSwap *swaps);
+// The same, but redoes exchanges that were undone.
+
+unsigned int SSExchangeHistoryComposeSwaps(SSExchangeHistory *history,
+                                           const SSExchangeSwap *swaps,
+                                           unsigned int numberOfSwaps,
+                                           SSExchangeMove *moves);
+// Produces the same moves as SSExchangeComposeSwaps(), although possibly in a different order, but
+// takes time proportional to n log n rather than n squared so it suits the thousands of swaps that
+// undoing a long history can produce. Uses the history's working memory and doesn't allocate.
+// numberOfSwaps must not exceed the capacity. moves must have room for 2 * numberOfSwaps moves.
+// Returns the number of moves.
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
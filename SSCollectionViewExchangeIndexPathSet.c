@@ -0,0 +1,185 @@
+//
+//  SSCollectionViewExchangeIndexPathSet.c
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include "SSCollectionViewExchangeIndexPathSet.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+struct SSExchangeIndexPathSet {
+    size_t              numberOfSections;
+    size_t              *firstBitOfSections;    // numberOfSections + 1 offsets into words, the last is the total number of items
+    uint64_t            *words;                 // one bit per item, section after section
+    SSExchangeIndexPath *members;               // count members, in the order they were added
+    size_t              count;
+    size_t              capacity;
+};
+
+
+static const size_t SSExchangeIndexPathSetInitialCapacity = 16;
+
+
+static bool SSExchangeIndexPathSetGetBit(const SSExchangeIndexPathSet *set, SSExchangeIndexPath indexPath, size_t *bit) {
+
+    if (SSExchangeIndexPathIsNone(indexPath) || (size_t)indexPath.section >= set->numberOfSections) return false;
+
+    size_t firstBit = set->firstBitOfSections[indexPath.section];
+    size_t numberOfItems = set->firstBitOfSections[indexPath.section + 1] - firstBit;
+    if ((size_t)indexPath.item >= numberOfItems) return false;
+
+    *bit = firstBit + (size_t)indexPath.item;
+    return true;
+}
+
+
+
+//--------------------------
+// Creating and freeing...
+
+SSExchangeIndexPathSet *SSExchangeIndexPathSetCreate(const size_t *numberOfItemsInSections, size_t numberOfSections) {
+
+    if (numberOfItemsInSections == NULL && numberOfSections > 0) return NULL;
+
+    SSExchangeIndexPathSet *set = calloc(1, sizeof(SSExchangeIndexPathSet));
+    if (set == NULL) return NULL;
+
+    set->numberOfSections = numberOfSections;
+    set->firstBitOfSections = malloc((numberOfSections + 1) * sizeof(size_t));
+    if (set->firstBitOfSections == NULL) goto fail;
+
+    size_t numberOfItems = 0;
+    for (size_t section = 0; section < numberOfSections; section++) {
+        set->firstBitOfSections[section] = numberOfItems;
+        numberOfItems += numberOfItemsInSections[section];
+    }
+    set->firstBitOfSections[numberOfSections] = numberOfItems;
+
+    // calloc() so every bit starts clear. At least one word so words is never NULL.
+    set->words = calloc(numberOfItems / 64 + 1, sizeof(uint64_t));
+    set->members = malloc(SSExchangeIndexPathSetInitialCapacity * sizeof(SSExchangeIndexPath));
+    if (set->words == NULL || set->members == NULL) goto fail;
+
+    set->capacity = SSExchangeIndexPathSetInitialCapacity;
+    return set;
+
+fail:
+    SSExchangeIndexPathSetFree(set);
+    return NULL;
+}
+
+void SSExchangeIndexPathSetFree(SSExchangeIndexPathSet *set) {
+
+    if (set == NULL) return;
+
+    free(set->firstBitOfSections);
+    free(set->words);
+    free(set->members);
+    free(set);
+}
+
+bool SSExchangeIndexPathSetHasNumbersOfItems(const SSExchangeIndexPathSet *set, const size_t *numberOfItemsInSections, size_t numberOfSections) {
+
+    if (set == NULL || set->numberOfSections != numberOfSections) return false;
+
+    for (size_t section = 0; section < numberOfSections; section++) {
+        if (set->firstBitOfSections[section + 1] - set->firstBitOfSections[section] != numberOfItemsInSections[section]) return false;
+    }
+    return true;
+}
+
+
+
+//---------------
+// Membership...
+
+bool SSExchangeIndexPathSetAdd(SSExchangeIndexPathSet *set, SSExchangeIndexPath indexPath) {
+
+    size_t bit;
+    if (set == NULL || SSExchangeIndexPathSetGetBit(set, indexPath, &bit) == false) return false;
+
+    uint64_t mask = 1ull << (bit % 64);
+    if (set->words[bit / 64] & mask) return true;
+
+    if (set->count == set->capacity) {
+        SSExchangeIndexPath *members = realloc(set->members, 2 * set->capacity * sizeof(SSExchangeIndexPath));
+        if (members == NULL) return false;
+        set->members = members;
+        set->capacity *= 2;
+    }
+
+    set->words[bit / 64] |= mask;
+    set->members[set->count++] = indexPath;
+    return true;
+}
+
+bool SSExchangeIndexPathSetContainsIndexPath(const SSExchangeIndexPathSet *set, SSExchangeIndexPath indexPath) {
+
+    size_t bit;
+    if (set == NULL || SSExchangeIndexPathSetGetBit(set, indexPath, &bit) == false) return false;
+
+    return (set->words[bit / 64] >> (bit % 64)) & 1;
+}
+
+void SSExchangeIndexPathSetRemove(SSExchangeIndexPathSet *set, SSExchangeIndexPath indexPath) {
+
+    if (SSExchangeIndexPathSetContainsIndexPath(set, indexPath) == false) return;
+
+    size_t bit;
+    SSExchangeIndexPathSetGetBit(set, indexPath, &bit);
+    set->words[bit / 64] &= ~(1ull << (bit % 64));
+
+    for (size_t i = 0; i < set->count; i++) {
+        if (SSExchangeIndexPathEqualToIndexPath(set->members[i], indexPath)) {
+            memmove(&set->members[i], &set->members[i + 1], (set->count - i - 1) * sizeof(SSExchangeIndexPath));
+            set->count--;
+            break;
+        }
+    }
+}
+
+void SSExchangeIndexPathSetRemoveAll(SSExchangeIndexPathSet *set) {
+
+    if (set == NULL) return;
+
+    // Only the members' bits are set, so clearing them is enough.
+    for (size_t i = 0; i < set->count; i++) {
+        size_t bit;
+        if (SSExchangeIndexPathSetGetBit(set, set->members[i], &bit)) set->words[bit / 64] &= ~(1ull << (bit % 64));
+    }
+    set->count = 0;
+}
+
+size_t SSExchangeIndexPathSetCount(const SSExchangeIndexPathSet *set) {
+
+    return (set)? set->count : 0;
+}
+
+const SSExchangeIndexPath *SSExchangeIndexPathSetMembers(const SSExchangeIndexPathSet *set) {
+
+    return (set)? set->members : NULL;
+}
@@ -0,0 +1,93 @@
+//
+//  SSCollectionViewExchangeIndexPathSet.h
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// SSExchangeIndexPathSet is a set of index paths backed by a bitmap with one bit per item.
+//
+// SSCollectionViewExchangeLayout checks every layout attribute it returns against the items to hide
+// and dim. With a single item to hide and one to dim two comparisons were enough, but a group
+// exchange hides and dims as many items as are in the group. A bitmap keeps each check to a shift
+// and a mask however many items there are. The set also keeps a list of its members, in the order
+// they were added, so it can be enumerated and emptied in time proportional to the number of
+// members rather than the number of items. The exchange controller also uses a pair of them to
+// remember the delegate's answers about which items can be displaced.
+//
+// The bitmap is sized for the number of items in each section when the set is created. Create a
+// new set when those change. The set is plain C so it can be used in tests on any platform.
+
+#ifndef SSCollectionViewExchangeIndexPathSet_h
+#define SSCollectionViewExchangeIndexPathSet_h
+
+#include "SSCollectionViewExchangeTypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef struct SSExchangeIndexPathSet SSExchangeIndexPathSet;
+
+
+SSExchangeIndexPathSet *SSExchangeIndexPathSetCreate(const size_t *numberOfItemsInSections, size_t numberOfSections);
+// Creates an empty set that can hold any index path with a section less than numberOfSections and
+// an item less than numberOfItemsInSections[section]. Returns NULL if memory can't be allocated.
+// Release the set with SSExchangeIndexPathSetFree().
+
+void SSExchangeIndexPathSetFree(SSExchangeIndexPathSet *set);
+// Frees the set. set can be NULL.
+
+bool SSExchangeIndexPathSetHasNumbersOfItems(const SSExchangeIndexPathSet *set, const size_t *numberOfItemsInSections, size_t numberOfSections);
+// Returns true if set was created with these numbers of items. set can be NULL, in which case it
+// returns false.
+
+bool SSExchangeIndexPathSetAdd(SSExchangeIndexPathSet *set, SSExchangeIndexPath indexPath);
+// Adds indexPath and returns true. Adding a member again does nothing. Returns false, leaving the
+// set unchanged, if indexPath is outside the numbers of items the set was created with, or if
+// memory can't be allocated. set can be NULL, in which case it returns false.
+
+bool SSExchangeIndexPathSetContainsIndexPath(const SSExchangeIndexPathSet *set, SSExchangeIndexPath indexPath);
+// set can be NULL, in which case it returns false.
+
+void SSExchangeIndexPathSetRemove(SSExchangeIndexPathSet *set, SSExchangeIndexPath indexPath);
+// Removes indexPath if it is a member. Takes time proportional to the count, to keep the members
+// in order. set can be NULL.
+
+void SSExchangeIndexPathSetRemoveAll(SSExchangeIndexPathSet *set);
+// Empties the set, in time proportional to its count. set can be NULL.
+
+size_t SSExchangeIndexPathSetCount(const SSExchangeIndexPathSet *set);
+// The number of members. set can be NULL.
+
+const SSExchangeIndexPath *SSExchangeIndexPathSetMembers(const SSExchangeIndexPathSet *set);
+// SSExchangeIndexPathSetCount() members, in the order they were added. Valid until the set is
+// next changed. set can be NULL, in which case it returns NULL.
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
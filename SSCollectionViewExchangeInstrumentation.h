@@ -0,0 +1,130 @@
+//
+//  SSCollectionViewExchangeInstrumentation.h
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#import <Foundation/Foundation.h>
+
+
+// Opt-in timing of the exchange controller's hot paths. Set the exchange controller's
+// instrumentation property to a sink and every phase below is timed and handed to it as an
+// SSExchangeSample. When the property is nil, the default, nothing is timed.
+//
+// SSCollectionViewExchangeInstrumentation is the provided sink. It keeps the most recent samples
+// in a ring buffer allocated once, and for each phase a histogram of durations in power of two
+// buckets, so recording never allocates and costs a few dozen instructions. Compare the
+// durations with frameBudget to see whether dropped frames come from the delegate or the library.
+//
+// If SS_EXCHANGE_SIGNPOSTS is defined as 1 each phase is also emitted as an os_signpost interval
+// so it shows in Instruments. That requires iOS 12 or later.
+//
+// Samples are recorded on the main thread. SSExchangePhaseCommit is timed on the exchange
+// controller's commit queue and each sample is handed to the sink on the main thread afterwards.
+// Only Foundation is used.
+
+
+typedef enum {
+    SSExchangePhaseCatch,               // beginning a transaction, from the long press to the snapshot being shown
+    SSExchangePhaseSnapshot,            // making the snapshot, part of the catch
+    SSExchangePhaseExchangeEvent,       // each exchange event's batch update, including the delegate's part
+    SSExchangePhaseDelegate,            // each call to the delegate, or group of them, made by the exchange controller; with a commit queue, just queueing the model changes
+    SSExchangePhaseLayout,              // each prepareLayout and layoutAttributesForElementsInRect: of the exchange layout
+    SSExchangePhaseRelease,             // finishing a transaction, up to the start of the release animation
+    SSExchangePhaseReleaseAnimation,    // the release animation, until the snapshot is removed
+    SSExchangePhaseAutoScroll,          // each auto scroll tick, including any exchange event it causes
+    SSExchangePhaseCommit,              // each exchange event's model changes on the commit queue, including exchangeControllerDidFinishExchangeEvent:
+    SSExchangePhaseCount
+} SSExchangePhase;
+
+typedef struct {
+    SSExchangePhase phase;
+    uint64_t        startTime;          // nanoseconds, from SSExchangeInstrumentationTime()
+    uint64_t        duration;           // nanoseconds
+} SSExchangeSample;
+
+#define SSExchangeInstrumentationNumberOfBuckets 64
+// Bucket 0 counts durations of 0. Bucket b counts durations of at least 2^(b-1) and less than 2^b
+// nanoseconds. The last bucket also counts anything longer.
+
+
+uint64_t SSExchangeInstrumentationTime(void);
+// A monotonic clock in nanoseconds.
+
+NSString *NSStringFromSSExchangePhase(SSExchangePhase phase);
+
+
+@protocol SSCollectionViewExchangeInstrumentationSink <NSObject>
+
+- (void)recordSample:(SSExchangeSample)sample;
+// Called on the main thread as each phase ends, often several times a frame. Keep it cheap.
+
+@end
+
+
+uint64_t SSExchangeInstrumentationBeginPhase(SSExchangePhase phase);
+void SSExchangeInstrumentationEndPhase(id<SSCollectionViewExchangeInstrumentationSink> sink, SSExchangePhase phase, uint64_t startTime);
+// Used by the exchange controller and layout. Begin returns the start time to pass to End, which
+// records the sample in sink. Both emit signposts if they are enabled.
+
+SSExchangeSample SSExchangeInstrumentationMakeSample(SSExchangePhase phase, uint64_t startTime);
+// Ends the phase like SSExchangeInstrumentationEndPhase() but returns the sample instead of
+// recording it, for a phase timed off the main thread. Hand the sample to the sink on the main
+// thread.
+
+
+
+@interface SSCollectionViewExchangeInstrumentation : NSObject <SSCollectionViewExchangeInstrumentationSink>
+
+- (id)initWithCapacity:(NSUInteger)capacity;
+// Keeps the most recent capacity samples. init keeps 1024. The histograms count every sample.
+
+@property (nonatomic) uint64_t frameBudget;
+// In nanoseconds. Samples longer than this are counted as over budget. The default is one frame at
+// 60 frames per second. Only meaningful for phases that block the main thread, which is all of them
+// except SSExchangePhaseReleaseAnimation and SSExchangePhaseCommit.
+
+- (NSUInteger)getRecentSamples:(SSExchangeSample *)samples count:(NSUInteger)count;
+// Copies up to count of the most recent samples, oldest first, and returns how many were copied.
+
+- (uint64_t)numberOfSamplesForPhase:(SSExchangePhase)phase;
+- (uint64_t)numberOfSamplesOverFrameBudgetForPhase:(SSExchangePhase)phase;
+- (uint64_t)totalDurationForPhase:(SSExchangePhase)phase;
+- (uint64_t)maximumDurationForPhase:(SSExchangePhase)phase;
+
+- (uint64_t)durationAtPercentile:(double)percentile forPhase:(SSExchangePhase)phase;
+// percentile is from 0 to 100. Returns the upper bound of the histogram bucket the percentile falls
+// in, but no more than the maximum, so it is accurate to within a factor of two. Returns 0 if
+// there are no samples.
+
+- (void)getHistogram:(uint64_t *)buckets forPhase:(SSExchangePhase)phase;
+// buckets must have room for SSExchangeInstrumentationNumberOfBuckets counts.
+
+- (void)removeAllSamples;
+
+- (NSString *)summary;
+// One line for each phase with samples: the count, the 50th and 99th percentiles, the maximum, and
+// the number over budget. Handy for NSLog.
+
+@end
@@ -0,0 +1,303 @@
+//
+//  SSCollectionViewExchangeInstrumentation.m
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#import "SSCollectionViewExchangeInstrumentation.h"
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+#if SS_EXCHANGE_SIGNPOSTS
+#include <os/signpost.h>
+#endif
+
+
+static NSUInteger const SSExchangeInstrumentationDefaultCapacity = 1024;
+
+
+uint64_t SSExchangeInstrumentationTime(void) {
+
+#ifdef __APPLE__
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) mach_timebase_info(&timebase);
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+NSString *NSStringFromSSExchangePhase(SSExchangePhase phase) {
+
+    switch (phase) {
+        case SSExchangePhaseCatch:              return @"Catch";
+        case SSExchangePhaseSnapshot:           return @"Snapshot";
+        case SSExchangePhaseExchangeEvent:      return @"Exchange event";
+        case SSExchangePhaseDelegate:           return @"Delegate";
+        case SSExchangePhaseLayout:             return @"Layout";
+        case SSExchangePhaseRelease:            return @"Release";
+        case SSExchangePhaseReleaseAnimation:   return @"Release animation";
+        case SSExchangePhaseAutoScroll:         return @"Auto scroll";
+        case SSExchangePhaseCommit:             return @"Commit";
+        case SSExchangePhaseCount:              break;
+    }
+    return nil;
+}
+
+
+
+//---------------------------
+#pragma mark - Signposts...
+
+#if SS_EXCHANGE_SIGNPOSTS
+
+static os_log_t SSExchangeInstrumentationLog(void) {
+
+    static os_log_t log;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        log = os_log_create("SSCollectionViewExchangeController", "Exchange");
+    });
+    return log;
+}
+
+// Signpost names must be string literals.
+#define SSExchangeInstrumentationSignpost(signpost, phase)                                                          \
+    switch (phase) {                                                                                                \
+        case SSExchangePhaseCatch:              signpost(SSExchangeInstrumentationLog(), OS_SIGNPOST_ID_EXCLUSIVE, "Catch"); break;              \
+        case SSExchangePhaseSnapshot:           signpost(SSExchangeInstrumentationLog(), OS_SIGNPOST_ID_EXCLUSIVE, "Snapshot"); break;           \
+        case SSExchangePhaseExchangeEvent:      signpost(SSExchangeInstrumentationLog(), OS_SIGNPOST_ID_EXCLUSIVE, "Exchange event"); break;     \
+        case SSExchangePhaseDelegate:           signpost(SSExchangeInstrumentationLog(), OS_SIGNPOST_ID_EXCLUSIVE, "Delegate"); break;           \
+        case SSExchangePhaseLayout:             signpost(SSExchangeInstrumentationLog(), OS_SIGNPOST_ID_EXCLUSIVE, "Layout"); break;             \
+        case SSExchangePhaseRelease:            signpost(SSExchangeInstrumentationLog(), OS_SIGNPOST_ID_EXCLUSIVE, "Release"); break;            \
+        case SSExchangePhaseReleaseAnimation:   signpost(SSExchangeInstrumentationLog(), OS_SIGNPOST_ID_EXCLUSIVE, "Release animation"); break;  \
+        case SSExchangePhaseAutoScroll:         signpost(SSExchangeInstrumentationLog(), OS_SIGNPOST_ID_EXCLUSIVE, "Auto scroll"); break;        \
+        case SSExchangePhaseCommit:             signpost(SSExchangeInstrumentationLog(), OS_SIGNPOST_ID_EXCLUSIVE, "Commit"); break;             \
+        case SSExchangePhaseCount:              break;                                                              \
+    }
+
+#endif
+
+uint64_t SSExchangeInstrumentationBeginPhase(SSExchangePhase phase) {
+
+#if SS_EXCHANGE_SIGNPOSTS
+    SSExchangeInstrumentationSignpost(os_signpost_interval_begin, phase);
+#endif
+    return SSExchangeInstrumentationTime();
+}
+
+void SSExchangeInstrumentationEndPhase(id<SSCollectionViewExchangeInstrumentationSink> sink, SSExchangePhase phase, uint64_t startTime) {
+
+    [sink recordSample:SSExchangeInstrumentationMakeSample(phase, startTime)];
+}
+
+SSExchangeSample SSExchangeInstrumentationMakeSample(SSExchangePhase phase, uint64_t startTime) {
+
+    uint64_t endTime = SSExchangeInstrumentationTime();
+
+#if SS_EXCHANGE_SIGNPOSTS
+    SSExchangeInstrumentationSignpost(os_signpost_interval_end, phase);
+#endif
+
+    SSExchangeSample sample = { phase, startTime, (endTime > startTime)? endTime - startTime : 0 };
+    return sample;
+}
+
+
+
+//-----------------------------------
+#pragma mark - The provided sink...
+
+typedef struct {
+    uint64_t    numberOfSamples;
+    uint64_t    numberOfSamplesOverFrameBudget;
+    uint64_t    totalDuration;
+    uint64_t    maximumDuration;
+    uint64_t    buckets[SSExchangeInstrumentationNumberOfBuckets];
+} SSExchangeHistogram;
+
+static unsigned int SSExchangeHistogramBucketForDuration(uint64_t duration) {
+
+    if (duration == 0) return 0;
+    unsigned int bucket = 64 - (unsigned int)__builtin_clzll(duration);
+    return (bucket < SSExchangeInstrumentationNumberOfBuckets)? bucket : SSExchangeInstrumentationNumberOfBuckets - 1;
+}
+
+
+
+@interface SSCollectionViewExchangeInstrumentation () {
+
+    SSExchangeSample        *_samples;          // capacity samples, a ring ending just before _nextSample
+    NSUInteger              _capacity;
+    NSUInteger              _nextSample;
+    NSUInteger              _numberOfRecentSamples;
+    SSExchangeHistogram     _histograms[SSExchangePhaseCount];
+}
+
+@end
+
+
+
+@implementation SSCollectionViewExchangeInstrumentation
+
+- (id)init {
+
+    return [self initWithCapacity:SSExchangeInstrumentationDefaultCapacity];
+}
+
+- (id)initWithCapacity:(NSUInteger)capacity {
+
+    self = [super init];
+    if (self) {
+
+        _capacity = MAX(capacity, 1);
+        _samples = malloc(_capacity * sizeof(SSExchangeSample));
+        if (_samples == NULL) return nil;
+
+        _frameBudget = 1000000000ull / 60;
+    }
+    return self;
+}
+
+- (void)dealloc {
+
+    free(_samples);
+}
+
+- (void)recordSample:(SSExchangeSample)sample {
+
+    if ((unsigned int)sample.phase >= SSExchangePhaseCount) return;
+
+    _samples[_nextSample] = sample;
+    _nextSample = (_nextSample + 1 == _capacity)? 0 : _nextSample + 1;
+    if (_numberOfRecentSamples < _capacity) _numberOfRecentSamples++;
+
+    SSExchangeHistogram *histogram = &_histograms[sample.phase];
+    histogram->numberOfSamples++;
+    histogram->totalDuration += sample.duration;
+    histogram->buckets[SSExchangeHistogramBucketForDuration(sample.duration)]++;
+    if (sample.duration > histogram->maximumDuration) histogram->maximumDuration = sample.duration;
+    if (sample.duration > _frameBudget) histogram->numberOfSamplesOverFrameBudget++;
+}
+
+- (NSUInteger)getRecentSamples:(SSExchangeSample *)samples count:(NSUInteger)count {
+
+    if (samples == NULL) return 0;
+
+    NSUInteger numberToCopy = MIN(count, _numberOfRecentSamples);
+    NSUInteger first = (_nextSample + _capacity - numberToCopy) % _capacity;
+
+    for (NSUInteger i = 0; i < numberToCopy; i++) {
+        samples[i] = _samples[(first + i) % _capacity];
+    }
+    return numberToCopy;
+}
+
+- (uint64_t)numberOfSamplesForPhase:(SSExchangePhase)phase {
+
+    return ((unsigned int)phase < SSExchangePhaseCount)? _histograms[phase].numberOfSamples : 0;
+}
+
+- (uint64_t)numberOfSamplesOverFrameBudgetForPhase:(SSExchangePhase)phase {
+
+    return ((unsigned int)phase < SSExchangePhaseCount)? _histograms[phase].numberOfSamplesOverFrameBudget : 0;
+}
+
+- (uint64_t)totalDurationForPhase:(SSExchangePhase)phase {
+
+    return ((unsigned int)phase < SSExchangePhaseCount)? _histograms[phase].totalDuration : 0;
+}
+
+- (uint64_t)maximumDurationForPhase:(SSExchangePhase)phase {
+
+    return ((unsigned int)phase < SSExchangePhaseCount)? _histograms[phase].maximumDuration : 0;
+}
+
+- (uint64_t)durationAtPercentile:(double)percentile forPhase:(SSExchangePhase)phase {
+
+    if ((unsigned int)phase >= SSExchangePhaseCount) return 0;
+
+    const SSExchangeHistogram *histogram = &_histograms[phase];
+    if (histogram->numberOfSamples == 0) return 0;
+
+    // The rank of the sample at the percentile, counting from 1.
+    double rank = ceil(MIN(MAX(percentile, 0.0), 100.0) / 100.0 * histogram->numberOfSamples);
+    uint64_t target = MAX((uint64_t)rank, 1);
+    uint64_t cumulative = 0;
+
+    for (unsigned int bucket = 0; bucket < SSExchangeInstrumentationNumberOfBuckets; bucket++) {
+        cumulative += histogram->buckets[bucket];
+        if (cumulative >= target) {
+            uint64_t upperBound = (1ull << bucket) - 1;
+            return MIN(upperBound, histogram->maximumDuration);
+        }
+    }
+    return histogram->maximumDuration;
+}
+
+- (void)getHistogram:(uint64_t *)buckets forPhase:(SSExchangePhase)phase {
+
+    if (buckets == NULL) return;
+
+    if ((unsigned int)phase < SSExchangePhaseCount) {
+        memcpy(buckets, _histograms[phase].buckets, sizeof(_histograms[phase].buckets));
+    } else {
+        memset(buckets, 0, SSExchangeInstrumentationNumberOfBuckets * sizeof(uint64_t));
+    }
+}
+
+- (void)removeAllSamples {
+
+    _nextSample = 0;
+    _numberOfRecentSamples = 0;
+    memset(_histograms, 0, sizeof(_histograms));
+}
+
+- (NSString *)summary {
+
+    NSMutableString *summary = [NSMutableString string];
+
+    for (int phase = 0; phase < SSExchangePhaseCount; phase++) {
+
+        uint64_t numberOfSamples = [self numberOfSamplesForPhase:phase];
+        if (numberOfSamples == 0) continue;
+
+        [summary appendFormat:@"%@: %llu samples, p50 %.3f ms, p99 %.3f ms, max %.3f ms, %llu over budget\n",
+         NSStringFromSSExchangePhase(phase),
+         (unsigned long long)numberOfSamples,
+         [self durationAtPercentile:50 forPhase:phase] / 1e6,
+         [self durationAtPercentile:99 forPhase:phase] / 1e6,
+         [self maximumDurationForPhase:phase] / 1e6,
+         (unsigned long long)[self numberOfSamplesOverFrameBudgetForPhase:phase]];
+    }
+    return summary;
+}
+
+@end
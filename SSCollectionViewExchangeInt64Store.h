@@ -0,0 +1,84 @@
+//
+//  SSCollectionViewExchangeInt64Store.h
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#import "SSCollectionViewExchangeBackingStore.h"
+
+
+// SSCollectionViewExchangeInt64Store keeps every item as an unboxed int64_t, a value or the ID of an
+// object kept elsewhere, in one contiguous buffer: section 0's items, then section 1's, and so on.
+// An exchange is two loads and two stores. There is no boxing and nothing to retain or release.
+//
+// The store also keeps the sum of each section's items. An exchange within a section doesn't change
+// it and an exchange between sections adjusts both sums by the difference, so reading a sum never
+// iterates. Sums wrap on overflow.
+//
+// The layout of the buffer is what -data returns, and is also the file format of
+// SSCollectionViewExchangeMappedInt64Store: a 16 byte header (the magic number 'SSXS', version 1
+// and the number of sections, each a uint32_t, then 4 reserved bytes), the number of items in
+// each section as a uint64_t, then the items. Everything is in the device's byte order.
+
+
+@interface SSCollectionViewExchangeInt64Store : NSObject <SSCollectionViewExchangeBackingStore>
+
+- (id)initWithNumbersOfItems:(const NSUInteger *)numbersOfItems numberOfSections:(NSUInteger)numberOfSections;
+// Every item is 0. Returns nil if a section has more items than an SSExchangeIndexPath can address
+// or memory can't be allocated.
+
+- (id)initWithArrays:(NSArray *)arrays;
+// arrays holds one array of NSNumbers for each section. Each item is the number's longLongValue.
+
+- (id)initWithData:(NSData *)data;
+// data must be the layout described above, like from -data. Returns nil if it isn't.
+
+- (NSData *)data;
+
+- (int64_t)itemAtIndexPath:(SSExchangeIndexPath)indexPath;
+- (void)setItem:(int64_t)item atIndexPath:(SSExchangeIndexPath)indexPath;
+// indexPath must exist. Setting an item adjusts its section's sum.
+
+- (const int64_t *)itemsInSection:(NSUInteger)section;
+// The section's items, contiguous, for reading. Valid until the store is deallocated.
+
+- (int64_t)sumOfItemsInSection:(NSUInteger)section;
+
+@end
+
+
+
+@interface SSCollectionViewExchangeMappedInt64Store : SSCollectionViewExchangeInt64Store
+
+- (id)initWithContentsOfFile:(NSString *)path;
+// Maps the file, which must hold the layout described above, shared and writable. Create the file
+// by writing the -data of another store to it. Exchanges change the file in place and the system
+// pages the items in and out as they are used, so the store can be far larger than memory. The
+// sums are calculated once, here, which reads every item. Returns nil if the file can't be opened
+// or mapped or doesn't hold a valid layout.
+
+- (BOOL)synchronize;
+// Waits for every change to reach the file.
+
+@end
@@ -0,0 +1,407 @@
+//
+//  SSCollectionViewExchangeInt64Store.m
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#import "SSCollectionViewExchangeInt64Store.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+static const uint32_t   SSExchangeInt64StoreMagic = 'SSXS';
+static const uint32_t   SSExchangeInt64StoreVersion = 1;
+static const size_t     SSExchangeInt64StoreHeaderLength = 16;
+
+
+static void *SSExchangeInt64StoreCreateBuffer(const NSUInteger *numbersOfItems, NSUInteger numberOfSections, size_t *length) {
+
+    if (numberOfSections > INT32_MAX || (numberOfSections > 0 && numbersOfItems == NULL)) return NULL;
+
+    size_t numberOfValues = SSExchangeInt64StoreHeaderLength / sizeof(uint64_t) + numberOfSections;
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        if (numbersOfItems[section] > INT32_MAX || numbersOfItems[section] > SIZE_MAX / sizeof(int64_t) - numberOfValues) return NULL;
+        numberOfValues += numbersOfItems[section];
+    }
+
+    uint8_t *buffer = calloc(numberOfValues, sizeof(int64_t));
+    if (buffer == NULL) return NULL;
+
+    uint32_t header[4] = { SSExchangeInt64StoreMagic, SSExchangeInt64StoreVersion, (uint32_t)numberOfSections, 0 };
+    memcpy(buffer, header, sizeof(header));
+
+    uint64_t *counts = (uint64_t *)(buffer + SSExchangeInt64StoreHeaderLength);
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        counts[section] = numbersOfItems[section];
+    }
+
+    *length = numberOfValues * sizeof(int64_t);
+    return buffer;
+}
+
+static inline BOOL SSExchangeInt64StoreContainsIndexPath(const uint64_t *counts, NSUInteger numberOfSections, SSExchangeIndexPath indexPath) {
+
+    return (indexPath.section >= 0 && (NSUInteger)indexPath.section < numberOfSections &&
+            indexPath.item >= 0 && (uint64_t)indexPath.item < counts[indexPath.section]);
+}
+
+static int SSExchangeInt64StoreCompareIndexPaths(const void *indexPath1, const void *indexPath2) {
+
+    uint64_t value1 = *(const uint64_t *)indexPath1;
+    uint64_t value2 = *(const uint64_t *)indexPath2;
+    return (value1 > value2) - (value1 < value2);
+}
+
+
+
+@interface SSCollectionViewExchangeInt64Store ()
+
+@property (nonatomic) void          *buffer;            // the whole layout, owned by the store
+@property (nonatomic) size_t        length;
+@property (nonatomic) NSUInteger    numberOfSections;
+@property (nonatomic) uint64_t      *counts;            // in buffer
+@property (nonatomic) int64_t       *values;            // in buffer
+@property (nonatomic) NSUInteger    *sectionStarts;     // numberOfSections + 1 offsets into values
+@property (nonatomic) uint64_t      *sums;              // numberOfSections sums, unsigned so they wrap
+
+- (id)initWithBuffer:(void *)buffer length:(size_t)length;
+- (void)releaseBuffer:(void *)buffer length:(size_t)length;
+
+@end
+
+
+
+@implementation SSCollectionViewExchangeInt64Store
+
+- (id)initWithNumbersOfItems:(const NSUInteger *)numbersOfItems numberOfSections:(NSUInteger)numberOfSections {
+
+    size_t length = 0;
+    void *buffer = SSExchangeInt64StoreCreateBuffer(numbersOfItems, numberOfSections, &length);
+    if (buffer == NULL) return nil;
+
+    return [self initWithBuffer:buffer length:length];
+}
+
+- (id)initWithArrays:(NSArray *)arrays {
+
+    NSUInteger numberOfSections = arrays.count;
+    NSUInteger *numbersOfItems = malloc(MAX(numberOfSections, 1) * sizeof(NSUInteger));
+    if (numbersOfItems == NULL) return nil;
+
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        numbersOfItems[section] = [arrays[section] count];
+    }
+
+    size_t length = 0;
+    uint8_t *buffer = SSExchangeInt64StoreCreateBuffer(numbersOfItems, numberOfSections, &length);
+    free(numbersOfItems);
+    if (buffer == NULL) return nil;
+
+    int64_t *values = (int64_t *)(buffer + SSExchangeInt64StoreHeaderLength + numberOfSections * sizeof(uint64_t));
+    for (NSArray *array in arrays) {
+        for (NSNumber *number in array) {
+            *values++ = [number longLongValue];
+        }
+    }
+
+    return [self initWithBuffer:buffer length:length];
+}
+
+- (id)initWithData:(NSData *)data {
+
+    void *buffer = malloc(MAX(data.length, 1));
+    if (buffer == NULL) return nil;
+    [data getBytes:buffer length:data.length];
+
+    return [self initWithBuffer:buffer length:data.length];
+}
+
+- (id)initWithBuffer:(void *)buffer length:(size_t)length {
+
+    // Takes ownership of buffer, even on failure.
+    self = [super init];
+    if (self == nil || ![self adoptBuffer:buffer length:length]) {
+        [self releaseBuffer:buffer length:length];
+        return nil;
+    }
+    return self;
+}
+
+- (BOOL)adoptBuffer:(uint8_t *)buffer length:(size_t)length {
+
+    if (length < SSExchangeInt64StoreHeaderLength) return NO;
+
+    uint32_t header[4];
+    memcpy(header, buffer, sizeof(header));
+    if (header[0] != SSExchangeInt64StoreMagic || header[1] != SSExchangeInt64StoreVersion || header[2] > INT32_MAX) return NO;
+
+    NSUInteger numberOfSections = header[2];
+    if (numberOfSections > (length - SSExchangeInt64StoreHeaderLength) / sizeof(uint64_t)) return NO;
+
+    uint64_t *counts = (uint64_t *)(buffer + SSExchangeInt64StoreHeaderLength);
+    size_t numberOfValues = (length - SSExchangeInt64StoreHeaderLength) / sizeof(uint64_t) - numberOfSections;
+    if (SSExchangeInt64StoreHeaderLength + (numberOfSections + numberOfValues) * sizeof(uint64_t) != length) return NO;
+
+    NSUInteger *sectionStarts = malloc((numberOfSections + 1) * sizeof(NSUInteger));
+    uint64_t *sums = calloc(MAX(numberOfSections, 1), sizeof(uint64_t));
+    if (sectionStarts == NULL || sums == NULL) {
+        free(sectionStarts);
+        free(sums);
+        return NO;
+    }
+
+    sectionStarts[0] = 0;
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        if (counts[section] > INT32_MAX || counts[section] > numberOfValues - sectionStarts[section]) {
+            free(sectionStarts);
+            free(sums);
+            return NO;
+        }
+        sectionStarts[section + 1] = sectionStarts[section] + (NSUInteger)counts[section];
+    }
+
+    if (sectionStarts[numberOfSections] != numberOfValues) {
+        free(sectionStarts);
+        free(sums);
+        return NO;
+    }
+
+    int64_t *values = (int64_t *)(counts + numberOfSections);
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        for (NSUInteger i = sectionStarts[section]; i < sectionStarts[section + 1]; i++) {
+            sums[section] += (uint64_t)values[i];
+        }
+    }
+
+    _buffer = buffer;
+    _length = length;
+    _numberOfSections = numberOfSections;
+    _counts = counts;
+    _values = values;
+    _sectionStarts = sectionStarts;
+    _sums = sums;
+
+    return YES;
+}
+
+- (void)releaseBuffer:(void *)buffer length:(size_t)length {
+
+    free(buffer);
+}
+
+- (void)dealloc {
+
+    if (_buffer) [self releaseBuffer:_buffer length:_length];
+    free(_sectionStarts);
+    free(_sums);
+}
+
+
+
+//--------------------------
+#pragma mark - Accessing...
+
+- (NSData *)data {
+
+    return [NSData dataWithBytes:self.buffer length:self.length];
+}
+
+- (NSUInteger)numberOfItemsInSection:(NSUInteger)section {
+
+    return (section < self.numberOfSections)? (NSUInteger)self.counts[section] : 0;
+}
+
+- (int64_t)itemAtIndexPath:(SSExchangeIndexPath)indexPath {
+
+    NSAssert(SSExchangeInt64StoreContainsIndexPath(self.counts, self.numberOfSections, indexPath), @"indexPath does not exist");
+    return self.values[self.sectionStarts[indexPath.section] + indexPath.item];
+}
+
+- (void)setItem:(int64_t)item atIndexPath:(SSExchangeIndexPath)indexPath {
+
+    NSAssert(SSExchangeInt64StoreContainsIndexPath(self.counts, self.numberOfSections, indexPath), @"indexPath does not exist");
+    int64_t *value = &self.values[self.sectionStarts[indexPath.section] + indexPath.item];
+    self.sums[indexPath.section] += (uint64_t)item - (uint64_t)*value;
+    *value = item;
+}
+
+- (const int64_t *)itemsInSection:(NSUInteger)section {
+
+    NSAssert(section < self.numberOfSections, @"section does not exist");
+    return self.values + self.sectionStarts[section];
+}
+
+- (int64_t)sumOfItemsInSection:(NSUInteger)section {
+
+    NSAssert(section < self.numberOfSections, @"section does not exist");
+    return (int64_t)self.sums[section];
+}
+
+
+
+//---------------------------
+#pragma mark - Exchanging...
+
+- (BOOL)exchangeItemsWithSwaps:(const SSExchangeSwap *)swaps count:(NSUInteger)count {
+
+    if (count == 0) return YES;
+    if (swaps == NULL) return NO;
+
+    const uint64_t *counts = self.counts;
+    NSUInteger numberOfSections = self.numberOfSections;
+
+    // Validate everything first...
+    for (NSUInteger i = 0; i < count; i++) {
+        if (!SSExchangeInt64StoreContainsIndexPath(counts, numberOfSections, swaps[i].indexPath1) ||
+            !SSExchangeInt64StoreContainsIndexPath(counts, numberOfSections, swaps[i].indexPath2)) return NO;
+    }
+
+    int64_t *values = self.values;
+    const NSUInteger *sectionStarts = self.sectionStarts;
+    uint64_t *sums = self.sums;
+
+    for (NSUInteger i = 0; i < count; i++) {
+
+        SSExchangeIndexPath indexPath1 = swaps[i].indexPath1;
+        SSExchangeIndexPath indexPath2 = swaps[i].indexPath2;
+        int64_t *item1 = &values[sectionStarts[indexPath1.section] + indexPath1.item];
+        int64_t *item2 = &values[sectionStarts[indexPath2.section] + indexPath2.item];
+        int64_t value1 = *item1;
+        int64_t value2 = *item2;
+
+        if (indexPath1.section != indexPath2.section) {
+            uint64_t difference = (uint64_t)value2 - (uint64_t)value1;
+            sums[indexPath1.section] += difference;
+            sums[indexPath2.section] -= difference;
+        }
+
+        *item1 = value2;
+        *item2 = value1;
+    }
+
+    return YES;
+}
+
+- (BOOL)moveItemsWithMoves:(const SSExchangeMove *)moves count:(NSUInteger)count {
+
+    if (count == 0) return YES;
+    if (moves == NULL) return NO;
+
+    const uint64_t *counts = self.counts;
+    NSUInteger numberOfSections = self.numberOfSections;
+
+    for (NSUInteger i = 0; i < count; i++) {
+        if (!SSExchangeInt64StoreContainsIndexPath(counts, numberOfSections, moves[i].fromIndexPath) ||
+            !SSExchangeInt64StoreContainsIndexPath(counts, numberOfSections, moves[i].toIndexPath)) return NO;
+    }
+
+    // The moves must be a permutation, or items would be duplicated and others lost: sorted, the
+    // packed fromIndexPaths and toIndexPaths are the same, with none named twice...
+    uint64_t *fromIndexPaths = malloc(2 * count * sizeof(uint64_t));
+    if (fromIndexPaths == NULL) return NO;
+    uint64_t *toIndexPaths = fromIndexPaths + count;
+
+    for (NSUInteger i = 0; i < count; i++) {
+        fromIndexPaths[i] = SSExchangeIndexPathPack(moves[i].fromIndexPath);
+        toIndexPaths[i] = SSExchangeIndexPathPack(moves[i].toIndexPath);
+    }
+    qsort(fromIndexPaths, count, sizeof(uint64_t), SSExchangeInt64StoreCompareIndexPaths);
+    qsort(toIndexPaths, count, sizeof(uint64_t), SSExchangeInt64StoreCompareIndexPaths);
+
+    BOOL isPermutation = YES;
+    for (NSUInteger i = 0; isPermutation && i < count; i++) {
+        if (fromIndexPaths[i] != toIndexPaths[i] || (i > 0 && fromIndexPaths[i] == fromIndexPaths[i - 1])) isPermutation = NO;
+    }
+    free(fromIndexPaths);
+    if (!isPermutation) return NO;
+
+    int64_t *movingValues = malloc(count * sizeof(int64_t));
+    if (movingValues == NULL) return NO;
+
+    int64_t *values = self.values;
+    const NSUInteger *sectionStarts = self.sectionStarts;
+    uint64_t *sums = self.sums;
+
+    // Pick up every item that moves before putting any of them down...
+    for (NSUInteger i = 0; i < count; i++) {
+        SSExchangeIndexPath fromIndexPath = moves[i].fromIndexPath;
+        movingValues[i] = values[sectionStarts[fromIndexPath.section] + fromIndexPath.item];
+    }
+
+    for (NSUInteger i = 0; i < count; i++) {
+
+        SSExchangeIndexPath fromIndexPath = moves[i].fromIndexPath;
+        SSExchangeIndexPath toIndexPath = moves[i].toIndexPath;
+        values[sectionStarts[toIndexPath.section] + toIndexPath.item] = movingValues[i];
+
+        if (fromIndexPath.section != toIndexPath.section) {
+            sums[fromIndexPath.section] -= (uint64_t)movingValues[i];
+            sums[toIndexPath.section] += (uint64_t)movingValues[i];
+        }
+    }
+
+    free(movingValues);
+    return YES;
+}
+
+@end
+
+
+
+@implementation SSCollectionViewExchangeMappedInt64Store
+
+- (id)initWithContentsOfFile:(NSString *)path {
+
+    int fileDescriptor = open([path fileSystemRepresentation], O_RDWR);
+    if (fileDescriptor < 0) return nil;
+
+    struct stat status;
+    if (fstat(fileDescriptor, &status) != 0 || status.st_size <= 0 || (uintmax_t)status.st_size > SIZE_MAX) {
+        close(fileDescriptor);
+        return nil;
+    }
+
+    size_t length = (size_t)status.st_size;
+    void *buffer = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+
+    // The mapping keeps the file open.
+    close(fileDescriptor);
+    if (buffer == MAP_FAILED) return nil;
+
+    return [self initWithBuffer:buffer length:length];
+}
+
+- (void)releaseBuffer:(void *)buffer length:(size_t)length {
+
+    munmap(buffer, length);
+}
+
+- (BOOL)synchronize {
+
+    return msync(self.buffer, self.length, MS_SYNC) == 0;
+}
+
+@end
@@ -0,0 +1,117 @@
+//
+//  SSCollectionViewExchangeJournal.h
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#import <Foundation/Foundation.h>
+#import "SSCollectionViewExchangeTypes.h"
+
+
+// SSCollectionViewExchangeJournal persists a model that changes by exchanges without rewriting
+// the whole model after every exchange transaction.
+//
+// It keeps two files in a directory. The snapshot file holds the model as it was at some moment,
+// in whatever form the snapshot provider chooses. The log file holds every exchange since then, 16
+// bytes each, appended one at a time as transactions finish. Saving a transaction is one small
+// write no matter how big the model is. Once enough exchanges have been logged the journal asks
+// the snapshot provider for the current model, writes a new snapshot, and empties the log.
+//
+// On launch, restore the model from snapshotData then apply the logged exchanges, which
+// replayExchangesWithBlock: hands back in order, with NSMutableArray's
+// exchangeObjectsInArrays:withSwaps:count:.
+//
+// Only Foundation is used. Exchanges are recorded as they are reported by
+// exchangeControllerDidFinishExchangeTransaction:withIndexPath1:indexPath2:, and by your own code
+// for anything like undo that exchanges items outside of a transaction.
+//
+// If the app is killed while an exchange is being written the partial record is ignored. If it
+// is killed while a snapshot is being written either the old snapshot and its log or the new
+// snapshot is used, never a mix of the two.
+
+
+@class SSCollectionViewExchangeJournal;
+
+
+@protocol SSCollectionViewExchangeJournalSnapshotProvider <NSObject>
+
+- (NSData *)snapshotDataForExchangeJournal:(SSCollectionViewExchangeJournal *)exchangeJournal;
+// Return the whole model, as it is now, archived in any form. It is returned, as is, by
+// snapshotData. Return nil if the model can't be archived, the log is kept instead.
+
+@end
+
+
+
+@interface SSCollectionViewExchangeJournal : NSObject
+
+- (id)initWithDirectoryPath:(NSString *)directoryPath;
+// The directory is created if it doesn't exist. Returns nil if it can't be created or the log
+// can't be opened.
+
+@property (weak, nonatomic) id<SSCollectionViewExchangeJournalSnapshotProvider> snapshotProvider;
+
+@property (nonatomic) NSUInteger numberOfExchangesBetweenSnapshots;
+// Once this many exchanges have been logged since the last snapshot the next append writes a new
+// snapshot from the snapshot provider. The default is 512. Zero means never.
+
+@property (nonatomic, readonly) NSUInteger numberOfExchangesSinceSnapshot;
+
+@property (nonatomic, readonly) BOOL hasSnapshot;
+
+- (BOOL)appendExchangeOfItemAtIndexPath1:(NSIndexPath *)indexPath1 withItemAtIndexPath2:(NSIndexPath *)indexPath2;
+// Logs an exchange. If the index paths are equal there was no exchange and nothing is logged.
+// Returns NO if the exchange could not be written.
+
+- (BOOL)appendSwap:(SSExchangeSwap)swap;
+// The same but for an SSExchangeSwap.
+
+- (BOOL)appendSwaps:(const SSExchangeSwap *)swaps count:(NSUInteger)count;
+// Logs count exchanges, in order, with a single write. Use it for anything that applies many
+// exchanges at once, like undoing several steps. Returns NO, logging none of them, if any index
+// path is SSExchangeIndexPathNone or they could not be written.
+
+- (BOOL)writeSnapshot;
+// Writes a new snapshot from the snapshot provider and empties the log. Use it after replacing
+// the whole model, like on first run or reset. Returns NO if there is no snapshot provider, it
+// returned nil, or the snapshot could not be written, in which case the old snapshot and log are
+// still used.
+
+- (BOOL)writeSnapshotData:(NSData *)snapshotData;
+// The same but for snapshot data you already have.
+
+- (NSData *)snapshotData;
+// Returns the snapshot data, as it was returned by the snapshot provider, or nil if there is no
+// snapshot.
+
+- (void)replayExchangesWithBlock:(void (^)(const SSExchangeSwap *swaps, NSUInteger count))block;
+// Calls block once with all the exchanges logged since the snapshot, in the order they were
+// appended. block is not called if there are none. The swaps are only valid for the duration
+// of the block.
+
+- (BOOL)synchronize;
+// Forces everything written so far to permanent storage. Appends are written to the file system
+// straight away but, like NSUserDefaults, the system decides when they reach the disk.
+
+@end
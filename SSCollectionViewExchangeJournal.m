@@ -0,0 +1,383 @@
+//
+//  SSCollectionViewExchangeJournal.m
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#import "SSCollectionViewExchangeJournal.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+// Both files start with the same header: a magic number, a format version, and the snapshot's
+// generation. The log only belongs to the snapshot with the same generation. All integers are
+// little-endian.
+//
+// Each log record is an exchange: section and item of indexPath1 then section and item of indexPath2.
+
+static const char       SSExchangeJournalMagic[4] = { 'S', 'S', 'X', 'J' };
+static const uint32_t   SSExchangeJournalVersion = 1;
+static const size_t     SSExchangeJournalHeaderLength = 16;
+static const size_t     SSExchangeJournalRecordLength = 16;
+
+static NSString * const SSExchangeJournalSnapshotFileName = @"exchanges.snapshot";
+static NSString * const SSExchangeJournalLogFileName = @"exchanges.log";
+
+
+static void SSExchangeJournalEncodeHeader(uint8_t *bytes, uint64_t generation) {
+
+    uint32_t version = NSSwapHostIntToLittle(SSExchangeJournalVersion);
+    uint64_t littleEndianGeneration = NSSwapHostLongLongToLittle(generation);
+
+    memcpy(bytes, SSExchangeJournalMagic, 4);
+    memcpy(bytes + 4, &version, 4);
+    memcpy(bytes + 8, &littleEndianGeneration, 8);
+}
+
+static BOOL SSExchangeJournalDecodeHeader(const uint8_t *bytes, uint64_t *generation) {
+
+    uint32_t version;
+    uint64_t littleEndianGeneration;
+
+    memcpy(&version, bytes + 4, 4);
+    memcpy(&littleEndianGeneration, bytes + 8, 8);
+
+    if (memcmp(bytes, SSExchangeJournalMagic, 4) != 0) return NO;
+    if (NSSwapLittleIntToHost(version) != SSExchangeJournalVersion) return NO;
+
+    *generation = NSSwapLittleLongLongToHost(littleEndianGeneration);
+    return YES;
+}
+
+static void SSExchangeJournalEncodeSwap(uint8_t *bytes, SSExchangeSwap swap) {
+
+    uint32_t values[4] = { NSSwapHostIntToLittle((uint32_t)swap.indexPath1.section),
+                           NSSwapHostIntToLittle((uint32_t)swap.indexPath1.item),
+                           NSSwapHostIntToLittle((uint32_t)swap.indexPath2.section),
+                           NSSwapHostIntToLittle((uint32_t)swap.indexPath2.item) };
+    memcpy(bytes, values, sizeof(values));
+}
+
+static SSExchangeSwap SSExchangeJournalDecodeSwap(const uint8_t *bytes) {
+
+    uint32_t values[4];
+    memcpy(values, bytes, sizeof(values));
+
+    return SSExchangeSwapMake(SSExchangeIndexPathMake((int32_t)NSSwapLittleIntToHost(values[0]), (int32_t)NSSwapLittleIntToHost(values[1])),
+                              SSExchangeIndexPathMake((int32_t)NSSwapLittleIntToHost(values[2]), (int32_t)NSSwapLittleIntToHost(values[3])));
+}
+
+static BOOL SSExchangeJournalWriteAll(int fileDescriptor, const uint8_t *bytes, size_t length, off_t offset) {
+
+    while (length > 0) {
+        ssize_t written = pwrite(fileDescriptor, bytes, length, offset);
+        if (written <= 0) return NO;
+        bytes += written;
+        length -= (size_t)written;
+        offset += written;
+    }
+    return YES;
+}
+
+
+
+@interface SSCollectionViewExchangeJournal ()
+
+@property (strong, nonatomic)   NSString    *snapshotPath;
+@property (strong, nonatomic)   NSString    *logPath;
+@property (nonatomic)           int         logFileDescriptor;      // -1 when the log isn't open
+@property (nonatomic)           off_t       logLength;              // the header and every complete record
+@property (nonatomic)           uint64_t    snapshotGeneration;     // 0 when there is no snapshot
+@property (nonatomic, readwrite) NSUInteger numberOfExchangesSinceSnapshot;
+@property (nonatomic, readwrite) BOOL       hasSnapshot;
+
+@end
+
+
+
+@implementation SSCollectionViewExchangeJournal
+
+- (id)initWithDirectoryPath:(NSString *)directoryPath {
+
+    self = [super init];
+    if (self) {
+
+        if (![[NSFileManager defaultManager] createDirectoryAtPath:directoryPath withIntermediateDirectories:YES attributes:nil error:NULL]) {
+            return nil;
+        }
+
+        _snapshotPath = [directoryPath stringByAppendingPathComponent:SSExchangeJournalSnapshotFileName];
+        _logPath = [directoryPath stringByAppendingPathComponent:SSExchangeJournalLogFileName];
+        _logFileDescriptor = -1;
+        _numberOfExchangesBetweenSnapshots = 512;
+
+        if (![self openLog]) return nil;
+    }
+    return self;
+}
+
+- (void)dealloc {
+
+    [self closeLog];
+}
+
+
+
+//-------------------------------------
+#pragma mark - Opening and closing...
+
+- (BOOL)openLog {
+
+    // Finds the current snapshot's generation then opens the log for it. A log that belongs to an
+    // older snapshot, or isn't a log at all, is emptied. A partial record at the end, left by
+    // being killed in the middle of an append, is cut off.
+
+    [self closeLog];
+    [self readSnapshotGeneration];
+
+    int fileDescriptor = open([self.logPath fileSystemRepresentation], O_RDWR | O_CREAT, 0644);
+    if (fileDescriptor < 0) return NO;
+
+    struct stat status;
+    uint8_t header[SSExchangeJournalHeaderLength];
+    uint64_t logGeneration = 0;
+
+    BOOL logIsValid = (fstat(fileDescriptor, &status) == 0 &&
+                       status.st_size >= (off_t)SSExchangeJournalHeaderLength &&
+                       pread(fileDescriptor, header, SSExchangeJournalHeaderLength, 0) == (ssize_t)SSExchangeJournalHeaderLength &&
+                       SSExchangeJournalDecodeHeader(header, &logGeneration) &&
+                       logGeneration == self.snapshotGeneration);
+
+    off_t logLength = SSExchangeJournalHeaderLength;
+
+    if (logIsValid) {
+
+        off_t numberOfRecords = (status.st_size - SSExchangeJournalHeaderLength) / SSExchangeJournalRecordLength;
+        logLength += numberOfRecords * SSExchangeJournalRecordLength;
+
+        if (logLength != status.st_size && ftruncate(fileDescriptor, logLength) != 0) {
+            close(fileDescriptor);
+            return NO;
+        }
+
+    } else {
+
+        SSExchangeJournalEncodeHeader(header, self.snapshotGeneration);
+
+        if (ftruncate(fileDescriptor, 0) != 0 ||
+            !SSExchangeJournalWriteAll(fileDescriptor, header, SSExchangeJournalHeaderLength, 0)) {
+            close(fileDescriptor);
+            return NO;
+        }
+    }
+
+    self.logFileDescriptor = fileDescriptor;
+    self.logLength = logLength;
+    self.numberOfExchangesSinceSnapshot = (NSUInteger)((logLength - SSExchangeJournalHeaderLength) / SSExchangeJournalRecordLength);
+    return YES;
+}
+
+- (void)closeLog {
+
+    if (self.logFileDescriptor >= 0) {
+        close(self.logFileDescriptor);
+        self.logFileDescriptor = -1;
+    }
+}
+
+- (void)readSnapshotGeneration {
+
+    uint8_t header[SSExchangeJournalHeaderLength];
+    uint64_t generation = 0;
+    BOOL hasSnapshot = NO;
+
+    int fileDescriptor = open([self.snapshotPath fileSystemRepresentation], O_RDONLY);
+    if (fileDescriptor >= 0) {
+        hasSnapshot = (pread(fileDescriptor, header, SSExchangeJournalHeaderLength, 0) == (ssize_t)SSExchangeJournalHeaderLength &&
+                       SSExchangeJournalDecodeHeader(header, &generation));
+        close(fileDescriptor);
+    }
+
+    self.hasSnapshot = hasSnapshot;
+    self.snapshotGeneration = (hasSnapshot)? generation : 0;
+}
+
+
+
+//------------------------
+#pragma mark - Appending...
+
+- (BOOL)appendExchangeOfItemAtIndexPath1:(NSIndexPath *)indexPath1 withItemAtIndexPath2:(NSIndexPath *)indexPath2 {
+
+    return [self appendSwap:SSExchangeSwapMake(SSExchangeIndexPathFromNSIndexPath(indexPath1),
+                                               SSExchangeIndexPathFromNSIndexPath(indexPath2))];
+}
+
+- (BOOL)appendSwap:(SSExchangeSwap)swap {
+
+    return [self appendSwaps:&swap count:1];
+}
+
+- (BOOL)appendSwaps:(const SSExchangeSwap *)swaps count:(NSUInteger)count {
+
+    if (count == 0) return YES;
+    if (swaps == NULL) return NO;
+
+    for (NSUInteger i = 0; i < count; i++) {
+        if (SSExchangeIndexPathIsNone(swaps[i].indexPath1) || SSExchangeIndexPathIsNone(swaps[i].indexPath2)) return NO;
+    }
+
+    if (self.logFileDescriptor < 0 && ![self openLog]) return NO;
+
+    uint8_t record[SSExchangeJournalRecordLength];
+    uint8_t *records = (count == 1)? record : malloc(count * SSExchangeJournalRecordLength);
+    if (records == NULL) return NO;
+
+    NSUInteger numberOfRecords = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        if (!SSExchangeIndexPathEqualToIndexPath(swaps[i].indexPath1, swaps[i].indexPath2)) {
+            SSExchangeJournalEncodeSwap(records + numberOfRecords * SSExchangeJournalRecordLength, swaps[i]);
+            numberOfRecords++;
+        }
+    }
+
+    size_t length = numberOfRecords * SSExchangeJournalRecordLength;
+    BOOL written = SSExchangeJournalWriteAll(self.logFileDescriptor, records, length, self.logLength);
+    if (records != record) free(records);
+
+    if (!written) {
+
+        // Don't leave part of a record behind for the next append to land after.
+        (void) ftruncate(self.logFileDescriptor, self.logLength);
+        return NO;
+    }
+
+    self.logLength += length;
+    self.numberOfExchangesSinceSnapshot += numberOfRecords;
+
+    if (self.numberOfExchangesBetweenSnapshots > 0 &&
+        self.numberOfExchangesSinceSnapshot >= self.numberOfExchangesBetweenSnapshots) {
+
+        // The exchanges are already safe in the log so a failure here only means the log keeps growing.
+        (void) [self writeSnapshot];
+    }
+
+    return YES;
+}
+
+
+
+//-------------------------
+#pragma mark - Snapshots...
+
+- (BOOL)writeSnapshot {
+
+    NSData *snapshotData = [self.snapshotProvider snapshotDataForExchangeJournal:self];
+    if (snapshotData == nil) return NO;
+
+    return [self writeSnapshotData:snapshotData];
+}
+
+- (BOOL)writeSnapshotData:(NSData *)snapshotData {
+
+    if (snapshotData == nil) return NO;
+
+    // The new snapshot replaces the old one atomically. Until the log has been emptied it still
+    // has the old generation, so if the app is killed in between the log is ignored next time.
+
+    uint64_t generation = self.snapshotGeneration + 1;
+    uint8_t header[SSExchangeJournalHeaderLength];
+    SSExchangeJournalEncodeHeader(header, generation);
+
+    NSMutableData *data = [NSMutableData dataWithCapacity:SSExchangeJournalHeaderLength + snapshotData.length];
+    [data appendBytes:header length:SSExchangeJournalHeaderLength];
+    [data appendData:snapshotData];
+
+    if (![data writeToFile:self.snapshotPath options:NSDataWritingAtomic error:NULL]) return NO;
+
+    // If the log can't be opened now the next append tries again.
+    [self openLog];
+    return YES;
+}
+
+
+
+//-----------------------
+#pragma mark - Replaying...
+
+- (NSData *)snapshotData {
+
+    if (!self.hasSnapshot) return nil;
+
+    NSData *data = [NSData dataWithContentsOfFile:self.snapshotPath options:NSDataReadingMappedIfSafe error:NULL];
+    uint64_t generation;
+
+    if (data.length < SSExchangeJournalHeaderLength ||
+        !SSExchangeJournalDecodeHeader(data.bytes, &generation) ||
+        generation != self.snapshotGeneration) {
+        return nil;
+    }
+
+    return [data subdataWithRange:NSMakeRange(SSExchangeJournalHeaderLength, data.length - SSExchangeJournalHeaderLength)];
+}
+
+- (void)replayExchangesWithBlock:(void (^)(const SSExchangeSwap *swaps, NSUInteger count))block {
+
+    NSUInteger count = self.numberOfExchangesSinceSnapshot;
+
+    if (block && count > 0 && self.logFileDescriptor >= 0) {
+
+        // One read for the whole log, decoded into one buffer, handed over in one call.
+
+        size_t length = count * SSExchangeJournalRecordLength;
+        uint8_t *records = malloc(length);
+        SSExchangeSwap *swaps = malloc(count * sizeof(SSExchangeSwap));
+
+        if (records && swaps &&
+            pread(self.logFileDescriptor, records, length, SSExchangeJournalHeaderLength) == (ssize_t)length) {
+
+            for (NSUInteger i = 0; i < count; i++) {
+                swaps[i] = SSExchangeJournalDecodeSwap(records + i * SSExchangeJournalRecordLength);
+            }
+            block(swaps, count);
+        }
+
+        free(records);
+        free(swaps);
+    }
+}
+
+
+
+//-----------------------------
+#pragma mark - Synchronizing...
+
+- (BOOL)synchronize {
+
+    if (self.logFileDescriptor < 0) return NO;
+    return fsync(self.logFileDescriptor) == 0;
+}
+
+@end
@@ -26,18 +26,26 @@
 
 
 #import <UIKit/UIKit.h>
+#import "SSCollectionViewExchangeTypes.h"
+#import "SSCollectionViewExchangeIndexPathSet.h"
+#import "SSCollectionViewExchangeInstrumentation.h"
 
 
 // This UICollectionViewFlowLayout subclass implements a layout designed
 // to manage hiding and dimming items during the exchange process.
+//
+// The delegate's answers are read once per invalidation, not once per item,
+// so the delegate must invalidate the layout whenever they change.
 
 
 @protocol SSCollectionViewExchangeLayoutDelegate
 
 @required
 
-- (NSIndexPath *)indexPathForItemToHide;
-- (NSIndexPath *)indexPathForItemToDim;
+- (void)getItemsToHide:(SSExchangeIndexPathSet *)itemsToHide itemsToDim:(SSExchangeIndexPathSet *)itemsToDim;
+// Both sets are empty. Add the items to hide to one and the items to dim to the other with
+// SSExchangeIndexPathSetAdd(). An item in both is hidden.
+
 - (CGFloat)alphaForItemToDim;
 
 @end
@@ -47,4 +55,22 @@
 
 - (id)initWithDelegate:(id<SSCollectionViewExchangeLayoutDelegate>)delegate;
 
+- (void)invalidateLayoutForHidingAndDimming;
+// Call this instead of invalidateLayout when only the delegate's answers for hiding and dimming have
+// changed. The delegate is asked once, now, and only the items that were or will be hidden or dimmed
+// are invalidated. The flow layout's sizes and positions, and the grid index, are kept. The delegate
+// is also asked once in each prepareLayout, so any other invalidation picks up changes too.
+
+- (BOOL)getIndexPath:(SSExchangeIndexPath *)indexPath forItemAtPoint:(CGPoint)point;
+// A constant time replacement for UICollectionView's indexPathForItemAtPoint:. point is in the
+// collection view's coordinates. Sets indexPath to the item containing point, or to
+// SSExchangeIndexPathNone if there isn't one, and returns YES. The answer comes from a grid index
+// of the item frames that is built on the first call after the layout is invalidated and then
+// reused. Returns NO, leaving indexPath unchanged, if the index can't be built, in which case
+// use indexPathForItemAtPoint: instead.
+
+@property (weak, nonatomic) id<SSCollectionViewExchangeInstrumentationSink> instrumentation;
+// Set by the exchange controller from its own instrumentation property. When set, each
+// prepareLayout and layoutAttributesForElementsInRect: is recorded as SSExchangePhaseLayout.
+
 @end
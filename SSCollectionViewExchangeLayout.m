@@ -26,11 +26,27 @@
 
 
 #import "SSCollectionViewExchangeLayout.h"
+#import "SSCollectionViewExchangeGridIndex.h"
 
 
-@interface SSCollectionViewExchangeLayout ()
+@interface SSCollectionViewExchangeLayout () {
 
-@property (weak, nonatomic) id <SSCollectionViewExchangeLayoutDelegate> delegate;
+    // Answers getIndexPath:forItemAtPoint:. NULL until it is needed, and again whenever
+    // the layout is invalidated in a way that might move items.
+    SSExchangeGridIndex *_gridIndex;
+    
+    // The delegate's answers as of the last invalidation, and as of the one before, which
+    // invalidateLayoutForHidingAndDimming compares them with. Refer to takeSnapshotOfHidingAndDimming.
+    SSExchangeIndexPathSet *_itemsToHide;
+    SSExchangeIndexPathSet *_itemsToDim;
+    SSExchangeIndexPathSet *_previousItemsToHide;
+    SSExchangeIndexPathSet *_previousItemsToDim;
+}
+
+@property (weak, nonatomic)     id <SSCollectionViewExchangeLayoutDelegate> delegate;
+@property (nonatomic)           BOOL                itemFramesAreStale;         // YES between an invalidation that might move items and the next prepareLayout
+@property (nonatomic)           BOOL                numbersOfItemsAreStale;     // YES until the sets for hiding and dimming are sized for the numbers of items in the collection view
+@property (nonatomic)           CGFloat             alphaForItemToDim;          // the delegate's answer as of the last invalidation
 
 @end
 
@@ -44,65 +60,356 @@
     if (self) {
         
         _delegate = delegate;
+        _numbersOfItemsAreStale = YES;
+        _alphaForItemToDim = 1.0;
     }
     return self;
 }
 
+- (void)dealloc {
+    
+    SSExchangeGridIndexFree(_gridIndex);
+    SSExchangeIndexPathSetFree(_itemsToHide);
+    SSExchangeIndexPathSetFree(_itemsToDim);
+    SSExchangeIndexPathSetFree(_previousItemsToHide);
+    SSExchangeIndexPathSetFree(_previousItemsToDim);
+}
+
 
 
 //-----------------------------------------------------
 #pragma mark - Override the layout attribute methods...
 
-// There is one item that needs hiding and one that needs dimming. As the user drags the item being moved over
-// another item, that item moves to the original location of the item being dragged. That cell is dimmed, marking
-// the original location of the item being moved. The cell at the position of the displaced item is hidden giving
-// the user the sense that the item being dragged will land there if their finger is released.
+// There is one item that needs hiding and one that needs dimming, or one of each for every item in a group being
+// dragged together. As the user drags the item being moved over another item, that item moves to the original
+// location of the item being dragged. That cell is dimmed, marking the original location of the item being moved.
+// The cell at the position of the displaced item is hidden giving the user the sense that the item being dragged
+// will land there if their finger is released.
 //
 // This is accomplished by overriding layoutAttributesForElementsInRect: and layoutAttributesForItemAtIndexPath:.
 //
+// The delegate is asked for the items to hide and dim once per invalidation, in prepareLayout and in
+// invalidateLayoutForHidingAndDimming, not once per item. Its answers are kept in bitmaps so each attribute is
+// checked with a shift and a mask however many items there are, and only the attributes for the hidden and dimmed
+// items are patched. They are patched on copies so the flow
+// layout's cached attributes are never changed and never need restoring. When nothing is hidden or dimmed, which
+// is all the time outside an exchange transaction, super's attributes are returned untouched.
+//
 // It can happen that the item to hide and the item to dim will be the same. This happens when the user drags back
-// to the starting location. This collision is irrelevant because there are two separate properties: one tracking
-// the item to hide and one tracking the item to dim. In layoutAttributesForItem: the hidden property is set first
+// to the starting location. This collision is irrelevant because there are two separate sets: one tracking
+// the items to hide and one tracking the items to dim. In patchedLayoutAttributes: the hidden property is set first
 // then the alpha. If the items are the same setting the alpha for an item that is hidden has no effect.
 
 - (NSArray *)layoutAttributesForElementsInRect:(CGRect)rect {
     
+    id<SSCollectionViewExchangeInstrumentationSink> instrumentation = self.instrumentation;
+    uint64_t startTime = (instrumentation)? SSExchangeInstrumentationBeginPhase(SSExchangePhaseLayout) : 0;
+    
+    NSArray *layoutAttributes = [self patchedLayoutAttributesForElementsInRect:rect];
+    
+    if (instrumentation) SSExchangeInstrumentationEndPhase(instrumentation, SSExchangePhaseLayout, startTime);
+    return layoutAttributes;
+}
+
+- (NSArray *)patchedLayoutAttributesForElementsInRect:(CGRect)rect {
+    
     NSArray *layoutAttributes = [super layoutAttributesForElementsInRect:rect];
     
-    for (UICollectionViewLayoutAttributes *attributesForItem in layoutAttributes)
-    {
-        (void) [self layoutAttributesForItem:attributesForItem];
+    if ([self hasItemsToHideOrDim] == NO) {
+        return layoutAttributes;
     }
     
-    return layoutAttributes;
+    NSMutableArray *patchedLayoutAttributes = nil;
+    NSUInteger numberOfItemsToPatch = [self numberOfItemsToHideOrDim];
+    NSUInteger index = 0;
+    
+    for (UICollectionViewLayoutAttributes *attributesForItem in layoutAttributes) {
+        
+        if ([self isItemToHideOrDim:attributesForItem]) {
+            
+            if (patchedLayoutAttributes == nil) patchedLayoutAttributes = [layoutAttributes mutableCopy];
+            patchedLayoutAttributes[index] = [self patchedLayoutAttributes:attributesForItem];
+            
+            if (--numberOfItemsToPatch == 0) break;
+        }
+        index++;
+    }
+    
+    return (patchedLayoutAttributes)? patchedLayoutAttributes : layoutAttributes;
 }
 
 - (UICollectionViewLayoutAttributes *)layoutAttributesForItemAtIndexPath:(NSIndexPath *)indexPath {
     
     UICollectionViewLayoutAttributes *attributesForItem = [super layoutAttributesForItemAtIndexPath:indexPath];
     
-    return [self layoutAttributesForItem:attributesForItem];
+    return ([self isItemToHideOrDim:attributesForItem])? [self patchedLayoutAttributes:attributesForItem] : attributesForItem;
+}
+
+- (BOOL)isItemToHideOrDim:(UICollectionViewLayoutAttributes *)attributesForItem {
+    
+    if (attributesForItem.representedElementCategory != UICollectionElementCategoryCell) {
+        return NO;
+    }
+    
+    SSExchangeIndexPath indexPath = SSExchangeIndexPathFromNSIndexPath(attributesForItem.indexPath);
+    
+    return (SSExchangeIndexPathSetContainsIndexPath(_itemsToHide, indexPath) ||
+            SSExchangeIndexPathSetContainsIndexPath(_itemsToDim, indexPath));
+}
+
+- (UICollectionViewLayoutAttributes *)patchedLayoutAttributes:(UICollectionViewLayoutAttributes *)attributesForItem {
+    
+    SSExchangeIndexPath indexPath = SSExchangeIndexPathFromNSIndexPath(attributesForItem.indexPath);
+    
+    UICollectionViewLayoutAttributes *patchedAttributesForItem = [attributesForItem copy];
+    patchedAttributesForItem.hidden = (SSExchangeIndexPathSetContainsIndexPath(_itemsToHide, indexPath))? YES : NO;
+    patchedAttributesForItem.alpha =  (SSExchangeIndexPathSetContainsIndexPath(_itemsToDim, indexPath))?  self.alphaForItemToDim : 1.0;
+    
+    return patchedAttributesForItem;
+}
+
+- (BOOL)hasItemsToHideOrDim {
+    
+    return SSExchangeIndexPathSetCount(_itemsToHide) > 0 || SSExchangeIndexPathSetCount(_itemsToDim) > 0;
+}
+
+- (NSUInteger)numberOfItemsToHideOrDim {
+    
+    NSUInteger numberOfItems = SSExchangeIndexPathSetCount(_itemsToHide);
+    
+    const SSExchangeIndexPath *itemsToDim = SSExchangeIndexPathSetMembers(_itemsToDim);
+    for (size_t i = 0; i < SSExchangeIndexPathSetCount(_itemsToDim); i++) {
+        if (SSExchangeIndexPathSetContainsIndexPath(_itemsToHide, itemsToDim[i]) == NO) numberOfItems++;
+    }
+    
+    return numberOfItems;
+}
+
+
+
+//----------------------------------------------
+#pragma mark - Hiding and dimming invalidation...
+
+- (void)takeSnapshotOfHidingAndDimming {
+    
+    // The current answers become the previous ones and the sets that held the previous ones are
+    // emptied and reused, so nothing is allocated.
+    
+    SSExchangeIndexPathSet *itemsToHide = _previousItemsToHide;
+    SSExchangeIndexPathSet *itemsToDim = _previousItemsToDim;
+    _previousItemsToHide = _itemsToHide;
+    _previousItemsToDim = _itemsToDim;
+    _itemsToHide = itemsToHide;
+    _itemsToDim = itemsToDim;
+    
+    SSExchangeIndexPathSetRemoveAll(_itemsToHide);
+    SSExchangeIndexPathSetRemoveAll(_itemsToDim);
+    
+    [self.delegate getItemsToHide:_itemsToHide itemsToDim:_itemsToDim];
+    self.alphaForItemToDim = [self.delegate alphaForItemToDim];
+}
+
+- (void)prepareSetsForHidingAndDimming {
+    
+    // The sets are sized for the numbers of items in each section so they are created again when
+    // those change. Whatever was hidden or dimmed is forgotten, which doesn't matter because the
+    // whole layout is being prepared again.
+    
+    UICollectionView *collectionView = self.collectionView;
+    NSInteger numberOfSections = [collectionView numberOfSections];
+    
+    size_t *numberOfItemsInSections = malloc(MAX(numberOfSections, 1) * sizeof(size_t));
+    if (numberOfItemsInSections == NULL) return;
+    
+    for (NSInteger section = 0; section < numberOfSections; section++) {
+        numberOfItemsInSections[section] = [collectionView numberOfItemsInSection:section];
+    }
+    
+    if (SSExchangeIndexPathSetHasNumbersOfItems(_itemsToHide, numberOfItemsInSections, numberOfSections) == NO) {
+        
+        SSExchangeIndexPathSet **sets[] = { &_itemsToHide, &_itemsToDim, &_previousItemsToHide, &_previousItemsToDim };
+        for (int i = 0; i < 4; i++) {
+            SSExchangeIndexPathSetFree(*sets[i]);
+            *sets[i] = SSExchangeIndexPathSetCreate(numberOfItemsInSections, numberOfSections);
+        }
+    }
+    
+    free(numberOfItemsInSections);
+    self.numbersOfItemsAreStale = NO;
 }
 
-- (UICollectionViewLayoutAttributes *)layoutAttributesForItem:(UICollectionViewLayoutAttributes *)attributesForItem {
+- (void)invalidateLayoutForHidingAndDimming {
+    
+    if ([SSCollectionViewExchangeLayout invalidationContextsAreAvailable] == NO) {
+        [self takeSnapshotOfHidingAndDimming];
+        [self invalidateLayout];
+        return;
+    }
+    
+    // The items to invalidate are the ones that were hidden or dimmed and the ones that will be.
     
-    if ([self elementKindIsHeaderOrFooter:attributesForItem.representedElementKind]) {
-        return attributesForItem;
+    [self takeSnapshotOfHidingAndDimming];
+    
+    SSExchangeIndexPathSet *sets[] = { _previousItemsToHide, _previousItemsToDim, _itemsToHide, _itemsToDim };
+    NSMutableArray *indexPaths = [NSMutableArray array];
+    for (int i = 0; i < 4; i++) {
+        [self addMembersOfSet:sets[i] notInSets:sets count:i toIndexPaths:indexPaths];
     }
     
-    NSIndexPath *indexPathForItemToHide =   [self.delegate indexPathForItemToHide];
-    NSIndexPath *indexPathForItemToDim =    [self.delegate indexPathForItemToDim];
-    CGFloat alphaForItemToDim =             [self.delegate alphaForItemToDim];
+    // Hiding and dimming never change the size or position of anything.
+    UICollectionViewFlowLayoutInvalidationContext *context = [UICollectionViewFlowLayoutInvalidationContext new];
+    context.invalidateFlowLayoutAttributes = NO;
+    context.invalidateFlowLayoutDelegateMetrics = NO;
+    
+    // invalidateItemsAtIndexPaths: is available starting with iOS 8. Without it the collection view
+    // asks again for the attributes of all the visible elements, which is still cheap because the
+    // flow layout's own attributes are not recomputed.
+    if ([context respondsToSelector:@selector(invalidateItemsAtIndexPaths:)] && indexPaths.count > 0) {
+        [context invalidateItemsAtIndexPaths:indexPaths];
+    }
     
-    attributesForItem.hidden = ([attributesForItem.indexPath isEqual:indexPathForItemToHide])? YES : NO;
-    attributesForItem.alpha =  ([attributesForItem.indexPath isEqual:indexPathForItemToDim])?  alphaForItemToDim : 1.0;
+    [self invalidateLayoutWithContext:context];
+}
 
-    return attributesForItem;
+- (void)addMembersOfSet:(SSExchangeIndexPathSet *)set
+              notInSets:(SSExchangeIndexPathSet **)setsToSkip
+                  count:(int)numberOfSetsToSkip
+           toIndexPaths:(NSMutableArray *)indexPaths {
+    
+    // Skipping the members of the sets already added keeps each index path to one entry.
+    
+    const SSExchangeIndexPath *members = SSExchangeIndexPathSetMembers(set);
+    
+    for (size_t i = 0; i < SSExchangeIndexPathSetCount(set); i++) {
+        
+        BOOL alreadyAdded = NO;
+        for (int j = 0; j < numberOfSetsToSkip && alreadyAdded == NO; j++) {
+            alreadyAdded = SSExchangeIndexPathSetContainsIndexPath(setsToSkip[j], members[i]);
+        }
+        
+        if (alreadyAdded == NO) [indexPaths addObject:NSIndexPathFromSSExchangeIndexPath(members[i])];
+    }
 }
 
-- (BOOL)elementKindIsHeaderOrFooter:(NSString *)elementKind {
++ (BOOL)invalidationContextsAreAvailable {
+    
+    // Invalidation contexts are available starting with iOS 7.
+    static BOOL available;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        available = [UICollectionViewLayout instancesRespondToSelector:@selector(invalidateLayoutWithContext:)];
+    });
+    return available;
+}
+
+
+
+//-------------------------------
+#pragma mark - Hit testing...
+
+// During an exchange transaction the exchange controller needs the item under the user's finger
+// on every touch sample. UICollectionView's indexPathForItemAtPoint: searches the layout attributes
+// each time. Instead, the item frames are put into a grid index once and each lookup checks only
+// the one or two items near the point. Refer to SSCollectionViewExchangeGridIndex.h.
+//
+// The index is discarded when the layout is invalidated in a way that might move items and is
+// rebuilt on the next lookup after prepareLayout. Invalidations that only change hiding and
+// dimming keep it.
+
+- (void)prepareLayout {
+    
+    id<SSCollectionViewExchangeInstrumentationSink> instrumentation = self.instrumentation;
+    uint64_t startTime = (instrumentation)? SSExchangeInstrumentationBeginPhase(SSExchangePhaseLayout) : 0;
+    
+    [super prepareLayout];
+    
+    // Without invalidation contexts there is no way to tell which invalidations might move items.
+    if ([SSCollectionViewExchangeLayout invalidationContextsAreAvailable] == NO) {
+        SSExchangeGridIndexFree(_gridIndex);
+        _gridIndex = NULL;
+        self.numbersOfItemsAreStale = YES;
+    }
+    
+    self.itemFramesAreStale = NO;
+    if (self.numbersOfItemsAreStale) [self prepareSetsForHidingAndDimming];
+    [self takeSnapshotOfHidingAndDimming];
+    
+    if (instrumentation) SSExchangeInstrumentationEndPhase(instrumentation, SSExchangePhaseLayout, startTime);
+}
+
+- (void)invalidateLayoutWithContext:(UICollectionViewLayoutInvalidationContext *)context {
+    
+    if ([self invalidationContextMightMoveItems:context]) {
+        SSExchangeGridIndexFree(_gridIndex);
+        _gridIndex = NULL;
+        self.itemFramesAreStale = YES;
+    }
+    
+    if (context.invalidateEverything || context.invalidateDataSourceCounts) {
+        self.numbersOfItemsAreStale = YES;
+    }
+    
+    [super invalidateLayoutWithContext:context];
+}
+
+- (BOOL)invalidationContextMightMoveItems:(UICollectionViewLayoutInvalidationContext *)context {
+    
+    if (context.invalidateEverything || context.invalidateDataSourceCounts) return YES;
+    
+    if ([context isKindOfClass:[UICollectionViewFlowLayoutInvalidationContext class]]) {
+        UICollectionViewFlowLayoutInvalidationContext *flowLayoutContext = (UICollectionViewFlowLayoutInvalidationContext *)context;
+        return flowLayoutContext.invalidateFlowLayoutAttributes || flowLayoutContext.invalidateFlowLayoutDelegateMetrics;
+    }
+    
+    return YES;
+}
+
+- (BOOL)getIndexPath:(SSExchangeIndexPath *)indexPath forItemAtPoint:(CGPoint)point {
+    
+    // Until the layout is prepared again the flow layout's attributes may not match what is on screen.
+    if (self.itemFramesAreStale) return NO;
+    
+    if (_gridIndex == NULL) {
+        _gridIndex = [self createGridIndex];
+        if (_gridIndex == NULL) return NO;
+    }
+    
+    *indexPath = SSExchangeGridIndexIndexPathAtPoint(_gridIndex, point.x, point.y);
+    return YES;
+}
+
+- (SSExchangeGridIndex *)createGridIndex {
+    
+    // Super's attributes are used because hiding and dimming don't matter here.
+    CGRect contentRect = (CGRect){ CGPointZero, self.collectionViewContentSize };
+    NSArray *layoutAttributes = [super layoutAttributesForElementsInRect:contentRect];
+    
+    NSUInteger count = layoutAttributes.count;
+    if (count == 0) return NULL;
+    
+    SSExchangeRect *frames = malloc(count * sizeof(SSExchangeRect));
+    SSExchangeIndexPath *indexPaths = malloc(count * sizeof(SSExchangeIndexPath));
+    
+    size_t numberOfItems = 0;
+    if (frames != NULL && indexPaths != NULL) {
+        
+        for (UICollectionViewLayoutAttributes *attributes in layoutAttributes) {
+            
+            if (attributes.representedElementCategory != UICollectionElementCategoryCell) continue;
+            
+            CGRect frame = attributes.frame;
+            frames[numberOfItems] = (SSExchangeRect){ frame.origin.x, frame.origin.y, frame.size.width, frame.size.height };
+            indexPaths[numberOfItems] = SSExchangeIndexPathFromNSIndexPath(attributes.indexPath);
+            numberOfItems++;
+        }
+    }
+    
+    SSExchangeGridIndex *gridIndex = SSExchangeGridIndexCreate(frames, indexPaths, numberOfItems);
+    
+    free(frames);
+    free(indexPaths);
     
-    return (elementKind == UICollectionElementKindSectionHeader || elementKind == UICollectionElementKindSectionFooter);
+    return gridIndex;
 }
 
 @end
@@ -0,0 +1,150 @@
+//
+//  SSCollectionViewExchangeShadowPermutation.c
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include "SSCollectionViewExchangeShadowPermutation.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+struct SSExchangeShadowPermutation {
+    SSExchangeSwap  *swaps;             // the pending swaps are swaps[first] to swaps[first + count - 1], oldest first
+    unsigned int    first;
+    unsigned int    count;
+    unsigned int    capacity;
+};
+
+
+static const unsigned int SSExchangeShadowPermutationInitialCapacity = 16;
+
+
+
+//--------------------------
+// Creating and freeing...
+
+SSExchangeShadowPermutation *SSExchangeShadowPermutationCreate(void) {
+
+    SSExchangeShadowPermutation *shadowPermutation = calloc(1, sizeof(SSExchangeShadowPermutation));
+    if (shadowPermutation == NULL) return NULL;
+
+    shadowPermutation->swaps = malloc(SSExchangeShadowPermutationInitialCapacity * sizeof(SSExchangeSwap));
+    if (shadowPermutation->swaps == NULL) {
+        free(shadowPermutation);
+        return NULL;
+    }
+
+    shadowPermutation->capacity = SSExchangeShadowPermutationInitialCapacity;
+    return shadowPermutation;
+}
+
+void SSExchangeShadowPermutationFree(SSExchangeShadowPermutation *shadowPermutation) {
+
+    if (shadowPermutation == NULL) return;
+
+    free(shadowPermutation->swaps);
+    free(shadowPermutation);
+}
+
+
+
+//--------------------------------
+// Pushing and popping swaps...
+
+bool SSExchangeShadowPermutationPushSwaps(SSExchangeShadowPermutation *shadowPermutation,
+                                          const SSExchangeSwap *swaps,
+                                          unsigned int numberOfSwaps) {
+
+    if (shadowPermutation == NULL) return false;
+    if (numberOfSwaps == 0) return true;
+    if (swaps == NULL) return false;
+
+    // Popped swaps leave room at the front. Reclaim it before growing.
+    if (shadowPermutation->first + shadowPermutation->count + numberOfSwaps > shadowPermutation->capacity) {
+        memmove(shadowPermutation->swaps, &shadowPermutation->swaps[shadowPermutation->first], shadowPermutation->count * sizeof(SSExchangeSwap));
+        shadowPermutation->first = 0;
+    }
+
+    if (shadowPermutation->count + numberOfSwaps > shadowPermutation->capacity) {
+
+        unsigned int capacity = shadowPermutation->capacity;
+        while (capacity < shadowPermutation->count + numberOfSwaps) capacity *= 2;
+
+        SSExchangeSwap *grown = realloc(shadowPermutation->swaps, capacity * sizeof(SSExchangeSwap));
+        if (grown == NULL) return false;
+
+        shadowPermutation->swaps = grown;
+        shadowPermutation->capacity = capacity;
+    }
+
+    memcpy(&shadowPermutation->swaps[shadowPermutation->first + shadowPermutation->count], swaps, numberOfSwaps * sizeof(SSExchangeSwap));
+    shadowPermutation->count += numberOfSwaps;
+    return true;
+}
+
+void SSExchangeShadowPermutationPopSwaps(SSExchangeShadowPermutation *shadowPermutation, unsigned int numberOfSwaps) {
+
+    if (shadowPermutation == NULL) return;
+
+    if (numberOfSwaps >= shadowPermutation->count) {
+        shadowPermutation->first = 0;
+        shadowPermutation->count = 0;
+        return;
+    }
+
+    shadowPermutation->first += numberOfSwaps;
+    shadowPermutation->count -= numberOfSwaps;
+}
+
+unsigned int SSExchangeShadowPermutationNumberOfPendingSwaps(const SSExchangeShadowPermutation *shadowPermutation) {
+
+    return (shadowPermutation)? shadowPermutation->count : 0;
+}
+
+
+
+//-----------------------
+// Mapping index paths...
+
+SSExchangeIndexPath SSExchangeShadowPermutationIndexPathInModel(const SSExchangeShadowPermutation *shadowPermutation,
+                                                                SSExchangeIndexPath indexPath) {
+
+    if (shadowPermutation == NULL) return indexPath;
+
+    // The collection view is the model with the pending swaps applied, so undoing them, newest
+    // first, follows the item back to where the model has it. A swap is its own inverse.
+    const SSExchangeSwap *swaps = &shadowPermutation->swaps[shadowPermutation->first];
+
+    for (unsigned int i = shadowPermutation->count; i > 0; i--) {
+        if (SSExchangeIndexPathEqualToIndexPath(indexPath, swaps[i - 1].indexPath1)) {
+            indexPath = swaps[i - 1].indexPath2;
+        } else if (SSExchangeIndexPathEqualToIndexPath(indexPath, swaps[i - 1].indexPath2)) {
+            indexPath = swaps[i - 1].indexPath1;
+        }
+    }
+
+    return indexPath;
+}
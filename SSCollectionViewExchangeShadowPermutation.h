@@ -0,0 +1,86 @@
+//
+//  SSCollectionViewExchangeShadowPermutation.h
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// SSExchangeShadowPermutation keeps track of swaps that the collection view shows but the model
+// doesn't reflect yet.
+//
+// When the exchange controller has a commit queue the delegate's model is changed on that queue,
+// after the collection view has already moved the items. Until the queue catches up the two
+// differ by the swaps still waiting on it. The shadow permutation holds those swaps, in order, so
+// the index path of an item in the collection view can be mapped to its index path in the model
+// as it is right now. Swaps are pushed when they are queued and popped, oldest first, once the
+// model has them. Mapping an index path takes time proportional to the number of pending swaps,
+// which is a handful unless the queue falls far behind.
+//
+// The shadow permutation is not thread safe. The exchange controller pushes, pops and maps under
+// its own lock.
+
+#ifndef SSCollectionViewExchangeShadowPermutation_h
+#define SSCollectionViewExchangeShadowPermutation_h
+
+#include "SSCollectionViewExchangeTypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef struct SSExchangeShadowPermutation SSExchangeShadowPermutation;
+
+
+SSExchangeShadowPermutation *SSExchangeShadowPermutationCreate(void);
+// Creates a shadow permutation with no pending swaps. Returns NULL if memory can't be allocated.
+// Release it with SSExchangeShadowPermutationFree().
+
+void SSExchangeShadowPermutationFree(SSExchangeShadowPermutation *shadowPermutation);
+// shadowPermutation can be NULL.
+
+bool SSExchangeShadowPermutationPushSwaps(SSExchangeShadowPermutation *shadowPermutation,
+                                          const SSExchangeSwap *swaps,
+                                          unsigned int numberOfSwaps);
+// Appends swaps, which the collection view now shows but the model doesn't have yet. Returns false,
+// pushing none of them, if memory can't be allocated or swaps is NULL (and numberOfSwaps is not 0).
+
+void SSExchangeShadowPermutationPopSwaps(SSExchangeShadowPermutation *shadowPermutation, unsigned int numberOfSwaps);
+// Removes the oldest numberOfSwaps pending swaps, which the model now has. Popping more than are
+// pending removes them all.
+
+unsigned int SSExchangeShadowPermutationNumberOfPendingSwaps(const SSExchangeShadowPermutation *shadowPermutation);
+// shadowPermutation can be NULL, in which case it returns 0.
+
+SSExchangeIndexPath SSExchangeShadowPermutationIndexPathInModel(const SSExchangeShadowPermutation *shadowPermutation,
+                                                                SSExchangeIndexPath indexPath);
+// The index path in the model of the item at indexPath in the collection view. The same as
+// indexPath if no pending swap involves it. shadowPermutation can be NULL, in which case it
+// returns indexPath.
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
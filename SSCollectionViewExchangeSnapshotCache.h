@@ -0,0 +1,80 @@
+//
+//  SSCollectionViewExchangeSnapshotCache.h
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#import <UIKit/UIKit.h>
+
+
+// SSCollectionViewExchangeSnapshotCache keeps rendered images of items, and a small pool of
+// image views to show them in, so the exchange controller doesn't have to render the cell and
+// create a new view every time a long press begins.
+//
+// Images are keyed by the item's index path and tagged with a content version that the
+// delegate provides. An image is only returned if the version and size still match. When
+// items are exchanged in the model their images are exchanged too, so the cache follows the
+// content rather than the position.
+//
+// The exchange controller owns one of these. It is only used when the delegate implements
+// exchangeController:contentVersionForItemAtIndexPath:, because without a content version
+// there is no way to know when an image is out of date.
+
+
+@interface SSCollectionViewExchangeSnapshotCache : NSObject
+
+@property (nonatomic) NSUInteger countLimit;
+// The maximum number of images to keep. The default is 64. The cache also gives up images
+// when memory is low.
+
+- (UIImage *)imageForItemAtIndexPath:(NSIndexPath *)indexPath
+                      contentVersion:(NSUInteger)contentVersion
+                                size:(CGSize)size;
+// Returns the image for the item at indexPath if there is one for this content version and
+// size. Otherwise returns nil.
+
+- (void)setImage:(UIImage *)image
+forItemAtIndexPath:(NSIndexPath *)indexPath
+  contentVersion:(NSUInteger)contentVersion;
+
+- (void)exchangeImageForItemAtIndexPath:(NSIndexPath *)indexPath1
+               withImageForItemAtIndexPath:(NSIndexPath *)indexPath2;
+// Call when the items at the two index paths are exchanged in the model.
+
+- (void)removeAllImages;
+// Call when anything that affects every image changes, like the snapshot's background colour.
+
+- (UIImageView *)dequeueImageViewWithImage:(UIImage *)image;
+// Returns an image view from the pool, or a new one if the pool is empty, showing image at
+// its natural size with an alpha of 1.0 and no transform.
+
+- (void)enqueueImageView:(UIImageView *)imageView;
+// Returns an image view to the pool. It is removed from its superview. Only image views that
+// came from dequeueImageViewWithImage: should be returned.
+
++ (UIImage *)imageByRenderingView:(UIView *)view;
+// Renders view, as it is now, into an image. Uses UIGraphicsImageRenderer where it is
+// available. Must be called on the main thread.
+
+@end
@@ -0,0 +1,215 @@
+//
+//  SSCollectionViewExchangeSnapshotCache.m
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#import "SSCollectionViewExchangeSnapshotCache.h"
+
+
+// Only one snapshot is on screen at a time. One more covers a release animation still
+// running when the next long press begins.
+static const NSUInteger SSCollectionViewExchangeSnapshotCacheMaximumPooledImageViews = 2;
+
+
+
+@interface SSCollectionViewExchangeSnapshotCacheEntry : NSObject
+
+@property (strong, nonatomic)   UIImage     *image;
+@property (nonatomic)           NSUInteger  contentVersion;
+
+@end
+
+
+@implementation SSCollectionViewExchangeSnapshotCacheEntry
+
+@end
+
+
+
+@interface SSCollectionViewExchangeSnapshotCache ()
+
+@property (strong, nonatomic)   NSCache         *entries;           // SSCollectionViewExchangeSnapshotCacheEntry objects keyed by NSIndexPath
+@property (strong, nonatomic)   NSMutableArray  *imageViewPool;     // image views ready for reuse
+
+@end
+
+
+
+@implementation SSCollectionViewExchangeSnapshotCache
+
+- (id)init {
+
+    self = [super init];
+    if (self) {
+
+        _entries = [NSCache new];
+        _entries.countLimit = 64;
+        _imageViewPool = [NSMutableArray arrayWithCapacity:SSCollectionViewExchangeSnapshotCacheMaximumPooledImageViews];
+    }
+    return self;
+}
+
+
+
+//-------------------------
+#pragma mark - Accessors...
+
+- (NSUInteger)countLimit {
+
+    return self.entries.countLimit;
+}
+
+- (void)setCountLimit:(NSUInteger)countLimit {
+
+    self.entries.countLimit = countLimit;
+}
+
+
+
+//----------------------
+#pragma mark - Images...
+
+- (UIImage *)imageForItemAtIndexPath:(NSIndexPath *)indexPath
+                      contentVersion:(NSUInteger)contentVersion
+                                size:(CGSize)size {
+
+    if (indexPath == nil) return nil;
+
+    SSCollectionViewExchangeSnapshotCacheEntry *entry = [self.entries objectForKey:indexPath];
+
+    if (entry == nil || entry.contentVersion != contentVersion || !CGSizeEqualToSize(entry.image.size, size)) {
+        return nil;
+    }
+
+    return entry.image;
+}
+
+- (void)setImage:(UIImage *)image
+forItemAtIndexPath:(NSIndexPath *)indexPath
+  contentVersion:(NSUInteger)contentVersion {
+
+    if (indexPath == nil) return;
+
+    if (image == nil) {
+        [self.entries removeObjectForKey:indexPath];
+        return;
+    }
+
+    SSCollectionViewExchangeSnapshotCacheEntry *entry = [SSCollectionViewExchangeSnapshotCacheEntry new];
+    entry.image = image;
+    entry.contentVersion = contentVersion;
+    [self.entries setObject:entry forKey:indexPath];
+}
+
+- (void)exchangeImageForItemAtIndexPath:(NSIndexPath *)indexPath1
+               withImageForItemAtIndexPath:(NSIndexPath *)indexPath2 {
+
+    if (indexPath1 == nil || indexPath2 == nil || [indexPath1 isEqual:indexPath2]) return;
+
+    SSCollectionViewExchangeSnapshotCacheEntry *entry1 = [self.entries objectForKey:indexPath1];
+    SSCollectionViewExchangeSnapshotCacheEntry *entry2 = [self.entries objectForKey:indexPath2];
+
+    if (entry2) [self.entries setObject:entry2 forKey:indexPath1];
+    else        [self.entries removeObjectForKey:indexPath1];
+
+    if (entry1) [self.entries setObject:entry1 forKey:indexPath2];
+    else        [self.entries removeObjectForKey:indexPath2];
+}
+
+- (void)removeAllImages {
+
+    [self.entries removeAllObjects];
+}
+
+
+
+//---------------------------
+#pragma mark - Image views...
+
+- (UIImageView *)dequeueImageViewWithImage:(UIImage *)image {
+
+    UIImageView *imageView = [self.imageViewPool lastObject];
+
+    if (imageView) {
+        [self.imageViewPool removeLastObject];
+        imageView.transform = CGAffineTransformIdentity;
+        imageView.alpha = 1.0;
+        imageView.image = image;
+        imageView.frame = (CGRect){ CGPointZero, image.size };
+    } else {
+        imageView = [[UIImageView alloc] initWithImage:image];
+    }
+
+    return imageView;
+}
+
+- (void)enqueueImageView:(UIImageView *)imageView {
+
+    if (imageView == nil) return;
+
+    [imageView removeFromSuperview];
+
+    if (self.imageViewPool.count < SSCollectionViewExchangeSnapshotCacheMaximumPooledImageViews &&
+        [self.imageViewPool indexOfObjectIdenticalTo:imageView] == NSNotFound) {
+
+        // Don't keep the image alive just because the view is pooled.
+        imageView.image = nil;
+        [self.imageViewPool addObject:imageView];
+    }
+}
+
+
+
+//-----------------------
+#pragma mark - Rendering...
+
++ (UIImage *)imageByRenderingView:(UIView *)view {
+
+    // UIGraphicsImageRenderer is available starting with iOS 10. It reuses its backing
+    // memory and picks the best pixel format for the screen.
+
+    Class rendererClass = NSClassFromString(@"UIGraphicsImageRenderer");
+    Class formatClass = NSClassFromString(@"UIGraphicsImageRendererFormat");
+
+    if (rendererClass && formatClass) {
+
+        id format = [formatClass defaultFormat];
+        [format setOpaque:view.opaque];
+
+        id renderer = [[rendererClass alloc] initWithSize:view.bounds.size format:format];
+        return [renderer imageWithActions:^(id rendererContext) {
+            [view.layer renderInContext:[rendererContext CGContext]];
+        }];
+    }
+
+    UIGraphicsBeginImageContextWithOptions(view.bounds.size, view.opaque, 0.0f);
+    [view.layer renderInContext:UIGraphicsGetCurrentContext()];
+    UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+
+    return image;
+}
+
+@end
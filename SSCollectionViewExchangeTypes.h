@@ -0,0 +1,117 @@
+//
+//  SSCollectionViewExchangeTypes.h
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// Plain C types shared by the exchange controller, its layout, and the Foundation-only
+// parts of this library. The types themselves depend on neither UIKit nor Foundation so
+// they can be used in headless code (tests, benchmarks, replay tools) on any platform.
+// When compiled as Objective-C, conversions to and from NSIndexPath are also available.
+
+#ifndef SSCollectionViewExchangeTypes_h
+#define SSCollectionViewExchangeTypes_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+// A compact stand-in for an NSIndexPath with a section and an item. It lives on the stack,
+// costs 8 bytes, and compares with two integer comparisons instead of isEqual:.
+typedef struct {
+    int32_t section;
+    int32_t item;
+} SSExchangeIndexPath;
+
+
+// A single exchange of the items at two index paths. The order of the index paths
+// has no meaning; exchanging indexPath1 with indexPath2 is the same as the reverse.
+typedef struct {
+    SSExchangeIndexPath indexPath1;
+    SSExchangeIndexPath indexPath2;
+} SSExchangeSwap;
+
+
+// Stands in for a nil NSIndexPath.
+static const SSExchangeIndexPath SSExchangeIndexPathNone = { -1, -1 };
+
+
+static inline SSExchangeIndexPath SSExchangeIndexPathMake(int32_t section, int32_t item) {
+
+    SSExchangeIndexPath indexPath = { section, item };
+    return indexPath;
+}
+
+static inline bool SSExchangeIndexPathEqualToIndexPath(SSExchangeIndexPath indexPath1, SSExchangeIndexPath indexPath2) {
+
+    return indexPath1.section == indexPath2.section && indexPath1.item == indexPath2.item;
+}
+
+static inline bool SSExchangeIndexPathIsNone(SSExchangeIndexPath indexPath) {
+
+    return indexPath.section < 0 || indexPath.item < 0;
+}
+
+static inline uint64_t SSExchangeIndexPathPack(SSExchangeIndexPath indexPath) {
+
+    // Packs the index path into a single integer, for use as a hash or dictionary key.
+    return ((uint64_t)(uint32_t)indexPath.section << 32) | (uint64_t)(uint32_t)indexPath.item;
+}
+
+static inline SSExchangeIndexPath SSExchangeIndexPathUnpack(uint64_t packedIndexPath) {
+
+    return SSExchangeIndexPathMake((int32_t)(uint32_t)(packedIndexPath >> 32), (int32_t)(uint32_t)packedIndexPath);
+}
+
+static inline SSExchangeSwap SSExchangeSwapMake(SSExchangeIndexPath indexPath1, SSExchangeIndexPath indexPath2) {
+
+    SSExchangeSwap swap = { indexPath1, indexPath2 };
+    return swap;
+}
+
+
+#ifdef __OBJC__
+
+#import <Foundation/Foundation.h>
+
+// Conversions to and from NSIndexPath, for use at the boundary with UIKit and the delegate. Only
+// Foundation API is used so they also work where NSIndexPath has no section and item properties.
+
+static inline SSExchangeIndexPath SSExchangeIndexPathFromNSIndexPath(NSIndexPath *indexPath) {
+
+    if (indexPath == nil || indexPath.length < 2) return SSExchangeIndexPathNone;
+    return SSExchangeIndexPathMake((int32_t)[indexPath indexAtPosition:0], (int32_t)[indexPath indexAtPosition:1]);
+}
+
+static inline NSIndexPath *NSIndexPathFromSSExchangeIndexPath(SSExchangeIndexPath indexPath) {
+
+    if (SSExchangeIndexPathIsNone(indexPath)) return nil;
+    NSUInteger indexes[] = { (NSUInteger)indexPath.section, (NSUInteger)indexPath.item };
+    return [NSIndexPath indexPathWithIndexes:indexes length:2];
+}
+
+#endif
+
+#endif
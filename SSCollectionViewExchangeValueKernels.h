@@ -0,0 +1,118 @@
+//
+//  SSCollectionViewExchangeValueKernels.h
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+// SSCollectionViewExchangeValueKernels apply exchanges and moves to models of plain numbers, like
+// scores, slots or IDs, kept unboxed in a C buffer for each section. They are the value type
+// counterpart of the NSMutableArray category's exchangeObjectsInArrays:withSwaps:count: and
+// moveObjectsInArrays:fromIndexPaths:toIndexPaths:, where every exchange goes through
+// replaceObjectAtIndex:withObject: and is paid for in retains and releases.
+//
+// Each kernel is a C++ template, in SSCollectionViewExchangeValueKernels.mm, instantiated for each
+// SSExchangeValueType so the loops are compiled for the element's own size and arithmetic. The
+// functions here pick the instantiation. NSMutableData+SSCollectionViewExchangeControllerAdditions.h
+// wraps them for sections kept in NSMutableData objects.
+//
+// Like the array category every index path is validated before anything changes. Sections can
+// also carry running sums: exchanges and moves within a section don't change its sum and those
+// between sections adjust both, so a sum never has to be recalculated.
+
+#ifndef SSCollectionViewExchangeValueKernels_h
+#define SSCollectionViewExchangeValueKernels_h
+
+#include "SSCollectionViewExchangeCore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef enum {
+    SSExchangeValueTypeInt32,
+    SSExchangeValueTypeInt64,
+    SSExchangeValueTypeFloat,
+    SSExchangeValueTypeDouble
+} SSExchangeValueType;
+
+
+// The sum of a section. Integer values are summed into integerSum, which wraps on overflow.
+// Floating point values are summed into doubleSum.
+typedef union {
+    int64_t integerSum;
+    double  doubleSum;
+} SSExchangeValueSum;
+
+
+size_t SSExchangeValueTypeSize(SSExchangeValueType type);
+// The size of one value. 0 if type isn't one of the above.
+
+bool SSExchangeValuesExchange(SSExchangeValueType type,
+                              void *const *sections,
+                              const size_t *numbersOfValues,
+                              size_t numberOfSections,
+                              const SSExchangeSwap *swaps,
+                              size_t numberOfSwaps,
+                              SSExchangeValueSum *sums);
+// Applies the swaps, in order. sections[n] holds numbersOfValues[n] values of type for section n.
+// sums, which can be NULL, has the sum of each section and is kept up to date. Returns false,
+// changing nothing, if swaps is NULL (and numberOfSwaps is not 0) or any index path names a
+// section or value that does not exist.
+
+bool SSExchangeValuesMove(SSExchangeValueType type,
+                          void *const *sections,
+                          const size_t *numbersOfValues,
+                          size_t numberOfSections,
+                          const SSExchangeMove *moves,
+                          size_t numberOfMoves,
+                          SSExchangeValueSum *sums);
+// Applies the moves all at once, like moveObjectsInArrays:fromIndexPaths:toIndexPaths:. The value
+// at each fromIndexPath moves to its toIndexPath. Otherwise as above. Also returns false if an
+// index path appears twice as a fromIndexPath or twice as a toIndexPath, if the toIndexPaths
+// aren't the fromIndexPaths rearranged, or if memory can't be allocated. The checks take
+// time proportional to the number of moves, not the sizes of the sections.
+
+bool SSExchangeValuesPermute(SSExchangeValueType type,
+                             void *values,
+                             size_t numberOfValues,
+                             const uint32_t *sourceIndices);
+// Rearranges a whole section at once: afterwards values[i] is the value that was at
+// sourceIndices[i]. For the large permutations that come from sorting, shuffling or undoing a long
+// history, where a list of moves would touch almost every value anyway. The values are gathered
+// into a scratch buffer in one pass with no dependencies between iterations, which the compiler
+// can vectorize, then copied back. Returns false, changing nothing, if sourceIndices isn't a
+// permutation of 0 to numberOfValues - 1 or memory can't be allocated.
+
+SSExchangeValueSum SSExchangeValuesSum(SSExchangeValueType type, const void *values, size_t numberOfValues);
+// The sum of numberOfValues values, to start the running sums. Several independent accumulators
+// are used so the loop vectorizes. Floating point sums can differ from a plain loop's in the last
+// bits because the additions are done in a different order.
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
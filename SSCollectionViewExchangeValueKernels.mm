@@ -0,0 +1,319 @@
+//
+//  SSCollectionViewExchangeValueKernels.mm
+//
+// Copyright (c) 2014 Signature Software and Murray Sagal
+// SSCollectionViewExchangeController: https://github.com/murraysagal/SSCollectionViewExchangeController
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include "SSCollectionViewExchangeValueKernels.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+
+namespace {
+
+
+//-----------------------------
+// Arithmetic for each type...
+
+// Integer sums are done in uint64_t so they wrap rather than overflow.
+template <typename T> struct SSExchangeSumTraits {
+
+    static int64_t &sum(SSExchangeValueSum &sum) { return sum.integerSum; }
+    static int64_t add(int64_t sum, T value) { return (int64_t)((uint64_t)sum + (uint64_t)(int64_t)value); }
+    static int64_t subtract(int64_t sum, T value) { return (int64_t)((uint64_t)sum - (uint64_t)(int64_t)value); }
+    static int64_t combine(int64_t sum1, int64_t sum2) { return (int64_t)((uint64_t)sum1 + (uint64_t)sum2); }
+    typedef int64_t Accumulator;
+};
+
+template <> struct SSExchangeSumTraits<float> {
+
+    static double &sum(SSExchangeValueSum &sum) { return sum.doubleSum; }
+    static double add(double sum, float value) { return sum + value; }
+    static double subtract(double sum, float value) { return sum - value; }
+    static double combine(double sum1, double sum2) { return sum1 + sum2; }
+    typedef double Accumulator;
+};
+
+template <> struct SSExchangeSumTraits<double> {
+
+    static double &sum(SSExchangeValueSum &sum) { return sum.doubleSum; }
+    static double add(double sum, double value) { return sum + value; }
+    static double subtract(double sum, double value) { return sum - value; }
+    static double combine(double sum1, double sum2) { return sum1 + sum2; }
+    typedef double Accumulator;
+};
+
+
+static bool SSExchangeValuesContainIndexPath(const size_t *numbersOfValues, size_t numberOfSections, SSExchangeIndexPath indexPath) {
+
+    return !SSExchangeIndexPathIsNone(indexPath) &&
+           (size_t)indexPath.section < numberOfSections &&
+           (size_t)indexPath.item < numbersOfValues[indexPath.section];
+}
+
+
+static bool SSExchangeValuesMovesArePermutation(const SSExchangeMove *moves, size_t numberOfMoves) {
+
+    // The moves must rearrange the values they pick up, or a value would be lost or duplicated:
+    // sorted, the fromIndexPaths and the toIndexPaths are the same, with no repeats. Sorting the
+    // packed index paths takes time proportional to the moves, however big the sections are.
+    uint64_t stackIndexPaths[2 * 64];
+    uint64_t *fromIndexPaths = (numberOfMoves <= 64)? stackIndexPaths : (uint64_t *)malloc(2 * numberOfMoves * sizeof(uint64_t));
+    if (fromIndexPaths == NULL) return false;
+    uint64_t *toIndexPaths = fromIndexPaths + numberOfMoves;
+
+    for (size_t i = 0; i < numberOfMoves; i++) {
+        fromIndexPaths[i] = SSExchangeIndexPathPack(moves[i].fromIndexPath);
+        toIndexPaths[i] = SSExchangeIndexPathPack(moves[i].toIndexPath);
+    }
+    std::sort(fromIndexPaths, fromIndexPaths + numberOfMoves);
+    std::sort(toIndexPaths, toIndexPaths + numberOfMoves);
+
+    bool isPermutation = true;
+    for (size_t i = 0; isPermutation && i < numberOfMoves; i++) {
+        if (fromIndexPaths[i] != toIndexPaths[i] || (i > 0 && fromIndexPaths[i] == fromIndexPaths[i - 1])) isPermutation = false;
+    }
+
+    if (fromIndexPaths != stackIndexPaths) free(fromIndexPaths);
+    return isPermutation;
+}
+
+
+
+//------------
+// Kernels...
+
+template <typename T>
+void SSExchangeValuesExchangeKernel(T *const *sections, const SSExchangeSwap *swaps, size_t numberOfSwaps, SSExchangeValueSum *sums) {
+
+    typedef SSExchangeSumTraits<T> Traits;
+
+    for (size_t i = 0; i < numberOfSwaps; i++) {
+
+        SSExchangeIndexPath indexPath1 = swaps[i].indexPath1;
+        SSExchangeIndexPath indexPath2 = swaps[i].indexPath2;
+        T *value1 = &sections[indexPath1.section][indexPath1.item];
+        T *value2 = &sections[indexPath2.section][indexPath2.item];
+        T v1 = *value1;
+        T v2 = *value2;
+
+        if (sums && indexPath1.section != indexPath2.section) {
+            Traits::sum(sums[indexPath1.section]) = Traits::add(Traits::subtract(Traits::sum(sums[indexPath1.section]), v1), v2);
+            Traits::sum(sums[indexPath2.section]) = Traits::add(Traits::subtract(Traits::sum(sums[indexPath2.section]), v2), v1);
+        }
+
+        *value1 = v2;
+        *value2 = v1;
+    }
+}
+
+template <typename T>
+bool SSExchangeValuesMoveKernel(T *const *sections, const SSExchangeMove *moves, size_t numberOfMoves, SSExchangeValueSum *sums) {
+
+    typedef SSExchangeSumTraits<T> Traits;
+
+    // Events and composed histories move a handful of values, so the stack usually does.
+    T stackValues[64];
+    T *movingValues = (numberOfMoves <= 64)? stackValues : (T *)malloc(numberOfMoves * sizeof(T));
+    if (movingValues == NULL) return false;
+
+    // Pick up every value that moves before putting any of them down...
+    for (size_t i = 0; i < numberOfMoves; i++) {
+        movingValues[i] = sections[moves[i].fromIndexPath.section][moves[i].fromIndexPath.item];
+    }
+
+    for (size_t i = 0; i < numberOfMoves; i++) {
+
+        SSExchangeIndexPath fromIndexPath = moves[i].fromIndexPath;
+        SSExchangeIndexPath toIndexPath = moves[i].toIndexPath;
+        sections[toIndexPath.section][toIndexPath.item] = movingValues[i];
+
+        if (sums && fromIndexPath.section != toIndexPath.section) {
+            Traits::sum(sums[fromIndexPath.section]) = Traits::subtract(Traits::sum(sums[fromIndexPath.section]), movingValues[i]);
+            Traits::sum(sums[toIndexPath.section]) = Traits::add(Traits::sum(sums[toIndexPath.section]), movingValues[i]);
+        }
+    }
+
+    if (movingValues != stackValues) free(movingValues);
+    return true;
+}
+
+template <typename T>
+void SSExchangeValuesPermuteKernel(T *values, size_t numberOfValues, const uint32_t *sourceIndices, T *scratch) {
+
+    // Every iteration is independent, a gather then a contiguous store.
+    for (size_t i = 0; i < numberOfValues; i++) {
+        scratch[i] = values[sourceIndices[i]];
+    }
+    memcpy(values, scratch, numberOfValues * sizeof(T));
+}
+
+template <typename T>
+SSExchangeValueSum SSExchangeValuesSumKernel(const T *values, size_t numberOfValues) {
+
+    typedef SSExchangeSumTraits<T> Traits;
+    typedef typename Traits::Accumulator Accumulator;
+
+    // Four accumulators so no addition waits on the one before it.
+    Accumulator sums[4] = { 0, 0, 0, 0 };
+    size_t i = 0;
+
+    for (; i + 4 <= numberOfValues; i += 4) {
+        sums[0] = Traits::add(sums[0], values[i]);
+        sums[1] = Traits::add(sums[1], values[i + 1]);
+        sums[2] = Traits::add(sums[2], values[i + 2]);
+        sums[3] = Traits::add(sums[3], values[i + 3]);
+    }
+    for (; i < numberOfValues; i++) {
+        sums[0] = Traits::add(sums[0], values[i]);
+    }
+
+    SSExchangeValueSum sum;
+    Traits::sum(sum) = Traits::combine(Traits::combine(sums[0], sums[1]), Traits::combine(sums[2], sums[3]));
+    return sum;
+}
+
+}   // namespace
+
+
+
+//------------------------------------------
+// Choosing the kernel for the value type...
+
+extern "C" size_t SSExchangeValueTypeSize(SSExchangeValueType type) {
+
+    switch (type) {
+        case SSExchangeValueTypeInt32:  return sizeof(int32_t);
+        case SSExchangeValueTypeInt64:  return sizeof(int64_t);
+        case SSExchangeValueTypeFloat:  return sizeof(float);
+        case SSExchangeValueTypeDouble: return sizeof(double);
+    }
+    return 0;
+}
+
+extern "C" bool SSExchangeValuesExchange(SSExchangeValueType type,
+                                         void *const *sections,
+                                         const size_t *numbersOfValues,
+                                         size_t numberOfSections,
+                                         const SSExchangeSwap *swaps,
+                                         size_t numberOfSwaps,
+                                         SSExchangeValueSum *sums) {
+
+    if (numberOfSwaps == 0) return true;
+    if (swaps == NULL || sections == NULL || numbersOfValues == NULL || SSExchangeValueTypeSize(type) == 0) return false;
+
+    // Validate everything first...
+    for (size_t i = 0; i < numberOfSwaps; i++) {
+        if (!SSExchangeValuesContainIndexPath(numbersOfValues, numberOfSections, swaps[i].indexPath1) ||
+            !SSExchangeValuesContainIndexPath(numbersOfValues, numberOfSections, swaps[i].indexPath2)) return false;
+    }
+
+    switch (type) {
+        case SSExchangeValueTypeInt32:  SSExchangeValuesExchangeKernel((int32_t *const *)sections, swaps, numberOfSwaps, sums); break;
+        case SSExchangeValueTypeInt64:  SSExchangeValuesExchangeKernel((int64_t *const *)sections, swaps, numberOfSwaps, sums); break;
+        case SSExchangeValueTypeFloat:  SSExchangeValuesExchangeKernel((float *const *)sections, swaps, numberOfSwaps, sums); break;
+        case SSExchangeValueTypeDouble: SSExchangeValuesExchangeKernel((double *const *)sections, swaps, numberOfSwaps, sums); break;
+    }
+    return true;
+}
+
+extern "C" bool SSExchangeValuesMove(SSExchangeValueType type,
+                                     void *const *sections,
+                                     const size_t *numbersOfValues,
+                                     size_t numberOfSections,
+                                     const SSExchangeMove *moves,
+                                     size_t numberOfMoves,
+                                     SSExchangeValueSum *sums) {
+
+    if (numberOfMoves == 0) return true;
+    if (moves == NULL || sections == NULL || numbersOfValues == NULL || SSExchangeValueTypeSize(type) == 0) return false;
+
+    for (size_t i = 0; i < numberOfMoves; i++) {
+        if (!SSExchangeValuesContainIndexPath(numbersOfValues, numberOfSections, moves[i].fromIndexPath) ||
+            !SSExchangeValuesContainIndexPath(numbersOfValues, numberOfSections, moves[i].toIndexPath)) return false;
+    }
+
+    if (!SSExchangeValuesMovesArePermutation(moves, numberOfMoves)) return false;
+
+    switch (type) {
+        case SSExchangeValueTypeInt32:  return SSExchangeValuesMoveKernel((int32_t *const *)sections, moves, numberOfMoves, sums);
+        case SSExchangeValueTypeInt64:  return SSExchangeValuesMoveKernel((int64_t *const *)sections, moves, numberOfMoves, sums);
+        case SSExchangeValueTypeFloat:  return SSExchangeValuesMoveKernel((float *const *)sections, moves, numberOfMoves, sums);
+        case SSExchangeValueTypeDouble: return SSExchangeValuesMoveKernel((double *const *)sections, moves, numberOfMoves, sums);
+    }
+    return false;
+}
+
+extern "C" bool SSExchangeValuesPermute(SSExchangeValueType type,
+                                        void *values,
+                                        size_t numberOfValues,
+                                        const uint32_t *sourceIndices) {
+
+    size_t size = SSExchangeValueTypeSize(type);
+    if (numberOfValues == 0) return true;
+    if (values == NULL || sourceIndices == NULL || size == 0 || numberOfValues > UINT32_MAX) return false;
+
+    // A bit for each index, to check every one appears exactly once...
+    uint64_t *seen = (uint64_t *)calloc(numberOfValues / 64 + 1, sizeof(uint64_t));
+    void *scratch = malloc(numberOfValues * size);
+    bool isPermutation = (seen != NULL && scratch != NULL);
+
+    for (size_t i = 0; isPermutation && i < numberOfValues; i++) {
+        uint32_t index = sourceIndices[i];
+        uint64_t mask = 1ull << (index % 64);
+        if (index >= numberOfValues || (seen[index / 64] & mask)) isPermutation = false;
+        else seen[index / 64] |= mask;
+    }
+
+    if (isPermutation) {
+        switch (type) {
+            case SSExchangeValueTypeInt32:  SSExchangeValuesPermuteKernel((int32_t *)values, numberOfValues, sourceIndices, (int32_t *)scratch); break;
+            case SSExchangeValueTypeInt64:  SSExchangeValuesPermuteKernel((int64_t *)values, numberOfValues, sourceIndices, (int64_t *)scratch); break;
+            case SSExchangeValueTypeFloat:  SSExchangeValuesPermuteKernel((float *)values, numberOfValues, sourceIndices, (float *)scratch); break;
+            case SSExchangeValueTypeDouble: SSExchangeValuesPermuteKernel((double *)values, numberOfValues, sourceIndices, (double *)scratch); break;
+        }
+    }
+
+    free(seen);
+    free(scratch);
+    return isPermutation;
+}
+
+extern "C" SSExchangeValueSum SSExchangeValuesSum(SSExchangeValueType type, const void *values, size_t numberOfValues) {
+
+    if (values == NULL) numberOfValues = 0;
+
+    switch (type) {
+        case SSExchangeValueTypeInt32:  return SSExchangeValuesSumKernel((const int32_t *)values, numberOfValues);
+        case SSExchangeValueTypeInt64:  return SSExchangeValuesSumKernel((const int64_t *)values, numberOfValues);
+        case SSExchangeValueTypeFloat:  return SSExchangeValuesSumKernel((const float *)values, numberOfValues);
+        case SSExchangeValueTypeDouble: return SSExchangeValuesSumKernel((const double *)values, numberOfValues);
+    }
+
+    SSExchangeValueSum sum;
+    sum.integerSum = 0;
+    return sum;
+}